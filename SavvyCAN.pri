@@ -0,0 +1,280 @@
+#-------------------------------------------------
+#
+# Everything but main.cpp. Shared by the application and the unit tests
+# so the tests always link against the same sources the app is built from
+#
+#-------------------------------------------------
+
+QT += core gui printsupport qml serialbus serialport widgets help network opengl concurrent
+
+CONFIG += c++17
+
+DEFINES += QCUSTOMPLOT_USE_OPENGL
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/canbridgewindow.cpp \
+    $$PWD/connections/canlogserver.cpp \
+    $$PWD/connections/canserver.cpp \
+    $$PWD/connections/lawicel_serial.cpp \
+    $$PWD/connections/mqtt_bus.cpp \
+    $$PWD/dbc/dbcnodeduplicateeditor.cpp \
+    $$PWD/framesenderobject.cpp \
+    $$PWD/framesendprogram.cpp \
+    $$PWD/framesendschedule.cpp \
+    $$PWD/restbusengine.cpp \
+    $$PWD/restbusplanner.cpp \
+    $$PWD/mqtt/qmqtt_client.cpp \
+    $$PWD/mqtt/qmqtt_client_p.cpp \
+    $$PWD/mqtt/qmqtt_frame.cpp \
+    $$PWD/mqtt/qmqtt_message.cpp \
+    $$PWD/mqtt/qmqtt_network.cpp \
+    $$PWD/mqtt/qmqtt_router.cpp \
+    $$PWD/mqtt/qmqtt_routesubscription.cpp \
+    $$PWD/mqtt/qmqtt_socket.cpp \
+    $$PWD/mqtt/qmqtt_ssl_socket.cpp \
+    $$PWD/mqtt/qmqtt_timer.cpp \
+    $$PWD/mqtt/qmqtt_websocket.cpp \
+    $$PWD/mqtt/qmqtt_websocketiodevice.cpp \
+    $$PWD/qcpaxistickerhex.cpp \
+    $$PWD/re/dbccomparatorwindow.cpp \
+    $$PWD/mainwindow.cpp \
+    $$PWD/canframemodel.cpp \
+    $$PWD/simplecrypt.cpp \
+    $$PWD/triggerdialog.cpp \
+    $$PWD/utility.cpp \
+    $$PWD/qcustomplot.cpp \
+    $$PWD/frameplaybackwindow.cpp \
+    $$PWD/candatagrid.cpp \
+    $$PWD/framesenderwindow.cpp \
+    $$PWD/framefileio.cpp \
+    $$PWD/mainsettingsdialog.cpp \
+    $$PWD/firmwareuploaderwindow.cpp \
+    $$PWD/scriptingwindow.cpp \
+    $$PWD/scriptcontainer.cpp \
+    $$PWD/scriptframebatch.cpp \
+    $$PWD/canfilter.cpp \
+    $$PWD/can_structs.cpp \
+    $$PWD/motorcontrollerconfigwindow.cpp \
+    $$PWD/connections/canconnection.cpp \
+    $$PWD/connections/serialbusconnection.cpp \
+    $$PWD/connections/canconfactory.cpp \
+    $$PWD/connections/gvretserial.cpp \
+    $$PWD/connections/socketcand.cpp \
+    $$PWD/connections/canconmanager.cpp \
+    $$PWD/connections/cantimebase.cpp \
+    $$PWD/connections/simulatedconnection.cpp \
+    $$PWD/re/sniffer/snifferitem.cpp \
+    $$PWD/re/sniffer/sniffermodel.cpp \
+    $$PWD/re/sniffer/snifferwindow.cpp \
+    $$PWD/dbc/dbcmessageeditor.cpp \
+    $$PWD/dbc/dbc_classes.cpp \
+    $$PWD/dbc/dbchandler.cpp \
+    $$PWD/dbc/signalcodec.cpp \
+    $$PWD/dbc/dbcloadsavewindow.cpp \
+    $$PWD/dbc/dbcmaineditor.cpp \
+    $$PWD/dbc/dbcnodeeditor.cpp \
+    $$PWD/dbc/dbcsignaleditor.cpp \
+    $$PWD/dbc/dbcnoderebaseeditor.cpp \
+    $$PWD/re/discretestatewindow.cpp \
+    $$PWD/re/discretestatesolver.cpp \
+    $$PWD/re/filecomparatorwindow.cpp \
+    $$PWD/re/filecomparator.cpp \
+    $$PWD/re/signalvaluekey.cpp \
+    $$PWD/re/framestatistics.cpp \
+    $$PWD/re/graphpyramid.cpp \
+    $$PWD/re/graphbuilder.cpp \
+    $$PWD/re/udsscanengine.cpp \
+    $$PWD/re/flowviewwindow.cpp \
+    $$PWD/re/frameinfowindow.cpp \
+    $$PWD/re/fuzzingwindow.cpp \
+    $$PWD/re/isotp_interpreterwindow.cpp \
+    $$PWD/re/rangestatewindow.cpp \
+    $$PWD/re/rangesignalsearch.cpp \
+    $$PWD/re/udsscanwindow.cpp \
+    $$PWD/connections/canbus.cpp \
+    $$PWD/connections/canconnectionmodel.cpp \
+    $$PWD/connections/connectionwindow.cpp \
+    $$PWD/re/graphingwindow.cpp \
+    $$PWD/re/newgraphdialog.cpp \
+    $$PWD/bisectwindow.cpp \
+    $$PWD/signalviewerwindow.cpp \
+    $$PWD/bus_protocols/isotp_handler.cpp \
+    $$PWD/bus_protocols/isotp_transmitter.cpp \
+    $$PWD/bus_protocols/isotp_reassembler.cpp \
+    $$PWD/bus_protocols/j1939_handler.cpp \
+    $$PWD/bus_protocols/j1939_reassembler.cpp \
+    $$PWD/bus_protocols/uds_handler.cpp \
+    $$PWD/jsedit.cpp \
+    $$PWD/frameplaybackobject.cpp \
+    $$PWD/frameplaybackscheduler.cpp \
+    $$PWD/helpwindow.cpp \
+    $$PWD/blfhandler.cpp \
+    $$PWD/re/sniffer/SnifferDelegate.cpp \
+    $$PWD/connections/newconnectiondialog.cpp \
+    $$PWD/re/temporalgraphwindow.cpp \
+    $$PWD/filterutility.cpp \
+    $$PWD/pcaplite.cpp
+
+HEADERS  += $$PWD/mainwindow.h \
+    $$PWD/can_structs.h \
+    $$PWD/canbridgewindow.h \
+    $$PWD/canframemodel.h \
+    $$PWD/connections/canlogserver.h \
+    $$PWD/connections/canserver.h \
+    $$PWD/connections/lawicel_serial.h \
+    $$PWD/connections/socketcand.h \
+    $$PWD/connections/mqtt_bus.h \
+    $$PWD/dbc/dbcnodeduplicateeditor.h \
+    $$PWD/dbc/dbcnoderebaseeditor.h \
+    $$PWD/framesenderobject.h \
+    $$PWD/framesendprogram.h \
+    $$PWD/framesendschedule.h \
+    $$PWD/restbusengine.h \
+    $$PWD/restbusplanner.h \
+    $$PWD/mqtt/qmqtt.h \
+    $$PWD/mqtt/qmqtt_client.h \
+    $$PWD/mqtt/qmqtt_client_p.h \
+    $$PWD/mqtt/qmqtt_frame.h \
+    $$PWD/mqtt/qmqtt_global.h \
+    $$PWD/mqtt/qmqtt_message.h \
+    $$PWD/mqtt/qmqtt_message_p.h \
+    $$PWD/mqtt/qmqtt_network_p.h \
+    $$PWD/mqtt/qmqtt_networkinterface.h \
+    $$PWD/mqtt/qmqtt_routedmessage.h \
+    $$PWD/mqtt/qmqtt_router.h \
+    $$PWD/mqtt/qmqtt_routesubscription.h \
+    $$PWD/mqtt/qmqtt_socket_p.h \
+    $$PWD/mqtt/qmqtt_socketinterface.h \
+    $$PWD/mqtt/qmqtt_ssl_socket_p.h \
+    $$PWD/mqtt/qmqtt_timer_p.h \
+    $$PWD/mqtt/qmqtt_timerinterface.h \
+    $$PWD/mqtt/qmqtt_websocket_p.h \
+    $$PWD/mqtt/qmqtt_websocketiodevice_p.h \
+    $$PWD/qcpaxistickerhex.h \
+    $$PWD/re/dbccomparatorwindow.h \
+    $$PWD/simplecrypt.h \
+    $$PWD/triggerdialog.h \
+    $$PWD/utility.h \
+    $$PWD/qcustomplot.h \
+    $$PWD/frameplaybackwindow.h \
+    $$PWD/candatagrid.h \
+    $$PWD/framesenderwindow.h \
+    $$PWD/can_trigger_structs.h \
+    $$PWD/framefileio.h \
+    $$PWD/config.h \
+    $$PWD/mainsettingsdialog.h \
+    $$PWD/firmwareuploaderwindow.h \
+    $$PWD/scriptingwindow.h \
+    $$PWD/scriptcontainer.h \
+    $$PWD/scriptframebatch.h \
+    $$PWD/canfilter.h \
+    $$PWD/utils/lfqueue.h \
+    $$PWD/utils/lfinbox.h \
+    $$PWD/utils/hiresclock.h \
+    $$PWD/motorcontrollerconfigwindow.h \
+    $$PWD/connections/canconnection.h \
+    $$PWD/connections/serialbusconnection.h \
+    $$PWD/connections/canconconst.h \
+    $$PWD/connections/canconfactory.h \
+    $$PWD/connections/gvretserial.h \
+    $$PWD/connections/canconmanager.h \
+    $$PWD/connections/cantimebase.h \
+    $$PWD/connections/simulatedconnection.h \
+    $$PWD/re/sniffer/snifferitem.h \
+    $$PWD/re/sniffer/sniffermodel.h \
+    $$PWD/re/sniffer/snifferwindow.h \
+    $$PWD/dbc/dbc_classes.h \
+    $$PWD/dbc/dbchandler.h \
+    $$PWD/dbc/signalcodec.h \
+    $$PWD/dbc/dbcloadsavewindow.h \
+    $$PWD/dbc/dbcmaineditor.h \
+    $$PWD/dbc/dbcsignaleditor.h \
+    $$PWD/dbc/dbcmessageeditor.h \
+    $$PWD/dbc/dbcnodeeditor.h \
+    $$PWD/re/discretestatewindow.h \
+    $$PWD/re/discretestatesolver.h \
+    $$PWD/re/filecomparatorwindow.h \
+    $$PWD/re/filecomparator.h \
+    $$PWD/re/signalvaluekey.h \
+    $$PWD/re/framestatistics.h \
+    $$PWD/re/graphpyramid.h \
+    $$PWD/re/graphbuilder.h \
+    $$PWD/re/udsscanengine.h \
+    $$PWD/re/flowviewwindow.h \
+    $$PWD/re/frameinfowindow.h \
+    $$PWD/re/fuzzingwindow.h \
+    $$PWD/re/isotp_interpreterwindow.h \
+    $$PWD/re/rangestatewindow.h \
+    $$PWD/re/rangesignalsearch.h \
+    $$PWD/re/udsscanwindow.h \
+    $$PWD/connections/canbus.h \
+    $$PWD/connections/canconnectionmodel.h \
+    $$PWD/connections/connectionwindow.h \
+    $$PWD/re/graphingwindow.h \
+    $$PWD/re/newgraphdialog.h \
+    $$PWD/bisectwindow.h \
+    $$PWD/signalviewerwindow.h \
+    $$PWD/bus_protocols/isotp_handler.h \
+    $$PWD/bus_protocols/isotp_transmitter.h \
+    $$PWD/bus_protocols/isotp_reassembler.h \
+    $$PWD/bus_protocols/j1939_handler.h \
+    $$PWD/bus_protocols/j1939_reassembler.h \
+    $$PWD/bus_protocols/j1939_message.h \
+    $$PWD/bus_protocols/uds_handler.h \
+    $$PWD/bus_protocols/isotp_message.h \
+    $$PWD/jsedit.h \
+    $$PWD/frameplaybackobject.h \
+    $$PWD/frameplaybackscheduler.h \
+    $$PWD/helpwindow.h \
+    $$PWD/blfhandler.h \
+    $$PWD/re/sniffer/SnifferDelegate.h \
+    $$PWD/connections/newconnectiondialog.h \
+    $$PWD/re/temporalgraphwindow.h \
+    $$PWD/filterutility.h \
+    $$PWD/pcaplite.h
+
+FORMS    += $$PWD/ui/candatagrid.ui \
+    $$PWD/triggerdialog.ui \
+    $$PWD/ui/canbridgewindow.ui \
+    $$PWD/ui/dbcnodeduplicateeditor.ui \
+    $$PWD/ui/dbccomparatorwindow.ui \
+    $$PWD/ui/dbcmessageeditor.ui \
+    $$PWD/ui/connectionwindow.ui \
+    $$PWD/ui/dbcloadsavewindow.ui \
+    $$PWD/ui/dbcmaineditor.ui \
+    $$PWD/ui/dbcnoderebaseeditor.ui \
+    $$PWD/ui/dbcsignaleditor.ui \
+    $$PWD/ui/dbcnodeeditor.ui \
+    $$PWD/ui/discretestatewindow.ui \
+    $$PWD/ui/filecomparatorwindow.ui \
+    $$PWD/ui/firmwareuploaderwindow.ui \
+    $$PWD/ui/flowviewwindow.ui \
+    $$PWD/ui/frameinfowindow.ui \
+    $$PWD/ui/frameplaybackwindow.ui \
+    $$PWD/ui/framesenderwindow.ui \
+    $$PWD/ui/fuzzingwindow.ui \
+    $$PWD/ui/graphingwindow.ui \
+    $$PWD/ui/isotp_interpreterwindow.ui \
+    $$PWD/ui/mainsettingsdialog.ui \
+    $$PWD/ui/mainwindow.ui \
+    $$PWD/ui/motorcontrollerconfigwindow.ui \
+    $$PWD/ui/newgraphdialog.ui \
+    $$PWD/ui/rangestatewindow.ui \
+    $$PWD/ui/scriptingwindow.ui \
+    $$PWD/ui/snifferwindow.ui \
+    $$PWD/ui/udsscanwindow.ui \
+    $$PWD/ui/bisectwindow.ui \
+    $$PWD/ui/signalviewerwindow.ui \
+    $$PWD/ui/helpwindow.ui \
+    $$PWD/ui/newconnectiondialog.ui \
+    $$PWD/ui/temporalgraphwindow.ui
+
+win32-msvc* {
+   LIBS += opengl32.lib
+}
+
+win32-g++ {
+   LIBS += libopengl32
+}
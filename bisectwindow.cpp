@@ -18,6 +18,7 @@ BisectWindow::BisectWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     modelFrames = frames;
 
     connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    connect(MainWindow::getReference()->getCANFrameModel(), &CANFrameModel::idsAdded, this, &BisectWindow::newIDsSeen);
     connect(ui->btnCalculate, &QAbstractButton::clicked, this, &BisectWindow::handleCalculateButton);
     connect(ui->btnReplaceFrames, &QAbstractButton::clicked, this, &BisectWindow::handleReplaceButton);
     connect(ui->btnSaveFrames, &QAbstractButton::clicked, this, &BisectWindow::handleSaveButton);
@@ -95,27 +96,29 @@ void BisectWindow::updateSectionsText()
 
 void BisectWindow::refreshIDList()
 {
-    int id;
-    foundID.clear();
+    foundID = MainWindow::getReference()->getCANFrameModel()->getUniqueIDs(modelFrames);
     ui->cbIDLower->clear();
     ui->cbIDUpper->clear();
-    for (int i = 0; i < modelFrames->count(); i++)
-    {
-        id = modelFrames->at(i).frameId();
-        if (!foundID.contains(id))
-        {
-            foundID.append(id);
-        }
-    }
-
-    std::sort(foundID.begin(), foundID.end());
 
-    foreach (int id, foundID) {
+    foreach (uint32_t id, foundID) {
         ui->cbIDLower->addItem(Utility::formatCANID(id));
         ui->cbIDUpper->addItem(Utility::formatCANID(id));
     }
 }
 
+//slot each new ID in at its sorted place instead of rebuilding the lists
+void BisectWindow::newIDsSeen(const QVector<uint32_t> &newIDs)
+{
+    foreach (uint32_t id, newIDs) {
+        auto it = std::lower_bound(foundID.begin(), foundID.end(), id);
+        if (it != foundID.end() && *it == id) continue;
+        int idx = static_cast<int>(it - foundID.begin());
+        foundID.insert(idx, id);
+        ui->cbIDLower->insertItem(idx, Utility::formatCANID(id));
+        ui->cbIDUpper->insertItem(idx, Utility::formatCANID(id));
+    }
+}
+
 void BisectWindow::refreshFrameNumbers()
 {
     ui->labelMainListNum->setText(QString::number(modelFrames->count()));
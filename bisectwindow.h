@@ -23,6 +23,7 @@ signals:
 
 private slots:
     void updatedFrames(int numFrames);
+    void newIDsSeen(const QVector<uint32_t> &newIDs);
     void handleSaveButton();
     void handleReplaceButton();
     void handleCalculateButton();
@@ -36,7 +37,7 @@ private:
     Ui::BisectWindow *ui;
     const QVector<CANFrame> *modelFrames;
     QVector<CANFrame> splitFrames;
-    QList<int> foundID;
+    QVector<uint32_t> foundID; //ascending, same order as the ID combo boxes
 
     void refreshIDList();
     void refreshFrameNumbers();
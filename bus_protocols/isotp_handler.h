@@ -3,54 +3,63 @@
 #include <Qt>
 #include <QObject>
 #include <QDebug>
-#include <QTimer>
 #include "can_structs.h"
 #include "mainwindow.h"
 #include "canframemodel.h"
 #include "isotp_message.h"
 #include "canfilter.h"
+#include "isotp_transmitter.h"
+#include "isotp_reassembler.h"
 
 class ISOTP_HANDLER : public QObject
 {
     Q_OBJECT
 
 public:
+    typedef std::function<void(const CANFrame&)> FrameSender;
+
     ISOTP_HANDLER();
     ~ISOTP_HANDLER();
     void setExtendedAddressing(bool mode);
     void setReception(bool mode); //set whether to accept and forward frames or not
     void setEmitPartials(bool mode);
     void sendISOTPFrame(int bus, int ID, QByteArray data);
+    void setFrameSize(int size); //TX_DL for sending. 8 for classic CAN, up to 64 for CAN FD
     void setProcessAll(bool state);
     void setFlowCtrl(bool state);
     void addFilter(int pBusId, uint32_t ID, uint32_t mask);
     void removeFilter(int pBusId, uint32_t ID, uint32_t mask);
     void clearAllFilters();
+    /* where frames sent on the handler's own thread go, that is single frame messages and flow control.
+       Without one they go straight to CANConManager */
+    void setFrameSender(FrameSender sender);
 
 public slots:
     void updatedFrames(int);
     void rapidFrames(const CANConnection* conn, const QVector<CANFrame>& pFrames);
-    void frameTimerTick();
 
 signals:
     void newISOMessage(ISOTP_MESSAGE msg);
+    void transmitFinished(ISOTPTransmitStats stats);
 
 private:
-    QHash<uint32_t, ISOTP_MESSAGE> messageBuffer;
-    QList<CANFrame> sendingFrames;
+    ISOTPReassembler reassembler;
+    QVector<ISOTP_MESSAGE> finished;
     QList<CANFilter> filters;
+    QHash<quint64, bool> filterMatches;    //(bus, ID) -> whether any filter takes it. Cleared when the filters change
     const QVector<CANFrame> *modelFrames;
     bool useExtendedAddressing;
     bool isReceiving;
-    bool waitingForFlow;
-    int framesUntilFlow;
     bool processAll;
     bool issueFlowMsgs;
-    bool sendPartialMessages;
-    QTimer frameTimer;
+    ISOTPTransmitter *transmitter;
+    FrameSender localSender;
+    int frameSize;
     uint32_t lastSenderID;
     uint32_t lastSenderBus;
 
+    void sendFrame(const CANFrame &frame);
     void processFrame(const CANFrame &frame);
-    void checkNeedFlush(uint64_t ID);
+    bool passesFilters(const CANFrame &frame);
+    void emitFinished();
 };
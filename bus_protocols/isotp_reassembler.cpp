@@ -0,0 +1,222 @@
+#include <cstring>
+#include "isotp_reassembler.h"
+
+ISOTPReassembler::ISOTPReassembler()
+{
+    useExtendedAddressing = false;
+    emitPartials = false;
+    timeoutUs = ISOTP_RX_TIMEOUT_US;
+    openSessions = 0;
+}
+
+void ISOTPReassembler::setExtendedAddressing(bool mode)
+{
+    if (useExtendedAddressing == mode) return;
+    useExtendedAddressing = mode;
+    clear(); //session keys mean something else now
+}
+
+void ISOTPReassembler::setEmitPartials(bool mode)
+{
+    emitPartials = mode;
+}
+
+void ISOTPReassembler::setTimeout(qint64 us)
+{
+    timeoutUs = us;
+}
+
+void ISOTPReassembler::clear()
+{
+    index.clear();
+    sessions.clear();
+    openSessions = 0;
+}
+
+int ISOTPReassembler::getOpenSessions() const
+{
+    return openSessions;
+}
+
+qint64 ISOTPReassembler::frameTimeUs(const CANFrame& frame)
+{
+    return frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+}
+
+quint64 ISOTPReassembler::sessionKey(int bus, uint32_t frameId, int address)
+{
+    return ((quint64)(quint16)bus << 48) | ((quint64)address << 32) | frameId;
+}
+
+ISOTPReassembler::Session &ISOTPReassembler::session(quint64 key, int bus, uint32_t id)
+{
+    QHash<quint64, int>::const_iterator it = index.constFind(key);
+    if (it != index.constEnd()) return sessions[it.value()];
+
+    Session sess;
+    sess.active = false;
+    sess.bus = bus;
+    sess.id = id;
+    sess.extended = false;
+    sess.isReceived = true;
+    sess.lastUs = 0;
+    sess.length = 0;
+    sess.received = 0;
+    sess.nextSequence = 0;
+    index.insert(key, sessions.count());
+    sessions.append(sess);
+    return sessions.last();
+}
+
+ISOTP_MESSAGE ISOTPReassembler::makeMessage(const CANFrame& frame, uint32_t id, const QByteArray& payload, int length, bool multi)
+{
+    ISOTP_MESSAGE msg;
+    msg.bus = frame.bus;
+    msg.setFrameType(QCanBusFrame::DataFrame);
+    msg.setExtendedFrameFormat(frame.hasExtendedFrameFormat());
+    msg.setFrameId(id);
+    msg.isReceived = frame.isReceived;
+    msg.setTimeStamp(frame.timeStamp());
+    msg.reportedLength = length;
+    msg.isMultiframe = multi;
+    msg.lastSequence = -1;
+    msg.setPayload(payload);
+    return msg;
+}
+
+void ISOTPReassembler::finish(Session& sess, QVector<ISOTP_MESSAGE>& out)
+{
+    CANFrame first;
+    first.bus = sess.bus;
+    first.setExtendedFrameFormat(sess.extended);
+    first.isReceived = sess.isReceived;
+    first.setTimeStamp(sess.started);
+
+    //the buffer goes with the message. The next first frame allocates a new one
+    out.append(makeMessage(first, sess.id, sess.data, sess.length, true));
+    out.last().lastSequence = (sess.nextSequence + 15) & 0xF;
+    sess.data = QByteArray();
+    sess.active = false;
+    openSessions--;
+}
+
+void ISOTPReassembler::drop(Session& sess, QVector<ISOTP_MESSAGE>& out)
+{
+    if (!sess.active) return;
+    if (emitPartials && sess.received > 0)
+    {
+        sess.data.truncate(sess.received);
+        finish(sess, out);
+        return;
+    }
+    sess.data = QByteArray();
+    sess.active = false;
+    openSessions--;
+}
+
+int ISOTPReassembler::addFrame(const CANFrame& frame, QVector<ISOTP_MESSAGE>& out)
+{
+    const QByteArray payload = frame.payload();
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    const int base = useExtendedAddressing ? 1 : 0;
+    const int dataLen = payload.length();
+    if (dataLen <= base) return -1;
+
+    const int address = useExtendedAddressing ? data[0] : 0;
+    const quint64 key = sessionKey(frame.bus, frame.frameId(), address);
+    uint32_t id = frame.frameId();
+    if (useExtendedAddressing) id = (id << 8) + address;
+
+    const int frameType = data[base] >> 4;
+    int length = data[base] & 0xF;
+
+    switch (frameType)
+    {
+    case 0: //single frame
+    {
+        int start = base + 1;
+        if (length == 0) //CAN FD single frame, length in the next byte
+        {
+            if (dataLen <= 8 || dataLen < base + 2) return -1;
+            length = data[base + 1];
+            start = base + 2;
+        }
+        if (length == 0 || start + length > dataLen) return -1;
+
+        if (!index.isEmpty())
+        {
+            QHash<quint64, int>::const_iterator it = index.constFind(key);
+            if (it != index.constEnd()) drop(sessions[it.value()], out);
+        }
+        out.append(makeMessage(frame, id, payload.mid(start, length), length, false));
+        return 0;
+    }
+    case 1: //first frame of a multi-frame message
+    {
+        if (dataLen < 8) return -1; //MUST have all 8 data bytes in this first frame.
+        if (dataLen < base + 2) return -1;
+        length = (length << 8) + data[base + 1];
+        int start = base + 2;
+        if (length == 0) //escaped, 32 bit length follows
+        {
+            if (dataLen < base + 6) return -1;
+            length = (int)qMin((quint32)ISOTP_MAX_RX_LENGTH + 1,
+                               ((quint32)data[base + 2] << 24) | ((quint32)data[base + 3] << 16) | ((quint32)data[base + 4] << 8) | data[base + 5]);
+            start = base + 6;
+        }
+        if (length > ISOTP_MAX_RX_LENGTH) return -1;
+
+        Session &sess = session(key, frame.bus, id);
+        drop(sess, out);
+
+        const int chunk = qMin(length, dataLen - start);
+        sess.active = true;
+        sess.extended = frame.hasExtendedFrameFormat();
+        sess.isReceived = frame.isReceived;
+        sess.started = frame.timeStamp();
+        sess.lastUs = frameTimeUs(frame);
+        sess.length = length;
+        sess.received = chunk;
+        sess.nextSequence = 1;
+        sess.data = QByteArray(length, Qt::Uninitialized);
+        memcpy(sess.data.data(), data + start, chunk);
+        openSessions++;
+        if (sess.received >= sess.length) finish(sess, out);
+        return 1;
+    }
+    case 2: //subsequent frames for multi-frame messages
+    {
+        QHash<quint64, int>::const_iterator it = index.constFind(key);
+        if (it == index.constEnd()) return 2;
+        Session &sess = sessions[it.value()];
+        if (!sess.active) return 2; //if we didn't get a first frame then ignore this frame.
+
+        const qint64 now = frameTimeUs(frame);
+        if ((now - sess.lastUs) > timeoutUs || length != sess.nextSequence)
+        {
+            drop(sess, out);
+            return 2;
+        }
+
+        const int chunk = qMin(sess.length - sess.received, dataLen - base - 1);
+        memcpy(sess.data.data() + sess.received, data + base + 1, chunk);
+        sess.received += chunk;
+        sess.nextSequence = (sess.nextSequence + 1) & 0xF;
+        sess.lastUs = now;
+        if (sess.received >= sess.length) finish(sess, out);
+        return 2;
+    }
+    case 3: //flow control, nothing to put together
+        return 3;
+    }
+    return -1;
+}
+
+void ISOTPReassembler::expire(qint64 nowUs, QVector<ISOTP_MESSAGE>& out)
+{
+    if (openSessions == 0) return;
+    for (int i = 0; i < sessions.count(); i++)
+    {
+        if (sessions[i].active && (nowUs - sessions[i].lastUs) > timeoutUs) drop(sessions[i], out);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef ISOTP_REASSEMBLER_H
+#define ISOTP_REASSEMBLER_H
+
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include "can_structs.h"
+#include "isotp_message.h"
+
+/* N_Cr, a session that hasn't seen a consecutive frame for this long is given up. In frame time */
+#define ISOTP_RX_TIMEOUT_US         1000000
+/* first frames announcing more than this are ignored rather than allocated */
+#define ISOTP_MAX_RX_LENGTH         (16 * 1024 * 1024)
+
+/*
+  Puts ISO-TP messages back together from the frames they were split into. One session per
+  (bus, ID, extended address) is kept in a flat table and reused message after message. The buffer
+  for a multi frame message is allocated once at its full length when the first frame comes in and
+  the consecutive frames are copied straight into place.
+
+  Both classic and CAN FD frames are understood, including the escaped single frame length and the
+  32 bit first frame length of messages over 4095 bytes. Sequence numbers are checked. A session whose
+  sender went quiet for longer than N_Cr, or that was broken by a bad sequence number or a new first frame,
+  is dropped. With partials enabled what was received up to then is still handed out.
+
+  Time is taken from the frame timestamps so captures reassemble the same way they did live.
+*/
+class ISOTPReassembler
+{
+public:
+    ISOTPReassembler();
+
+    void setExtendedAddressing(bool mode);
+    void setEmitPartials(bool mode);
+    void setTimeout(qint64 timeoutUs);
+    void clear();
+
+    /**
+     * @brief feed one frame
+     * @param out - appended with any message this frame finished or broke off
+     * @return the ISO-TP frame type (0 = single, 1 = first, 2 = consecutive, 3 = flow control) or -1 if it isn't one
+     */
+    int addFrame(const CANFrame& frame, QVector<ISOTP_MESSAGE>& out);
+
+    /* drops sessions that have been idle for longer than the timeout as of nowUs */
+    void expire(qint64 nowUs, QVector<ISOTP_MESSAGE>& out);
+
+    /* multi frame messages currently being received */
+    int getOpenSessions() const;
+
+    static qint64 frameTimeUs(const CANFrame& frame);
+
+private:
+    struct Session
+    {
+        bool active;
+        int bus;
+        uint32_t id;            //ID the message goes out with. With extended addressing the address byte is appended
+        bool extended;
+        bool isReceived;
+        QCanBusFrame::TimeStamp started;
+        qint64 lastUs;
+        int length;
+        int received;
+        int nextSequence;
+        QByteArray data;
+    };
+
+    static quint64 sessionKey(int bus, uint32_t frameId, int address);
+    Session &session(quint64 key, int bus, uint32_t id);
+    void finish(Session& sess, QVector<ISOTP_MESSAGE>& out);
+    void drop(Session& sess, QVector<ISOTP_MESSAGE>& out);
+    static ISOTP_MESSAGE makeMessage(const CANFrame& frame, uint32_t id, const QByteArray& payload, int length, bool multi);
+
+    bool useExtendedAddressing;
+    bool emitPartials;
+    qint64 timeoutUs;
+    QHash<quint64, int> index;
+    QVector<Session> sessions;
+    int openSessions;
+};
+
+#endif // ISOTP_REASSEMBLER_H
@@ -0,0 +1,259 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include "isotp_transmitter.h"
+#include "utils/hiresclock.h"
+
+ISOTPTransmitter::ISOTPTransmitter(std::function<void(const CANFrame&)> sender, QObject *parent) : QThread(parent)
+{
+    qRegisterMetaType<ISOTPTransmitStats>("ISOTPTransmitStats");
+
+    sendFrame = sender;
+    active = false;
+    waitingForFlow = false;
+}
+
+ISOTPTransmitter::~ISOTPTransmitter()
+{
+    abort();
+}
+
+int ISOTPTransmitter::paddedLength(int len)
+{
+    static const int fdLengths[] = {12, 16, 20, 24, 32, 48, 64};
+    if (len <= 8) return 8;
+    for (int fdLen : fdLengths) if (len <= fdLen) return fdLen;
+    return 64;
+}
+
+qint64 ISOTPTransmitter::separationNs(quint8 stMin)
+{
+    if (stMin <= 0x7F) return stMin * 1000000ll;
+    if (stMin >= 0xF1 && stMin <= 0xF9) return (stMin - 0xF0) * 100000ll;
+    return 0x7F * 1000000ll;
+}
+
+QVector<QByteArray> ISOTPTransmitter::segment(const QByteArray& data, int frameSize)
+{
+    QVector<QByteArray> frames;
+    const int txDL = paddedLength(qBound(8, frameSize, 64));
+    const int len = data.length();
+    int pos = 0;
+
+    if (len <= 7)
+    {
+        QByteArray bytes(8, 0);
+        bytes[0] = len;
+        for (int i = 0; i < len; i++) bytes[1 + i] = data[i];
+        frames.append(bytes);
+        return frames;
+    }
+    if (len <= txDL - 2) //CAN FD single frame, the length moves to the second byte
+    {
+        QByteArray bytes(paddedLength(len + 2), 0);
+        bytes[1] = len;
+        for (int i = 0; i < len; i++) bytes[2 + i] = data[i];
+        frames.append(bytes);
+        return frames;
+    }
+
+    QByteArray first(txDL, 0);
+    int header;
+    if (len <= ISOTP_MAX_SHORT_LENGTH)
+    {
+        first[0] = 0x10 + (len >> 8);
+        first[1] = len & 0xFF;
+        header = 2;
+    }
+    else
+    {
+        first[0] = 0x10;
+        first[1] = 0;
+        first[2] = (len >> 24) & 0xFF;
+        first[3] = (len >> 16) & 0xFF;
+        first[4] = (len >> 8) & 0xFF;
+        first[5] = len & 0xFF;
+        header = 6;
+    }
+    for (int i = header; i < txDL; i++) first[i] = data[pos++];
+    frames.append(first);
+
+    int sequence = 1;
+    while (pos < len)
+    {
+        const int bytesToGo = qMin(len - pos, txDL - 1);
+        QByteArray bytes(paddedLength(bytesToGo + 1), 0);
+        bytes[0] = 0x20 + sequence;
+        sequence = (sequence + 1) & 0xF;
+        for (int i = 0; i < bytesToGo; i++) bytes[1 + i] = data[pos++];
+        frames.append(bytes);
+    }
+    return frames;
+}
+
+void ISOTPTransmitter::transmit(const CANFrame& header, const QByteArray& data, int frameSize)
+{
+    Pending msg;
+    msg.header = header;
+    msg.header.setFlexibleDataRateFormat(frameSize > 8);
+    msg.frames = segment(data, frameSize);
+    msg.bytes = data.length();
+
+    if (msg.frames.count() == 1)
+    {
+        send(msg.header, msg.frames[0]);
+        return;
+    }
+
+    bool needStart = false;
+    {
+        QMutexLocker locker(&mutex);
+        queue.enqueue(msg);
+        if (!active)
+        {
+            active = true;
+            needStart = true;
+        }
+    }
+    if (needStart)
+    {
+        wait(); //the last run may still be on its way out
+        mAbort.storeRelaxed(0);
+        start(QThread::TimeCriticalPriority);
+    }
+}
+
+void ISOTPTransmitter::flowControl(int status, int blockSize, quint8 stMin)
+{
+    QMutexLocker locker(&mutex);
+    if (!waitingForFlow) return;
+    flows.enqueue({status, blockSize, stMin});
+    flowArrived.wakeAll();
+}
+
+void ISOTPTransmitter::abort()
+{
+    {
+        QMutexLocker locker(&mutex);
+        queue.clear();
+        mAbort.storeRelaxed(1);
+        flowArrived.wakeAll();
+    }
+    wait();
+}
+
+void ISOTPTransmitter::send(const CANFrame& header, const QByteArray& payload)
+{
+    CANFrame frame = header;
+    frame.setPayload(payload);
+    sendFrame(frame);
+}
+
+bool ISOTPTransmitter::waitForFlow(int timeoutMs, Flow& flow)
+{
+    QElapsedTimer waited;
+    waited.start();
+
+    QMutexLocker locker(&mutex);
+    while (flows.isEmpty() && !mAbort.loadRelaxed())
+    {
+        const qint64 remaining = timeoutMs - waited.elapsed();
+        if (remaining <= 0) return false;
+        flowArrived.wait(&mutex, (unsigned long)remaining);
+    }
+    if (flows.isEmpty()) return false;
+    flow = flows.dequeue();
+    return true;
+}
+
+void ISOTPTransmitter::run()
+{
+    while (!mAbort.loadRelaxed())
+    {
+        Pending msg;
+        {
+            QMutexLocker locker(&mutex);
+            if (queue.isEmpty())
+            {
+                active = false;
+                return;
+            }
+            msg = queue.head();
+            flows.clear();
+            waitingForFlow = true;
+        }
+
+        ISOTPTransmitStats stats;
+        stats.id = msg.header.frameId();
+        stats.bus = msg.header.bus;
+        stats.bytes = msg.bytes;
+        stats.completed = true;
+
+        const qint64 startNs = HiResClock::nowNs();
+        qint64 lastNs = startNs;    //when the last frame went out
+        send(msg.header, msg.frames[0]);
+        int next = 1;
+        int waits = 0;
+        bool firstFlow = true;
+
+        while (next < msg.frames.count() && !mAbort.loadRelaxed())
+        {
+            Flow flow;
+            if (!waitForFlow(firstFlow ? ISOTP_FIRST_FLOW_TIMEOUT_MS : ISOTP_FLOW_TIMEOUT_MS, flow))
+            {
+                if (!firstFlow || mAbort.loadRelaxed())
+                {
+                    stats.completed = false;
+                    break;
+                }
+                //nobody is answering. Send the lot anyway at a pace that should be OK for anything
+                qDebug() << "No ISO-TP flow control for" << QString::number(stats.id, 16) << "sending without it";
+                flow = {0, 0, ISOTP_NO_FLOW_STMIN};
+            }
+            firstFlow = false;
+
+            if (flow.status == 1) //wait. Nothing goes out until the next flow control frame
+            {
+                if (++waits > ISOTP_MAX_WAIT_FRAMES)
+                {
+                    stats.completed = false;
+                    break;
+                }
+                continue;
+            }
+            if (flow.status != 0) //overflow or abort
+            {
+                stats.completed = false;
+                break;
+            }
+            waits = 0;
+
+            //first consecutive frame goes right away, then each one no sooner than STmin after the one before
+            const qint64 separation = separationNs(flow.stMin);
+            for (int sent = 0; next < msg.frames.count() && (flow.blockSize == 0 || sent < flow.blockSize); sent++)
+            {
+                if (sent > 0)
+                {
+                    HiResClock::sleepUntil(lastNs + separation, HIRES_DEFAULT_SPIN_NS, &mAbort);
+                    if (mAbort.loadRelaxed()) break;
+                }
+                lastNs = HiResClock::nowNs();
+                send(msg.header, msg.frames[next++]);
+            }
+        }
+        if (next < msg.frames.count()) stats.completed = false;
+
+        stats.frames = next;
+        stats.elapsedNs = lastNs - startNs;
+
+        {
+            QMutexLocker locker(&mutex);
+            waitingForFlow = false;
+            if (!queue.isEmpty()) queue.dequeue();
+        }
+
+        emit transmitFinished(stats);
+    }
+
+    QMutexLocker locker(&mutex);
+    active = false;
+}
@@ -0,0 +1,123 @@
+#ifndef ISOTP_TRANSMITTER_H
+#define ISOTP_TRANSMITTER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QQueue>
+#include <QVector>
+#include <QMetaType>
+#include <functional>
+#include "can_structs.h"
+
+/* how long to wait for the first flow control frame before sending anyway. Same as the old timer code */
+#define ISOTP_FIRST_FLOW_TIMEOUT_MS 200
+/* separation used when the other side never sent flow control */
+#define ISOTP_NO_FLOW_STMIN         20
+/* N_Bs, how long to wait for flow control after a block or a wait frame */
+#define ISOTP_FLOW_TIMEOUT_MS       1000
+/* this many wait frames in a row and the transfer is given up (N_WFTmax) */
+#define ISOTP_MAX_WAIT_FRAMES       10
+/* biggest message a classic first frame can announce. Longer ones use the 32 bit escape */
+#define ISOTP_MAX_SHORT_LENGTH      4095
+
+/* what one multi frame transfer achieved */
+struct ISOTPTransmitStats
+{
+    uint32_t id;
+    int bus;
+    int bytes;
+    int frames;
+    qint64 elapsedNs;   //first frame out to last consecutive frame out
+    bool completed;     //false if it was aborted, overflowed or flow control never came after a block
+
+    double bytesPerSecond() const
+    {
+        if (elapsedNs <= 0) return 0.0;
+        return bytes * 1000000000.0 / elapsedNs;
+    }
+};
+
+Q_DECLARE_METATYPE(ISOTPTransmitStats)
+
+/*
+  Sends multi frame ISO-TP messages from its own thread so the block size and separation time the
+  receiver asks for in its flow control frames are honored exactly, including the 100 - 900 us codes.
+  Consecutive frames are timed with HiResClock, each one going out as soon as STmin has passed since the
+  one before.
+
+  Frame size is the ISO-TP TX_DL: 8 for classic CAN or up to 64 for CAN FD. Messages longer than 4095
+  bytes use the escaped first frame with a 32 bit length. Messages queued while one is going out are
+  sent one after the other in order.
+
+  The transmitter knows nothing about buses. Frames go to the send function it was made with, which is
+  also what lets it be tested without a connection. The send function is called from the transmitter's
+  thread (and from the caller's for single frames) so it has to be thread safe.
+*/
+class ISOTPTransmitter : public QThread
+{
+    Q_OBJECT
+
+public:
+    ISOTPTransmitter(std::function<void(const CANFrame&)> sender, QObject *parent = nullptr);
+    ~ISOTPTransmitter();
+
+    /**
+     * @brief queue a message. Single frame messages are sent right away from the calling thread
+     * @param header - bus, ID and frame format to send with. The payload is ignored
+     * @param frameSize - TX_DL, 8 or a CAN FD frame length up to 64
+     */
+    void transmit(const CANFrame& header, const QByteArray& data, int frameSize);
+
+    /**
+     * @brief hand over a received flow control frame. Thread safe
+     * @param status - 0 = continue, 1 = wait, 2 = overflow / abort
+     */
+    void flowControl(int status, int blockSize, quint8 stMin);
+
+    /* drops the current transfer and everything queued, then waits for the thread */
+    void abort();
+
+    /* payloads of the frames that carry data, first frame first. Short frames are padded */
+    static QVector<QByteArray> segment(const QByteArray& data, int frameSize);
+    /* separation time in ns an STmin byte stands for. Reserved values mean the maximum, 127 ms */
+    static qint64 separationNs(quint8 stMin);
+    /* CAN FD frames only come in some lengths, this is the next one up from len */
+    static int paddedLength(int len);
+
+signals:
+    void transmitFinished(ISOTPTransmitStats stats);
+
+protected:
+    void run() override;
+
+private:
+    struct Pending
+    {
+        CANFrame header;
+        QVector<QByteArray> frames;
+        int bytes;
+    };
+
+    struct Flow
+    {
+        int status;
+        int blockSize;
+        quint8 stMin;
+    };
+
+    bool waitForFlow(int timeoutMs, Flow& flow);
+    void send(const CANFrame& header, const QByteArray& payload);
+
+    std::function<void(const CANFrame&)> sendFrame;
+    QMutex mutex;
+    QWaitCondition flowArrived;
+    QQueue<Pending> queue;
+    QQueue<Flow> flows;
+    bool active;            //the thread is working through the queue or about to
+    bool waitingForFlow;
+    QAtomicInt mAbort;
+};
+
+#endif // ISOTP_TRANSMITTER_H
@@ -1,2 +1,126 @@
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 #include "j1939_handler.h"
+#include "mainwindow.h"
+#include "connections/canconmanager.h"
 
+J1939_HANDLER::J1939_HANDLER()
+{
+    isReceiving = false;
+    processAll = false;
+    captureRun = 0;
+
+    //there is no main window when the handler runs headless (tests)
+    MainWindow *mainWindow = MainWindow::getReference();
+    modelFrames = mainWindow ? mainWindow->getCANFrameModel()->getListReference() : nullptr;
+}
+
+J1939_HANDLER::~J1939_HANDLER()
+{
+    setReception(false);
+}
+
+void J1939_HANDLER::setReception(bool mode)
+{
+    if (isReceiving == mode) return;
+    isReceiving = mode;
+
+    if (isReceiving)
+    {
+        connect(CANConManager::getInstance(), &CANConManager::framesReceived, this, &J1939_HANDLER::rapidFrames);
+    }
+    else
+    {
+        disconnect(CANConManager::getInstance(), &CANConManager::framesReceived, this, &J1939_HANDLER::rapidFrames);
+    }
+}
+
+void J1939_HANDLER::setProcessAll(bool state)
+{
+    processAll = state;
+}
+
+void J1939_HANDLER::addPGNFilter(int pgn)
+{
+    pgnFilters.insert(pgn);
+}
+
+void J1939_HANDLER::removePGNFilter(int pgn)
+{
+    pgnFilters.remove(pgn);
+}
+
+void J1939_HANDLER::clearPGNFilters()
+{
+    pgnFilters.clear();
+}
+
+//remember, negative numbers are special -1 = all frames deleted, -2 = totally new set of frames.
+void J1939_HANDLER::updatedFrames(int numFrames)
+{
+    if (numFrames == -1) //all frames deleted
+    {
+        reassembler.clear();
+        captureRun++;
+    }
+    else if (numFrames == -2) //all new set of frames. Reset
+    {
+        reassembler.clear();
+        processCapture();
+    }
+    //new frames are taken in rapidFrames instead
+}
+
+void J1939_HANDLER::processCapture()
+{
+    const int run = ++captureRun;
+    if (!modelFrames) return;
+
+    //the model belongs to the GUI thread so the copy is taken there, which is implicitly shared until the model adds
+    //frames. Nothing waits for it: a script closing blocks the GUI thread on this one. The result comes back through the watcher
+    QFutureInterface<QVector<J1939_MESSAGE>> result;
+    result.reportStarted();
+    const QVector<CANFrame> *capture = modelFrames;
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [result, capture]()
+    {
+        const QVector<CANFrame> frames = *capture;
+        QtConcurrent::run([result, frames]() mutable
+        {
+            result.reportResult(J1939Reassembler::processCapture(frames));
+            result.reportFinished();
+        });
+    }, Qt::QueuedConnection);
+
+    QFutureWatcher<QVector<J1939_MESSAGE>> *watcher = new QFutureWatcher<QVector<J1939_MESSAGE>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, run]()
+    {
+        //a newer run or a clear came along in the meantime
+        if (run == captureRun)
+        {
+            finished += watcher->result();
+            emitFinished();
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(result.future());
+}
+
+void J1939_HANDLER::rapidFrames(const CANConnection* conn, const QVector<CANFrame>& pFrames)
+{
+    Q_UNUSED(conn)
+    if (pFrames.length() <= 0) return;
+
+    foreach(const CANFrame& thisFrame, pFrames) reassembler.addFrame(thisFrame, finished);
+    reassembler.expire(pFrames.last().timeStamp().seconds() * 1000000 + pFrames.last().timeStamp().microSeconds());
+    emitFinished();
+}
+
+void J1939_HANDLER::emitFinished()
+{
+    foreach (const J1939_MESSAGE &msg, finished)
+    {
+        if (processAll || pgnFilters.contains(msg.jid.pgn)) emit newJ1939Message(msg);
+    }
+    finished.clear();
+}
@@ -4,18 +4,51 @@
 #include <Qt>
 #include <QObject>
 #include <QDebug>
+#include <QSet>
 #include "can_structs.h"
+#include "j1939_message.h"
+#include "j1939_reassembler.h"
 
-struct J1939ID
+class CANConnection;
+
+/*
+  Turns frames into J1939 parameter groups, multi-packet transfers included. Works on live traffic once
+  reception is turned on and on the whole capture when it is loaded. Subscribe to PGNs with addPGNFilter
+  or take everything with setProcessAll.
+*/
+class J1939_HANDLER : public QObject
 {
+    Q_OBJECT
+
 public:
-    int src;
-    int dest;
-    int pgn;
-    int pf;
-    int ps;
-    int priority;
-    bool isBroadcast;
+    J1939_HANDLER();
+    ~J1939_HANDLER();
+    void setReception(bool mode); //set whether to accept and forward frames or not
+    void setProcessAll(bool state);
+    void addPGNFilter(int pgn);
+    void removePGNFilter(int pgn);
+    void clearPGNFilters();
+
+    /* runs the whole loaded capture through in the background, spread over all cores, and emits what it finds once done */
+    void processCapture();
+
+public slots:
+    void updatedFrames(int);
+    void rapidFrames(const CANConnection* conn, const QVector<CANFrame>& pFrames);
+
+signals:
+    void newJ1939Message(J1939_MESSAGE msg);
+
+private:
+    J1939Reassembler reassembler;
+    QVector<J1939_MESSAGE> finished;
+    QSet<int> pgnFilters;
+    const QVector<CANFrame> *modelFrames;
+    bool isReceiving;
+    bool processAll;
+    int captureRun;         //bumped by every processCapture and clear so results of an older run are dropped
+
+    void emitFinished();
 };
 
 #endif // J1939_HANDLER_H
@@ -0,0 +1,56 @@
+#ifndef J1939_MESSAGE_H
+#define J1939_MESSAGE_H
+
+#include <Qt>
+#include <can_structs.h>
+
+struct J1939ID
+{
+public:
+    int src;
+    int dest;
+    int pgn;
+    int pf;
+    int ps;
+    int priority;
+    bool isBroadcast;
+
+    /* splits a 29 bit ID. PDU1 PGNs (PF below 0xF0) don't include the destination byte */
+    static J1939ID fromFrameId(uint32_t id)
+    {
+        J1939ID jid;
+        jid.src = id & 0xFF;
+        jid.ps = (id >> 8) & 0xFF;
+        jid.pf = (id >> 16) & 0xFF;
+        jid.priority = (id >> 26) & 0x7;
+        jid.pgn = (id >> 8) & 0x3FFFF;
+        jid.isBroadcast = (jid.pf > 0xEF);
+        if (jid.isBroadcast) jid.dest = 0xFF;
+        else
+        {
+            jid.dest = jid.ps;
+            jid.pgn &= 0x3FF00;
+        }
+        return jid;
+    }
+
+    /* the 29 bit ID a frame with this PGN, priority, source and destination goes out with */
+    uint32_t toFrameId() const
+    {
+        uint32_t pgnField = pgn & 0x3FFFF;
+        if (((pgnField >> 8) & 0xFF) <= 0xEF) pgnField = (pgnField & 0x3FF00) | (dest & 0xFF);
+        return ((uint32_t)(priority & 0x7) << 26) | (pgnField << 8) | (src & 0xFF);
+    }
+};
+
+//A J1939 parameter group. Either a single frame or put back together from a TP or ETP transfer.
+//The frame ID and payload are what the group would be if it had fit into one frame.
+class J1939_MESSAGE : public CANFrame
+{
+public:
+    J1939ID jid;
+    int reportedLength;
+    bool isTransport;
+};
+
+#endif // J1939_MESSAGE_H
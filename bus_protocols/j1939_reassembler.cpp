@@ -0,0 +1,313 @@
+#include <QThread>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <cstring>
+#include "j1939_reassembler.h"
+
+namespace
+{
+    enum
+    {
+        TP_RTS = 16,
+        TP_CTS = 17,
+        TP_EOMA = 19,
+        TP_BAM = 32,
+        ETP_RTS = 20,
+        ETP_CTS = 21,
+        ETP_DPO = 22,
+        ETP_EOMA = 23,
+        TP_ABORT = 255
+    };
+
+    inline qint64 frameTimeUs(const CANFrame& frame)
+    {
+        return frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+    }
+}
+
+J1939Reassembler::J1939Reassembler()
+{
+    openSessions = 0;
+}
+
+void J1939Reassembler::clear()
+{
+    index.clear();
+    sessions.clear();
+    openSessions = 0;
+}
+
+int J1939Reassembler::getOpenSessions() const
+{
+    return openSessions;
+}
+
+bool J1939Reassembler::isTransportPGN(int pgn)
+{
+    return pgn == J1939_PGN_TP_CM || pgn == J1939_PGN_TP_DT || pgn == J1939_PGN_ETP_CM || pgn == J1939_PGN_ETP_DT;
+}
+
+quint64 J1939Reassembler::sessionKey(int bus, int src, int dest, bool etp)
+{
+    return ((quint64)(quint32)bus << 24) | (src << 16) | (dest << 8) | (etp ? 1 : 0);
+}
+
+J1939Reassembler::Session *J1939Reassembler::findSession(int bus, int src, int dest, bool etp)
+{
+    QHash<quint64, int>::const_iterator it = index.constFind(sessionKey(bus, src, dest, etp));
+    if (it == index.constEnd()) return nullptr;
+    return &sessions[it.value()];
+}
+
+void J1939Reassembler::close(Session& sess)
+{
+    if (!sess.active) return;
+    sess.active = false;
+    sess.data = QByteArray();
+    sess.gotPacket = QVector<bool>();
+    openSessions--;
+}
+
+void J1939Reassembler::open(const CANFrame& frame, const J1939ID& jid, bool etp, bool broadcast, int length, int pgn)
+{
+    Session *sess = findSession(frame.bus, jid.src, jid.dest, etp);
+    if (!sess)
+    {
+        index.insert(sessionKey(frame.bus, jid.src, jid.dest, etp), sessions.count());
+        sessions.append(Session());
+        sess = &sessions.last();
+        sess->active = false;
+    }
+    close(*sess); //a sender announcing again has given up on the last one
+
+    sess->active = true;
+    sess->broadcast = broadcast;
+    sess->bus = frame.bus;
+    sess->src = jid.src;
+    sess->dest = jid.dest;
+    sess->pgn = pgn;
+    sess->priority = jid.priority;
+    sess->length = length;
+    sess->packets = (length + 6) / 7;
+    sess->packetsReceived = 0;
+    sess->nextPacket = 1;
+    sess->offset = 0;
+    sess->lastUs = frameTimeUs(frame);
+    sess->started = frame.timeStamp();
+    sess->data = QByteArray(length, 0);
+    sess->gotPacket = QVector<bool>(sess->packets, false);
+    openSessions++;
+}
+
+void J1939Reassembler::control(const CANFrame& frame, const J1939ID& jid, bool etp)
+{
+    const QByteArray payload = frame.payload();
+    if (payload.length() < 8) return;
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    const int pgn = data[5] | (data[6] << 8) | (data[7] << 16);
+    Session *sess;
+
+    switch (data[0])
+    {
+    case TP_RTS:
+    case TP_BAM:
+    {
+        if (etp) return;
+        const int length = data[1] | (data[2] << 8);
+        if (length < 9 || length > J1939_TP_MAX_LENGTH) return;
+        open(frame, jid, false, data[0] == TP_BAM, length, pgn);
+        break;
+    }
+    case ETP_RTS:
+    {
+        if (!etp) return;
+        const quint32 length = data[1] | (data[2] << 8) | (data[3] << 16) | ((quint32)data[4] << 24);
+        if (length < 9 || length > J1939_MAX_RX_LENGTH) return;
+        open(frame, jid, true, false, (int)length, pgn);
+        break;
+    }
+    case TP_CTS:
+    case ETP_CTS:
+        //comes from the receiving end. The transfer is still alive
+        sess = findSession(frame.bus, jid.dest, jid.src, etp);
+        if (sess && sess->active) sess->lastUs = frameTimeUs(frame);
+        break;
+    case ETP_DPO:
+        if (!etp) return;
+        sess = findSession(frame.bus, jid.src, jid.dest, true);
+        if (!sess || !sess->active) return;
+        sess->offset = data[2] | (data[3] << 8) | (data[4] << 16);
+        sess->lastUs = frameTimeUs(frame);
+        break;
+    case TP_EOMA:
+    case ETP_EOMA:
+        //the receiver thinks it is done. If we are still missing packets we never will have them
+        sess = findSession(frame.bus, jid.dest, jid.src, etp);
+        if (sess) close(*sess);
+        break;
+    case TP_ABORT:
+        //either end can abort
+        sess = findSession(frame.bus, jid.src, jid.dest, etp);
+        if (sess) close(*sess);
+        sess = findSession(frame.bus, jid.dest, jid.src, etp);
+        if (sess) close(*sess);
+        break;
+    }
+}
+
+void J1939Reassembler::dataPacket(const CANFrame& frame, const J1939ID& jid, bool etp, QVector<J1939_MESSAGE>& out)
+{
+    const QByteArray payload = frame.payload();
+    if (payload.length() < 2) return;
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+
+    Session *sess = findSession(frame.bus, jid.src, jid.dest, etp);
+    if (!sess || !sess->active) return;
+
+    const qint64 now = frameTimeUs(frame);
+    if ((now - sess->lastUs) > (sess->broadcast ? J1939_BAM_TIMEOUT_US : J1939_CONN_TIMEOUT_US))
+    {
+        close(*sess);
+        return;
+    }
+
+    const int seq = data[0];
+    if (sess->broadcast && seq != sess->nextPacket)
+    {
+        close(*sess); //broadcasts can't resend so a missed packet ruins the lot
+        return;
+    }
+    const int packet = sess->offset + seq - 1;
+    if (seq == 0 || packet >= sess->packets) return;
+
+    sess->nextPacket = seq + 1;
+    sess->lastUs = now;
+    if (!sess->gotPacket[packet])
+    {
+        sess->gotPacket[packet] = true;
+        sess->packetsReceived++;
+    }
+    const int pos = packet * 7;
+    const int chunk = qMin(qMin(7, sess->length - pos), payload.length() - 1);
+    memcpy(sess->data.data() + pos, data + 1, chunk);
+
+    if (sess->packetsReceived < sess->packets) return;
+
+    J1939_MESSAGE msg;
+    msg.jid.src = sess->src;
+    msg.jid.dest = sess->dest;
+    msg.jid.pgn = sess->pgn;
+    msg.jid.priority = sess->priority;
+    msg.jid.pf = (sess->pgn >> 8) & 0xFF;
+    msg.jid.isBroadcast = (msg.jid.pf > 0xEF);
+    msg.jid.ps = msg.jid.isBroadcast ? (sess->pgn & 0xFF) : sess->dest;
+    msg.bus = sess->bus;
+    msg.isReceived = frame.isReceived;
+    msg.setFrameType(QCanBusFrame::DataFrame);
+    msg.setExtendedFrameFormat(true);
+    msg.setFrameId(msg.jid.toFrameId());
+    msg.setTimeStamp(sess->started);
+    msg.setPayload(sess->data);
+    msg.reportedLength = sess->length;
+    msg.isTransport = true;
+    out.append(msg);
+    close(*sess);
+}
+
+void J1939Reassembler::addFrame(const CANFrame& frame, QVector<J1939_MESSAGE>& out)
+{
+    if (!frame.hasExtendedFrameFormat() || frame.frameType() != QCanBusFrame::DataFrame) return;
+
+    const J1939ID jid = J1939ID::fromFrameId(frame.frameId());
+    switch (jid.pgn)
+    {
+    case J1939_PGN_TP_CM:
+        control(frame, jid, false);
+        return;
+    case J1939_PGN_ETP_CM:
+        control(frame, jid, true);
+        return;
+    case J1939_PGN_TP_DT:
+        dataPacket(frame, jid, false, out);
+        return;
+    case J1939_PGN_ETP_DT:
+        dataPacket(frame, jid, true, out);
+        return;
+    }
+
+    J1939_MESSAGE msg;
+    static_cast<CANFrame &>(msg) = frame;
+    msg.jid = jid;
+    msg.reportedLength = frame.payload().length();
+    msg.isTransport = false;
+    out.append(msg);
+}
+
+void J1939Reassembler::expire(qint64 nowUs)
+{
+    if (openSessions == 0) return;
+    for (int i = 0; i < sessions.count(); i++)
+    {
+        Session &sess = sessions[i];
+        if (!sess.active) continue;
+        if ((nowUs - sess.lastUs) > (sess.broadcast ? J1939_BAM_TIMEOUT_US : J1939_CONN_TIMEOUT_US)) close(sess);
+    }
+}
+
+QVector<J1939_MESSAGE> J1939Reassembler::processCapture(const QVector<CANFrame>& frames)
+{
+    struct Found
+    {
+        QVector<int> at;    //frame that finished each message
+        QVector<J1939_MESSAGE> msgs;
+    };
+
+    //everything two nodes say to each other lands in the same part so transfers stay whole
+    const int parts = qMax(1, QThread::idealThreadCount());
+    QVector<QVector<int>> buckets(parts);
+    for (int i = 0; i < frames.count(); i++)
+    {
+        const CANFrame &frame = frames[i];
+        if (!frame.hasExtendedFrameFormat()) continue;
+        const J1939ID jid = J1939ID::fromFrameId(frame.frameId());
+        const int other = isTransportPGN(jid.pgn) ? jid.dest : jid.src;
+        const quint32 pair = ((quint32)(quint16)frame.bus << 16) | (qMin(jid.src, other) << 8) | qMax(jid.src, other);
+        buckets[pair % parts].append(i);
+    }
+
+    QVector<Found> found(parts);
+    QVector<QFuture<void>> jobs;
+    for (int p = 0; p < parts; p++)
+    {
+        if (buckets[p].isEmpty()) continue;
+        jobs.append(QtConcurrent::run([&frames, &buckets, &found, p]()
+        {
+            J1939Reassembler rx;
+            Found &result = found[p];
+            foreach (int idx, buckets[p])
+            {
+                rx.addFrame(frames[idx], result.msgs);
+                while (result.at.count() < result.msgs.count()) result.at.append(idx);
+            }
+        }));
+    }
+    for (int j = 0; j < jobs.count(); j++) jobs[j].waitForFinished();
+
+    //back into capture order
+    struct Ref
+    {
+        int at;
+        int part;
+        int msg;
+    };
+    QVector<Ref> order;
+    for (int p = 0; p < parts; p++)
+        for (int m = 0; m < found[p].msgs.count(); m++) order.append({found[p].at[m], p, m});
+    std::sort(order.begin(), order.end(), [](const Ref &a, const Ref &b) { return a.at < b.at; });
+
+    QVector<J1939_MESSAGE> msgs;
+    msgs.reserve(order.count());
+    foreach (const Ref &ref, order) msgs.append(found[ref.part].msgs[ref.msg]);
+    return msgs;
+}
@@ -0,0 +1,94 @@
+#ifndef J1939_REASSEMBLER_H
+#define J1939_REASSEMBLER_H
+
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include "can_structs.h"
+#include "j1939_message.h"
+
+#define J1939_PGN_TP_CM         0xEC00
+#define J1939_PGN_TP_DT         0xEB00
+#define J1939_PGN_ETP_CM        0xC800
+#define J1939_PGN_ETP_DT        0xC700
+
+/* biggest transfer TP can do, 255 packets of 7 bytes. Anything larger goes over ETP */
+#define J1939_TP_MAX_LENGTH     1785
+/* ETP transfers announcing more than this are ignored rather than allocated */
+#define J1939_MAX_RX_LENGTH     (16 * 1024 * 1024)
+/* T1, longest gap between the packets of a broadcast. In frame time */
+#define J1939_BAM_TIMEOUT_US    750000
+/* T2 / T3, longest a connection mode transfer may stall waiting for data or clear to send */
+#define J1939_CONN_TIMEOUT_US   1250000
+
+/*
+  Puts J1939 multi-packet transfers back together while watching the bus: BAM broadcasts, RTS/CTS
+  connection mode transfers and ETP transfers over 1785 bytes. Every other extended frame comes out as a
+  single frame parameter group.
+
+  The data packets don't say which PGN they belong to, only who sent them to whom, so sessions are kept
+  per (bus, source, destination, TP or ETP) and the PGN comes from the announcement that opened the session.
+  A sender can only run one of each per destination at a time, so that is enough to tell transfers of
+  different PGNs apart. The buffer is allocated at the announced size and packets are copied into place by
+  their sequence number, so packets sent again after a CTS just overwrite themselves. Aborts from either
+  side, a new announcement or stalling past the J1939-21 timeouts (in frame time) end a session.
+
+  processCapture does a whole capture at once. Frames are split up by the pair of nodes talking so every
+  transfer stays together, the pieces run on the thread pool and the results are put back in capture order.
+*/
+class J1939Reassembler
+{
+public:
+    J1939Reassembler();
+
+    void clear();
+
+    /**
+     * @brief feed one frame
+     * @param out - appended with the parameter group this frame finished, if any
+     */
+    void addFrame(const CANFrame& frame, QVector<J1939_MESSAGE>& out);
+
+    /* drops transfers that have stalled as of nowUs */
+    void expire(qint64 nowUs);
+
+    /* transfers currently being received */
+    int getOpenSessions() const;
+
+    static QVector<J1939_MESSAGE> processCapture(const QVector<CANFrame>& frames);
+    static bool isTransportPGN(int pgn);
+
+private:
+    struct Session
+    {
+        bool active;
+        bool broadcast;
+        int bus;
+        int src;
+        int dest;
+        int pgn;
+        int priority;
+        int length;
+        int packets;
+        int packetsReceived;
+        int nextPacket;         //BAM packets have to come in order
+        int offset;             //ETP, packets before the current data packet offset
+        qint64 lastUs;
+        QCanBusFrame::TimeStamp started;
+        QByteArray data;
+        QVector<bool> gotPacket;
+    };
+
+    static quint64 sessionKey(int bus, int src, int dest, bool etp);
+    Session *findSession(int bus, int src, int dest, bool etp);
+    void open(const CANFrame& frame, const J1939ID& jid, bool etp, bool broadcast, int length, int pgn);
+    void close(Session& sess);
+    void control(const CANFrame& frame, const J1939ID& jid, bool etp);
+    void dataPacket(const CANFrame& frame, const J1939ID& jid, bool etp, QVector<J1939_MESSAGE>& out);
+
+    QHash<quint64, int> index;
+    QVector<Session> sessions;
+    int openSessions;
+};
+
+#endif // J1939_REASSEMBLER_H
@@ -173,8 +173,11 @@ UDS_HANDLER::UDS_HANDLER()
 {
     isReceiving = false;
     useExtendedAddressing = false;
-    modelFrames = MainWindow::getReference()->getCANFrameModel()->getListReference();
+    //there is no main window when the handler runs headless (tests)
+    MainWindow *mainWindow = MainWindow::getReference();
+    modelFrames = mainWindow ? mainWindow->getCANFrameModel()->getListReference() : nullptr;
     isoHandler = new ISOTP_HANDLER();
+    connect(isoHandler, &ISOTP_HANDLER::transmitFinished, this, &UDS_HANDLER::transmitFinished);
 }
 
 UDS_HANDLER::~UDS_HANDLER()
@@ -251,6 +254,16 @@ void UDS_HANDLER::setFlowCtrl(bool state)
     isoHandler->setFlowCtrl(state);
 }
 
+void UDS_HANDLER::setFrameSender(ISOTP_HANDLER::FrameSender sender)
+{
+    isoHandler->setFrameSender(sender);
+}
+
+void UDS_HANDLER::setFrameSize(int size)
+{
+    isoHandler->setFrameSize(size);
+}
+
 void UDS_HANDLER::setReception(bool mode)
 {
     if (isReceiving == mode) return;
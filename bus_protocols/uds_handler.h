@@ -94,6 +94,8 @@ public:
     void sendUDSFrame(const UDS_MESSAGE &msg);
     void setProcessAllIDs(bool state);
     void setFlowCtrl(bool state);
+    void setFrameSender(ISOTP_HANDLER::FrameSender sender); //see ISOTP_HANDLER::setFrameSender
+    void setFrameSize(int size); //see ISOTP_HANDLER::setFrameSize
     void addFilter(uint32_t pBusId, uint32_t ID, uint32_t mask);
     void removeFilter(uint32_t pBusId, uint32_t ID, uint32_t mask);
     void clearAllFilters();
@@ -112,6 +114,7 @@ public slots:
 
 signals:
     void newUDSMessage(UDS_MESSAGE msg);
+    void transmitFinished(ISOTPTransmitStats stats); //a multi frame request went out, or was given up
 
 private:
     QList<ISOTP_MESSAGE> messageBuffer;
@@ -41,6 +41,7 @@ public:
     quint32 id;
     quint32 mask;
     QObject * observer; //used to target the specific object that setup this filter
+    Qt::ConnectionType connType; //how gotTargettedFrame is called. Not part of the comparison below
 
     bool operator ==(const CANFltObserver &b) const
     {
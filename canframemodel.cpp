@@ -5,12 +5,15 @@
 #include <QPalette>
 #include <QDateTime>
 #include <QSettings>
+#include <algorithm>
 #include "utility.h"
 
 CANFrameModel::~CANFrameModel()
 {
     frames.clear();
     filteredFrames.clear();
+    idRows.clear();
+    idStats.clear();
     filters.clear();
     busFilters.clear();
 }
@@ -176,6 +179,7 @@ void CANFrameModel::normalizeTiming()
         }
         frames[i].setTimeStamp(QCanBusFrame::TimeStamp(0, thisStamp));
     }
+    rebuildIDIndex(); //first and last stamps moved
 
     this->beginResetModel();
     for (int i = 0; i < filteredFrames.count(); i++)
@@ -689,6 +693,7 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
         try
         {
             frames.append(tempFrame);
+            indexRow(frames.count() - 1);
 
             if (filters[tempFrame.frameId()] && busFilters[tempFrame.bus])
             {
@@ -729,6 +734,7 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
             }
         }
         frames.append(tempFrame);
+        indexRow(frames.count() - 1);
         if (!found)
         {
             //frames.append(tempFrame);
@@ -766,6 +772,7 @@ void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFr
         mutex.lock();
         qDebug() << "Frames count: " << frames.length() << " of " << frames.capacity() << " capacity, removing first " << (int)(frames.capacity() * 0.05) << " frames";
         frames.remove(0, (int)(frames.capacity() * 0.05));
+        rebuildIDIndex();
         qDebug() << "Frames removed, new count: " << frames.length();
         mutex.unlock();
     }
@@ -783,6 +790,7 @@ void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFr
     {
         addFrame(frame);
     }
+    flushNewIDs();
     if (overwriteDups) //if in overwrite mode we'll update every time frames come in
     {
         beginResetModel();
@@ -855,6 +863,10 @@ void CANFrameModel::clearFrames()
     this->beginResetModel();
     frames.clear();
     filteredFrames.clear();
+    idRows.clear();
+    indexedBuses.clear();
+    idStats.clear();
+    pendingNewIDs.clear();
     if(filtersPersistDuringClear == false)
     {
         filters.clear();
@@ -885,6 +897,7 @@ void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
     for (int i = 0; i < newFrames.count(); i++)
     {
         frames.append(newFrames[i]);
+        indexRow(frames.count() - 1);
         if (!filters.contains(newFrames[i].frameId()))
         {
             filters.insert(newFrames[i].frameId(), true);
@@ -903,25 +916,139 @@ void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
     }
     lastUpdateNumFrames = newFrames.count();
     mutex.unlock();
+    flushNewIDs();
     //endResetModel();
     //beginInsertRows(QModelIndex(), filteredFrames.count() + 1, filteredFrames.count() + insertedFiltered);
     //endInsertRows();
     if (needFilterRefresh) emit updatedFiltersList();
 }
 
+/*
+ * Row of the last frame with this ID at or before the given time (in seconds), or -1.
+ * Frames of one ID arrive in time order so the row list can be binary searched.
+*/
 int CANFrameModel::getIndexFromTimeID(unsigned int ID, double timestamp)
 {
-    int bestIndex = -1;
     int64_t intTimeStamp = static_cast<int64_t> (timestamp * 1000000l);
-    for (int i = 0; i < frames.count(); i++)
+    const QVector<int> rows = getRowsForID(ID);
+
+    auto it = std::upper_bound(rows.constBegin(), rows.constEnd(), intTimeStamp,
+                               [this](int64_t stamp, int row) { return stamp < frames[row].timeStamp().microSeconds(); });
+    if (it == rows.constBegin()) return -1;
+    return *(it - 1);
+}
+
+/*
+ * Posting lists of the rows in frames for every bus/ID pair. They're appended to as frames come in
+ * so a window switching to another ID doesn't need to scan the whole capture to find its frames.
+*/
+void CANFrameModel::indexRow(int row)
+{
+    const CANFrame &frame = frames[row];
+    const int64_t stamp = frame.timeStamp().microSeconds();
+    idRows[idIndexKey(frame.bus, frame.frameId())].append(row);
+    indexedBuses.insert(frame.bus);
+
+    auto it = idStats.find(frame.frameId());
+    if (it == idStats.end())
+    {
+        CANIDStats stats;
+        stats.count = 1;
+        stats.firstStamp = stamp;
+        stats.lastStamp = stamp;
+        idStats.insert(frame.frameId(), stats);
+        pendingNewIDs.append(frame.frameId());
+    }
+    else
+    {
+        it->count++;
+        it->lastStamp = stamp;
+    }
+}
+
+void CANFrameModel::rebuildIDIndex()
+{
+    idRows.clear();
+    indexedBuses.clear();
+    idStats.clear();
+    for (int i = 0; i < frames.count(); i++) indexRow(i);
+    pendingNewIDs.clear(); //not new, just recounted
+}
+
+//tell listeners about the IDs that showed up in the last batch so they only add those to their lists
+void CANFrameModel::flushNewIDs()
+{
+    if (pendingNewIDs.isEmpty()) return;
+    QVector<uint32_t> newIDs;
+    newIDs.swap(pendingNewIDs);
+    std::sort(newIDs.begin(), newIDs.end());
+    emit idsAdded(newIDs);
+}
+
+/*
+ * Every ID in ascending order. Straight from the registry for our own list, windows looking
+ * at some other list get it scanned instead.
+*/
+QVector<uint32_t> CANFrameModel::getUniqueIDs(const QVector<CANFrame> *list) const
+{
+    QVector<uint32_t> ids;
+
+    if (list && list != &frames)
+    {
+        QSet<uint32_t> seen;
+        for (int i = 0; i < list->count(); i++) seen.insert(list->at(i).frameId());
+        ids.reserve(seen.count());
+        foreach (uint32_t id, seen) ids.append(id);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    ids.reserve(idStats.count());
+    for (auto it = idStats.constBegin(); it != idStats.constEnd(); ++it) ids.append(it.key());
+    return ids;
+}
+
+/*
+ * Rows in the full frame list for one bus/ID pair in capture order. nullptr if there are none.
+ * Same rules as getListReference, read only and only valid until frames are added or cleared.
+*/
+const QVector<int>* CANFrameModel::getRowsForBusID(int bus, uint32_t ID) const
+{
+    auto it = idRows.constFind(idIndexKey(bus, ID));
+    if (it == idRows.constEnd()) return nullptr;
+    return &it.value();
+}
+
+/*
+ * Rows of every frame with this ID on any bus, in capture order. Windows that may have been handed
+ * some other list than ours (the filtered list for instance) pass it in. Then it gets scanned instead.
+*/
+QVector<int> CANFrameModel::getRowsForID(uint32_t ID, const QVector<CANFrame> *list) const
+{
+    QVector<int> rows;
+
+    if (list && list != &frames)
+    {
+        for (int i = 0; i < list->count(); i++)
+        {
+            if (list->at(i).frameId() == ID) rows.append(i);
+        }
+        return rows;
+    }
+
+    foreach (int bus, indexedBuses)
     {
-        if ((frames[i].frameId() == ID))
+        const QVector<int> *busRows = getRowsForBusID(bus, ID);
+        if (!busRows) continue;
+        if (rows.isEmpty()) rows = *busRows; //implicitly shared, the usual single bus case copies nothing
+        else
         {
-            if (frames[i].timeStamp().microSeconds() <= intTimeStamp) bestIndex = i;
-            else break; //drop out of loop as soon as we pass the proper timestamp
+            QVector<int> merged(rows.count() + busRows->count());
+            std::merge(rows.constBegin(), rows.constEnd(), busRows->constBegin(), busRows->constEnd(), merged.begin());
+            rows.swap(merged);
         }
     }
-    return bestIndex;
+    return rows;
 }
 
 void CANFrameModel::loadFilterFile(QString filename)
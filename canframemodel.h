@@ -6,6 +6,8 @@
 #include <QVector>
 #include <QDebug>
 #include <QMutex>
+#include <QHash>
+#include <QSet>
 #include "can_structs.h"
 #include "dbc/dbchandler.h"
 #include "connections/canconnection.h"
@@ -24,6 +26,14 @@ enum class Column {
     NUM_COLUMN
 };
 
+//what the model knows about one ID across all buses
+struct CANIDStats
+{
+    quint64 count;
+    int64_t firstStamp;
+    int64_t lastStamp;
+};
+
 class CANFrameModel: public QAbstractTableModel
 {
     Q_OBJECT
@@ -63,6 +73,9 @@ public:
     void insertFrames(const QVector<CANFrame> &newFrames);
     void sortByColumn(int column);
     int getIndexFromTimeID(unsigned int ID, double timestamp);
+    const QVector<int> *getRowsForBusID(int bus, uint32_t ID) const;
+    QVector<int> getRowsForID(uint32_t ID, const QVector<CANFrame> *list = nullptr) const;
+    QVector<uint32_t> getUniqueIDs(const QVector<CANFrame> *list = nullptr) const;
     const QVector<CANFrame> *getListReference() const; //thou shalt not modify these frames externally!
     const QVector<CANFrame> *getFilteredListReference() const; //Thus saith the Lord, NO.
     const QMap<int, bool> *getFiltersReference() const; //this neither
@@ -74,6 +87,7 @@ public slots:
 
 signals:
     void updatedFiltersList();
+    void idsAdded(const QVector<uint32_t> &newIDs); //IDs seen for the first time since the last emit, ascending
 
 private:
     void qSortCANFrameAsc(QVector<CANFrame>* frames, Column column, int lowerBound, int upperBound);
@@ -81,9 +95,17 @@ private:
     uint64_t getCANFrameVal(QVector<CANFrame> *frames, int row, Column col);
     bool any_filters_are_configured(void);
     bool any_busfilters_are_configured(void);
+    void indexRow(int row);
+    void rebuildIDIndex();
+    void flushNewIDs();
+    static quint64 idIndexKey(int bus, uint32_t ID) { return (static_cast<quint64>(static_cast<uint32_t>(bus)) << 32) | ID; }
 
     QVector<CANFrame> frames;
     QVector<CANFrame> filteredFrames;
+    QHash<quint64, QVector<int>> idRows; //rows in frames for each bus/ID pair, always ascending
+    QSet<int> indexedBuses;
+    QMap<uint32_t, CANIDStats> idStats; //unique ID registry, sorted by ID
+    QVector<uint32_t> pendingNewIDs;
     QMap<int, bool> filters;
     QMap<int, bool> busFilters;
     DBCHandler *dbcHandler;
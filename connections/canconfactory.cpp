@@ -7,6 +7,8 @@
 #include "lawicel_serial.h"
 #include "canserver.h"
 #include "canlogserver.h"
+#include "simulatedconnection.h"
+#include "framefileio.h"
 
 using namespace CANCon;
 
@@ -32,6 +34,17 @@ CANConnection* CanConFactory::create(type pType, QString pPortName, QString pDri
         return new CANserver(pPortName);
     case CANLOGSERVER:
         return new CanLogServer(pPortName);
+    case SIMULATED: {
+        SimulatedConnection* sim_p = new SimulatedConnection(pPortName);
+        /* files are loaded here, in the GUI thread, since the loaders may pop up dialogs */
+        if (!sim_p->getReplayFile().isEmpty())
+        {
+            QVector<CANFrame> frames;
+            if (FrameFileIO::autoDetectLoadFile(sim_p->getReplayFile(), &frames))
+                sim_p->setReplayFrames(frames);
+        }
+        return sim_p;
+    }
     default: {}
     }
 
@@ -4,6 +4,7 @@
 
 #include "canconmanager.h"
 #include "canconfactory.h"
+#include "cantimebase.h"
 
 CANConManager* CANConManager::mInstance = nullptr;
 
@@ -17,6 +18,11 @@ CANConManager* CANConManager::getInstance()
 
 CANConManager::CANConManager(QObject *parent): QObject(parent)
 {
+    /* framesReceived is also delivered queued to handlers living on other threads (scripts) */
+    qRegisterMetaType<CANFrame>("CANFrame");
+    qRegisterMetaType<QVector<CANFrame>>("QVector<CANFrame>");
+    qRegisterMetaType<CANConnection*>("CANConnection*");
+
     connect(&mTimer, SIGNAL(timeout()), this, SLOT(refreshCanList()));
     mTimer.setInterval(20); /*Tick 50 times per second to allow for good resolution in reception where needed. GUI updates *MUCH* more slowly*/
     mTimer.setSingleShot(false);
@@ -37,8 +43,7 @@ CANConManager::CANConManager(QObject *parent): QObject(parent)
 
 void CANConManager::resetTimeBasis()
 {
-    mTimestampBasis = QDateTime::currentMSecsSinceEpoch() * 1000;
-    mElapsedTimer.restart();
+    CANTimebase::reset();
 }
 
 CANConManager::~CANConManager()
@@ -57,6 +62,7 @@ void CANConManager::stopAllConnections()
 
 void CANConManager::add(CANConnection* pConn_p)
 {
+    QMutexLocker locker(&mConnsMutex);
     mConns.append(pConn_p);
 }
 
@@ -64,19 +70,28 @@ void CANConManager::add(CANConnection* pConn_p)
 void CANConManager::remove(CANConnection* pConn_p)
 {
     //disconnect(pConn_p, 0, this, 0);
+    QMutexLocker locker(&mConnsMutex);
     mConns.removeOne(pConn_p);
+    //no new sends can find it now but ones already started still have to finish before the caller deletes it
+    while (mSending.contains(pConn_p)) mSendDone.wait(&mConnsMutex);
 }
 
 void CANConManager::replace(int idx, CANConnection* pConn_p)
 {
-    CANConnection *original = mConns[idx];
-    mConns.replace(idx, pConn_p);
+    CANConnection *original;
+    {
+        QMutexLocker locker(&mConnsMutex);
+        original = mConns[idx];
+        mConns.replace(idx, pConn_p);
+        while (mSending.contains(original)) mSendDone.wait(&mConnsMutex);
+    }
     delete original; original = NULL;
 }
 
 //Get total number of buses currently registered with the program
 int CANConManager::getNumBuses()
 {
+    QMutexLocker locker(&mConnsMutex);
     int buses = 0;
     foreach(CANConnection* conn_p, mConns)
     {
@@ -87,6 +102,7 @@ int CANConManager::getNumBuses()
 
 int CANConManager::getBusBase(CANConnection *which)
 {
+    QMutexLocker locker(&mConnsMutex);
     int buses = 0;
     foreach(CANConnection* conn_p, mConns)
     {
@@ -100,15 +116,15 @@ void CANConManager::refreshCanList()
 {
     QObject* sender_p = QObject::sender();
 
+    //only this thread changes mConns so it can read it without the lock. buslessFrames is filled from any thread
     if (mConns.count() == 0)
     {
         tempFrames.clear();
-        //TODO: Seems to crash under heavy load. Find out why.
-        if(buslessFrames.size()) {            
-            tempFrames = buslessFrames; //make a copy and pass that copy
-            buslessFrames.clear(); //delete all frames from the original
-            emit framesReceived(nullptr, tempFrames);
+        {
+            QMutexLocker locker(&mConnsMutex);
+            tempFrames.swap(buslessFrames);
         }
+        if (tempFrames.size()) emit framesReceived(nullptr, tempFrames);
         return;
     }
 
@@ -121,14 +137,61 @@ void CANConManager::refreshCanList()
     }
     else
     {
-        foreach (CANConnection* conn_p, mConns)
-            refreshConnection((CANConnection*)conn_p);
+        updateActiveBuses();
+
+        /* every connection stamps through CANTimebase and its output is monotonic so merging the
+           per connection runs is enough to get one capture ordered by time. No sort needed. */
+        int lastIdx = -1;
+        int nonEmpty = 0;
+        mergeSources.resize(mConns.count());
+        for (int i = 0; i < mConns.count(); i++)
+        {
+            mergeSources[i].clear();
+            drainConnection(mConns[i], mergeSources[i]);
+            if (mergeSources[i].count())
+            {
+                nonEmpty++;
+                lastIdx = i;
+            }
+        }
+
+        if (nonEmpty == 0) return;
+        if (nonEmpty == 1)
+        {
+            emit framesReceived(mConns[lastIdx], mergeSources[lastIdx]);
+            return;
+        }
+
+        QVector<CANFrame> merged;
+        QVector<int> heads(mergeSources.count(), 0);
+        int total = 0;
+        for (int i = 0; i < mergeSources.count(); i++) total += mergeSources[i].count();
+        merged.reserve(total);
+
+        while (merged.count() < total)
+        {
+            int best = -1;
+            qint64 bestStamp = 0;
+            for (int i = 0; i < mergeSources.count(); i++)
+            {
+                if (heads[i] >= mergeSources[i].count()) continue;
+                qint64 stamp = mergeSources[i][heads[i]].timeStamp().microSeconds();
+                if (best == -1 || stamp < bestStamp)
+                {
+                    best = i;
+                    bestStamp = stamp;
+                }
+            }
+            merged.append(mergeSources[best][heads[best]++]);
+        }
+
+        emit framesReceived(nullptr, merged);
     }
 }
 
 uint64_t CANConManager::getTimeBasis()
 {
-    return mTimestampBasis;
+    return CANTimebase::getBasis();
 }
 
 QList<CANConnection*>& CANConManager::getConnections()
@@ -139,6 +202,7 @@ QList<CANConnection*>& CANConManager::getConnections()
 
 CANConnection* CANConManager::getByName(const QString& pName) const
 {
+    QMutexLocker locker(&mConnsMutex);
     foreach(CANConnection* conn_p, mConns)
     {
         if(conn_p->getPort() == pName)
@@ -149,7 +213,7 @@ CANConnection* CANConManager::getByName(const QString& pName) const
 }
 
 
-void CANConManager::refreshConnection(CANConnection* pConn_p)
+void CANConManager::updateActiveBuses()
 {
     unsigned int buses = 0;
     foreach(CANConnection* conn_p, mConns)
@@ -161,11 +225,26 @@ void CANConManager::refreshConnection(CANConnection* pConn_p)
         mNumActiveBuses = buses;
         emit connectionStatusUpdated(buses);
     }
+}
 
+
+void CANConManager::refreshConnection(CANConnection* pConn_p)
+{
+    updateActiveBuses();
+
+    QVector<CANFrame> frames;
+    drainConnection(pConn_p, frames);
+
+    if(frames.size())
+        emit framesReceived(pConn_p, frames);
+}
+
+
+void CANConManager::drainConnection(CANConnection* pConn_p, QVector<CANFrame>& frames)
+{
     if (pConn_p->getQueue().peek() == nullptr) return;
 
     CANFrame* frame_p = nullptr;
-    QVector<CANFrame> frames;
 
     //Each connection only knows about its own bus numbers
     //so this variable is used to fix that up to turn local bus numbers
@@ -186,9 +265,37 @@ void CANConManager::refreshConnection(CANConnection* pConn_p)
         frames.append(*frame_p);
         pConn_p->getQueue().dequeue();
     }
+}
 
-    if(frames.size())
-        emit framesReceived(pConn_p, frames);
+/*
+ * Finds the connection that handles a system wide bus number and how many buses come before it.
+ * Called with mConnsMutex held.
+*/
+CANConnection* CANConManager::findConnection(int bus, int& busBase) const
+{
+    busBase = 0;
+    foreach (CANConnection* conn, mConns)
+    {
+        //check if this CAN connection is supposed to handle the requested bus
+        if (bus < (busBase + conn->getNumBuses())) return conn;
+        busBase += conn->getNumBuses();
+    }
+    return nullptr;
+}
+
+/*
+ * A send in progress holds a count on its connection instead of holding mConnsMutex, so sends on
+ * different connections or from different threads don't queue up behind one another. remove and
+ * replace wait for the count to drop before handing the connection back to be deleted.
+*/
+void CANConManager::releaseConnection(CANConnection* pConn_p)
+{
+    QMutexLocker locker(&mConnsMutex);
+    if (--mSending[pConn_p] <= 0)
+    {
+        mSending.remove(pConn_p);
+        mSendDone.wakeAll();
+    }
 }
 
 /*
@@ -206,63 +313,105 @@ bool CANConManager::sendFrame(const CANFrame& pFrame)
 {
     int busBase = 0;
     CANFrame workingFrame = pFrame;
+    CANConnection *conn;
 
-    if (mConns.count() == 0)
     {
-        buslessFrames.append(pFrame);
-        return true;
+        QMutexLocker locker(&mConnsMutex);
+        if (mConns.count() == 0)
+        {
+            buslessFrames.append(pFrame);
+            return true;
+        }
+
+        conn = findConnection(pFrame.bus, busBase);
+        if (!conn) return false;
+        mSending[conn]++;
     }
 
-    foreach (CANConnection* conn, mConns)
+    workingFrame.bus -= busBase;
+    workingFrame.isReceived = false;
+    workingFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, CANTimebase::nowMicros(useSystemTime)));
+
+    bool ret = conn->sendFrame(workingFrame);
+    releaseConnection(conn);
+    return ret;
+}
+
+/*
+ * Batched version of sendFrame. Consecutive frames that go to the same CANConnection are handed over
+ * in one sendFrames call so there is one blocking cross thread call and one piSendFrames per run of
+ * frames instead of one per frame. Order between frames is kept. The runs are all worked out under
+ * the lock first and then sent without it.
+*/
+bool CANConManager::sendFrames(const QList<CANFrame>& pFrames)
+{
+    QList<CANConnection*> batchConns;
+    QList<QList<CANFrame>> batches;
+    bool badBus = false;
+    //one timestamp for the whole batch. They all go out at the same moment anyway
+    const uint64_t stamp = CANTimebase::nowMicros(useSystemTime);
+
     {
-        //check if this CAN connection is supposed to handle the requested bus
-        if (pFrame.bus < (busBase + conn->getNumBuses()))
+        QMutexLocker locker(&mConnsMutex);
+        if (mConns.count() == 0)
         {
-            workingFrame.bus -= busBase;
-            workingFrame.isReceived = false;
-            if (useSystemTime)
+            buslessFrames.append(pFrames.toVector());
+            return true;
+        }
+
+        foreach(const CANFrame& frame, pFrames)
+        {
+            int busBase = 0;
+            CANConnection *target = findConnection(frame.bus, busBase);
+            if (!target)
             {
-                workingFrame.setTimeStamp(QCanBusFrame::TimeStamp(0,QDateTime::currentMSecsSinceEpoch() * 1000));
+                //whatever was collected before the bad bus still goes out
+                badBus = true;
+                break;
             }
-            else
+
+            if (batchConns.isEmpty() || batchConns.last() != target)
             {
-                workingFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, mElapsedTimer.nsecsElapsed() / 1000));
-                //workingFrame.timestamp -= mTimestampBasis;
+                batchConns.append(target);
+                batches.append(QList<CANFrame>());
+                mSending[target]++;
             }
 
-            return conn->sendFrame(workingFrame);
+            batches.last().append(frame);
+            CANFrame &workingFrame = batches.last().last();
+            workingFrame.bus -= busBase;
+            workingFrame.isReceived = false;
+            workingFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, stamp));
         }
-        busBase += conn->getNumBuses();
     }
-    return false;
-}
 
-bool CANConManager::sendFrames(const QList<CANFrame>& pFrames)
-{
-    foreach(const CANFrame& frame, pFrames)
+    bool failed = false;
+    for (int i = 0; i < batches.count(); i++)
     {
-        if(!sendFrame(frame))
-            return false;
+        //after a failed run the rest are dropped but every count still has to be given back
+        if (!failed && !batchConns[i]->sendFrames(batches[i])) failed = true;
+        releaseConnection(batchConns[i]);
     }
 
-    return true;
+    return !failed && !badBus;
 }
 
 //For each device associated with buses go through and see if that device has a bus
 //that the filter should apply to. If so forward the data on but fudge
 //the bus numbers if bus wasn't -1 so that they're local to the device
-bool CANConManager::addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver)
+bool CANConManager::addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver, Qt::ConnectionType type)
 {
     //int tempBusVal;
     int busBase = 0;
 
+    QMutexLocker locker(&mConnsMutex);
     foreach (CANConnection* conn, mConns)
     {
-        if (pBusId == -1) conn->addTargettedFrame(pBusId, ID, mask, receiver);
+        if (pBusId == -1) conn->addTargettedFrame(pBusId, ID, mask, receiver, type);
         else if (pBusId < (busBase + conn->getNumBuses()))
         {
             qDebug() << "Forwarding targetted frame setting to a connection object";
-            conn->addTargettedFrame(pBusId - busBase, ID, mask, receiver);
+            conn->addTargettedFrame(pBusId - busBase, ID, mask, receiver, type);
 
         }
         busBase += conn->getNumBuses();
@@ -275,6 +424,7 @@ bool CANConManager::removeTargettedFrame(int pBusId, uint32_t ID, uint32_t mask,
     //int tempBusVal;
     int busBase = 0;
 
+    QMutexLocker locker(&mConnsMutex);
     foreach (CANConnection* conn, mConns)
     {
         if (pBusId == -1) conn->removeTargettedFrame(pBusId, ID, mask, receiver);
@@ -291,6 +441,7 @@ bool CANConManager::removeTargettedFrame(int pBusId, uint32_t ID, uint32_t mask,
 
 bool CANConManager::removeAllTargettedFrames(QObject *receiver)
 {
+    QMutexLocker locker(&mConnsMutex);
     foreach (CANConnection* conn, mConns)
     {
         conn->removeAllTargettedFrames(receiver);
@@ -4,6 +4,9 @@
 #include <QObject>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
 
 #include "canconnection.h"
 
@@ -15,6 +18,8 @@ public:
     static CANConManager* getInstance();
     virtual ~CANConManager();
 
+    /* add, remove, replace and changes through getConnections are GUI thread only. Once remove returns no
+       other thread is still sending through the connection so it can be stopped and deleted */
     void add(CANConnection* pConn_p);
     void remove(CANConnection* pConn_p);
     void replace(int idx, CANConnection* pConn_p);
@@ -23,6 +28,11 @@ public:
 
     CANConnection* getByName(const QString& pName) const;
 
+    /**
+     * @brief getTimeBasis
+     * @return wall clock time (microseconds since epoch) that frame timestamps are relative to
+     * @note the actual clock lives in CANTimebase. Connections stamp frames through a DeviceClock
+     */
     uint64_t getTimeBasis();
     void resetTimeBasis();
 
@@ -34,6 +44,7 @@ public:
      * @param pFrame - reference to a CANFrame struct that has been filled out for sending
      * @return bool specifying whether the send succeeded or not
      * @note Finds which CANConnection object is responsible for this bus and automatically converts bus number to pass properly to CANConnection
+     * @note safe to call from any thread, as are sendFrames, getNumBuses, getBusBase and getByName
      */
     bool sendFrame(const CANFrame& pFrame);
 
@@ -41,14 +52,17 @@ public:
     bool sendFrames(const QList<CANFrame>& pFrames);
 
     /**
-     * @brief Add a new filter for the targetted frames. If a frame matches it will immediately be sent via the targettedFrameReceived signal
+     * @brief Add a new filter for the targetted frames. If a frame matches, the receiver's gotTargettedFrame(const CANFrame&) slot
+     * is called through a queued connection in the receiver's own thread
      * @param pBusId - Which bus to bond to. -1 for any, otherwise a bitfield of buses (but 0 = first bus, etc)
      * @param ID - 11 or 29 bit ID to match against
      * @param mask - 11 or 29 bit mask used for filter
      * @param receiver - Pointer to a QObject that wants to receive notification when filter is matched
+     * @param type - Qt::DirectConnection calls the slot right away from the connection's thread instead. The slot then
+     * has to be thread safe and should only hand the frame off
      * @return true if filter was able to be added, false otherwise.
      */
-    bool addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver);
+    bool addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver, Qt::ConnectionType type = Qt::QueuedConnection);
 
     /**
      * @brief Try to find a matching filter in the list and remove it, no longer targetting those frames
@@ -63,7 +77,7 @@ public:
     bool removeAllTargettedFrames(QObject *receiver);
 
 signals:
-    void framesReceived(CANConnection* pConn_p, QVector<CANFrame>& pFrames);
+    void framesReceived(CANConnection* pConn_p, const QVector<CANFrame>& pFrames);
     void connectionStatusUpdated(int conns);
 
 private slots:
@@ -72,16 +86,22 @@ private slots:
 private:
     explicit CANConManager(QObject *parent = 0);
     void refreshConnection(CANConnection* pConn_p);
+    void drainConnection(CANConnection* pConn_p, QVector<CANFrame>& frames);
+    void updateActiveBuses();
+    CANConnection* findConnection(int bus, int& busBase) const;
+    void releaseConnection(CANConnection* pConn_p);
 
     static CANConManager*  mInstance;
+    mutable QMutex         mConnsMutex; //held by other threads while they look through mConns and by the GUI thread to change it. Also guards buslessFrames and mSending
+    QHash<CANConnection*, int> mSending; //sends in progress per connection, made outside mConnsMutex
+    QWaitCondition         mSendDone;
     QList<CANConnection*>  mConns;
     QTimer                 mTimer;
-    QElapsedTimer          mElapsedTimer;
-    uint64_t               mTimestampBasis;
     uint32_t               mNumActiveBuses;
     bool                   useSystemTime;
     QVector<CANFrame>      buslessFrames;
     QVector<CANFrame>      tempFrames;
+    QVector<QVector<CANFrame>> mergeSources; //per connection frames drained on a timer tick, reused between ticks
 };
 
 #endif // CANCONNECTIONMODEL_H
@@ -26,6 +26,7 @@ CANConnection::CANConnection(QString pPort,
     /* register types */
     qRegisterMetaType<CANBus>("CANBus");
     qRegisterMetaType<CANFrame>("CANFrame");
+    qRegisterMetaType<QList<CANFrame>>("QList<CANFrame>");
     qRegisterMetaType<CANConStatus>("CANConStatus");
     qRegisterMetaType<CANFltObserver>("CANFlt");
 
@@ -177,15 +178,17 @@ bool CANConnection::sendFrame(const CANFrame& pFrame)
         return ret;
     }
 
-    CANFrame *txFrame;
-    txFrame = getQueue().get();
+    if (!piSendFrame(pFrame)) return false;
+
+    /* only frames that really went out show up in the capture */
+    CANFrame *txFrame = getQueue().get();
     if (txFrame)
     {
-        *txFrame = pFrame;        
-    }    
-    getQueue().queue();
+        *txFrame = pFrame;
+        getQueue().queue();
+    }
 
-    return piSendFrame(pFrame);
+    return true;
 }
 
 
@@ -202,7 +205,18 @@ bool CANConnection::sendFrames(const QList<CANFrame>& pFrames)
         return ret;
     }
 
-    return piSendFrames(pFrames);
+    if (!piSendFrames(pFrames)) return false;
+
+    /* transmitted frames show up in the capture just like with sendFrame */
+    foreach(const CANFrame& frame, pFrames)
+    {
+        CANFrame *txFrame = getQueue().get();
+        if (!txFrame) break;
+        *txFrame = frame;
+        getQueue().queue();
+    }
+
+    return true;
 }
 
 
@@ -281,7 +295,7 @@ void CANConnection::debugInput(QByteArray bytes) {
     Q_UNUSED(bytes)
 }
 
-bool CANConnection::addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver)
+bool CANConnection::addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver, Qt::ConnectionType type)
 {
 /*
     if( mThread_p && (mThread_p != QThread::currentThread()) ) {
@@ -305,6 +319,8 @@ bool CANConnection::addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QO
     target.id = ID;
     target.mask = mask;
     target.observer = receiver;
+    target.connType = type;
+    QMutexLocker locker(&mTargetsMutex);
     if (pBusId > -1)
         mBusData[pBusId].mTargettedFrames.append(target);
     else
@@ -338,14 +354,21 @@ bool CANConnection::removeTargettedFrame(int pBusId, uint32_t ID, uint32_t mask,
     target.id = ID;
     target.mask = mask;
     target.observer = receiver;
-    mBusData[pBusId].mTargettedFrames.removeAll(target);
+    QMutexLocker locker(&mTargetsMutex);
+    if (pBusId > -1)
+        mBusData[pBusId].mTargettedFrames.removeAll(target);
+    else
+    {
+        for (int i = 0; i < mBusData.count(); i++) mBusData[i].mTargettedFrames.removeAll(target);
+    }
 
     return true;
 }
 
 bool CANConnection::removeAllTargettedFrames(QObject *receiver)
 {
-    for (int i = 0; i < getNumBuses(); i++) {
+    QMutexLocker locker(&mTargetsMutex);
+    for (int i = 0; i < mBusData.count(); i++) {
         foreach (const CANFltObserver filt, mBusData[i].mTargettedFrames)
         {
             if (filt.observer == receiver) mBusData[i].mTargettedFrames.removeOne(filt);
@@ -363,15 +386,18 @@ void CANConnection::checkTargettedFrame(CANFrame &frame)
 
     int bus = frame.bus;
     if (bus > (mBusData.length() - 1)) bus = mBusData.length() - 1;
+    if (bus < 0) bus = 0;
 
+    //held through the calls so a receiver that removed its filters is never called after that returned
+    QMutexLocker locker(&mTargetsMutex);
     if (mBusData[bus].mTargettedFrames.length() == 0) return;
-    foreach (const CANFltObserver filt, mBusData[frame.bus].mTargettedFrames)
+    foreach (const CANFltObserver filt, mBusData[bus].mTargettedFrames)
     {
         //qDebug() << "Checking filter with id " << filt.id << " mask " << filt.mask;
         maskedID = frame.frameId() & filt.mask;
         if (maskedID == filt.id) {
-            qDebug() << "In connection object I got a targetted frame. Forwarding it.";
-            QMetaObject::invokeMethod(filt.observer, "gotTargettedFrame",Qt::QueuedConnection, Q_ARG(CANFrame, frame));
+            //queued to the receiver's thread unless it asked to be called right here on the connection thread
+            QMetaObject::invokeMethod(filt.observer, "gotTargettedFrame", filt.connType, Q_ARG(CANFrame, frame));
         }
     }
 }
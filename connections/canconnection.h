@@ -3,6 +3,7 @@
 
 #include <Qt>
 #include <QObject>
+#include <QMutex>
 #include "utils/lfqueue.h"
 #include "can_structs.h"
 #include "canbus.h"
@@ -170,22 +171,25 @@ public slots:
      * @brief provides device with a list of frames to send
      * @param pFrame: the list of frames to send
      * @return false if parameter is invalid (bus id for instance)
-     * @note this calls piSendFrameBatch (in the working thread context if one has been started)
+     * @note this calls piSendFrames (in the working thread context if one has been started)
      */
     bool sendFrames(const QList<CANFrame>& pFrames);
 
     /**
-     * @brief Add a new filter for the targetted frames. If a frame matches it will immediately be sent via the targettedFrameReceived signal
+     * @brief Add a new filter for the targetted frames. If a frame matches, the receiver's gotTargettedFrame(const CANFrame&) slot
+     * is called immediately from the connection's thread. It has to be thread safe and should only hand the frame off
      * @param pBusId - Which bus to bond to. -1 for any, otherwise a bitfield of buses (but 0 = first bus, etc)
      * @param ID - 11 or 29 bit ID to match against
      * @param mask - 11 or 29 bit mask used for filter
      * @param receiver - Pointer to a QObject that wants to receive notification when filter is matched
+     * @param type - how the receiver's gotTargettedFrame slot is called from the connection thread
      * @return true if filter was able to be added, false otherwise.
      */
-    bool addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver);
+    bool addTargettedFrame(int pBusId, uint32_t ID, uint32_t mask, QObject *receiver, Qt::ConnectionType type = Qt::QueuedConnection);
 
     /**
-     * @brief Try to find a matching filter in the list and remove it, no longer targetting those frames
+     * @brief Try to find a matching filter in the list and remove it, no longer targetting those frames.
+     * Once it returns the connection thread won't call the receiver for that filter again
      * @param pBusId - Which bus to bond to. Doesn't have to match the call to addTargettedFrame exactly. You could disconnect just one bus for instance.
      * @param ID - 11 or 29 bit ID to match against
      * @param mask - 11 or 29 bit mask used for filter
@@ -310,7 +314,8 @@ protected:
      * @brief provides device with a list of frames to send
      * @param pFrame: the list of frames to send
      * @return false if parameter is invalid (bus id for instance)
-     * @note implementing this function is optional
+     * @note the default implementation calls piSendFrame for each frame. Drivers should override it
+     * @note to coalesce the whole list into as few device writes as possible
      */
     virtual bool piSendFrames(const QList<CANFrame>&);
 
@@ -323,6 +328,7 @@ private:
     QAtomicInt          mStatus;
     bool                mStarted;
     QThread*            mThread_p;
+    QMutex              mTargetsMutex;  //guards the mTargettedFrames of every bus. Held while frames are delivered
 };
 
 #endif // CANCONNECTION_H
@@ -50,6 +50,9 @@ void CanLogServer::readNetworkData()
     if(isCapSuspended())
         return;
 
+    /* one host clock sample for every line read now */
+    deviceClock.beginBatch(useSystemTime);
+
     while (m_ptcpSocket->canReadLine()) {
         // Get a complete line and remove whitespace at the start and at the end of the string
         QString data = QString(m_ptcpSocket->readLine()).trimmed();
@@ -86,7 +89,7 @@ void CanLogServer::readNetworkData()
                         // Frame is recived
                         frame_p->isReceived = true;
                         // Set timestamp
-                        frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, qstrTs.toULongLong()));
+                        frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.stamp(qstrTs.toULongLong())));
                         // Set payload
                         frame_p->setPayload(QByteArray::fromHex(qstrPayload.toUtf8()));
                         // Elaborate frame
@@ -162,10 +165,17 @@ bool CanLogServer::piSendFrame(const CANFrame& )
     return true;
 }
 
+bool CanLogServer::piSendFrames(const QList<CANFrame>& )
+{
+    return true;
+}
+
 void CanLogServer::connectToDevice()
 {
     qDebug() << "Canlogserver: " << "Establishing connection to a Canlogserver device...";
 
+    deviceClock.reset();
+
     QUrl url("http://" + m_qsAddress);
     qDebug() << "address:" << m_qsAddress;
     qDebug() << "Host:" << url.host();
@@ -15,6 +15,7 @@
 #include "canframemodel.h"
 #include "canconnection.h"
 #include "canconmanager.h"
+#include "cantimebase.h"
 
 class CanLogServer : public CANConnection
 {
@@ -32,6 +33,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&);
+    virtual bool piSendFrames(const QList<CANFrame>&);
 
 private slots:
     void readNetworkData();
@@ -53,5 +55,7 @@ protected:
 //    QUdpSocket *_udpClient;
 
 //    QTimer  *_heartbeatTimer;
+
+     DeviceClock deviceClock;
 };
 #endif // CANLOGSERVER_H
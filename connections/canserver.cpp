@@ -97,6 +97,11 @@ bool CANserver::piSendFrame(const CANFrame& )
     return true;
 }
 
+bool CANserver::piSendFrames(const QList<CANFrame>& )
+{
+    return true;
+}
+
 void CANserver::connectToDevice()
 {
     qDebug() << "CANserver: " << "Establishing UDP connection to a CANserver device...";
@@ -156,6 +161,9 @@ void CANserver::readNetworkData()
     if(isCapSuspended())
         return;
 
+    /* CANserver sends no timestamps, everything in this datagram gets the same host time */
+    deviceClock.beginBatch(useSystemTime);
+
     
     uint16_t packetCount = datagram.length() / 16;
     //qDebug() << "Processing " << packetCount << " packets";
@@ -214,7 +222,7 @@ void CANserver::readNetworkData()
             frame_p->setFrameType(QCanBusFrame::DataFrame);
             frame_p->isReceived = true;
         
-            frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, QDateTime::currentMSecsSinceEpoch() * 1000ul));
+            frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.hostStamp()));
 
             frame_p->setPayload(datagram.mid(dataByteLocation, length));
         
@@ -22,6 +22,7 @@
 #include "canframemodel.h"
 #include "canconnection.h"
 #include "canconmanager.h"
+#include "cantimebase.h"
 
 class CANserver : public CANConnection
 {
@@ -39,6 +40,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&);
+    virtual bool piSendFrames(const QList<CANFrame>&);
     
 private slots:
     void readNetworkData();
@@ -59,6 +61,8 @@ protected:
     QUdpSocket *_udpClient;
 
     QTimer  *_heartbeatTimer;
+
+    DeviceClock deviceClock;
 };
 
 #endif /* canserver_h */
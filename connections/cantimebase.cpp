@@ -0,0 +1,167 @@
+#include <QDateTime>
+#include "cantimebase.h"
+#include "utils/hiresclock.h"
+
+//length of one envelope window in device microseconds
+#define DEVCLOCK_WINDOW_US      2000000
+//ignore drift estimates beyond this. Real crystals are well under 100ppm
+#define DEVCLOCK_MAX_SKEW       0.001
+//weight of a new window when smoothing the drift estimate
+#define DEVCLOCK_SKEW_ALPHA     0.25
+//a device stamp going back more than this (and not rolling over) means the device reset its clock
+#define DEVCLOCK_RESET_US       10000
+
+QAtomicInteger<qint64> CANTimebase::mBasisMicros(0);
+QAtomicInteger<qint64> CANTimebase::mMonoAtResetNs(0);
+QAtomicInt             CANTimebase::mGeneration(0);
+
+void CANTimebase::reset()
+{
+    mMonoAtResetNs.storeRelease(HiResClock::nowNs());
+    mBasisMicros.storeRelease(QDateTime::currentMSecsSinceEpoch() * 1000);
+    mGeneration.fetchAndAddRelease(1);
+}
+
+quint64 CANTimebase::getBasis()
+{
+    return mBasisMicros.loadAcquire();
+}
+
+int CANTimebase::getGeneration()
+{
+    return mGeneration.loadAcquire();
+}
+
+quint64 CANTimebase::nowMicros(bool systemTime)
+{
+    qint64 elapsed = (HiResClock::nowNs() - mMonoAtResetNs.loadAcquire()) / 1000;
+    if (systemTime) return mBasisMicros.loadAcquire() + elapsed;
+    return elapsed;
+}
+
+
+
+DeviceClock::DeviceClock(quint64 wrapMicros)
+{
+    mWrapMicros = wrapMicros;
+    mSystemTime = false;
+    mBatchHost = 0;
+    reset();
+}
+
+void DeviceClock::reset()
+{
+    mGeneration = CANTimebase::getGeneration();
+    mValid = false;
+    mLastRaw = 0;
+    mWrapOffset = 0;
+    mRefDevice = 0;
+    mRefOffset = 0.0;
+    mSkew = 0.0;
+    mHaveSkew = false;
+    mWindowStart = 0;
+    mWindowMin = 0;
+    mWindowMinDevice = 0;
+    mLastStamp = 0;
+}
+
+void DeviceClock::beginBatch(bool systemTime)
+{
+    beginBatch(systemTime, CANTimebase::nowMicros(false));
+}
+
+void DeviceClock::beginBatch(bool systemTime, qint64 hostMicros)
+{
+    if (mGeneration != CANTimebase::getGeneration())
+    {
+        //basis moved so the old offset is meaningless, but the drift of the device is still right
+        bool haveSkew = mHaveSkew;
+        double skew = mSkew;
+        reset();
+        mHaveSkew = haveSkew;
+        mSkew = skew;
+    }
+    mSystemTime = systemTime;
+    mBatchHost = hostMicros;
+}
+
+quint64 DeviceClock::hostStamp()
+{
+    qint64 stamp = qMax(mBatchHost, mLastStamp);
+    mLastStamp = stamp;
+    return mSystemTime ? CANTimebase::getBasis() + stamp : stamp;
+}
+
+quint64 DeviceClock::stamp(quint64 deviceMicros)
+{
+    qint64 raw = (qint64)deviceMicros;
+
+    //unwrap counters that roll over. Any other real step back is the device starting over
+    if (mValid && raw < mLastRaw)
+    {
+        const qint64 back = mLastRaw - raw;
+        if (mWrapMicros && back > (qint64)(mWrapMicros / 2)) mWrapOffset += mWrapMicros;
+        else if (back > DEVCLOCK_RESET_US)
+        {
+            //the crystal is the same so the drift stays, only the offset has to be found again
+            mValid = false;
+            mWrapOffset = 0;
+        }
+    }
+    mLastRaw = raw;
+    const qint64 device = raw + mWrapOffset;
+    const qint64 delta = mBatchHost - device;
+
+    if (!mValid)
+    {
+        mValid = true;
+        mRefDevice = device;
+        mRefOffset = delta;
+        mWindowStart = device;
+        mWindowMin = delta;
+        mWindowMinDevice = device;
+    }
+    else
+    {
+        if (delta < mWindowMin)
+        {
+            mWindowMin = delta;
+            mWindowMinDevice = device;
+        }
+
+        if ((device - mWindowStart) >= DEVCLOCK_WINDOW_US)
+        {
+            qint64 span = mWindowMinDevice - mRefDevice;
+            if (span > 0)
+            {
+                double skew = (mWindowMin - mRefOffset) / (double)span;
+                if (qAbs(skew) < DEVCLOCK_MAX_SKEW)
+                {
+                    if (mHaveSkew) mSkew += DEVCLOCK_SKEW_ALPHA * (skew - mSkew);
+                    else mSkew = skew;
+                    mHaveSkew = true;
+                }
+            }
+            mRefDevice = mWindowMinDevice;
+            mRefOffset = mWindowMin;
+            mWindowStart = device;
+            mWindowMin = delta;
+            mWindowMinDevice = device;
+        }
+    }
+
+    double offset = mRefOffset + mSkew * (device - mRefDevice);
+    //a frame can't have been received after we read it
+    if (offset > delta) offset = delta;
+
+    qint64 stamp = device + (qint64)offset;
+    if (stamp < mLastStamp) stamp = mLastStamp;
+    mLastStamp = stamp;
+
+    return mSystemTime ? CANTimebase::getBasis() + stamp : stamp;
+}
+
+double DeviceClock::getDriftPpm() const
+{
+    return mSkew * 1000000.0;
+}
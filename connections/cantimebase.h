@@ -0,0 +1,120 @@
+#ifndef CANTIMEBASE_H
+#define CANTIMEBASE_H
+
+#include <QtGlobal>
+#include <QAtomicInteger>
+
+/*
+  Central timebase for every connection. All frame timestamps in the program are relative to one
+  basis: either microseconds since the last reset (the default) or microseconds since the epoch
+  when the "use system clock" option is on. The basis is sampled once from the wall clock at reset
+  and from then on time only comes from the monotonic clock, so stamps never jump when the system
+  time is adjusted and there is no wall clock call on the per frame path.
+*/
+class CANTimebase
+{
+public:
+    /**
+     * @brief start a new basis. Frames stamped afterward start counting from zero again
+     */
+    static void reset();
+
+    /**
+     * @brief getBasis
+     * @return wall clock time of the last reset in microseconds since the epoch
+     */
+    static quint64 getBasis();
+
+    /**
+     * @brief getGeneration
+     * @return a number that changes every time reset() is called so device clocks know to resync
+     */
+    static int getGeneration();
+
+    /**
+     * @brief nowMicros
+     * @param systemTime - if true the result is in microseconds since the epoch otherwise since reset
+     * @return current monotonic time in the requested basis
+     */
+    static quint64 nowMicros(bool systemTime);
+
+private:
+    static QAtomicInteger<qint64> mBasisMicros;
+    static QAtomicInteger<qint64> mMonoAtResetNs;
+    static QAtomicInt             mGeneration;
+};
+
+/*
+  Maps the timestamps of one device onto the central timebase. The host clock is read once per
+  received batch (beginBatch) and every frame in the batch is stamped from its own device timestamp.
+  Transfer latency is always positive so the lower envelope of (host - device) over a window is the
+  best offset estimate. Comparing successive window minimums gives the device crystal drift which is
+  then applied between windows. Devices without their own timestamps just get the batch host time.
+  Output is kept monotonic per device so frames from several adapters can be merged in order.
+  A device timestamp that jumps back without rolling over means the device restarted its clock. The
+  offset is learned again from there on while the drift estimate is kept.
+*/
+class DeviceClock
+{
+public:
+    /**
+     * @param wrapMicros - period after which the device timestamp rolls over. 0 if it never does
+     */
+    DeviceClock(quint64 wrapMicros = 0);
+
+    /**
+     * @brief forget everything learned about the device. Call after reconnecting
+     */
+    void reset();
+
+    /**
+     * @brief sample the host clock for the batch of frames about to be stamped
+     * @param systemTime - stamp relative to the epoch instead of the last reset
+     */
+    void beginBatch(bool systemTime);
+
+    /**
+     * @brief same as above with the host time of the batch given instead of read from the clock
+     * @param hostMicros - microseconds since the last reset. Lets recorded timing be replayed, mostly by the tests
+     */
+    void beginBatch(bool systemTime, qint64 hostMicros);
+
+    /**
+     * @brief stamp a frame from its device timestamp
+     * @param deviceMicros - raw timestamp reported by the device in microseconds
+     * @return timestamp in the central timebase
+     */
+    quint64 stamp(quint64 deviceMicros);
+
+    /**
+     * @brief stamp a frame that has no usable device timestamp
+     * @return the host time of the current batch in the central timebase
+     */
+    quint64 hostStamp();
+
+    /**
+     * @brief getDriftPpm
+     * @return estimated device clock drift against the host in parts per million
+     */
+    double getDriftPpm() const;
+
+private:
+    quint64 mWrapMicros;
+    bool mSystemTime;
+    int mGeneration;
+    qint64 mBatchHost;      //host time of the current batch, microseconds since reset
+
+    bool mValid;
+    qint64 mLastRaw;        //last raw device stamp, for rollover detection
+    qint64 mWrapOffset;     //accumulated rollovers
+    qint64 mRefDevice;      //device time of the last envelope point
+    double mRefOffset;      //host - device at that point
+    double mSkew;           //drift as a fraction (1e-6 = 1ppm)
+    bool mHaveSkew;
+    qint64 mWindowStart;
+    qint64 mWindowMin;
+    qint64 mWindowMinDevice;
+    qint64 mLastStamp;
+};
+
+#endif // CANTIMEBASE_H
@@ -147,16 +147,18 @@ void ConnectionWindow::readPendingDatagrams()
 }
 ConnectionWindow::~ConnectionWindow()
 {
-    QList<CANConnection*>& conns = CANConManager::getInstance()->getConnections();
+    CANConManager* manager = CANConManager::getInstance();
+    QList<CANConnection*>& conns = manager->getConnections();
     CANConnection* conn_p;
 
     /* save configuration */
     saveConnections();
 
-    /* delete connections */
+    /* delete connections. Removing them first waits out any other thread still sending through them */
     while(!conns.isEmpty())
     {
-        conn_p = conns.takeFirst();
+        conn_p = conns.first();
+        manager->remove(conn_p);
         conn_p->stop();
         delete conn_p;
     }
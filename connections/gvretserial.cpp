@@ -24,9 +24,7 @@ GVRetSerial::GVRetSerial(QString portName, bool useTcp) :
     isAutoRestart = false;
     espSerialMode = true;
 
-    timeBasis = 0;
-    lastSystemTimeBasis = 0;
-    timeAtGVRETSync = 0;
+    deviceClock = DeviceClock(0x100000000ull); //GVRET timestamps are 32 bit microseconds
 
     readSettings();
 }
@@ -228,49 +226,90 @@ void GVRetSerial::piSetBusSettings(int pBusIdx, CANBus bus)
 }
 
 
+bool GVRetSerial::isWritable()
+{
+    if (serial == nullptr && tcpClient == nullptr && udpClient == nullptr) return false;
+    if (serial && !serial->isOpen()) return false;
+    if (tcpClient && !tcpClient->isOpen()) return false;
+    if (udpClient && !udpClient->isOpen()) return false;
+    return true;
+}
+
+//Appends the binary GVRET "send frame" command for one frame to buffer. Returns false for frames that shouldn't be sent
+bool GVRetSerial::encodeFrame(const CANFrame& frame, QByteArray &buffer)
+{
+    // Doesn't make sense to send an error frame
+    // to an adapter
+    if (frame.frameId() & 0x20000000) return false;
+
+    quint32 ID = frame.frameId();
+    if (frame.hasExtendedFrameFormat()) ID |= 1u << 31;
+
+    const QByteArray payload = frame.payload();
+    buffer.append((char)0xF1); //start of a command over serial
+    buffer.append((char)0); //command ID for sending a CANBUS frame
+    buffer.append((char)(ID & 0xFF)); //four bytes of ID LSB first
+    buffer.append((char)(ID >> 8));
+    buffer.append((char)(ID >> 16));
+    buffer.append((char)(ID >> 24));
+    buffer.append((char)((frame.bus) & 3));
+    buffer.append((char)payload.length());
+    buffer.append(payload);
+    buffer.append((char)0);
+    return true;
+}
+
 bool GVRetSerial::piSendFrame(const CANFrame& frame)
 {
     QByteArray buffer;
-    int c;
-    quint32 ID;
 
     //qDebug() << "Sending out GVRET frame with id " << frame.ID << " on bus " << frame.bus;
 
     framesRapid++;
 
-    if (serial == nullptr && tcpClient == nullptr && udpClient == nullptr) return false;
-    if (serial && !serial->isOpen()) return false;
-    if (tcpClient && !tcpClient->isOpen()) return false;
-    if (udpClient && !udpClient->isOpen()) return false;
+    if (!isWritable()) return false;
     //if (!isConnected) return false;
 
-    // Doesn't make sense to send an error frame
-    // to an adapter
-    if (frame.frameId() & 0x20000000) {
-        return true;
-    }
-    ID = frame.frameId();
-    if (frame.hasExtendedFrameFormat()) ID |= 1u << 31;
+    if (encodeFrame(frame, buffer)) sendToSerial(buffer);
+
+    return true;
+}
+
+/*
+ * Coalesces the whole list into as few device writes as possible instead of one tiny write per frame.
+ * UDP writes are kept under one MTU since each write turns into a datagram.
+*/
+bool GVRetSerial::piSendFrames(const QList<CANFrame>& frames)
+{
+    if (!isWritable()) return false;
 
-    buffer[0] = (char)0xF1; //start of a command over serial
-    buffer[1] = 0; //command ID for sending a CANBUS frame
-    buffer[2] = (char)(ID & 0xFF); //four bytes of ID LSB first
-    buffer[3] = (char)(ID >> 8);
-    buffer[4] = (char)(ID >> 16);
-    buffer[5] = (char)(ID >> 24);
-    buffer[6] = (char)((frame.bus) & 3);
-    buffer[7] = (char)frame.payload().length();
-    for (c = 0; c < frame.payload().length(); c++)
+    const int maxChunk = udpClient ? GVRET_UDP_BATCH_BYTES : GVRET_STREAM_BATCH_BYTES;
+    QByteArray buffer;
+    buffer.reserve(qMin(frames.count() * GVRET_MAX_CMD_BYTES, maxChunk + GVRET_MAX_CMD_BYTES));
+
+    foreach (const CANFrame& frame, frames)
     {
-        buffer[8 + c] = frame.payload()[c];
+        framesRapid++;
+        encodeFrame(frame, buffer);
+        if (buffer.size() >= maxChunk)
+        {
+            writeBatch(buffer);
+            buffer.resize(0);
+        }
     }
-    buffer[8 + frame.payload().length()] = 0;
-
-    sendToSerial(buffer);
+    if (buffer.size() > 0) writeBatch(buffer);
 
     return true;
 }
 
+//Straight write with no per byte debug dump. Used for batched sends where the dump would cost more than the write
+void GVRetSerial::writeBatch(const QByteArray &bytes)
+{
+    if (serial) serial->write(bytes);
+    if (tcpClient) tcpClient->write(bytes);
+    if (udpClient) udpClient->write(bytes);
+}
+
 
 
 /****************************************************************/
@@ -291,6 +330,9 @@ void GVRetSerial::connectDevice()
 {
     QSettings settings;
 
+    /* device may have rebooted so its timestamps start over */
+    deviceClock.reset();
+
     /* disconnect device */
     if(serial)
         disconnectDevice();
@@ -581,6 +623,8 @@ void GVRetSerial::readSerialData()
     if (tcpClient) data = tcpClient->readAll();
     if (udpClient) data = udpClient->readAll();
 
+    deviceClock.beginBatch(useSystemTime);
+
     sendDebug("Got data from serial. Len = " % QString::number(data.length()));
     for (int i = 0; i < data.length(); i++)
     {
@@ -682,12 +726,7 @@ void GVRetSerial::procRXChar(unsigned char c)
         case 3:
             buildTimestamp |= (uint)c << 24;
 
-            buildTimestamp += timeBasis;
-            if (useSystemTime)
-            {
-                buildTimestamp = QDateTime::currentMSecsSinceEpoch() * 1000l;
-            }
-            buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, buildTimestamp));
+            buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.stamp(buildTimestamp)));
             break;
         case 4:
             buildId = c;
@@ -767,12 +806,7 @@ void GVRetSerial::procRXChar(unsigned char c)
         case 3:
             buildTimestamp |= (uint)c << 24;
 
-            buildTimestamp += timeBasis;
-            if (useSystemTime)
-            {
-                buildTimestamp = QDateTime::currentMSecsSinceEpoch() * 1000l;
-            }
-            buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, buildTimestamp));
+            buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.stamp(buildTimestamp)));
             break;
         case 4:
             buildId = c;
@@ -849,9 +883,9 @@ void GVRetSerial::procRXChar(unsigned char c)
         case 3:
             buildTimeBasis += ((uint32_t)c << 24);
             qDebug() << "GVRET firmware reports timestamp of " << buildTimeBasis;
-            timeAtGVRETSync = QDateTime::currentMSecsSinceEpoch() * 1000;
 
-            rebuildLocalTimeBasis();
+            //seeds the device clock offset before any traffic shows up
+            deviceClock.stamp(buildTimeBasis);
 
             continuousTimeSync = false;
             rx_state = IDLE;
@@ -1082,26 +1116,8 @@ void GVRetSerial::procRXChar(unsigned char c)
     }
 }
 
-void GVRetSerial::rebuildLocalTimeBasis()
-{
-    qDebug() << "Rebuilding GVRET time base. GVRET local base = " << buildTimeBasis;
-
-    /*
-      our time basis is the value we have to modulate the main system basis by in order
-      to sync the GVRET timestamps to the rest of the system.
-      The rest of the system uses CANConManager::getInstance()->getTimeBasis as the basis.
-      GVRET returns to us the current time since boot up in microseconds.
-      timeAtGVRETSync stores the "system" timestamp when the GVRET timestamp was retrieved.
-    */
-    lastSystemTimeBasis = CANConManager::getInstance()->getTimeBasis();
-    int64_t systemDelta = timeAtGVRETSync - lastSystemTimeBasis;
-    int32_t localDelta = buildTimeBasis - systemDelta;
-    timeBasis = -localDelta;
-}
-
 void GVRetSerial::handleTick()
 {
-    if (lastSystemTimeBasis != CANConManager::getInstance()->getTimeBasis()) rebuildLocalTimeBasis();
     //qDebug() << "Tick!";
 
     if( CANCon::CONNECTED == getStatus() )
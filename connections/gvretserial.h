@@ -15,6 +15,13 @@
 #include "canframemodel.h"
 #include "canconnection.h"
 #include "canconmanager.h"
+#include "cantimebase.h"
+
+//batched sends are written in chunks of about this many bytes
+#define GVRET_STREAM_BATCH_BYTES    16384
+#define GVRET_UDP_BATCH_BYTES       1024
+//F1 00 + 4 byte ID + bus + len + up to 64 data bytes + terminator
+#define GVRET_MAX_CMD_BYTES         73
 
 namespace SERIALSTATE {
 
@@ -56,6 +63,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&) ;
+    virtual bool piSendFrames(const QList<CANFrame>&);
 
     void disconnectDevice();
 
@@ -74,8 +82,10 @@ private:
     void readSettings();
     void procRXChar(unsigned char);
     void sendCommValidation();
-    void rebuildLocalTimeBasis();
     void sendToSerial(const QByteArray &bytes);
+    void writeBatch(const QByteArray &bytes);
+    bool isWritable();
+    bool encodeFrame(const CANFrame& frame, QByteArray &buffer);
     void sendDebug(const QString debugText);
 
 protected:
@@ -104,9 +114,7 @@ protected:
     int deviceBuildNum;
     int deviceSingleWireMode;
     uint32_t buildTimeBasis;
-    int32_t timeBasis;
-    uint64_t lastSystemTimeBasis;
-    uint64_t timeAtGVRETSync;
+    DeviceClock deviceClock;
 };
 
 #endif // GVRETSERIAL_H
@@ -17,6 +17,7 @@ LAWICELSerial::LAWICELSerial(QString portName, int serialSpeed, int lawicelSpeed
 
     serial = nullptr;
     isAutoRestart = false;
+    deviceClock = DeviceClock(LAWICEL_TIMESTAMP_WRAP);
 
     readSettings();
 }
@@ -129,72 +130,86 @@ void LAWICELSerial::piSetBusSettings(int pBusIdx, CANBus bus)
 }
 
 
-bool LAWICELSerial::piSendFrame(const CANFrame& frame)
+//Appends the ASCII LAWICEL transmit command for one frame (terminated by CR) to buffer
+void LAWICELSerial::encodeFrame(const CANFrame& frame, QByteArray &buffer)
 {
-    QByteArray buffer;
-    int c;
-    quint32 ID;
-
-    //qDebug() << "Sending out lawicel frame with id " << frame.ID << " on bus " << frame.bus;
-
-    framesRapid++;
-
-    if (serial == nullptr) return false;
-    if (serial && !serial->isOpen()) return false;
-    //if (!isConnected) return false;
-
-    // Doesn't make sense to send an error frame
-    // to an adapter
-    if (frame.frameId() & 0x20000000) {
-        return true;
-    }
-
-    ID = frame.frameId();
+    quint32 ID = frame.frameId();
     if (frame.hasExtendedFrameFormat()) ID |= 1u << 31;
 
-    int idx = 0;
+    const QByteArray payload = frame.payload();
     QString buildStr;
     if(frame.hasFlexibleDataRateFormat()){
         if (frame.hasExtendedFrameFormat())
         {
             if (frame.hasBitrateSwitch())
-                buildStr = QString::asprintf("B%08X%u", ID, LAWICELSerial::bytes_to_dlc_code(frame.payload().length()));
+                buildStr = QString::asprintf("B%08X%u", ID, LAWICELSerial::bytes_to_dlc_code(payload.length()));
             else
-                buildStr = QString::asprintf("D%08X%u", ID, LAWICELSerial::bytes_to_dlc_code(frame.payload().length()));
+                buildStr = QString::asprintf("D%08X%u", ID, LAWICELSerial::bytes_to_dlc_code(payload.length()));
         }
         else
         {
             if (frame.hasBitrateSwitch())
-                buildStr = QString::asprintf("b%03X%u", ID, LAWICELSerial::bytes_to_dlc_code(frame.payload().length()));
+                buildStr = QString::asprintf("b%03X%u", ID, LAWICELSerial::bytes_to_dlc_code(payload.length()));
             else
-                buildStr = QString::asprintf("d%03X%u", ID, LAWICELSerial::bytes_to_dlc_code(frame.payload().length()));
+                buildStr = QString::asprintf("d%03X%u", ID, LAWICELSerial::bytes_to_dlc_code(payload.length()));
         }
     }
     else {
         if (frame.hasExtendedFrameFormat())
         {
-            buildStr = QString::asprintf("T%08X%u", ID, frame.payload().length());
+            buildStr = QString::asprintf("T%08X%u", ID, payload.length());
         }
         else
         {
-            buildStr = QString::asprintf("t%03X%u", ID, frame.payload().length());
+            buildStr = QString::asprintf("t%03X%u", ID, payload.length());
         }
     }
-    foreach (QChar chr, buildStr)
-    {
-        buffer[idx] = chr.toLatin1();
-        idx++;
+    buffer.append(buildStr.toLatin1());
+    buffer.append(payload.toHex().toUpper());
+    buffer.append((char)13); //CR
+}
+
+bool LAWICELSerial::piSendFrame(const CANFrame& frame)
+{
+    QByteArray buffer;
+
+    //qDebug() << "Sending out lawicel frame with id " << frame.ID << " on bus " << frame.bus;
+
+    framesRapid++;
+
+    if (serial == nullptr) return false;
+    if (serial && !serial->isOpen()) return false;
+    //if (!isConnected) return false;
+
+    // Doesn't make sense to send an error frame
+    // to an adapter
+    if (frame.frameId() & 0x20000000) {
+        return true;
     }
 
-    for (c = 0; c < frame.payload().length(); c++)
+    encodeFrame(frame, buffer);
+    sendToSerial(buffer);
+
+    return true;
+}
+
+//Builds all commands into one buffer so the batch goes out in a single serial write
+bool LAWICELSerial::piSendFrames(const QList<CANFrame>& frames)
+{
+    if (serial == nullptr) return false;
+    if (serial && !serial->isOpen()) return false;
+
+    QByteArray buffer;
+    buffer.reserve(frames.count() * 32);
+
+    foreach (const CANFrame& frame, frames)
     {
-        QString byt = Utility::formatByteAsHex(frame.payload()[c]);
-        buffer[idx + (c * 2)] = byt[0].toLatin1();
-        buffer[idx + (c * 2) + 1] = byt[1].toLatin1();
+        framesRapid++;
+        if (frame.frameId() & 0x20000000) continue;
+        encodeFrame(frame, buffer);
     }
-    buffer[idx + (frame.payload().length() * 2)] = 13; //CR
 
-    sendToSerial(buffer);
+    if (buffer.size() > 0) serial->write(buffer);
 
     return true;
 }
@@ -217,6 +232,8 @@ void LAWICELSerial::connectDevice()
     if(serial)
         disconnectDevice();
 
+    deviceClock.reset();
+
     /* open new device */
 
     qDebug() << "Serial port: " << getPort();
@@ -479,6 +496,9 @@ void LAWICELSerial::readSerialData()
 
     if (serial) data = serial->readAll();
 
+    /* one host clock sample for every frame in this read */
+    deviceClock.beginBatch(useSystemTime);
+
     sendDebug("Got data from serial. Len = " % QString::number(data.length()));
     for (int i = 0; i < data.length(); i++)
     {
@@ -491,25 +511,24 @@ void LAWICELSerial::readSerialData()
         {
             qDebug() << "Got CR!";
 
-            if (useSystemTime)
+            //Extended commands have an 8 digit ID, standard ones 3. Length digit follows the ID.
+            const char cmd = mBuildLine[0].toLatin1();
+            const int hdrLen = (cmd == 'T' || cmd == 'D' || cmd == 'B') ? 10 : 5;
+            int dataLen = mBuildLine.mid(hdrLen - 1, 1).toInt(nullptr, 16);
+            if (cmd == 'd' || cmd == 'b' || cmd == 'D' || cmd == 'B') dataLen = dlc_code_to_bytes(dataLen);
+
+            //If total length is greater than command, header and data, timestamps must be enabled.
+            if (mBuildLine.length() >= (hdrLen + dataLen * 2 + 4 + 1))
             {
-                buildTimestamp = QDateTime::currentMSecsSinceEpoch() * 1000l;
+                //Four digits of milliseconds after the end of the data bytes, rolls over every minute.
+                buildTimestamp = mBuildLine.mid(hdrLen + dataLen * 2, 4).toInt(nullptr, 16) * 1000l;
+                buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.stamp(buildTimestamp)));
             }
             else
             {
-                //If total length is greater than command, header and data, timestamps must be enabled.
-                if (data.length() > (5 + mBuildLine.mid(4, 1).toInt() * 2 + 1))
-                {
-                    //Four bytes after the end of the data bytes.
-                    buildTimestamp = mBuildLine.mid(5 + mBuildLine.mid(4, 1).toInt() * 2, 4).toInt(nullptr, 16) * 1000l;
-                }
-                else
-                {
-                    //Default to system time if timestamps are disabled.
-                    buildTimestamp = QDateTime::currentMSecsSinceEpoch() * 1000l;
-                }
+                //Default to host time if timestamps are disabled.
+                buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.hostStamp()));
             }
-            buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, buildTimestamp));
 
             switch (mBuildLine[0].toLatin1())
             {
@@ -13,6 +13,10 @@
 #include "canframemodel.h"
 #include "canconnection.h"
 #include "canconmanager.h"
+#include "cantimebase.h"
+
+/* device timestamps are 4 hex digits of milliseconds, 0 - 59999 */
+#define LAWICEL_TIMESTAMP_WRAP  60000000ull
 
 class LAWICELSerial : public CANConnection
 {
@@ -30,6 +34,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&) ;
+    virtual bool piSendFrames(const QList<CANFrame>&);
 
     void disconnectDevice();
 
@@ -46,8 +51,8 @@ private slots:
 
 private:
     void readSettings();
-    void rebuildLocalTimeBasis();
     void sendToSerial(const QByteArray &bytes);
+    void encodeFrame(const CANFrame& frame, QByteArray &buffer);
     void sendDebug(const QString debugText);
     uint8_t dlc_code_to_bytes(int dlc_code);
     uint8_t bytes_to_dlc_code(uint8_t bytes);
@@ -62,6 +67,7 @@ protected:
     int framesRapid;
     CANFrame buildFrame;
     qint64 buildTimestamp;
+    DeviceClock deviceClock;
     bool can0Enabled;
     bool can0ListenOnly;
     bool canFd;
@@ -20,9 +20,6 @@ MQTT_BUS::MQTT_BUS(QString topicName) :
     isAutoRestart = false;
     this->topicName = topicName;
 
-    timeBasis = 0;
-    lastSystemTimeBasis = 0;
-
     readSettings();
 }
 
@@ -225,24 +222,12 @@ void MQTT_BUS::piSetBusSettings(int pBusIdx, CANBus bus)
 }
 
 
-bool MQTT_BUS::piSendFrame(const CANFrame& frame)
+//publishes one frame to its ID topic using the passed timestamp
+void MQTT_BUS::publishFrame(const CANFrame& frame, uint64_t micros)
 {
-    QByteArray buffer;
-    //int c;
-    //quint32 ID;
-
-    //qDebug() << "Sending out GVRET frame with id " << frame.ID << " on bus " << frame.bus;
-
-    framesRapid++;
-
-    // Doesn't make sense to send an error frame
-    // to an adapter
-    if (frame.frameId() & 0x20000000) {
-        return true;
-    }
-
     QMQTT::Message msg;
     QByteArray bytes;
+    bytes.reserve(9 + frame.payload().length());
 
     msg.setTopic(topicName + "/s/" + QString::number(frame.frameId()));
     uint8_t flags = 0;
@@ -251,7 +236,6 @@ bool MQTT_BUS::piSendFrame(const CANFrame& frame)
     if (frame.hasFlexibleDataRateFormat()) flags += 4;
     if (frame.frameType() == QCanBusFrame::ErrorFrame) flags += 8;
 
-    uint64_t micros = QDateTime::currentMSecsSinceEpoch() * 1000ull;
     for (int x = 0; x < 8; x++)
     {
         bytes.append(micros & 0xFF);
@@ -262,6 +246,36 @@ bool MQTT_BUS::piSendFrame(const CANFrame& frame)
 
     msg.setPayload(bytes);
     mqttClient->publish(msg);
+}
+
+bool MQTT_BUS::piSendFrame(const CANFrame& frame)
+{
+    //qDebug() << "Sending out GVRET frame with id " << frame.ID << " on bus " << frame.bus;
+
+    framesRapid++;
+
+    // Doesn't make sense to send an error frame
+    // to an adapter
+    if (frame.frameId() & 0x20000000) {
+        return true;
+    }
+
+    publishFrame(frame, QDateTime::currentMSecsSinceEpoch() * 1000ull);
+
+    return true;
+}
+
+//Every frame is its own MQTT message so there is nothing to coalesce but the wall clock only gets read once per batch
+bool MQTT_BUS::piSendFrames(const QList<CANFrame>& frames)
+{
+    const uint64_t micros = QDateTime::currentMSecsSinceEpoch() * 1000ull;
+
+    foreach (const CANFrame& frame, frames)
+    {
+        framesRapid++;
+        if (frame.frameId() & 0x20000000) continue;
+        publishFrame(frame, micros);
+    }
 
     return true;
 }
@@ -278,9 +292,6 @@ void MQTT_BUS::readSettings()
 
 void MQTT_BUS::clientMessageReceived(const QMQTT::Message& message)
 {
-    //uint64_t timeBasis = CANConManager::getInstance()->getTimeBasis();
-
-
     /* drop frame if capture is suspended */
     if(isCapSuspended())
         return;
@@ -300,11 +311,9 @@ void MQTT_BUS::clientMessageReceived(const QMQTT::Message& message)
         frame_p->setFrameId(frameID);
         frame_p->setFrameType(QCanBusFrame::DataFrame);
         frame_p->isReceived = true;
-        if (useSystemTime)
-        {
-            frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, QDateTime::currentMSecsSinceEpoch() * 1000ul));
-        }
-        else frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, timeStamp));
+        /* the publisher stamps in its own clock, map it onto ours */
+        deviceClock.beginBatch(useSystemTime);
+        frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.stamp(timeStamp)));
 
         checkTargettedFrame(*frame_p);
 
@@ -335,23 +344,3 @@ void MQTT_BUS::disconnectDevice() {
     stats.numHardwareBuses = mNumBuses;
     emit status(stats);
 }
-
-void MQTT_BUS::rebuildLocalTimeBasis()
-{
-
-    //qDebug() << "Rebuilding GVRET time base. GVRET local base = " << buildTimeBasis;
-
-    /*
-      our time basis is the value we have to modulate the main system basis by in order
-      to sync the GVRET timestamps to the rest of the system.
-      The rest of the system uses CANConManager::getInstance()->getTimeBasis as the basis.
-      GVRET returns to us the current time since boot up in microseconds.
-      timeAtGVRETSync stores the "system" timestamp when the GVRET timestamp was retrieved.
-    */
-    /*
-    lastSystemTimeBasis = CANConManager::getInstance()->getTimeBasis();
-    int64_t systemDelta = timeAtGVRETSync - lastSystemTimeBasis;
-    int32_t localDelta = buildTimeBasis - systemDelta;
-    timeBasis = -localDelta;
-    */
-}
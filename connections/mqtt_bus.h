@@ -13,6 +13,7 @@
 #include "canframemodel.h"
 #include "canconnection.h"
 #include "canconmanager.h"
+#include "cantimebase.h"
 #include "simplecrypt.h"
 
 class MQTT_BUS : public CANConnection
@@ -31,6 +32,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&) ;
+    virtual bool piSendFrames(const QList<CANFrame>&);
 
     void disconnectDevice();
 
@@ -41,8 +43,8 @@ private slots:
 
 private:
     void readSettings();
-    void rebuildLocalTimeBasis();
     void sendDebug(const QString debugText);
+    void publishFrame(const CANFrame& frame, uint64_t micros);
     QString genRandomClientID();
     SimpleCrypt *crypto;
 
@@ -59,9 +61,7 @@ protected:
     qint64 buildTimestamp;
     quint32 buildId;
     QByteArray buildData;
-    uint32_t buildTimeBasis;
-    int32_t timeBasis;
-    uint64_t lastSystemTimeBasis;
+    DeviceClock deviceClock;
 };
 
 #endif // MQTT_BUS_H
@@ -30,6 +30,7 @@ NewConnectionDialog::NewConnectionDialog(QVector<QString>* gvretips, QVector<QSt
     connect(ui->rbLawicel, &QAbstractButton::clicked, this, &NewConnectionDialog::handleConnTypeChanged);
     connect(ui->rbCANserver, &QAbstractButton::clicked, this, &NewConnectionDialog::handleConnTypeChanged);
     connect(ui->rbCanlogserver, &QAbstractButton::clicked, this, &NewConnectionDialog::handleConnTypeChanged);
+    connect(ui->rbSimulated, &QAbstractButton::clicked, this, &NewConnectionDialog::handleConnTypeChanged);
 
     connect(ui->cbDeviceType, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &NewConnectionDialog::handleDeviceTypeChanged);
     connect(ui->btnOK, &QPushButton::clicked, this, &NewConnectionDialog::handleCreateButton);
@@ -70,6 +71,7 @@ void NewConnectionDialog::handleConnTypeChanged()
     if (ui->rbMQTT->isChecked()) selectMQTT();
     if (ui->rbCANserver->isChecked()) selectCANserver();
     if (ui->rbCanlogserver->isChecked()) selectCANlogserver();
+    if (ui->rbSimulated->isChecked()) selectSimulated();
 }
 
 void NewConnectionDialog::handleDeviceTypeChanged()
@@ -270,6 +272,27 @@ void NewConnectionDialog::selectCANlogserver()
     ui->cbPort->clear();
 }
 
+void NewConnectionDialog::selectSimulated()
+{
+    ui->lPort->setText("Traffic Profile (key=value;...) or file=path;speed=N:");
+
+    ui->lblDeviceType->setHidden(true);
+    ui->cbDeviceType->setHidden(true);
+    ui->cbCANSpeed->setHidden(true);
+    ui->cbSerialSpeed->setHidden(true);
+    ui->lblCANSpeed->setHidden(true);
+    ui->lblSerialSpeed->setHidden(true);
+    ui->cbCanFd->setHidden(true);
+    ui->cbDataRate->setHidden(true);
+    ui->lblDataRate->setHidden(true);
+
+    ui->cbPort->clear();
+    ui->cbPort->addItem("ids=32;period=10,20,50,100;dlc=8");
+    ui->cbPort->addItem("ids=200;period=1,5,10;dlc=0,2,4,8;burst=4;buses=2");
+    ui->cbPort->addItem("ids=64;period=1;fd=1;dlc=8,16,64");
+    ui->cbPort->addItem("ids=2000;period=1;ext=1;buses=4");
+}
+
 void NewConnectionDialog::setPortName(CANCon::type pType, QString pPortName, QString pDriver)
 {
 
@@ -299,6 +322,9 @@ void NewConnectionDialog::setPortName(CANCon::type pType, QString pPortName, QSt
         case CANCon::CANLOGSERVER:
           ui->rbCanlogserver->setChecked(true);
           break;
+        case CANCon::SIMULATED:
+          ui->rbSimulated->setChecked(true);
+          break;
         default: {}
     }
 
@@ -344,6 +370,7 @@ void NewConnectionDialog::setPortName(CANCon::type pType, QString pPortName, QSt
             break;
         case CANCon::CANSERVER:
         case CANCon::CANLOGSERVER:
+        case CANCon::SIMULATED:
         {
             ui->cbPort->setCurrentText(pPortName);
             break;
@@ -365,6 +392,7 @@ QString NewConnectionDialog::getPortName()
         return ui->cbPort->currentText();
     case CANCon::CANSERVER:
     case CANCon::CANLOGSERVER:
+    case CANCon::SIMULATED:
         return ui->cbPort->currentText();
 
     default:
@@ -411,6 +439,7 @@ CANCon::type NewConnectionDialog::getConnectionType()
     if (ui->rbLawicel->isChecked()) return CANCon::LAWICEL;
     if (ui->rbCANserver->isChecked()) return CANCon::CANSERVER;
     if (ui->rbCanlogserver->isChecked()) return CANCon::CANLOGSERVER;
+    if (ui->rbSimulated->isChecked()) return CANCon::SIMULATED;
     qDebug() << "getConnectionType: error";
 
     return CANCon::NONE;
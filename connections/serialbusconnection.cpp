@@ -37,6 +37,8 @@ void SerialBusConnection::piStarted()
         return;
     }
 
+    deviceClock.reset();
+
     /* connect slots */
     connect(mDev_p, &QCanBusDevice::errorOccurred, this, &SerialBusConnection::errorReceived);
     connect(mDev_p, &QCanBusDevice::framesWritten, this, &SerialBusConnection::framesWritten);
@@ -131,6 +133,27 @@ bool SerialBusConnection::piSendFrame(const CANFrame& pFrame)
 }
 
 
+bool SerialBusConnection::piSendFrames(const QList<CANFrame>& pFrames)
+{
+    if (!mDev_p) return false;
+
+    /* only bus 0 exists so check the whole batch once and then hand the frames straight to the device */
+    foreach(const CANFrame& frame, pFrames)
+    {
+        if(0 != frame.bus)
+            return false;
+    }
+
+    foreach(const CANFrame& frame, pFrames)
+    {
+        if(!mDev_p->writeFrame(frame))
+            return false;
+    }
+
+    return true;
+}
+
+
 /***********************************/
 /****   private methods         ****/
 /***********************************/
@@ -167,12 +190,13 @@ void SerialBusConnection::framesWritten(qint64 count)
 
 void SerialBusConnection::framesReceived()
 {
-    uint64_t timeBasis = CANConManager::getInstance()->getTimeBasis();
-
     /* sanity checks */
     if(!mDev_p)
         return;
 
+    /* one host clock sample for everything pending */
+    deviceClock.beginBatch(useSystemTime);
+
     /* read frame */
     while(true)
     {
@@ -204,16 +228,17 @@ void SerialBusConnection::framesReceived()
                     frame_p->setExtendedFrameFormat(recFrame.hasExtendedFrameFormat());
                     frame_p->setFrameId(recFrame.frameId());
                 }
-                frame_p->setTimeStamp(recFrame.timeStamp());
                 frame_p->setFrameType(recFrame.frameType());
                 frame_p->setError(recFrame.error());
                 /* If recorded frame has a local echo, it is a Tx message, and thus should not be marked as Rx */
                 frame_p->isReceived = !recFrame.hasLocalEcho();
 
-                if (useSystemTime) {
-                    frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, QDateTime::currentMSecsSinceEpoch() * 1000ul));
-                }
-                else frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, (recFrame.timeStamp().seconds() * 1000000ul + recFrame.timeStamp().microSeconds()) - timeBasis));
+                /* not every plugin fills in the timestamp */
+                const quint64 devMicros = recFrame.timeStamp().seconds() * 1000000ull + recFrame.timeStamp().microSeconds();
+                if (devMicros)
+                    frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.stamp(devMicros)));
+                else
+                    frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock.hostStamp()));
 
                 checkTargettedFrame(*frame_p);
 
@@ -3,6 +3,7 @@
 
 #include "canconnection.h"
 #include "canframemodel.h"
+#include "cantimebase.h"
 
 #include <QCanBusDevice>
 #include <QTimer>
@@ -38,6 +39,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&);
+    virtual bool piSendFrames(const QList<CANFrame>&);
 
     void disconnectDevice();
 
@@ -50,6 +52,7 @@ private slots:
 protected:
     QCanBusDevice     *mDev_p = nullptr;
     QTimer             mTimer;
+    DeviceClock        deviceClock;
 };
 
 
@@ -0,0 +1,359 @@
+#include <QDebug>
+#include <QStringList>
+#include <algorithm>
+
+#include "simulatedconnection.h"
+#include "utils/hiresclock.h"
+
+SimulatedConnection::SimulatedConnection(QString spec) :
+    CANConnection(spec, "simulated", CANCon::SIMULATED, 0, 0, false, 0, getBusCount(spec), SIMULATED_QUEUE_LEN, true),
+    mTimer(this) /*NB: set this as parent of timer to manage it from working thread */
+{
+    parseSpec(spec);
+
+    mReplayPos = 0;
+    mReplayLoopOffsetUs = 0;
+    mStartNs = 0;
+    mStartStampUs = 0;
+
+    CANBus bus_info;
+    bus_info.setActive(true);
+    bus_info.setSpeed(500000);
+    bus_info.setCanFD(mFD);
+    for (int i = 0; i < mNumBuses; i++) setBusConfig(i, bus_info);
+}
+
+
+SimulatedConnection::~SimulatedConnection()
+{
+    stop();
+}
+
+
+int SimulatedConnection::getBusCount(const QString& spec)
+{
+    foreach (const QString& item, spec.split(';', Qt::SkipEmptyParts))
+    {
+        QString key = item.section('=', 0, 0).trimmed().toLower();
+        if (key == "buses") return qBound(1, item.section('=', 1).trimmed().toInt(), SIMULATED_MAX_BUSES);
+    }
+    return 1;
+}
+
+
+void SimulatedConnection::parseSpec(const QString& spec)
+{
+    mNumIDs = 32;
+    mPeriodsMs = {10, 20, 50, 100};
+    mDataLens.clear();
+    mFD = false;
+    mExtended = false;
+    mBurst = 1;
+    mSeed = 1;
+    mSpeed = 1.0;
+    mLoop = false;
+
+    foreach (const QString& item, spec.split(';', Qt::SkipEmptyParts))
+    {
+        QString key = item.section('=', 0, 0).trimmed().toLower();
+        QString value = item.section('=', 1).trimmed();
+
+        if (key == "ids") mNumIDs = qMax(1, value.toInt());
+        else if (key == "period" || key == "dlc")
+        {
+            QVector<double> periods;
+            QVector<int> lens;
+            foreach (const QString& num, value.split(',', Qt::SkipEmptyParts))
+            {
+                if (key == "period" && num.toDouble() > 0.0) periods.append(num.toDouble());
+                if (key == "dlc") lens.append(qBound(0, num.toInt(), 64));
+            }
+            if (!periods.isEmpty()) mPeriodsMs = periods;
+            if (!lens.isEmpty()) mDataLens = lens;
+        }
+        else if (key == "fd") mFD = (value.toInt() != 0);
+        else if (key == "ext") mExtended = (value.toInt() != 0);
+        else if (key == "burst") mBurst = qMax(1, value.toInt());
+        else if (key == "seed") mSeed = value.toUInt();
+        else if (key == "file") mReplayFile = value;
+        else if (key == "speed") mSpeed = qMax(0.0, value.toDouble());
+        else if (key == "loop") mLoop = (value.toInt() != 0);
+        else if (key != "buses") qDebug() << "Simulated connection: unknown key" << key;
+    }
+
+    if (mDataLens.isEmpty())
+    {
+        if (mFD) mDataLens = {8, 12, 16, 32, 64};
+        else mDataLens = {8};
+    }
+
+    /* classic frames can't carry more than 8 bytes and FD only has a few valid lengths */
+    for (int i = 0; i < mDataLens.count(); i++)
+    {
+        int len = mDataLens[i];
+        if (!mFD) len = qMin(len, 8);
+        else if (len > 8)
+        {
+            static const int fdLens[] = {12, 16, 20, 24, 32, 48, 64};
+            for (int l : fdLens) if (l >= len) { len = l; break; }
+        }
+        mDataLens[i] = len;
+    }
+}
+
+
+QString SimulatedConnection::getReplayFile() const
+{
+    return mReplayFile;
+}
+
+
+void SimulatedConnection::setReplayFrames(const QVector<CANFrame>& frames)
+{
+    mReplayFrames = frames;
+}
+
+
+quint64 SimulatedConnection::getGeneratedFrames() const
+{
+    return mGenerated.loadAcquire();
+}
+
+
+quint64 SimulatedConnection::getDroppedFrames() const
+{
+    return mDropped.loadAcquire();
+}
+
+
+void SimulatedConnection::piStarted()
+{
+    mIDs.clear();
+    mHeap.clear();
+    mReplayPos = 0;
+    mReplayLoopOffsetUs = 0;
+    mGenerated.storeRelease(0);
+    mDropped.storeRelease(0);
+
+    if (mReplayFile.isEmpty())
+    {
+        for (int i = 0; i < mNumIDs; i++)
+        {
+            SimID sim;
+            sim.id = mExtended ? (0x18000000 + i) & 0x1FFFFFFF : (0x100 + i) & 0x7FF;
+            sim.bus = i % mNumBuses;
+            sim.dataLen = mDataLens[i % mDataLens.count()];
+            sim.periodUs = qMax<quint64>(1, (quint64)(mPeriodsMs[i % mPeriodsMs.count()] * 1000.0) * mBurst);
+            /* stagger the IDs over their period so they don't all fire on the same tick */
+            sim.nextDueUs = sim.periodUs * i / mNumIDs;
+            sim.counter = 0;
+            mIDs.append(sim);
+            mHeap.append(i);
+        }
+        std::make_heap(mHeap.begin(), mHeap.end(), [this](int a, int b) {
+            return mIDs[a].nextDueUs > mIDs[b].nextDueUs;
+        });
+    }
+    else if (mReplayFrames.isEmpty())
+    {
+        qDebug() << "Simulated connection: nothing loaded from" << mReplayFile;
+    }
+
+    mStartNs = HiResClock::nowNs();
+    mStartStampUs = CANTimebase::nowMicros(useSystemTime);
+
+    connect(&mTimer, SIGNAL(timeout()), this, SLOT(handleTick()));
+    mTimer.setTimerType(Qt::PreciseTimer);
+    mTimer.setInterval(SIMULATED_TICK_MS);
+    mTimer.setSingleShot(false);
+    mTimer.start();
+
+    setStatus(CANCon::CONNECTED);
+
+    CANConStatus stats;
+    stats.conStatus = getStatus();
+    stats.numHardwareBuses = mNumBuses;
+    emit status(stats);
+}
+
+
+void SimulatedConnection::piStop()
+{
+    mTimer.stop();
+    disconnect(&mTimer, nullptr, this, nullptr);
+    setStatus(CANCon::NOT_CONNECTED);
+}
+
+
+void SimulatedConnection::piSuspend(bool pSuspend)
+{
+    /* update capSuspended */
+    setCapSuspended(pSuspend);
+
+    /* flush queue if we are suspended */
+    if(isCapSuspended())
+        getQueue().flush();
+}
+
+
+bool SimulatedConnection::piGetBusSettings(int pBusIdx, CANBus& pBus)
+{
+    return getBusConfig(pBusIdx, pBus);
+}
+
+
+void SimulatedConnection::piSetBusSettings(int pBusIdx, CANBus bus)
+{
+    /* sanity checks */
+    if( (pBusIdx < 0) || pBusIdx >= getNumBuses())
+        return;
+
+    /* copy bus config */
+    setBusConfig(pBusIdx, bus);
+}
+
+
+/* the simulated bus accepts everything. CANConnection already echoes it into the capture */
+bool SimulatedConnection::piSendFrame(const CANFrame& )
+{
+    return true;
+}
+
+
+bool SimulatedConnection::piSendFrames(const QList<CANFrame>& )
+{
+    return true;
+}
+
+
+void SimulatedConnection::handleTick()
+{
+    quint64 nowUs = (quint64)((HiResClock::nowNs() - mStartNs) / 1000);
+
+    if (mReplayFile.isEmpty()) generateUntil(nowUs);
+    else replayUntil(nowUs);
+}
+
+
+bool SimulatedConnection::pushFrame(const CANFrame& frame)
+{
+    mGenerated.fetchAndAddRelaxed(1);
+
+    CANFrame* frame_p = getQueue().get();
+    if (!frame_p)
+    {
+        mDropped.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    *frame_p = frame;
+    checkTargettedFrame(*frame_p);
+    getQueue().queue();
+    return true;
+}
+
+
+/* little endian frame counter in front, then a xorshift stream seeded from seed, ID and counter */
+void SimulatedConnection::fillPayload(SimID& sim, QByteArray& payload)
+{
+    payload.resize(sim.dataLen);
+    char *out = payload.data();
+    quint32 state = mSeed ^ (sim.id * 0x9E3779B1u) ^ (sim.counter * 0x85EBCA6Bu);
+    if (!state) state = 0x6D2B79F5u;
+    for (int c = 0; c < sim.dataLen; c++)
+    {
+        if (c < 2) out[c] = (char)((sim.counter >> (c * 8)) & 0xFF);
+        else
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            out[c] = (char)(state & 0xFF);
+        }
+    }
+    sim.counter++;
+}
+
+
+void SimulatedConnection::generateUntil(quint64 nowUs)
+{
+    auto later = [this](int a, int b) { return mIDs[a].nextDueUs > mIDs[b].nextDueUs; };
+    CANFrame frame;
+    QByteArray payload;
+
+    frame.setFrameType(QCanBusFrame::DataFrame);
+    frame.setExtendedFrameFormat(mExtended);
+    frame.setFlexibleDataRateFormat(mFD);
+    frame.setBitrateSwitch(mFD);
+    frame.isReceived = true;
+
+    while (!mHeap.isEmpty() && mIDs[mHeap.first()].nextDueUs <= nowUs)
+    {
+        std::pop_heap(mHeap.begin(), mHeap.end(), later);
+        SimID& sim = mIDs[mHeap.last()];
+
+        if (!isCapSuspended())
+        {
+            frame.setFrameId(sim.id);
+            frame.bus = sim.bus;
+            frame.setTimeStamp(QCanBusFrame::TimeStamp(0, mStartStampUs + sim.nextDueUs));
+            for (int b = 0; b < mBurst; b++)
+            {
+                fillPayload(sim, payload);
+                frame.setPayload(payload);
+                pushFrame(frame);
+            }
+        }
+
+        sim.nextDueUs += sim.periodUs;
+        std::push_heap(mHeap.begin(), mHeap.end(), later);
+    }
+}
+
+
+void SimulatedConnection::replayUntil(quint64 nowUs)
+{
+    if (mReplayFrames.isEmpty()) return;
+
+    const quint64 firstUs = mReplayFrames.first().timeStamp().microSeconds();
+    const quint64 lastUs = mReplayFrames.last().timeStamp().microSeconds();
+
+    while (true)
+    {
+        if (mReplayPos >= mReplayFrames.count())
+        {
+            if (!mLoop)
+            {
+                mTimer.stop();
+                return;
+            }
+            mReplayPos = 0;
+            mReplayLoopOffsetUs += ((lastUs > firstUs) ? lastUs - firstUs : 0) + 1000;
+        }
+
+        CANFrame frame = mReplayFrames[mReplayPos];
+        /* stamps before the first one (logs jumping back) go out right away instead of wrapping around */
+        const quint64 frameUs = frame.timeStamp().microSeconds();
+        quint64 fileUs = ((frameUs > firstUs) ? frameUs - firstUs : 0) + mReplayLoopOffsetUs;
+        quint64 stampUs;
+
+        if (mSpeed > 0.0)
+        {
+            quint64 dueUs = (quint64)(fileUs / mSpeed);
+            if (dueUs > nowUs) return;
+            stampUs = mStartStampUs + dueUs;
+        }
+        else
+        {
+            /* as fast as possible, but only as fast as the consumer keeps up. Nothing is dropped */
+            if (!getQueue().get()) return;
+            stampUs = mStartStampUs + nowUs;
+        }
+
+        frame.bus = frame.bus % mNumBuses;
+        frame.isReceived = true;
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, stampUs));
+        if (!isCapSuspended()) pushFrame(frame);
+        mReplayPos++;
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef SIMULATEDCONNECTION_H
+#define SIMULATEDCONNECTION_H
+
+#include <QTimer>
+#include <QVector>
+#include <QAtomicInteger>
+
+#include "canconnection.h"
+#include "cantimebase.h"
+
+/* generator tick. Frames due since the last tick are all produced at once */
+#define SIMULATED_TICK_MS       1
+/* queue length, same as the hardware drivers so drops show up at the same load */
+#define SIMULATED_QUEUE_LEN     4000
+#define SIMULATED_MAX_BUSES     8
+
+/*
+  Connection that makes up its own traffic so the whole ingest path can be loaded at a known rate
+  without hardware. Everything is configured from the port string so it is saved and restored like
+  any other connection. It is a list of key=value pairs separated by ';'
+
+  Generated traffic:
+    ids=32              number of distinct IDs, starting at 0x100
+    period=10,20,50,100 periods in ms, handed out to the IDs round robin
+    dlc=8               payload lengths in bytes, handed out round robin (FD lengths allowed with fd=1)
+    fd=0                send CAN-FD frames with bitrate switch
+    ext=0               use 29 bit IDs
+    burst=1             each ID sends this many frames back to back every burst*period
+    buses=1             frames are spread over this many buses
+    seed=1              payload generator seed. Same seed gives the same payloads every run
+
+  File replay:
+    file=path           frames are loaded by CanConFactory and set with setReplayFrames
+    speed=1             replay speed factor. 0 replays as fast as the queue accepts frames
+    loop=0              start over at the end of the file
+
+  Frames are stamped with the time they were scheduled for, not when the tick ran, so the capture
+  shows the intended timing. Frames that do not fit in the queue are counted as dropped.
+*/
+class SimulatedConnection : public CANConnection
+{
+    Q_OBJECT
+
+public:
+    SimulatedConnection(QString spec);
+    virtual ~SimulatedConnection();
+
+    /**
+     * @brief getReplayFile
+     * @return the file given in the spec or an empty string when traffic is generated
+     */
+    QString getReplayFile() const;
+
+    /**
+     * @brief set the frames to replay. Must be called before start()
+     */
+    void setReplayFrames(const QVector<CANFrame>& frames);
+
+    /**
+     * @brief getGeneratedFrames
+     * @return number of frames produced since start, including the dropped ones
+     */
+    quint64 getGeneratedFrames() const;
+
+    /**
+     * @brief getDroppedFrames
+     * @return number of frames that were produced but did not fit in the queue
+     */
+    quint64 getDroppedFrames() const;
+
+    /**
+     * @brief getBusCount
+     * @return the number of buses a spec asks for. Needed before the object exists
+     */
+    static int getBusCount(const QString& spec);
+
+protected:
+
+    virtual void piStarted();
+    virtual void piStop();
+    virtual void piSetBusSettings(int pBusIdx, CANBus pBus);
+    virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
+    virtual void piSuspend(bool pSuspend);
+    virtual bool piSendFrame(const CANFrame&);
+    virtual bool piSendFrames(const QList<CANFrame>&);
+
+private slots:
+    void handleTick();
+
+private:
+    struct SimID
+    {
+        quint32 id;
+        int bus;
+        int dataLen;
+        quint64 periodUs;
+        quint64 nextDueUs;  //offset from start
+        quint32 counter;
+    };
+
+    void parseSpec(const QString& spec);
+    void generateUntil(quint64 nowUs);
+    void replayUntil(quint64 nowUs);
+    bool pushFrame(const CANFrame& frame);
+    void fillPayload(SimID& sim, QByteArray& payload);
+
+    QTimer mTimer;
+
+    /* profile */
+    int mNumIDs;
+    QVector<double> mPeriodsMs;
+    QVector<int> mDataLens;
+    bool mFD;
+    bool mExtended;
+    int mBurst;
+    quint32 mSeed;
+
+    /* replay */
+    QString mReplayFile;
+    QVector<CANFrame> mReplayFrames;
+    double mSpeed;
+    bool mLoop;
+    int mReplayPos;
+    quint64 mReplayLoopOffsetUs; //file time covered by previous loops
+
+    QVector<SimID> mIDs;
+    QVector<int> mHeap;         //indices into mIDs ordered as a min heap on nextDueUs
+    qint64 mStartNs;
+    quint64 mStartStampUs;
+
+    QAtomicInteger<quint64> mGenerated;
+    QAtomicInteger<quint64> mDropped;
+};
+
+#endif // SIMULATEDCONNECTION_H
@@ -6,9 +6,32 @@
 #include <QStringBuilder>
 #include <QtNetwork>
 #include <QMetaObject>
+#include <cstring>
 
 #include "socketcand.h"
 
+//Initial capacity of each per-bus receive buffer. Raw mode traffic only ever leaves a partial token
+//behind so the buffer never needs to grow beyond one socket read plus one token.
+#define SOCKETCAND_RX_RESERVE   16384
+//A single socketcand token is far smaller than this. If no closing '>' shows up within this many bytes
+//the stream is garbage and gets thrown away.
+#define SOCKETCAND_MAX_TOKEN    512
+
+static inline int hexNibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+//Compares a complete token against a literal command, ie "< ok >"
+static inline bool tokenIs(const char *token, int len, const char *literal)
+{
+    int litLen = (int)strlen(literal);
+    return (len == litLen) && (memcmp(token, literal, litLen) == 0);
+}
+
 SocketCANd::SocketCANd(QString portName) :
     CANConnection(portName, "kayak", CANCon::KAYAK, 0, 0, false, 0, 1, 4000, true),
     mTimer(this) /*NB: set this as parent of timer to manage it from working thread */
@@ -32,7 +55,9 @@ SocketCANd::SocketCANd(QString portName) :
     for (int i = 0; i < mNumBuses; i++)
     {
         rx_state.append(IDLE);
-        unprocessedData.append("");
+        rxBuffer.append(QByteArray());
+        rxBuffer.last().reserve(SOCKETCAND_RX_RESERVE);
+        deviceClock.append(DeviceClock());
     }
 
 }
@@ -122,12 +147,33 @@ void SocketCANd::piSetBusSettings(int pBusIdx, CANBus bus)
 }
 
 
-bool SocketCANd::piSendFrame(const CANFrame& frame)
+//Appends "< send ID LEN B0 B1 ... >" for one frame. Extended IDs are written as 8 hex digits which is how socketcand tells them apart
+static void appendSendCommand(const CANFrame& frame, QByteArray &buffer)
 {
-    QByteArray buffer;
-    int c;
-    int ID;
+    static const char hexDigits[] = "0123456789abcdef";
+    char idStr[16];
+    const QByteArray payload = frame.payload();
+
+    if (frame.hasExtendedFrameFormat()) qsnprintf(idStr, sizeof(idStr), "%08x", frame.frameId());
+    else qsnprintf(idStr, sizeof(idStr), "%x", frame.frameId());
+
+    buffer.append("< send ");
+    buffer.append(idStr);
+    buffer.append(' ');
+    buffer.append(QByteArray::number(payload.length()));
+    buffer.append(' ');
+    for (int c = 0; c < payload.length(); c++)
+    {
+        unsigned char byt = (unsigned char)payload[c];
+        buffer.append(hexDigits[byt >> 4]);
+        buffer.append(hexDigits[byt & 0xF]);
+        buffer.append(' ');
+    }
+    buffer.append('>');
+}
 
+bool SocketCANd::piSendFrame(const CANFrame& frame)
+{
 //    //calculate bus number offset (in case of multiple connections)
 //    //useless since SavvyCAN already delivers the right index in frame.bus
 //    QList<CANConnection*> connList = CANConManager::getInstance()->getConnections();
@@ -143,6 +189,7 @@ bool SocketCANd::piSendFrame(const CANFrame& frame)
 
     framesRapid++;
 
+    if (busNum < 0 || busNum >= tcpClient.count()) return false;
     if (tcpClient[busNum] && !tcpClient[busNum]->isOpen()) return false;
     //if (!isConnected) return false;
 
@@ -151,18 +198,36 @@ bool SocketCANd::piSendFrame(const CANFrame& frame)
     if (frame.frameId() & 0x20000000) {
         return true;
     }
-    ID = frame.frameId();
-    if (frame.hasExtendedFrameFormat()) ID |= 1 << 31;
 
-    QString sendStr = "< send " + QString::number(ID, 16) + " " + QString::number(frame.payload().length()) + " ";
-    for (c = 0; c < frame.payload().length(); c++)
+    QByteArray sendCmd;
+    appendSendCommand(frame, sendCmd);
+    sendStringToTCP(sendCmd.constData(), busNum);
+
+    return true;
+}
+
+/*
+ * Pipelines the whole batch: commands are collected per bus and each bus socket gets one write.
+ * socketcand doesn't acknowledge raw mode sends so there is nothing to wait for in between.
+*/
+bool SocketCANd::piSendFrames(const QList<CANFrame>& frames)
+{
+    QVarLengthArray<QByteArray, 4> perBus(tcpClient.count());
+
+    foreach (const CANFrame& frame, frames)
+    {
+        framesRapid++;
+        if (frame.bus < 0 || frame.bus >= perBus.count()) return false;
+        if (frame.frameId() & 0x20000000) continue;
+        if (perBus[frame.bus].isEmpty()) perBus[frame.bus].reserve(frames.count() * 48);
+        appendSendCommand(frame, perBus[frame.bus]);
+    }
+
+    for (int busNum = 0; busNum < perBus.count(); busNum++)
     {
-       sendStr.append(QString::number(frame.payload()[c], 16) + " ");
+        if (perBus[busNum].isEmpty()) continue;
+        if (tcpClient[busNum] && tcpClient[busNum]->isOpen()) tcpClient[busNum]->write(perBus[busNum]);
     }
-    sendStr.append(">");
-    std::string str = sendStr.toStdString();
-    const char* sendCmd = str.c_str();
-    sendStringToTCP(sendCmd, busNum);
 
     return true;
 }
@@ -202,6 +267,8 @@ void SocketCANd::connectDevice()
     for (int i = 0; i < mNumBuses; i++)
     {
         rx_state[i] = IDLE;
+        rxBuffer[i].resize(0);
+        deviceClock[i].reset();
         tcpClient.append(new QTcpSocket());
         tcpClient[i]->connectToHost(hostIP, hostPort);
         //connect(tcpClient[i], SIGNAL(readyRead()), this, SLOT(readTCPData()));
@@ -250,89 +317,93 @@ void SocketCANd::switchToRawMode(int busNum)
     QCoreApplication::processEvents();
 }
 
-QString SocketCANd::decodeFrames(QString data, int busNum)
+/*
+ * Decodes one complete raw mode token of the form "< frame ID SECS.USECS DATA >" straight into the
+ * next free slot of the queue. Works on the bytes as received so there are no QString conversions
+ * and the only allocation is the payload QByteArray that QCanBusFrame needs anyway.
+*/
+void SocketCANd::decodeFrame(const char *token, int len, int busNum)
 {
-    if (data.indexOf("<") == -1)
-        return "";
-    else if(data.length() >= 8 && data.indexOf("< frame ") == -1)
-        return "";
-
-    int firstIndex = data.indexOf("< frame ");
-    if(firstIndex > 0)
+    const char *ptr = token + 1; //skip '<'
+    const char *end = token + len - 1; //points at '>'
+
+    while (ptr < end && *ptr == ' ') ptr++;
+    if ((end - ptr) < 5 || memcmp(ptr, "frame", 5) != 0) return; //not a frame (error, echo, etc) so ignore it
+    ptr += 5;
+
+    //ID in hex
+    while (ptr < end && *ptr == ' ') ptr++;
+    uint32_t id = 0;
+    int digits = 0;
+    int nib;
+    while (ptr < end && (nib = hexNibble(*ptr)) >= 0)
     {
-        QString framePartial = data.left(firstIndex);
-        qDebug() << "Received datagramm that starts with fragment (missing '< frame'), this should only occur on startup, removing...: " << framePartial;
+        id = (id << 4) | nib;
+        ptr++;
+        digits++;
     }
-    QString framePart = data.mid(firstIndex); //remove starting beginning of payload if not < frame >
-    const QString frameStrConst = framePart.left(framePart.indexOf(">")+1);
-    QString frameStr = frameStrConst;
-    QStringList frameParsed = (frameStr.remove(QRegularExpression("^<")).remove(QRegularExpression(">$"))).simplified().split(' ');
-
-    if(frameParsed.length() < 3)
+    if (digits == 0) return;
+
+    //timestamp as seconds.microseconds
+    while (ptr < end && *ptr == ' ') ptr++;
+    uint64_t secs = 0;
+    uint64_t usecs = 0;
+    digits = 0;
+    while (ptr < end && *ptr >= '0' && *ptr <= '9')
     {
-        //qDebug() << "Received datagramm is an incomplete frame: " << data;
-
-        //ok great, need to leave it in the buffer in case it can be combined with what comes next
-        //but if there was a fragment that did not have a starting token then we don't want it so only return
-        //known good data...again this should only happen on startup, but just in case we need to remove it
-        //so the data buffer doesn't grow uncontrolled.
-        return framePart;
+        secs = secs * 10 + (*ptr++ - '0');
+        digits++;
     }
-
-    buildFrame.setFrameId(frameParsed[1].toUInt(nullptr, 16));
-    buildFrame.bus = busNum;
-
-    if (buildFrame.frameId() > 0x7FF) buildFrame.setExtendedFrameFormat(true);
-    else buildFrame.setExtendedFrameFormat(false);
-
-    buildFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, frameParsed[2].toDouble() * 1000000l));
-    //buildFrame.len =  frameParsed[3].length() * 0.5;
-
-    int framelength = 0;
-
-    if(frameParsed.length() == 4)
+    if (digits == 0) return;
+    if (ptr < end && *ptr == '.')
     {
-        framelength = frameParsed[3].length() * 0.5;
+        ptr++;
+        int fracDigits = 0;
+        while (ptr < end && *ptr >= '0' && *ptr <= '9')
+        {
+            if (fracDigits < 6)
+            {
+                usecs = usecs * 10 + (*ptr - '0');
+                fracDigits++;
+            }
+            ptr++;
+        }
+        for (; fracDigits < 6; fracDigits++) usecs *= 10;
     }
 
-    QByteArray buildData;
-    buildData.resize(framelength);
+    //optional data as one run of hex digits
+    while (ptr < end && *ptr == ' ') ptr++;
+    const char *dataStart = ptr;
+    while (ptr < end && hexNibble(*ptr) >= 0) ptr++;
+    int dataLen = (int)(ptr - dataStart) / 2;
+    if (dataLen > 64) return;
 
-    int c;
-    for (c = 0; c < framelength; c++)
-    {
-        bool ok;
-        unsigned char byteVal = frameParsed[3].mid(c*2, 2).toUInt(&ok, 16);
-        buildData[c] = byteVal;
-    }
-    buildFrame.setPayload(buildData);
-//        buildFrame.isReceived = true;
+    if (isCapSuspended()) return;
 
-    if (!isCapSuspended())
-    {
-        /* get frame from queue */
-        CANFrame* frame_p = getQueue().get();
-        if(frame_p) {
-            /* copy frame */
-            *frame_p = buildFrame;
-            //frame_p->remote = false;
-            frame_p->setFrameType(QCanBusFrame::DataFrame);
-            checkTargettedFrame(buildFrame);
-            /* enqueue frame */
-            getQueue().queue();
-        }
-    }
-    //else
-    //    qDebug() << "can't get a frame, capture suspended";
+    /* get frame from queue */
+    CANFrame* frame_p = getQueue().get();
+    if (!frame_p) return;
 
-    //take out the data that we just processed and anything that is in front of it
-    //this should keep broken frames from accumulating at in the data buffer
-    if (framePart.length() > frameStrConst.length())
+    QByteArray payload(dataLen, Qt::Uninitialized);
+    char *out = payload.data();
+    for (int c = 0; c < dataLen; c++)
     {
-        return decodeFrames(framePart.right(framePart.length() - frameStrConst.length()), busNum);
+        out[c] = (char)((hexNibble(dataStart[c * 2]) << 4) | hexNibble(dataStart[c * 2 + 1]));
     }
 
-    return "";
+    frame_p->setFrameId(id);
+    frame_p->bus = busNum;
+    frame_p->setExtendedFrameFormat(id > 0x7FF);
+    frame_p->setFrameType(QCanBusFrame::DataFrame);
+    frame_p->setFlexibleDataRateFormat(dataLen > 8);
+    frame_p->setTimeStamp(QCanBusFrame::TimeStamp(0, deviceClock[busNum].stamp(secs * 1000000ull + usecs)));
+    frame_p->setPayload(payload);
+    frame_p->isReceived = true;
+    frame_p->timedelta = 0;
+    frame_p->frameCount = 1;
+    checkTargettedFrame(*frame_p);
+    /* enqueue frame */
+    getQueue().queue();
 }
 
 void SocketCANd::disconnectDevice() {
@@ -367,73 +438,99 @@ void SocketCANd::invokeReadTCPData()
 
 void SocketCANd::readTCPData(int busNum)
 {
-    QString data;
+    QTcpSocket* socket = tcpClient.value(busNum);
+    if (!socket || busNum >= rxBuffer.count()) return;
+
+    qint64 avail = socket->bytesAvailable();
+    if (avail <= 0) return;
 
-    if (QTcpSocket* socket = tcpClient.value(busNum))
-        data = QString(socket->readAll());
-    //sendDebug("Got data from TCP. Len = " % QString::number(data.length()));
-    //qDebug() << "Received datagramm: " << data;
-    procRXData(data, busNum);
+    //read straight onto the tail of whatever partial token is left from the last read
+    QByteArray &buffer = rxBuffer[busNum];
+    int oldLen = buffer.size();
+    buffer.resize(oldLen + (int)avail);
+    qint64 got = socket->read(buffer.data() + oldLen, avail);
+    buffer.resize(oldLen + (int)qMax<qint64>(got, 0));
+    if (buffer.size() == oldLen) return;
+
+    mTimer.stop();
+    mTimer.start();
+
+    deviceClock[busNum].beginBatch(useSystemTime);
+    procRXData(busNum);
 }
 
-void SocketCANd::procRXData(QString data, int busNum)
+/*
+ * Splits the receive buffer for a bus into complete "< ... >" tokens and hands each one to procToken.
+ * Anything in front of a '<' is noise (this should only happen on startup) and is skipped. An
+ * unterminated token at the end of the buffer is kept for the next read.
+*/
+void SocketCANd::procRXData(int busNum)
 {
-    if (data != "")
+    QByteArray &buffer = rxBuffer[busNum];
+    const char *data = buffer.constData();
+    const int len = buffer.size();
+    int pos = 0;
+
+    while (pos < len)
     {
-        mTimer.stop();
-        mTimer.start();
+        const char *open = static_cast<const char *>(memchr(data + pos, '<', len - pos));
+        if (!open)
+        {
+            pos = len;
+            break;
+        }
+        int tokenStart = (int)(open - data);
+        const char *close = static_cast<const char *>(memchr(open, '>', len - tokenStart));
+        if (!close)
+        {
+            pos = tokenStart;
+            if ((len - tokenStart) > SOCKETCAND_MAX_TOKEN)
+            {
+                qDebug() << "busNum: " << busNum << "- " << (len - tokenStart) << " bytes without end of token, something is wrong, clearing...";
+                pos = len;
+            }
+            break;
+        }
+        int tokenLen = (int)(close - open) + 1;
+        procToken(open, tokenLen, busNum);
+        pos = tokenStart + tokenLen;
     }
+
+    if (pos >= len) buffer.resize(0);
+    else if (pos > 0) buffer.remove(0, pos);
+}
+
+void SocketCANd::procToken(const char *token, int len, int busNum)
+{
     switch (rx_state.at(busNum))
     {
     case IDLE:
-        qDebug() << "Received datagramm: " << data;
-        if (data == "< hi >")
+        qDebug() << "Received datagramm: " << QByteArray(token, len);
+        if (tokenIs(token, len, "< hi >"))
         {
             deviceConnected(busNum);
             rx_state[busNum] = BCM;
         }
-        else qInfo() << hostCanIDs[busNum] << ": Could not open bus. Host did not greet with ""< hi >"": " << data;
+        else qInfo() << hostCanIDs[busNum] << ": Could not open bus. Host did not greet with ""< hi >"": " << QByteArray(token, len);
         break;
     case BCM:
-        qDebug() << "Received datagramm: " << data;
-        if (data == "< ok >")
+        qDebug() << "Received datagramm: " << QByteArray(token, len);
+        if (tokenIs(token, len, "< ok >"))
         {
             switchToRawMode(busNum);
             rx_state[busNum] = SWITCHING2RAW;
-            unprocessedData[busNum].clear();
         }
-        else qInfo() << hostCanIDs[busNum] << ": Could not open bus. Host did not respond with ""< ok >"": " << data;
+        else qInfo() << hostCanIDs[busNum] << ": Could not open bus. Host did not respond with ""< ok >"": " << QByteArray(token, len);
         break;
     case SWITCHING2RAW:
-        qDebug() << "Received datagramm: " << data;
-        if (data == "< ok >")
-        {
-            rx_state[busNum] = RAWMODE;
-        }
-        else if(data.indexOf("< ok >", 0, Qt::CaseSensitivity::CaseInsensitive) == 0)
-        {
-            qDebug() << "Ok found at start of compound message, switching to RAW and decoding immediately";
-            rx_state[busNum] = RAWMODE;
-            unprocessedData[busNum] = decodeFrames(data, busNum);
-        }
-        else if(data.indexOf("< ok >", 0, Qt::CaseSensitivity::CaseInsensitive) > 0)
+        qDebug() << "Received datagramm: " << QByteArray(token, len);
+        if (tokenIs(token, len, "< ok >"))
         {
-            qDebug() << "Ok found at in middle of compound message, switching to RAW and decoding immediately";
             rx_state[busNum] = RAWMODE;
-            unprocessedData[busNum] = decodeFrames(data, busNum);
         }
         break;
     case RAWMODE:
-        unprocessedData[busNum] = decodeFrames(unprocessedData[busNum] + data, busNum);
-
-        if(unprocessedData[busNum].length() > 128)
-        {
-            //the buffer has grown too much we need to clear it out, but what is good logic for that?
-            //the decodeFrames function strips out datat that doesn't have a '< frame' starting token, and in its
-            //recursive calling of itself it strips out data that preceedes valid frames, so this should never happen
-            qDebug() << "busNum: " << busNum << "- " << unprocessedData[busNum].length() << " bytes in unprocessedData, something is wrong, clearing...";
-            unprocessedData[busNum].clear();
-        }
+        decodeFrame(token, len, busNum);
         break;
     case ISOTP:
         break;
@@ -15,6 +15,7 @@
 #include "canframemodel.h"
 #include "canconnection.h"
 #include "canconmanager.h"
+#include "cantimebase.h"
 
 
 namespace KAYAKSTATE {
@@ -47,6 +48,7 @@ protected:
     virtual bool piGetBusSettings(int pBusIdx, CANBus& pBus);
     virtual void piSuspend(bool pSuspend);
     virtual bool piSendFrame(const CANFrame&);
+    virtual bool piSendFrames(const QList<CANFrame>&);
 
     void disconnectDevice();
 
@@ -57,10 +59,11 @@ private slots:
     void invokeReadTCPData();
     void deviceConnected(int busNum);
     void switchToRawMode(int busNum);
-    QString decodeFrames(QString, int busNum);
 
 private:
-    void procRXData(QString, int busNum);
+    void procRXData(int busNum);
+    void procToken(const char *token, int len, int busNum);
+    void decodeFrame(const char *token, int len, int busNum);
     void sendBytesToTCP(const QByteArray &bytes, int busNum);
     void sendStringToTCP(const char* data, int busNum);
     void sendDebug(const QString debugText);
@@ -74,8 +77,8 @@ protected:
     QList<QString> hostCanIDs;
     int framesRapid;
     QVarLengthArray<MODE> rx_state;
-    CANFrame buildFrame;
-    QVarLengthArray<QString> unprocessedData;
+    QVector<QByteArray> rxBuffer; //raw bytes per bus not yet consumed by procRXData (at most one partial token)
+    QVector<DeviceClock> deviceClock; //each bus is its own stream from the server so each gets its own clock mapping
 };
 
 
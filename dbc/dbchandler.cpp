@@ -449,6 +449,7 @@ void DBCFile::findAttributesByType(DBC_ATTRIBUTE_TYPE typ, QList<DBC_ATTRIBUTE>
 void DBCFile::setDirtyFlag()
 {
     isDirty = true;
+    emit DBCHandler::getReference()->filesChanged();
 }
 
 //BE CAREFUL HERE. Do not clear the dirty flag unless you're absolutely sure nothing has changed.
@@ -1780,6 +1781,7 @@ int DBCHandler::createBlankFile()
     newFile.setAssocBus(-1);
 
     loadedFiles.append(newFile);
+    emit filesChanged();
     return loadedFiles.count();
 }
 
@@ -1789,6 +1791,7 @@ DBCFile* DBCHandler::loadDBCFile(QString filename)
     if (newFile.loadFile(filename))
     {
         loadedFiles.append(newFile);
+        emit filesChanged();
     }
     else
     {
@@ -2179,11 +2182,13 @@ void DBCHandler::removeDBCFile(int idx)
     if (idx < 0) return;
     if (idx >= loadedFiles.count()) return;
     loadedFiles.removeAt(idx);
+    emit filesChanged();
 }
 
 void DBCHandler::removeAllFiles()
 {
     loadedFiles.clear();
+    emit filesChanged();
 }
 
 void DBCHandler::swapFiles(int pos1, int pos2)
@@ -2195,6 +2200,7 @@ void DBCHandler::swapFiles(int pos1, int pos2)
     if (pos2 >= loadedFiles.count()) return;
 
     loadedFiles.swapItemsAt(pos1, pos2);
+    emit filesChanged();
 }
 
 /*
@@ -135,6 +135,10 @@ public:
     DBCFile* loadSecretCSVFile(QString);
     static DBCHandler *getReference();
 
+signals:
+    /* a file was loaded, removed or reordered, or one of them was edited. Anything that copied layouts out should look them up again */
+    void filesChanged();
+
 private:
     QList<DBCFile> loadedFiles;
 
@@ -0,0 +1,213 @@
+#include <cmath>
+#include <cstring>
+#include "signalcodec.h"
+
+namespace
+{
+    inline int64_t signExtend(uint64_t raw, int size)
+    {
+        if (size < 64 && (raw & (1ULL << (size - 1)))) raw |= ~((1ULL << size) - 1);
+        return (int64_t)raw;
+    }
+
+    inline int minLength(const QVector<SignalCodecSegment>& segments)
+    {
+        int len = 0;
+        foreach (const SignalCodecSegment &seg, segments) len = qMax(len, seg.byteIdx + 1);
+        return len;
+    }
+}
+
+/*
+ * Walks the bits in the same order as Utility::processIntegerSignal. Intel counts up from the start bit.
+ * Motorola counts down within a byte and jumps to the top of the next byte. Either way neighbouring bits
+ * in a byte stay neighbours in the value so they are gathered up into one run.
+ */
+QVector<SignalCodecSegment> SignalCodec::layout(int startBit, int signalSize, bool intelByteOrder)
+{
+    QVector<SignalCodecSegment> segments;
+    int bit = startBit;
+    for (int i = 0; i < signalSize; i++)
+    {
+        if (bit < 0 || bit >= 512) break;
+        const int byteIdx = bit / 8;
+        const int inByte = bit % 8;
+        const int rawBit = intelByteOrder ? i : (signalSize - i - 1);
+
+        bool joined = false;
+        if (!segments.isEmpty() && segments.last().byteIdx == byteIdx)
+        {
+            SignalCodecSegment &seg = segments.last();
+            if (intelByteOrder && inByte == seg.shift + seg.width && rawBit == seg.rawShift + seg.width)
+            {
+                seg.width++;
+                joined = true;
+            }
+            else if (!intelByteOrder && inByte == seg.shift - 1 && rawBit == seg.rawShift - 1)
+            {
+                seg.shift--;
+                seg.rawShift--;
+                seg.width++;
+                joined = true;
+            }
+        }
+        if (!joined) segments.append({byteIdx, inByte, 1, rawBit});
+
+        if (intelByteOrder) bit++;
+        else if ((bit % 8) == 0) bit += 15;
+        else bit--;
+    }
+    return segments;
+}
+
+SignalCodecSpec SignalCodec::fromSignal(const DBC_SIGNAL *sig)
+{
+    SignalCodecSpec spec;
+    spec.valType = sig->valType;
+    spec.factor = sig->factor;
+    spec.bias = sig->bias;
+    spec.neverPresent = false;
+
+    if (sig->valType == SP_FLOAT) spec.signalSize = 32;
+    else if (sig->valType == DP_FLOAT) spec.signalSize = 64;
+    else spec.signalSize = qBound(1, sig->signalSize, 64);
+    spec.segments = layout(sig->startBit, spec.signalSize, sig->intelByteOrder);
+    spec.minLength = minLength(spec.segments);
+
+    //same walk as isSignalInMessage, up to the root multiplexor
+    for (const DBC_SIGNAL *cur = sig; cur && cur->isMultiplexed; cur = cur->multiplexParent)
+    {
+        const DBC_SIGNAL *parent = cur->multiplexParent;
+        if (!cur->parentMessage->multiplexorSignal || !parent || parent->valType == STRING
+                || parent->valType == SP_FLOAT || parent->valType == DP_FLOAT)
+        {
+            spec.neverPresent = true;
+            break;
+        }
+
+        SignalCodecMux mux;
+        mux.signalSize = qBound(1, parent->signalSize, 64);
+        mux.segments = layout(parent->startBit, mux.signalSize, parent->intelByteOrder);
+        mux.isSigned = (parent->valType == SIGNED_INT);
+        mux.factor = parent->factor;
+        mux.bias = parent->bias;
+        mux.lowValue = cur->multiplexLowValue;
+        mux.highValue = cur->multiplexHighValue;
+        spec.minLength = qMax(spec.minLength, minLength(mux.segments));
+        spec.muxChecks.append(mux);
+    }
+    return spec;
+}
+
+uint64_t SignalCodec::extract(const QVector<SignalCodecSegment>& segments, const unsigned char *data)
+{
+    uint64_t raw = 0;
+    foreach (const SignalCodecSegment &seg, segments)
+    {
+        const uint64_t bits = (data[seg.byteIdx] >> seg.shift) & ((1u << seg.width) - 1);
+        raw |= bits << seg.rawShift;
+    }
+    return raw;
+}
+
+void SignalCodec::insert(const QVector<SignalCodecSegment>& segments, uint64_t raw, unsigned char *data)
+{
+    foreach (const SignalCodecSegment &seg, segments)
+    {
+        const unsigned int mask = ((1u << seg.width) - 1) << seg.shift;
+        const unsigned int bits = (unsigned int)((raw >> seg.rawShift) << seg.shift) & mask;
+        data[seg.byteIdx] = (unsigned char)((data[seg.byteIdx] & ~mask) | bits);
+    }
+}
+
+bool SignalCodec::isPresent(const SignalCodecSpec& spec, const QByteArray& payload)
+{
+    if (spec.neverPresent || payload.length() < spec.minLength) return false;
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    foreach (const SignalCodecMux &mux, spec.muxChecks)
+    {
+        uint64_t raw = extract(mux.segments, data);
+        int32_t val = static_cast<int32_t>(mux.isSigned ? signExtend(raw, mux.signalSize) : (int64_t)raw);
+        val = static_cast<int32_t>((val * mux.factor) + mux.bias);
+        if (val < mux.lowValue || val > mux.highValue) return false;
+    }
+    return true;
+}
+
+bool SignalCodec::decode(const SignalCodecSpec& spec, const QByteArray& payload, double& value)
+{
+    if (spec.valType == STRING || !isPresent(spec, payload)) return false;
+
+    const uint64_t raw = extract(spec.segments, reinterpret_cast<const unsigned char *>(payload.constData()));
+    switch (spec.valType)
+    {
+    case SIGNED_INT:
+        value = (signExtend(raw, spec.signalSize) * spec.factor) + spec.bias;
+        break;
+    case SP_FLOAT:
+    {
+        const quint32 bits = (quint32)raw;
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        value = (f * spec.factor) + spec.bias;
+        break;
+    }
+    case DP_FLOAT:
+    {
+        double d;
+        memcpy(&d, &raw, sizeof(d));
+        value = (d * spec.factor) + spec.bias;
+        break;
+    }
+    default:
+        value = ((int64_t)raw * spec.factor) + spec.bias;
+        break;
+    }
+    return true;
+}
+
+bool SignalCodec::encode(const SignalCodecSpec& spec, double value, QByteArray& payload)
+{
+    if (spec.valType == STRING || std::isnan(value)) return false;
+    if (payload.length() < spec.minLength) payload.append(QByteArray(spec.minLength - payload.length(), 0));
+
+    const double scaled = (spec.factor != 0.0) ? (value - spec.bias) / spec.factor : 0.0;
+    uint64_t raw;
+    switch (spec.valType)
+    {
+    case SP_FLOAT:
+    {
+        const float f = (float)scaled;
+        quint32 bits;
+        memcpy(&bits, &f, sizeof(bits));
+        raw = bits;
+        break;
+    }
+    case DP_FLOAT:
+        memcpy(&raw, &scaled, sizeof(raw));
+        break;
+    default:
+    {
+        //out of range values are clamped to what the signal can hold rather than wrapped around
+        const int size = spec.signalSize;
+        const double rounded = std::round(scaled);
+        if (spec.valType == SIGNED_INT)
+        {
+            const double half = std::ldexp(1.0, size - 1);
+            const int64_t top = (int64_t)((1ULL << (size - 1)) - 1);
+            int64_t val;
+            if (rounded >= half) val = top;
+            else if (rounded < -half) val = -top - 1;
+            else val = (int64_t)rounded;
+            raw = (uint64_t)val;
+        }
+        else if (rounded <= 0) raw = 0;
+        else if (rounded >= std::ldexp(1.0, size)) raw = (size < 64) ? (1ULL << size) - 1 : ~0ULL;
+        else raw = (uint64_t)rounded;
+        if (size < 64) raw &= (1ULL << size) - 1;
+        break;
+    }
+    }
+    insert(spec.segments, raw, reinterpret_cast<unsigned char *>(payload.data()));
+    return true;
+}
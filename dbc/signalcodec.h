@@ -0,0 +1,71 @@
+#ifndef SIGNALCODEC_H
+#define SIGNALCODEC_H
+
+#include <QVector>
+#include <QByteArray>
+#include "dbc/dbc_classes.h"
+
+/* the bits of a signal that sit in one payload byte */
+struct SignalCodecSegment
+{
+    int byteIdx;
+    int shift;          //lowest bit of the run within the byte
+    int width;
+    int rawShift;       //where that bit goes in the raw signal value
+};
+
+/* one multiplexor value range a signal needs to be present, as DBC_SIGNAL::isSignalInMessage checks it */
+struct SignalCodecMux
+{
+    QVector<SignalCodecSegment> segments;
+    int signalSize;
+    bool isSigned;
+    double factor;
+    double bias;
+    int lowValue;
+    int highValue;
+};
+
+/* everything needed to decode or encode one signal */
+struct SignalCodecSpec
+{
+    QVector<SignalCodecSegment> segments;
+    int signalSize;
+    DBC_SIG_VAL_TYPE valType;
+    double factor;
+    double bias;
+    int minLength;      //payload bytes the signal needs
+    bool neverPresent;  //multiplexed on something that can't be read as an integer
+    QVector<SignalCodecMux> muxChecks;
+};
+
+/*
+  Decodes and encodes DBC signals without going back to the DBC for every frame. A signal's bit layout,
+  Intel or Motorola, is worked out once into runs of bits per payload byte so a value is a handful of
+  shifts and masks instead of a loop over every bit. The numbers come out the same as processAsDouble
+  gives them, and whether a multiplexed signal is present is checked the same way as isSignalInMessage.
+
+  Specs are copies. Once made they don't touch the DBC again, so they can be used from any thread.
+*/
+class SignalCodec
+{
+public:
+    static SignalCodecSpec fromSignal(const DBC_SIGNAL *sig);
+    static QVector<SignalCodecSegment> layout(int startBit, int signalSize, bool intelByteOrder);
+
+    static uint64_t extract(const QVector<SignalCodecSegment>& segments, const unsigned char *data);
+    static void insert(const QVector<SignalCodecSegment>& segments, uint64_t raw, unsigned char *data);
+
+    static bool isPresent(const SignalCodecSpec& spec, const QByteArray& payload);
+
+    /**
+     * @brief scaled value of the signal in payload
+     * @return false if the signal isn't in this payload (too short, other multiplex value or a string signal)
+     */
+    static bool decode(const SignalCodecSpec& spec, const QByteArray& payload, double& value);
+
+    /* puts value into payload, growing it to the length the signal needs. Multiplexors are left alone */
+    static bool encode(const SignalCodecSpec& spec, double value, QByteArray& payload);
+};
+
+#endif // SIGNALCODEC_H
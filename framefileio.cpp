@@ -14,6 +14,8 @@
 #include "blfhandler.h"
 
 QFile FrameFileIO::continuousFile;
+std::function<void(QVector<CANFrame>&)> FrameFileIO::frameSink;
+int FrameFileIO::sinkChunkFrames = 0;
 
 struct TeslaAPCANRecord
 {
@@ -265,6 +267,27 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
 }
 
 
+bool FrameFileIO::streamFrameFile(QString &fileName, std::function<void(QVector<CANFrame>&)> sink, int chunkFrames)
+{
+    QVector<CANFrame> block;
+    block.reserve(chunkFrames);
+
+    frameSink = sink;
+    sinkChunkFrames = qMax(1, chunkFrames);
+    bool result = loadFrameFile(fileName, &block);
+    if (!block.isEmpty()) flushToSink(&block);
+    frameSink = nullptr;
+
+    return result;
+}
+
+void FrameFileIO::flushToSink(QVector<CANFrame>* frames)
+{
+    frameSink(*frames);
+    frames->clear();
+    frames->reserve(sinkChunkFrames);
+}
+
 //Try every format by first using the "is" functions which try to detect whether a given file is a good match to that
 //file format or not. Those functions are much less tolerant than the load functions and so should help to discriminate
 //whether a file could be loaded or not by a given loader. The loader return is still used in case the guess was wrong.
@@ -634,7 +657,7 @@ bool FrameFileIO::loadVehicleSpyFile(QString filename, QVector<CANFrame> *frames
                 else break;
             }
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendFrame(frames, thisFrame);
         }
         else foundErrors = true;
     }
@@ -797,7 +820,7 @@ bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame>* frames)
                         else bytes[d] = 0;
                     }
                     thisFrame.setPayload(bytes);
-                    frames->append(thisFrame);
+                    appendFrame(frames, thisFrame);
                 }
             }
             else foundErrors = true;
@@ -907,7 +930,7 @@ bool FrameFileIO::loadCARBUSAnalyzerFile(QString filename, QVector<CANFrame>* fr
                     else bytes[d] = 0;
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
             else
             {
@@ -1140,7 +1163,7 @@ bool FrameFileIO::loadCANHackerFile(QString filename, QVector<CANFrame>* frames)
                     else bytes[d] = 0;
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -1258,7 +1281,7 @@ bool FrameFileIO::loadCANOpenFile(QString filename, QVector<CANFrame>* frames)
                     else bytes[d] = 0;
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -1480,7 +1503,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1531,7 +1554,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1573,7 +1596,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1625,7 +1648,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1881,7 +1904,7 @@ bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
                         }
                         thisFrame.setPayload(bytes);
                     }
-                    frames->append(thisFrame);
+                    appendFrame(frames, thisFrame);
                 }
             }
         }
@@ -2154,7 +2177,7 @@ bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
                     thisFrame.setPayload(bytes);
                 }
 
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -2424,7 +2447,7 @@ bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame>* frames
                 QByteArray bytes(dLen, 0);
                 for (int d = 0; d < dLen; d++) bytes[d] = static_cast<char>(dataTok[d].toInt(nullptr, 16));
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
         }
         else foundErrors = true;
@@ -2630,7 +2653,7 @@ bool FrameFileIO::loadLogFile(QString filename, QVector<CANFrame>* frames)
                         bytes[d] = static_cast<char>(tokens[d + 6].toInt(nullptr, 16));
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -2827,7 +2850,7 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
                 if (numBytes > 8) return false;
                 for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>(dataToks[d].toInt(nullptr, 16));
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
             else return false;
         }
@@ -3003,7 +3026,7 @@ bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
         {
             for (int d = 0; d < numBytes; d++) bytes[d] = data[4 + d];
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendFrame(frames, thisFrame);
         }
         else foundErrors = true;
     }
@@ -3194,7 +3217,7 @@ bool FrameFileIO::loadMicrochipFile(QString filename, QVector<CANFrame>* frames)
                         if (thisFrame.payload().length() + 4 > tokens.length()) thisFrame.payload().resize( tokens.length() - 4 );
                         for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>( Utility::ParseStringToNum(tokens[4 + d]) );
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendFrame(frames, thisFrame);
                     }
                     else foundErrors = true;
                 }
@@ -3420,7 +3443,7 @@ bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
                     //if (numBytes > dataToks.length()) thisFrame.payload().resize(dataToks.length());
                     for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>(dataToks[d].toInt(nullptr, 16));
                     thisFrame.setPayload(bytes);
-                    frames->append(thisFrame);
+                    appendFrame(frames, thisFrame);
                 }
                 else foundErrors = true;
             }
@@ -3843,7 +3866,7 @@ bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
             /*NB: should we make sure len <= 8? */
             thisFrame.isReceived = true;
        }
-       frames->append(thisFrame);
+       appendFrame(frames, thisFrame);
     }
     inFile->close();
     delete inFile;
@@ -3934,7 +3957,7 @@ bool FrameFileIO::loadLawicelFile(QString filename, QVector<CANFrame>* frames)
                 bytes[d] = static_cast<char>(line.mid(d * 2, 2).toInt(nullptr, 16));
             }
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendFrame(frames, thisFrame);
         }
     }
     inFile->close();
@@ -4039,7 +4062,7 @@ bool FrameFileIO::loadKvaserFile(QString filename, QVector<CANFrame> *frames, bo
             if (line.mid(72, 1).toUpper() == "R") thisFrame.isReceived = true;
                 else thisFrame.isReceived = false;
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendFrame(frames, thisFrame);
         }
         //else foundErrors = true;
     }
@@ -4190,7 +4213,7 @@ bool FrameFileIO::loadCabanaFile(QString filename, QVector<CANFrame>* frames)
                 }
                 
                 thisFrame.setPayload(finalbytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -4331,7 +4354,7 @@ bool FrameFileIO::loadTeslaAPFile(QString filename, QVector<CANFrame>* frames)
         {
             for (int d = 0; d < numBytes; d++) bytes[d] = record.data[d];
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendFrame(frames, thisFrame);
         }
         else foundErrors = true;
     }
@@ -4773,7 +4796,7 @@ bool FrameFileIO::loadCLX000File(QString filename, QVector<CANFrame>* frames) {
                 currentFrame.setPayload(QByteArray());
             }
 
-            frames->append(currentFrame);
+            appendFrame(frames, currentFrame);
         } else {
             qDebug() << "Could not parse:" << recordLine;
         }
@@ -4925,7 +4948,7 @@ bool FrameFileIO::loadCANServerFile(QString filename, QVector<CANFrame>* frames)
                 markFrame.isMark = true;
                 markFrame.markMessage = QString(markData);
                 
-                frames->append(markFrame);
+                appendFrame(frames, markFrame);
                  */
             }
             else if ((logVersion == 1 && data[0] == 0xCE) || (logVersion == 2 && data[0] == 0xA0))
@@ -5007,7 +5030,7 @@ bool FrameFileIO::loadCANServerFile(QString filename, QVector<CANFrame>* frames)
                 }
                 
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendFrame(frames, thisFrame);
             }
         }
     }
@@ -5080,7 +5103,7 @@ bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
             bytes[d] = *(packetData + 24 + d);
         }
         thisFrame.setPayload(bytes);
-        frames->append(thisFrame);
+        appendFrame(frames, thisFrame);
 
         packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
     }
@@ -5177,7 +5200,7 @@ bool FrameFileIO::loadWiresharkSocketCANFile(QString filename, QVector<CANFrame>
             bytes[d] = *(packetData + 8 + d);
         }
         thisFrame.setPayload(bytes);
-        frames->append(thisFrame);
+        appendFrame(frames, thisFrame);
 
         packetData = (const char*) pcap_next(pcap_data_file, &packetHeader);
     }
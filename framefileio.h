@@ -12,6 +12,7 @@
 #include <QString>
 #include <QStringList>
 #include <QFileDialog>
+#include <functional>
 #include "can_structs.h"
 #include "utility.h"
 
@@ -29,6 +30,17 @@ public:
     static bool loadFrameFile(QString &, QVector<CANFrame>*);
     static bool saveFrameFile(QString &, const QVector<CANFrame>*);
 
+    //Same as loadFrameFile but the frames are never all kept. Every chunkFrames frames the loaded block is handed
+    //to sink and thrown away, the last partial block is handed over before returning. Used for files too big for RAM.
+    static bool streamFrameFile(QString &, std::function<void(QVector<CANFrame>&)> sink, int chunkFrames);
+
+    //every loader adds its frames through this so that streaming works for all formats
+    static inline void appendFrame(QVector<CANFrame>* frames, const CANFrame &frame)
+    {
+        frames->append(frame);
+        if (frameSink && frames->count() >= sinkChunkFrames) flushToSink(frames);
+    }
+
     //These do the actual loading and saving and can be used directly if you'd prefer
     static bool autoDetectLoadFile(QString, QVector<CANFrame>*);
     static bool loadCRTDFile(QString, QVector<CANFrame>*);
@@ -103,7 +115,11 @@ public:
     static bool flushContinuousNative();
 
 private:
+    static void flushToSink(QVector<CANFrame>* frames);
+
     static QFile continuousFile;
+    static std::function<void(QVector<CANFrame>&)> frameSink;
+    static int sinkChunkFrames;
 };
 
 #endif // FRAMEFILEIO_H
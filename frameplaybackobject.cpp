@@ -14,6 +14,7 @@ FramePlaybackObject::FramePlaybackObject()
     useOrigTiming = false;
     whichBusSend = 0;
     currentSeqItem = nullptr;
+    hiresScheduler = nullptr;
 }
 
 FramePlaybackObject::~FramePlaybackObject()
@@ -130,12 +131,43 @@ void FramePlaybackObject::piStart()
     whichBusSend = 0;
 
     connect(playbackTimer, &QTimer::timeout, this, &FramePlaybackObject::timerTriggered);
+
+    hiresScheduler = new FramePlaybackScheduler();
+    connect(hiresScheduler, &FramePlaybackScheduler::positionUpdate, this, &FramePlaybackObject::statusUpdate);
+    connect(hiresScheduler, &FramePlaybackScheduler::timingStatsUpdate, this, &FramePlaybackObject::timingStatsUpdate);
+    connect(hiresScheduler, &FramePlaybackScheduler::loopCompleted, this, &FramePlaybackObject::schedulerLoopCompleted);
+    connect(hiresScheduler, &FramePlaybackScheduler::reachedEnd, this, &FramePlaybackObject::schedulerReachedEnd);
 }
 
 void FramePlaybackObject::piStop()
 {
     playbackTimer->stop();
     delete playbackTimer;
+    haltScheduler();
+    delete hiresScheduler;
+    hiresScheduler = nullptr;
+}
+
+//stops original timing playback if it is running and picks up where it left off
+void FramePlaybackObject::haltScheduler()
+{
+    if (hiresScheduler && hiresScheduler->isRunning())
+    {
+        currentPosition = hiresScheduler->stopPlayback();
+    }
+}
+
+void FramePlaybackObject::schedulerLoopCompleted()
+{
+    if (currentSeqItem) currentSeqItem->currentLoopCount++;
+}
+
+void FramePlaybackObject::schedulerReachedEnd()
+{
+    playbackActive = false;
+    currentPosition = 0;
+    emit statusUpdate(currentPosition);
+    emit EndOfFrameCache();
 }
 
 void FramePlaybackObject::initialize()
@@ -197,11 +229,13 @@ void FramePlaybackObject::startPlaybackForward()
 
     if (useOrigTiming)
     {
-        playbackTimer->setInterval(1);
-        playbackElapsed.start();
-        if (currentSeqItem->data[currentPosition].timeStamp().microSeconds() > 2000)
-            playbackLastTimeStamp = currentSeqItem->data[currentPosition].timeStamp().microSeconds() - 2000;
-        else playbackLastTimeStamp = 0;
+        //forward playback with original timing gets its own high resolution thread
+        playbackTimer->stop();
+        haltScheduler();
+        hiresScheduler->load(currentSeqItem, currentPosition, whichBusSend, numBuses,
+                             currentSeqItem->maxLoops - currentSeqItem->currentLoopCount);
+        hiresScheduler->start(QThread::TimeCriticalPriority);
+        return;
     }
     playbackTimer->start();
 }
@@ -215,6 +249,7 @@ void FramePlaybackObject::startPlaybackBackward()
         return;
     }
 
+    haltScheduler();
     playbackActive = true;
     playbackForward = false;
     if (useOrigTiming)
@@ -237,6 +272,7 @@ void FramePlaybackObject::stepPlaybackForward()
 
     sendingBuffer.clear();
     playbackTimer->stop();
+    haltScheduler();
     playbackActive = false;
     updatePosition(true);
     CANConManager::getInstance()->sendFrames(sendingBuffer);
@@ -254,6 +290,7 @@ void FramePlaybackObject::stepPlaybackBackward()
 
     sendingBuffer.clear();
     playbackTimer->stop(); //pushing this button halts automatic playback
+    haltScheduler();
     playbackActive = false;
 
     updatePosition(false);
@@ -271,6 +308,7 @@ void FramePlaybackObject::stopPlayback()
     }
 
     playbackTimer->stop(); //pushing this button halts automatic playback
+    haltScheduler();
     playbackActive = false;
     currentPosition = 0;
     emit statusUpdate(currentPosition);
@@ -287,6 +325,7 @@ void FramePlaybackObject::pausePlayback()
 
     playbackActive = false;
     playbackTimer->stop();
+    haltScheduler();
     emit statusUpdate(currentPosition);
 }
 
@@ -8,6 +8,7 @@
 #include <QDebug>
 #include "can_structs.h"
 #include "connections/canconmanager.h"
+#include "frameplaybackscheduler.h"
 
 //one entry in the sequence of data to use
 struct SequenceItem
@@ -65,9 +66,12 @@ public slots:
 signals:
     void EndOfFrameCache(); //we hit the end/beginning of the frame cache (depending on direction of playback)
     void statusUpdate(int frameNum);
+    void timingStatsUpdate(TimingStats stats); //only sent while playing with original timing
 
 private slots:
     void timerTriggered();
+    void schedulerLoopCompleted();
+    void schedulerReachedEnd();
 
 private:
      QList<CANFrame> sendingBuffer;
@@ -85,8 +89,10 @@ private:
      bool useOrigTiming;
      int whichBusSend;
      QThread*            mThread_p;
+     FramePlaybackScheduler* hiresScheduler; //original timing forward playback runs here instead of off playbackTimer
 
      quint64 updatePosition(bool forward);
+     void haltScheduler();
      quint64 peekPosition(bool forward);
      /**
       * @brief starts the device
@@ -0,0 +1,155 @@
+#include "frameplaybackscheduler.h"
+#include "frameplaybackobject.h"
+#include "connections/canconmanager.h"
+
+//lead time before the first frame and gap between loops. Matches what the timer based playback used.
+#define PLAYBACK_LEAD_NS        1000000
+//how often position and timing statistics are pushed out to the GUI
+#define PLAYBACK_REPORT_NS      250000000
+
+FramePlaybackScheduler::FramePlaybackScheduler(QObject *parent) : QThread(parent)
+{
+    qRegisterMetaType<TimingStats>("TimingStats");
+
+    mStartSlot = 0;
+    mLoops = 0;
+    mPassLengthNs = PLAYBACK_LEAD_NS;
+}
+
+FramePlaybackScheduler::~FramePlaybackScheduler()
+{
+    stopPlayback();
+}
+
+void FramePlaybackScheduler::load(const SequenceItem *item, int startPos, int sendBus, int numBuses, int loops)
+{
+    mSlots.clear();
+    mStartSlot = 0;
+    mLoops = qMax(loops, 1);
+    mPassLengthNs = PLAYBACK_LEAD_NS;
+    mPosition.storeRelaxed(startPos);
+    mAbort.storeRelaxed(0);
+
+    if (!item || item->data.isEmpty()) return;
+
+    const qint64 firstStamp = item->data.first().timeStamp().microSeconds();
+    qint64 lastOffset = 0;
+    qint64 lastStamp = -1;
+
+    for (int i = 0; i < item->data.count(); i++)
+    {
+        const CANFrame &frame = item->data[i];
+        if (!item->idFilters.value(frame.frameId(), false)) continue;
+
+        qint64 stamp = frame.timeStamp().microSeconds();
+        if (mSlots.isEmpty() || stamp != lastStamp)
+        {
+            PlaybackSlot slot;
+            //logs that jump backward in time just get sent right away instead of waiting
+            slot.offsetNs = qMax(lastOffset, (stamp - firstStamp) * 1000);
+            slot.sourcePos = i;
+            mSlots.append(slot);
+            lastOffset = slot.offsetNs;
+            lastStamp = stamp;
+        }
+
+        QList<CANFrame> &frames = mSlots.last().frames;
+        if (sendBus > -1)
+        {
+            frames.append(frame);
+            frames.last().bus = sendBus;
+        }
+        else if (sendBus == -1)
+        {
+            for (int c = 0; c < numBuses; c++)
+            {
+                frames.append(frame);
+                frames.last().bus = c;
+            }
+        }
+        else frames.append(frame); //from file so retain original bus and send as-is
+    }
+
+    if (mSlots.isEmpty()) return;
+
+    mPassLengthNs = mSlots.last().offsetNs + PLAYBACK_LEAD_NS;
+    while (mStartSlot < mSlots.count() - 1 && mSlots[mStartSlot].sourcePos < startPos) mStartSlot++;
+}
+
+int FramePlaybackScheduler::stopPlayback()
+{
+    if (isRunning())
+    {
+        mAbort.storeRelaxed(1);
+        wait();
+    }
+    return mPosition.loadRelaxed();
+}
+
+TimingStats FramePlaybackScheduler::getStats()
+{
+    QMutexLocker locker(&mStatsMutex);
+    return mStats;
+}
+
+void FramePlaybackScheduler::run()
+{
+    TimingStats stats;
+    CANConManager *manager = CANConManager::getInstance();
+    int slot = mStartSlot;
+    int loop = 0;
+
+    {
+        QMutexLocker locker(&mStatsMutex);
+        mStats.reset();
+    }
+
+    qint64 base = HiResClock::nowNs() + PLAYBACK_LEAD_NS;
+    if (!mSlots.isEmpty()) base -= mSlots[slot].offsetNs;
+    qint64 lastReport = HiResClock::nowNs();
+
+    while (loop < mLoops)
+    {
+        if (slot >= mSlots.count())
+        {
+            loop++;
+            slot = 0;
+            base += mPassLengthNs;
+            emit loopCompleted();
+            continue;
+        }
+
+        const PlaybackSlot &current = mSlots[slot];
+        const qint64 deadline = base + current.offsetNs;
+        HiResClock::sleepUntil(deadline, HIRES_DEFAULT_SPIN_NS, &mAbort);
+        if (mAbort.loadRelaxed()) break;
+
+        manager->sendFrames(current.frames);
+        //sampled after the send so the time spent handing the frames over counts as timing error too
+        const qint64 now = HiResClock::nowNs();
+        stats.add(now - deadline);
+
+        slot++;
+        mPosition.storeRelaxed((slot < mSlots.count()) ? mSlots[slot].sourcePos : 0);
+
+        if ((now - lastReport) > PLAYBACK_REPORT_NS)
+        {
+            lastReport = now;
+            {
+                QMutexLocker locker(&mStatsMutex);
+                mStats = stats;
+            }
+            emit positionUpdate(mPosition.loadRelaxed());
+            emit timingStatsUpdate(stats);
+        }
+    }
+
+    {
+        QMutexLocker locker(&mStatsMutex);
+        mStats = stats;
+    }
+    emit timingStatsUpdate(stats);
+
+    //the final timing numbers went out with timingStatsUpdate above and show in the playback window
+    if (!mAbort.loadRelaxed()) emit reachedEnd();
+}
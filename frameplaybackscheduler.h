@@ -0,0 +1,76 @@
+#ifndef FRAMEPLAYBACKSCHEDULER_H
+#define FRAMEPLAYBACKSCHEDULER_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+#include <QList>
+#include "can_structs.h"
+#include "utils/hiresclock.h"
+
+struct SequenceItem;
+
+//all frames that share one timestamp in the source log. They are sent as one batch.
+struct PlaybackSlot
+{
+    qint64 offsetNs; //when to send, relative to the first frame of the pass
+    int sourcePos;   //index of the first of these frames in SequenceItem::data
+    QList<CANFrame> frames;
+};
+
+/*
+  Original timing playback used to be driven from a 1ms QTimer which quantized every inter-frame gap
+  to timer ticks. This thread instead pre-decodes the sequence item into slots (filters and bus
+  remapping already applied) and then sends each slot at its absolute deadline using HiResClock, so
+  the only jitter left is the OS wake up latency that the final spin-wait doesn't absorb.
+  The difference between when a slot was really sent and when the log says it should have been is
+  collected into TimingStats and reported periodically.
+*/
+class FramePlaybackScheduler : public QThread
+{
+    Q_OBJECT
+
+public:
+    FramePlaybackScheduler(QObject *parent = nullptr);
+    ~FramePlaybackScheduler();
+
+    /**
+     * @brief Pre-decode a sequence item for playback. Must not be called while the thread runs
+     * @param item - the sequence item to play. Only read here, never touched by the thread afterward
+     * @param startPos - index into item->data to start playing from
+     * @param sendBus - bus to send on, -1 for all buses, -2 to keep the bus from the file
+     * @param numBuses - how many buses exist (used for sendBus == -1)
+     * @param loops - how many full passes to play. The first pass starts at startPos, the others at 0
+     */
+    void load(const SequenceItem *item, int startPos, int sendBus, int numBuses, int loops);
+
+    /**
+     * @brief ask the thread to stop and wait for it
+     * @return the source position of the next frame that would have been sent
+     */
+    int stopPlayback();
+
+    TimingStats getStats();
+
+signals:
+    void positionUpdate(int frameNum);
+    void loopCompleted();
+    void reachedEnd();
+    void timingStatsUpdate(TimingStats stats);
+
+protected:
+    void run() override;
+
+private:
+    QVector<PlaybackSlot> mSlots;
+    int mStartSlot;
+    int mLoops;
+    qint64 mPassLengthNs;
+    QAtomicInt mAbort;
+    QAtomicInt mPosition;
+    QMutex mStatsMutex;
+    TimingStats mStats;
+};
+
+#endif // FRAMEPLAYBACKSCHEDULER_H
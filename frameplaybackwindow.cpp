@@ -79,6 +79,7 @@ FramePlaybackWindow::FramePlaybackWindow(const QVector<CANFrame> *frames, QWidge
 
     connect(&playbackObject, &FramePlaybackObject::EndOfFrameCache, this, &FramePlaybackWindow::EndOfFrameCache);
     connect(&playbackObject, &FramePlaybackObject::statusUpdate, this, &FramePlaybackWindow::getStatusUpdate);
+    connect(&playbackObject, &FramePlaybackObject::timingStatsUpdate, this, &FramePlaybackWindow::getTimingStats);
 
     ui->listID->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->listID, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(contextMenuFilters(QPoint)));
@@ -413,6 +414,19 @@ void FramePlaybackWindow::getStatusUpdate(int frameNum)
     updateFrameLabel();
 }
 
+void FramePlaybackWindow::getTimingStats(TimingStats stats)
+{
+    if (stats.count == 0)
+    {
+        ui->lblTimingStats->setText("-");
+        return;
+    }
+    ui->lblTimingStats->setText(QString::number(stats.meanNs / 1000.0, 'f', 1) + " / "
+                                + QString::number(qMax(qAbs(stats.minNs), qAbs(stats.maxNs)) / 1000.0, 'f', 1) + " / "
+                                + QString::number(stats.stdDevNs() / 1000.0, 'f', 1) + " us ("
+                                + QString::number(stats.overLimit) + " over 100us)");
+}
+
 void FramePlaybackWindow::updateFrameLabel()
 {
     int row = currentSeqNum;
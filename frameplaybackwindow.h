@@ -43,6 +43,7 @@ private slots:
     void loadFilters();
     void useOrigTimingClicked();
     void getStatusUpdate(int frameNum);
+    void getTimingStats(TimingStats stats);
     void EndOfFrameCache();
     void updatedFrames(int);
 
@@ -5,13 +5,18 @@ FrameSenderObject::FrameSenderObject(const QVector<CANFrame> *frames)
 {
     mThread_p = new QThread();
 
-    statusCounter = 0;
     modelFrames = frames;
+    programDirty.storeRelaxed(0);
+    seedPending.storeRelaxed(0);
+    scheduleThread = nullptr;
     dbcHandler = DBCHandler::getReference();
+    //rows that modify DBC signals have the signal layouts compiled in
+    connect(dbcHandler, &DBCHandler::filesChanged, this, &FrameSenderObject::sendRecordsChanged);
 }
 
 FrameSenderObject::~FrameSenderObject()
 {
+    stopSending();
     mThread_p->quit();
     mThread_p->wait();
     delete mThread_p;
@@ -19,17 +24,12 @@ FrameSenderObject::~FrameSenderObject()
 
 void FrameSenderObject::piStart()
 {
-    sendingTimer = new QTimer();
-    sendingTimer->setTimerType(Qt::PreciseTimer);
-    sendingTimer->setInterval(1);
-
-    connect(sendingTimer, &QTimer::timeout, this, &FrameSenderObject::timerTriggered);
+    //nothing to set up here. Timed sending has its own thread, see startSending
 }
 
 void FrameSenderObject::piStop()
 {
-    sendingTimer->stop();
-    delete sendingTimer;
+    stopSending();
 }
 
 void FrameSenderObject::initialize()
@@ -81,28 +81,26 @@ void FrameSenderObject::finalize()
 
 void FrameSenderObject::startSending()
 {
-    /* make sure we execute in mThread context */
-    if( mThread_p && (mThread_p != QThread::currentThread()) ) {
-        QMetaObject::invokeMethod(this, "startSending",
-                                  Qt::BlockingQueuedConnection);
-        return;
-    }
+    if (scheduleThread) return;
 
-    sendingElapsed.start();
-    sendingTimer->start();
+    scheduleAbort.storeRelaxed(0);
+    programDirty.storeRelease(1); //deadlines start from now
+    scheduleThread = QThread::create([this]() { runSchedule(); });
+    scheduleThread->start(QThread::TimeCriticalPriority);
 }
 
 void FrameSenderObject::stopSending()
 {
-    /* make sure we execute in mThread context */
-    if( mThread_p && (mThread_p != QThread::currentThread()) ) {
-        QMetaObject::invokeMethod(this, "stopPlayback",
-                                  Qt::BlockingQueuedConnection);
-        return;
-    }
+    if (!scheduleThread) return;
 
-    sendingTimer->stop(); //pushing this button halts automatic playback
-    //emit statusUpdate(currentPosition);
+    {
+        QMutexLocker locker(&mutex);
+        scheduleAbort.storeRelaxed(1);
+        scheduleWake.wakeAll();
+    }
+    scheduleThread->wait();
+    delete scheduleThread;
+    scheduleThread = nullptr;
 }
 
 void FrameSenderObject::addSendRecord(FrameSendData record)
@@ -114,7 +112,11 @@ void FrameSenderObject::addSendRecord(FrameSendData record)
                                   Q_ARG(FrameSendData, record));
         return;
     }
+    QMutexLocker locker(&mutex);
     sendingData.append(record);
+    rowJitter.append(TimingStats());
+    programDirty.storeRelease(1);
+    scheduleWake.wakeAll();
 }
 
 void FrameSenderObject::removeSendRecord(int idx)
@@ -126,332 +128,300 @@ void FrameSenderObject::removeSendRecord(int idx)
                                   Q_ARG(int, idx));
         return;
     }
+    QMutexLocker locker(&mutex);
+    if (idx < 0 || idx >= sendingData.count()) return;
+    //the schedule refers to rows by index so take its phases before they shift
+    syncPhases(HiResClock::nowNs());
+    schedule.clear();
     sendingData.removeAt(idx);
+    if (idx < rowJitter.count()) rowJitter.removeAt(idx);
+    programDirty.storeRelease(1);
+    scheduleWake.wakeAll();
 }
 
 /*
- * Note: Getting a reference to an item in a QList is a dangerous thing. If anyone
- * or anything happens to reallocate the list you're screwed. So, call this, do the
- * work, and drop the reference as soon as possible.
+ * The records are only ever touched with the mutex held. A reference handed out would be read and
+ * written by the sending thread behind the caller's back, so changes go through here instead.
 */
-FrameSendData *FrameSenderObject::getSendRecordRef(int idx)
+bool FrameSenderObject::editSendRecord(int idx, std::function<void(FrameSendData&)> edit)
 {
-    if (idx < 0 || idx >= sendingData.count()) return nullptr;
-    return &sendingData[idx];
+    QMutexLocker locker(&mutex);
+    if (idx < 0 || idx >= sendingData.count()) return false;
+    edit(sendingData[idx]);
+    programDirty.storeRelease(1);
+    scheduleWake.wakeAll();
+    return true;
 }
 
-/// <summary>
-/// Called every millisecond to set the system update figures and send frames if necessary.
-/// </summary>
-/// <param name="sender"></param>
-/// <param name="timerEventArgs"></param>
-///
-void FrameSenderObject::timerTriggered()
+int FrameSenderObject::getSendCount(int idx)
 {
-    FrameSendData *sendData;
-    Trigger *trigger;
+    QMutexLocker locker(&mutex);
+    if (idx < 0 || idx >= sendingData.count()) return -1;
+    return sendingData[idx].count;
+}
 
-    sendingList.clear();
-    if(mutex.tryLock())
-    {
-        /*
-         * Requested tick interval was 1ms but the actual interval could be wildly different. So, we track
-         * by counting microseconds and accumulating. This creates decent stability even for long intervals
-         */
-        quint64 elapsed = sendingElapsed.nsecsElapsed() / 1000ul;
-        if (elapsed == 0) elapsed = 1;
-        sendingElapsed.start();
-        sendingLastTimeStamp += elapsed;
-        //qDebug() << sendingLastTimeStamp;
-        //qDebug() << "El: " << elapsed;
-        statusCounter++;
-        for (int i = 0; i < sendingData.count(); i++)
-        {
-            sendData = &sendingData[i];
-            if (!sendData->enabled)
-            {
-                if (sendData->triggers.count() > 0)
-                {
-                    for (int j = 0; j < sendData->triggers.count(); j++)    //resetting currCount when line is disabled
-                    {
-                        sendData->triggers[j].currCount = 0;
-                    }
-                }
-                continue; //abort any processing on this if it is not enabled.
-            }
-            if (sendData->triggers.count() == 0)
-            {
-                //qDebug() << "No triggers to process";
-                break;
-            }
-            for (int j = 0; j < sendData->triggers.count(); j++)
-            {
-                trigger = &sendData->triggers[j];
-                //if ( (trigger->currCount >= trigger->maxCount) || (trigger->maxCount == -1) ) continue; //don't process if we've sent max frames we were supposed to
-                if (!trigger->readyCount) continue; //don't tick if not ready to tick
-                //is it time to fire?
-                trigger->msCounter += elapsed; //gives proper tracking even if timer doesn't fire as fast as it should
-                //qDebug() << trigger->msCounter;
-                if (trigger->msCounter >= (trigger->milliseconds * 1000))
-                {
-                    trigger->msCounter -= (trigger->milliseconds * 1000);
-                    sendData->count++;
-                    trigger->currCount++;
-                    doModifiers(i);
-                    //updateGridRow(i);
-                    //qDebug() << "About to try to send a frame";
-                    //CANConManager::getInstance()->sendFrame(sendingData[i]);
-                    sendingList.append(sendingData[i]); //queue it instead of immediate sending
-                    if (trigger->ID > 0) trigger->readyCount = false; //reset flag if this is a timed ID trigger
-                }
-            }
-        }
+bool FrameSenderObject::getSendRecord(int idx, FrameSendData& record)
+{
+    QMutexLocker locker(&mutex);
+    if (idx < 0 || idx >= sendingData.count()) return false;
+    record = sendingData[idx];
+    return true;
+}
 
-        //if we have any frames to send after the above then send as a batch
-        if (sendingList.count() > 0) CANConManager::getInstance()->sendFrames(sendingList);
-        mutex.unlock();
-    }
-    else
+TimingStats FrameSenderObject::getJitterStats(int idx)
+{
+    QMutexLocker locker(&mutex);
+    if (idx < 0 || idx >= rowJitter.count()) return TimingStats();
+    return rowJitter[idx];
+}
+
+/*
+ * Compiles the send records and rebuilds the schedule if anything changed since last time. The signal
+ * layouts are taken out of the DBC here so the per frame work doesn't look anything up by name.
+ * Called with the mutex held.
+ */
+void FrameSenderObject::compileProgram()
+{
+    if (!programDirty.testAndSetOrdered(1, 0)) return;
+
+    program.compile(sendingData, [this](uint32_t id, const QString& sigName, SignalCodecSpec& spec)
+    {
+        DBC_MESSAGE *msg = dbcHandler->findMessage(id);
+        if (!msg) return false;
+        DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(sigName);
+        if (!sig) return false;
+        spec = SignalCodec::fromSignal(sig);
+        return true;
+    });
+    rebuildSchedule(HiResClock::nowNs());
+
+    //this can be the sending thread, which mustn't walk the capture. The object's own thread seeds the slots
+    if (program.hasWatches() && seedPending.testAndSetOrdered(0, 1))
     {
-        qDebug() << "framesenderobject::handleTick() couldn't get mutex, elapsed is: " << sendingElapsed.elapsed();
+        QMetaObject::invokeMethod(this, "seedFrames", Qt::QueuedConnection);
     }
 }
 
-void FrameSenderObject::buildFrameCache()
+//fills the frames the modifiers read from with the newest ones already captured
+void FrameSenderObject::seedFrames()
 {
-    CANFrame thisFrame;
-    frameCache.clear();
-    for (int i = 0; i < modelFrames->count(); i++)
+    QMutexLocker locker(&mutex);
+    seedPending.storeRelease(0);
+    compileProgram();
+    for (int i = modelFrames->count() - 1; i >= 0 && program.emptySlots() > 0; i--)
     {
-        thisFrame = modelFrames->at(i);
-        if (!frameCache.contains(thisFrame.frameId()))
-        {
-            frameCache.insert(thisFrame.frameId(), thisFrame);
-        }
-        else
-        {
-            frameCache[thisFrame.frameId()] = thisFrame;
-        }
+        program.seedFrame(modelFrames->at(i));
     }
 }
 
+void FrameSenderObject::sendRecordsChanged()
+{
+    QMutexLocker locker(&mutex);
+    programDirty.storeRelease(1);
+    scheduleWake.wakeAll();
+}
+
 //remember, negative numbers are special -1 = all frames deleted, -2 = totally new set of frames.
 void FrameSenderObject::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
     if (numFrames == -1) //all frames deleted.
     {
     }
     else if (numFrames == -2) //all new set of frames.
     {
-        buildFrameCache();
+        QMutexLocker locker(&mutex);
+        programDirty.storeRelease(1);
+        compileProgram();
     }
     else //just got some new frames. See if they are relevant.
     {
         if (numFrames > modelFrames->count()) return;
-        qDebug() << "New frames in sender window";
-        //run through the supposedly new frames in order
-        for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
-            thisFrame = modelFrames->at(i);
-            if (!frameCache.contains(thisFrame.frameId()))
+            QMutexLocker locker(&mutex);
+            compileProgram();
+            //run through the supposedly new frames in order
+            for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
             {
-                frameCache.insert(thisFrame.frameId(), thisFrame);
+                processIncomingFrame(modelFrames->at(i));
             }
-            else
+            if (!armedTriggers.isEmpty())
             {
-                frameCache[thisFrame.frameId()] = thisFrame;
+                scheduleArmed(armedTriggers, HiResClock::nowNs());
+                armedTriggers.clear();
             }
-            processIncomingFrame(&thisFrame);
+        }
+        if (sendingList.count() > 0)
+        {
+            CANConManager::getInstance()->sendFrames(sendingList);
+            sendingList.clear();
         }
     }
 }
 
-void FrameSenderObject::processIncomingFrame(CANFrame *frame)
+/*
+ * Rows whose triggers fire with no delay are queued on sendingList and go out together once the new frames
+ * are done. Triggers with a delay are collected and handed to the schedule in one go.
+ */
+void FrameSenderObject::processIncomingFrame(const CANFrame& frame)
 {
-    for (int sd = 0; sd < sendingData.count(); sd++)
-    {
-        if (sendingData[sd].triggers.count() == 0) continue;
-        bool passedChecks = true;
-        for (int trig = 0; trig < sendingData[sd].triggers.count(); trig++)
-        {
-            Trigger *thisTrigger = &sendingData[sd].triggers[trig];
-            //need to ensure that this trigger is actually related to frames incoming.
-            //Otherwise ignore it here. Only frames that have BUS and/or ID set as trigger will work here.
-            if (!(thisTrigger->triggerMask & (TriggerMask::TRG_BUS | TriggerMask::TRG_ID) ) ) continue;
-
-            passedChecks = true;
-            //qDebug() << "Trigger ID: " << thisTrigger->ID;
-            //qDebug() << "Frame ID: " << frame->frameId();
-
-            //Check to see if we have a bus trigger condition and if so does it match
-            if (thisTrigger->bus != frame->bus && (thisTrigger->triggerMask & TriggerMask::TRG_BUS) )
-                passedChecks = false;
-
-            //check to see if we have an ID trigger condition and if so does it match
-            if ((thisTrigger->triggerMask & TriggerMask::TRG_ID) && (uint32_t)thisTrigger->ID != frame->frameId() )
-                passedChecks = false;
-
-            //check to see if we're limiting the trigger by max count and have we reached that count?
-            if ( (thisTrigger->triggerMask & TriggerMask::TRG_COUNT) && (thisTrigger->currCount >= thisTrigger->maxCount) )
-                passedChecks = false;
-
-            //if the above passed then are we triggering not only on ID but also signal?
-            if (passedChecks && (thisTrigger->triggerMask & (TriggerMask::TRG_SIGNAL | TriggerMask::TRG_ID) ) )
-            {
-                bool sigCheckPassed = false;
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisTrigger->ID);
-                if (msg)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(thisTrigger->sigName);
-                    if (sig)
-                    {
-                        //first of all, is this signal really in this message we got?
-                        if (sig->isSignalInMessage(*frame)) sigCheckPassed = true;
-                        //if it was and we're also filtering on value then try that next
-                        if (sigCheckPassed && (thisTrigger->triggerMask & TriggerMask::TRG_SIGVAL))
-                        {
-                            double sigval = 0.0;
-                            if (sig->processAsDouble(*frame, sigval))
-                            {
-                                if (abs(sigval - thisTrigger->sigValueDbl) > 0.001)
-                                {
-                                    sigCheckPassed = false;
-                                }
-                            }
-                            else sigCheckPassed = false;
-                        }
-                    }
-                    else sigCheckPassed = false;
-                }
-                else sigCheckPassed = false;
-                passedChecks &= sigCheckPassed; //passedChecks can only be true if both are
-            }
+    program.processFrame(frame, sendingData, sendingList, &armedTriggers);
+}
 
-            //if all the above says it's OK then we'll go ahead and send that message.
-            //If a message that comes through here has a MS value then we use it as a delay
-            //after the check passes. This allows for delaying the sending of the frame if that
-            //is required. Otherwise, just send it immediately.
-            if (passedChecks)
-            {
-                if (thisTrigger->milliseconds == 0) //immediate reply
-                {
-                    thisTrigger->currCount++;
-                    sendingData[sd].count++;
-                    doModifiers(sd);
-                    //updateGridRow(sd);
-                    CANConManager::getInstance()->sendFrame(sendingData[sd]);
-                }
-                else //delayed sending frame
-                {
-                    thisTrigger->readyCount = true;
-                }
-            }
-        }
+/*
+ * Writes how far each scheduled trigger has got through its period back into its msCounter so the
+ * schedule can be rebuilt without every row losing its phase.
+ */
+void FrameSenderObject::syncPhases(qint64 nowNs)
+{
+    foreach (const SendScheduleEntry &entry, schedule.getEntries())
+    {
+        if (entry.row >= sendingData.count() || entry.trigger >= sendingData[entry.row].triggers.count()) continue;
+        const qint64 remainingNs = qMax(0ll, entry.dueNs - nowNs);
+        sendingData[entry.row].triggers[entry.trigger].msCounter = (int)qMax(0ll, (entry.periodNs - remainingNs) / 1000);
     }
 }
 
-
-/// <summary>
-/// given an index into the sendingData list we run the modifiers that it has set up
-/// </summary>
-/// <param name="idx">The index into the sendingData list</param>
-void FrameSenderObject::doModifiers(int idx)
+void FrameSenderObject::rebuildSchedule(qint64 nowNs)
 {
-    int shadowReg = 0; //shadow register we use to accumulate results
-    int first=0, second=0;
-
-    FrameSendData *sendData = &sendingData[idx];
-    Modifier *mod;
-    ModifierOp op;
-
-    if (sendData->modifiers.count() == 0) return; //if no modifiers just leave right now
+    syncPhases(nowNs);
+    schedule.clear();
+    rowJitter.resize(sendingData.count());
 
-    //qDebug() << "Executing mods";
-
-    for (int i = 0; i < sendData->modifiers.count(); i++)
+    for (int r = 0; r < sendingData.count(); r++)
     {
-        mod = &sendData->modifiers[i];
-        for (int j = 0; j < mod->operations.count(); j++)
+        FrameSendData &row = sendingData[r];
+        for (int t = 0; t < row.triggers.count(); t++)
         {
-            op = mod->operations.at(j);
-            if (op.first.ID == -1)
-            {
-                first = shadowReg;
-            }
-            else first = fetchOperand(idx, op.first);
-            second = fetchOperand(idx, op.second);
-            switch (op.operation)
+            Trigger &trig = row.triggers[t];
+            if (!row.enabled)
             {
-            case ADDITION:
-                shadowReg = first + second;
-                break;
-            case AND:
-                shadowReg = first & second;
-                break;
-            case DIVISION:
-                shadowReg = first / second;
-                break;
-            case MULTIPLICATION:
-                shadowReg = first * second;
-                break;
-            case OR:
-                shadowReg = first | second;
-                break;
-            case SUBTRACTION:
-                shadowReg = first - second;
-                break;
-            case XOR:
-                shadowReg = first ^ second;
-                break;
-            case MOD:
-                shadowReg = first % second;
+                trig.currCount = 0; //disabling a row starts its counts over
+                continue;
             }
+            if (trig.milliseconds <= 0 || !trig.readyCount) continue;
+            if ((trig.triggerMask & TriggerMask::TRG_COUNT) && trig.currCount >= trig.maxCount) continue;
+
+            SendScheduleEntry entry;
+            entry.periodNs = (qint64)trig.milliseconds * 1000000;
+            entry.dueNs = nowNs + qMax(0ll, entry.periodNs - (qint64)trig.msCounter * 1000);
+            entry.lastSentNs = -1;
+            entry.row = r;
+            entry.trigger = t;
+            entry.oneShot = (trig.ID > 0); //waits for its frame again after it has been sent
+            schedule.add(entry);
         }
-        //Finally, drop the result into the proper data byte
-        QByteArray newArr(sendData->payload());
-        newArr[mod->destByte] = (char) shadowReg;
-        sendData->setPayload(newArr);
     }
 }
 
-int FrameSenderObject::fetchOperand(int idx, ModifierOperand op)
+//delayed triggers a frame just set ready. They go out one delay from now
+void FrameSenderObject::scheduleArmed(const QVector<QPair<int, int>>& armed, qint64 nowNs)
 {
-    CANFrame *tempFrame = nullptr;
-    if (op.ID == 0) //numeric constant
+    for (int i = 0; i < armed.count(); i++)
     {
-        if (op.notOper) return ~op.databyte;
-        else return op.databyte;
+        const Trigger &trig = sendingData[armed[i].first].triggers[armed[i].second];
+        if (!sendingData[armed[i].first].enabled) continue;
+
+        SendScheduleEntry entry;
+        entry.periodNs = (qint64)trig.milliseconds * 1000000;
+        entry.dueNs = nowNs + entry.periodNs;
+        entry.lastSentNs = -1;
+        entry.row = armed[i].first;
+        entry.trigger = armed[i].second;
+        entry.oneShot = (trig.ID > 0);
+        schedule.add(entry);
     }
-    else if (op.ID == -2) //fetch data from a data byte within the output frame
+    scheduleWake.wakeAll();
+}
+
+/*
+ * Sends everything due within a slot of nowNs. Periodic rows go back on the schedule one period on from
+ * their deadline, not from now, so a late wake up doesn't push every later send back with it.
+ * Called with the mutex held.
+ */
+void FrameSenderObject::fireDue(qint64 nowNs, QList<CANFrame>& batch)
+{
+    QVector<SendScheduleEntry> due;
+    schedule.takeSlot(nowNs, due);
+
+    for (int i = 0; i < due.count(); i++)
     {
-        if (op.notOper) return ~((unsigned char)sendingData.at(idx).payload()[op.databyte]);
-        else return (unsigned char)sendingData.at(idx).payload()[op.databyte];
+        SendScheduleEntry &entry = due[i];
+        if (entry.row >= sendingData.count() || entry.trigger >= sendingData[entry.row].triggers.count()) continue;
+        FrameSendData &row = sendingData[entry.row];
+        Trigger &trig = row.triggers[entry.trigger];
+        if (!row.enabled || !trig.readyCount) continue;
+        if ((trig.triggerMask & TriggerMask::TRG_COUNT) && trig.currCount >= trig.maxCount) continue;
+
+        row.count++;
+        trig.currCount++;
+        trig.msCounter = 0;
+        doModifiers(entry.row);
+        batch.append(row);
+
+        if (entry.lastSentNs >= 0 && entry.row < rowJitter.count()) rowJitter[entry.row].add(nowNs - entry.lastSentNs - entry.periodNs);
+        if (entry.oneShot)
+        {
+            trig.readyCount = false; //reset flag if this is a timed ID trigger
+            continue;
+        }
+        entry.lastSentNs = nowNs;
+        schedule.reschedule(entry, nowNs);
     }
-    else //look up external data byte
+}
+
+/*
+ * The timed sending thread. It waits on the condition until the next deadline is close, spins out
+ * the last stretch with the mutex released and then sends the whole slot as one batch. Changes to the
+ * rows and newly armed triggers wake it early so it can look at the schedule again.
+ */
+void FrameSenderObject::runSchedule()
+{
+    CANConManager *manager = CANConManager::getInstance();
+    QList<CANFrame> batch;
+
+    mutex.lock();
+    while (!scheduleAbort.loadRelaxed())
     {
-        tempFrame = lookupFrame(op.ID, op.bus);
-        if (tempFrame != nullptr)
+        compileProgram();
+
+        const qint64 next = schedule.nextDue();
+        const qint64 now = HiResClock::nowNs();
+        if (next < 0)
+        {
+            scheduleWake.wait(&mutex);
+            continue;
+        }
+        if ((next - now) > FRAMESEND_SPIN_NS)
         {
-            if (op.notOper) return ~((unsigned char)tempFrame->payload()[op.databyte]);
-            else return (unsigned char)tempFrame->payload()[op.databyte];
+            QDeadlineTimer deadline(Qt::PreciseTimer);
+            deadline.setPreciseRemainingTime(0, next - now - FRAMESEND_SPIN_NS, Qt::PreciseTimer);
+            scheduleWake.wait(&mutex, deadline);
+            continue;
+        }
+
+        mutex.unlock();
+        HiResClock::sleepUntil(next, FRAMESEND_SPIN_NS, &scheduleAbort);
+        mutex.lock();
+        if (programDirty.loadAcquire()) continue; //rows changed while we spun, deadlines may be stale
+
+        fireDue(HiResClock::nowNs(), batch);
+        if (!batch.isEmpty())
+        {
+            mutex.unlock();
+            manager->sendFrames(batch);
+            batch.clear();
+            mutex.lock();
         }
-        else return 0;
     }
+    mutex.unlock();
 }
 
+
 /// <summary>
-/// Try to find the most recent frame given the input criteria
+/// given an index into the sendingData list we run the modifiers that it has set up
 /// </summary>
-/// <param name="ID">The ID to find</param>
-/// <param name="bus">Which bus to look on (-1 if you don't care)</param>
-/// <returns></returns>
-CANFrame* FrameSenderObject::lookupFrame(int ID, int bus)
+/// <param name="idx">The index into the sendingData list</param>
+void FrameSenderObject::doModifiers(int idx)
 {
-    if (!frameCache.contains(ID)) return nullptr;
-
-    if (bus == -1 || frameCache[ID].bus == bus) return &frameCache[ID];
-
-    return nullptr;
+    program.runModifiers(idx, sendingData[idx]);
 }
-
@@ -1,17 +1,28 @@
 #ifndef FRAMESENDEROBJECT_H
 #define FRAMESENDEROBJECT_H
 
-#include <QElapsedTimer>
-#include <QTimer>
 #include <QHash>
 #include <QThread>
 #include <QDebug>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QAtomicInt>
+#include <functional>
 #include "can_structs.h"
 #include "connections/canconmanager.h"
 #include "can_trigger_structs.h"
 #include "dbc/dbchandler.h"
+#include "framesendprogram.h"
+#include "framesendschedule.h"
+#include "utils/hiresclock.h"
 
+/*
+  Sends the rows of the main window's simple sender and of the frame sender window. Rows triggered by incoming frames are handled on the
+  object's own thread as frames come in. Everything timed is kept in a FrameSendSchedule and sent from a
+  time critical thread that sleeps until the next deadline instead of ticking every millisecond. Frames
+  that fall due together go out as one batch and the period jitter of every row is tracked.
+*/
 class FrameSenderObject : public QObject
 {
     Q_OBJECT
@@ -33,39 +44,68 @@ public slots:
      */
     void finalize();
 
+    /* start and stop the timed sending thread. Safe to call from any thread */
     void startSending();
     void stopSending();
 
     void addSendRecord(FrameSendData record);
     void removeSendRecord(int idx);
-    FrameSendData *getSendRecordRef(int idx);
+
+    /**
+     * @brief change a record with the sending thread locked out, then have its triggers and modifiers compiled again
+     * @param edit - called with the record. Keep it short, the sending thread waits for it
+     * @return false if there is no record idx
+     * @note safe to call from any thread
+     */
+    bool editSendRecord(int idx, std::function<void(FrameSendData&)> edit);
+
+    /* how many times record idx has been sent, -1 if there is no such record */
+    int getSendCount(int idx);
+
+    /* copies record idx out with the sending thread locked out. Returns false if there is no such record */
+    bool getSendRecord(int idx, FrameSendData& record);
+
+    /**
+     * @brief has the triggers and modifiers compiled again, for instance because the DBC files changed
+     * @note safe to call from any thread. The compile happens on the sending thread before it next uses the records
+     */
+    void sendRecordsChanged();
+
+    /* how far apart the sends of a row have been from its period, in ns */
+    TimingStats getJitterStats(int idx);
 
 signals:
 
 private slots:
-    void timerTriggered();
     void updatedFrames(int);
+    void seedFrames();
 
 private:
     QList<CANFrame> sendingList;
-    int currentPosition;
-    QTimer *sendingTimer;
-    QElapsedTimer sendingElapsed;
-    quint64 sendingLastTimeStamp;
-    int statusCounter;
+    QVector<QPair<int, int>> armedTriggers;
     QList<FrameSendData> sendingData;
     QThread*            mThread_p;    
-    QHash<int, CANFrame> frameCache; //hash with frame ID as the key and the most recent frame as the value
     const QVector<CANFrame> *modelFrames;
     bool inhibitChanged = false;
-    QMutex mutex;
+    QMutex mutex;           //guards sendingData, the program and the schedule
     DBCHandler *dbcHandler;
+    FrameSendProgram program;
+    QAtomicInt programDirty;
+    QAtomicInt seedPending;
+    FrameSendSchedule schedule;
+    QVector<TimingStats> rowJitter;
+    QThread *scheduleThread;
+    QWaitCondition scheduleWake;
+    QAtomicInt scheduleAbort;
 
     void doModifiers(int);
-    int fetchOperand(int, ModifierOperand);
-    CANFrame* lookupFrame(int, int);
-    void buildFrameCache();
-    void processIncomingFrame(CANFrame *frame);
+    void compileProgram();
+    void rebuildSchedule(qint64 nowNs);
+    void syncPhases(qint64 nowNs);
+    void scheduleArmed(const QVector<QPair<int, int>>& armed, qint64 nowNs);
+    void fireDue(qint64 nowNs, QList<CANFrame>& batch);
+    void runSchedule();
+    void processIncomingFrame(const CANFrame& frame);
 
     /**
      * @brief starts the device
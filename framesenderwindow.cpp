@@ -10,10 +10,8 @@
 #include "triggerdialog.h"
 
 /*
- * notes: need to ensure that you grab pointers when modifying data structures and dont
- * make copies. Also, check # of ms elapsed since last tick since they don't tend to come in at 1ms
- * intervals like we asked.
- * Also, rows default to enabled which is odd because the button state does not reflect that.
+ * notes: the rows belong to frameSender and its threads read them while they send, so they are only
+ * ever changed through editSendRecord and read back as copies.
 */
 
 FrameSenderWindow::FrameSenderWindow(const QVector<CANFrame> *frames, QWidget *parent) :
@@ -23,29 +21,30 @@ FrameSenderWindow::FrameSenderWindow(const QVector<CANFrame> *frames, QWidget *p
     ui->setupUi(this);
     setWindowFlags(Qt::Window);
 
-    modelFrames = frames;
-
     dbcHandler = DBCHandler::getReference();
 
-    intervalTimer = new QTimer();
-    intervalTimer->setTimerType(Qt::PreciseTimer);
-    intervalTimer->setInterval(1);
+    //the rows are sent by the same engine as the simple sender in the main window. Timed rows go out from
+    //its scheduling thread and triggered ones from its own thread, so nothing here waits on the GUI
+    frameSender = new FrameSenderObject(frames);
+    frameSender->initialize();
+    frameSender->startSending();
+
+    refreshTimer = new QTimer();
+    refreshTimer->setInterval(SENDER_REFRESH_MS);
 
     setupGrid();
     createBlankRow();
 
     connect(ui->tableSender, SIGNAL(cellChanged(int,int)), this, SLOT(onCellChanged(int,int)));
     connect(ui->tableSender, SIGNAL(cellDoubleClicked(int, int)), SLOT(onCellDoubleTap(int, int)));
-    connect(intervalTimer, SIGNAL(timeout()), this, SLOT(handleTick()));
+    connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refreshGrid()));
     connect(ui->btnClearGrid, SIGNAL(clicked(bool)), this, SLOT(clearGrid()));
     connect(ui->btnDisableAll, SIGNAL(clicked(bool)), this, SLOT(disableAll()));
     connect(ui->btnEnableAll, SIGNAL(clicked(bool)), this, SLOT(enableAll()));
     connect(ui->btnLoadGrid, SIGNAL(clicked(bool)), this, SLOT(loadGrid()));
     connect(ui->btnSaveGrid, SIGNAL(clicked(bool)), this, SLOT(saveGrid()));
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
 
-    intervalTimer->start();
-    elapsedTimer.start();
+    refreshTimer->start();
     installEventFilter(this);
 }
 
@@ -74,8 +73,12 @@ FrameSenderWindow::~FrameSenderWindow()
     removeEventFilter(this);
     delete ui;
 
-    intervalTimer->stop();
-    delete intervalTimer;
+    refreshTimer->stop();
+    delete refreshTimer;
+
+    frameSender->stopSending();
+    frameSender->finalize();
+    delete frameSender;
 }
 
 bool FrameSenderWindow::eventFilter(QObject *obj, QEvent *event)
@@ -132,146 +135,12 @@ void FrameSenderWindow::createBlankRow()
     inhibitChanged = false;
 }
 
-void FrameSenderWindow::buildFrameCache()
-{
-    CANFrame thisFrame;
-    frameCache.clear();
-    for (int i = 0; i < modelFrames->count(); i++)
-    {
-        thisFrame = modelFrames->at(i);
-        if (!frameCache.contains(thisFrame.frameId()))
-        {
-            frameCache.insert(thisFrame.frameId(), thisFrame);
-        }
-        else
-        {
-            frameCache[thisFrame.frameId()] = thisFrame;
-        }
-    }
-}
-
-//remember, negative numbers are special -1 = all frames deleted, -2 = totally new set of frames.
-void FrameSenderWindow::updatedFrames(int numFrames)
-{
-    CANFrame thisFrame;
-    if (numFrames == -1) //all frames deleted.
-    {
-    }
-    else if (numFrames == -2) //all new set of frames.
-    {
-        buildFrameCache();
-    }
-    else //just got some new frames. See if they are relevant.
-    {
-        if (numFrames > modelFrames->count()) return;
-        qDebug() << "New frames in sender window";
-        //run through the supposedly new frames in order
-        for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
-        {
-            thisFrame = modelFrames->at(i);
-            if (!frameCache.contains(thisFrame.frameId()))
-            {
-                frameCache.insert(thisFrame.frameId(), thisFrame);
-            }
-            else
-            {
-                frameCache[thisFrame.frameId()] = thisFrame;
-            }
-            processIncomingFrame(&thisFrame);
-        }
-    }
-}
-
-void FrameSenderWindow::processIncomingFrame(CANFrame *frame)
-{
-    for (int sd = 0; sd < sendingData.count(); sd++)
-    {
-        if (sendingData[sd].triggers.count() == 0) continue;
-        bool passedChecks = true;
-        for (int trig = 0; trig < sendingData[sd].triggers.count(); trig++)
-        {
-            Trigger *thisTrigger = &sendingData[sd].triggers[trig];
-            //need to ensure that this trigger is actually related to frames incoming.
-            //Otherwise ignore it here. Only frames that have BUS and/or ID set as trigger will work here.
-            if (!(thisTrigger->triggerMask & (TriggerMask::TRG_BUS | TriggerMask::TRG_ID) ) ) continue;
-
-            passedChecks = true;
-            //qDebug() << "Trigger ID: " << thisTrigger->ID;
-            //qDebug() << "Frame ID: " << frame->frameId();
-
-            //Check to see if we have a bus trigger condition and if so does it match
-            if (thisTrigger->bus != frame->bus && (thisTrigger->triggerMask & TriggerMask::TRG_BUS) )
-                passedChecks = false;
-
-            //check to see if we have an ID trigger condition and if so does it match
-            if ((thisTrigger->triggerMask & TriggerMask::TRG_ID) && (uint32_t)thisTrigger->ID != frame->frameId() )
-                passedChecks = false;
-
-            //check to see if we're limiting the trigger by max count and have we reached that count?
-            if ( (thisTrigger->triggerMask & TriggerMask::TRG_COUNT) && (thisTrigger->currCount >= thisTrigger->maxCount) )
-                passedChecks = false;
-
-            //if the above passed then are we triggering not only on ID but also signal?
-            if (passedChecks && (thisTrigger->triggerMask & (TriggerMask::TRG_SIGNAL | TriggerMask::TRG_ID) ) )
-            {
-                bool sigCheckPassed = false;
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisTrigger->ID);
-                if (msg)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(thisTrigger->sigName);
-                    if (sig)
-                    {
-                        //first of all, is this signal really in this message we got?
-                        if (sig->isSignalInMessage(*frame)) sigCheckPassed = true;
-                        //if it was and we're also filtering on value then try that next
-                        if (sigCheckPassed && (thisTrigger->triggerMask & TriggerMask::TRG_SIGVAL))
-                        {
-                            double sigval = 0.0;
-                            if (sig->processAsDouble(*frame, sigval))
-                            {
-                                if (abs(sigval - thisTrigger->sigValueDbl) > 0.001)
-                                {
-                                    sigCheckPassed = false;
-                                }
-                            }
-                            else sigCheckPassed = false;
-                        }
-                    }
-                    else sigCheckPassed = false;
-                }
-                else sigCheckPassed = false;
-                passedChecks &= sigCheckPassed; //passedChecks can only be true if both are
-            }
-
-            //if all the above says it's OK then we'll go ahead and send that message.
-            //If a message that comes through here has a MS value then we use it as a delay
-            //after the check passes. This allows for delaying the sending of the frame if that
-            //is required. Otherwise, just send it immediately.
-            if (passedChecks)
-            {
-                if (thisTrigger->milliseconds == 0) //immediate reply
-                {
-                    thisTrigger->currCount++;
-                    sendingData[sd].count++;
-                    doModifiers(sd);
-                    updateGridRow(sd);
-                    CANConManager::getInstance()->sendFrame(sendingData[sd]);
-                }
-                else //delayed sending frame
-                {
-                    thisTrigger->readyCount = true;
-                }
-            }
-        }
-    }
-}
-
 void FrameSenderWindow::enableAll()
 {
     for (int i = 0; i < ui->tableSender->rowCount() - 1; i++)
     {
         ui->tableSender->item(i, ST_COLS::SENDTAB_COL_EN)->setCheckState(Qt::Checked);
-        sendingData[i].enabled = true;
+        frameSender->editSendRecord(i, [](FrameSendData &data) { data.enabled = true; });
     }
 }
 
@@ -280,7 +149,7 @@ void FrameSenderWindow::disableAll()
     for (int i = 0; i < ui->tableSender->rowCount() - 1; i++)
     {
         ui->tableSender->item(i, ST_COLS::SENDTAB_COL_EN)->setCheckState(Qt::Unchecked);
-        sendingData[i].enabled = false;
+        frameSender->editSendRecord(i, [](FrameSendData &data) { data.enabled = false; });
     }
 }
 
@@ -289,8 +158,7 @@ void FrameSenderWindow::clearGrid()
     if (ui->tableSender->rowCount() == 1) return;
     for (int i = ui->tableSender->rowCount() - 2; i >= 0; i--)
     {
-        sendingData[i].enabled = false;
-        sendingData.removeAt(i);
+        frameSender->removeSendRecord(i);
         ui->tableSender->removeRow(i);
     }
 }
@@ -364,7 +232,7 @@ void FrameSenderWindow::saveSenderFile(QString filename)
         return;
     }
 
-    for (int c = 0; c < sendingData.count(); c++)
+    for (int c = 0; frameSender->getSendCount(c) > -1; c++)
     {
         outString.clear();
         if (ui->tableSender->item(c, ST_COLS::SENDTAB_COL_EN)->checkState() == Qt::Checked)
@@ -406,7 +274,7 @@ void FrameSenderWindow::loadSenderFile(QString filename)
 
     ui->tableSender->clear();
     while (ui->tableSender->rowCount() > 0) ui->tableSender->removeRow(0);
-    sendingData.clear();
+    while (frameSender->getSendCount(0) > -1) frameSender->removeSendRecord(0);
 
     while (!inFile->atEnd()) {
         inhibitChanged = true;
@@ -471,24 +339,22 @@ void FrameSenderWindow::onCellDoubleTap(int row, int column)
         {
             createBlankRow();
         }
-        if (row >= sendingData.count())
+        FrameSendData sendData;
+        if (!frameSender->getSendRecord(row, sendData))
         {
-            FrameSendData tempData;
-            tempData.enabled = false;
-            tempData.setFrameType(QCanBusFrame::DataFrame);
-            tempData.setExtendedFrameFormat(false);
-            sendingData.append(tempData);
+            sendData.enabled = false;
+            sendData.setFrameType(QCanBusFrame::DataFrame);
+            sendData.setExtendedFrameFormat(false);
+            frameSender->addSendRecord(sendData);
         }
-        sendData = nullptr;
-        sendData = &sendingData[row];
-        td = new TriggerDialog(sendData->triggers);
+        td = new TriggerDialog(sendData.triggers);
         if (td->exec() == QDialog::Accepted)
         {
-            sendData->triggers.clear();
-            sendData->triggers.append(td->getUpdatedTriggers());
+            const QList<Trigger> triggers = td->getUpdatedTriggers();
+            frameSender->editSendRecord(row, [&triggers](FrameSendData &data) { data.triggers = triggers; });
             //now have to generate the actual trigger text
             QString output;
-            foreach (Trigger trig, sendData->triggers)
+            foreach (Trigger trig, triggers)
             {
                 output += td->buildEntry(trig) + ",";
             }
@@ -514,174 +380,12 @@ void FrameSenderWindow::onCellChanged(int row, int col)
     processCellChange(row, col);
 }
 
-/// <summary>
-/// Called every millisecond to set the system update figures and send frames if necessary.
-/// </summary>
-/// <param name="sender"></param>
-/// <param name="timerEventArgs"></param>
-void FrameSenderWindow::handleTick()
-{
-    FrameSendData *sendData;
-    Trigger *trigger;
-    if(mutex.tryLock())
-    {
-        int elapsed = elapsedTimer.restart();
-        if (elapsed == 0) elapsed = 1;
-        //Modifier modifier;
-        for (int i = 0; i < sendingData.count(); i++)
-        {
-            sendData = &sendingData[i];
-            if (!sendData->enabled)
-            {
-                if (sendData->triggers.count() > 0)
-                {
-                    for (int j = 0; j < sendData->triggers.count(); j++)    //resetting currCount when line is disabled
-                    {
-                      sendData->triggers[j].currCount = 0;
-                    }
-                }
-                continue; //abort any processing on this if it is not enabled.
-            }
-            if (sendData->triggers.count() == 0) break;
-            for (int j = 0; j < sendData->triggers.count(); j++)
-            {
-                trigger = &sendData->triggers[j];
-                if (trigger->currCount >= trigger->maxCount) continue; //don't process if we've sent max frames we were supposed to
-                if (!trigger->readyCount) continue; //don't tick if not ready to tick
-                //is it time to fire?
-                trigger->msCounter += elapsed; //gives proper tracking even if timer doesn't fire as fast as it should
-                if (trigger->msCounter >= trigger->milliseconds)
-                {
-                    trigger->msCounter = 0;
-                    sendData->count++;
-                    trigger->currCount++;
-                    doModifiers(i);
-                    updateGridRow(i);
-                    //qDebug() << "About to try to send a frame";
-                    CANConManager::getInstance()->sendFrame(sendingData[i]);
-                    if (trigger->ID > 0) trigger->readyCount = false; //reset flag if this is a timed ID trigger
-                }
-            }
-        }
-
-        mutex.unlock();
-    }
-    else
-    {
-        qDebug() << "framesenderwindow::handleTick() couldn't get mutex, elapsed is: " << elapsedTimer.elapsed();
-    }
-
-}
-
-/// <summary>
-/// given an index into the sendingData list we run the modifiers that it has set up
-/// </summary>
-/// <param name="idx">The index into the sendingData list</param>
-void FrameSenderWindow::doModifiers(int idx)
-{
-    int shadowReg = 0; //shadow register we use to accumulate results
-    int first=0, second=0;
-
-    FrameSendData *sendData = &sendingData[idx];
-    Modifier *mod;
-    ModifierOp op;
-
-    if (sendData->modifiers.count() == 0) return; //if no modifiers just leave right now
-
-    //qDebug() << "Executing mods";
-
-    for (int i = 0; i < sendData->modifiers.count(); i++)
-    {
-        mod = &sendData->modifiers[i];
-        for (int j = 0; j < mod->operations.count(); j++)
-        {
-            op = mod->operations.at(j);
-            if (op.first.ID == -1)
-            {
-                first = shadowReg;
-            }
-            else first = fetchOperand(idx, op.first);
-            second = fetchOperand(idx, op.second);
-            switch (op.operation)
-            {
-            case ADDITION:
-                shadowReg = first + second;
-                break;
-            case AND:
-                shadowReg = first & second;
-                break;
-            case DIVISION:
-                shadowReg = first / second;
-                break;
-            case MULTIPLICATION:
-                shadowReg = first * second;
-                break;
-            case OR:
-                shadowReg = first | second;
-                break;
-            case SUBTRACTION:
-                shadowReg = first - second;
-                break;
-            case XOR:
-                shadowReg = first ^ second;
-                break;
-            case MOD:
-                shadowReg = first % second;
-            }
-        }
-        //Finally, drop the result into the proper data byte
-        QByteArray newArr(sendData->payload());
-        newArr[mod->destByte] = (char) shadowReg;
-        sendData->setPayload(newArr);
-    }
-}
-
-int FrameSenderWindow::fetchOperand(int idx, ModifierOperand op)
-{
-    CANFrame *tempFrame = nullptr;
-    if (op.ID == 0) //numeric constant
-    {
-        if (op.notOper) return ~op.databyte;
-        else return op.databyte;
-    }
-    else if (op.ID == -2) //fetch data from a data byte within the output frame
-    {
-        if (op.notOper) return ~((unsigned char)sendingData.at(idx).payload()[op.databyte]);
-        else return (unsigned char)sendingData.at(idx).payload()[op.databyte];
-    }
-    else //look up external data byte
-    {
-        tempFrame = lookupFrame(op.ID, op.bus);
-        if (tempFrame != nullptr)
-        {
-            if (op.notOper) return ~((unsigned char)tempFrame->payload()[op.databyte]);
-            else return (unsigned char)tempFrame->payload()[op.databyte];
-        }
-        else return 0;
-    }
-}
-
-/// <summary>
-/// Try to find the most recent frame given the input criteria
-/// </summary>
-/// <param name="ID">The ID to find</param>
-/// <param name="bus">Which bus to look on (-1 if you don't care)</param>
-/// <returns></returns>
-CANFrame* FrameSenderWindow::lookupFrame(int ID, int bus)
-{
-    if (!frameCache.contains(ID)) return nullptr;
-
-    if (bus == -1 || frameCache[ID].bus == bus) return &frameCache[ID];
-
-    return nullptr;
-}
-
 /// <summary>
 /// Process a single line from the dataGrid. Right now it seems to not trigger at all after the first adding of the code but that seems to maybe
 /// be because whichever field you where just in will show up as nothing to the code.
 /// </summary>
 /// <param name="line"></param>
-void FrameSenderWindow::processModifierText(int line)
+void FrameSenderWindow::processModifierText(int line, FrameSendData &data)
 {
     qDebug() << "processModifierText";
     QString modString;
@@ -705,12 +409,12 @@ void FrameSenderWindow::processModifierText(int line)
 
     //yeah, lots of operations on this one line but it's for a good cause. Removes the convenience English versions of the
     //logical operators and replaces them with the math equivs. Also uppercases and removes all superfluous whitespace
-    modString = ui->tableSender->item(line, 8)->text().toUpper().trimmed().replace("AND", "&").replace("XOR", "^").replace("OR", "|").replace(" ", "");
+    modString = ui->tableSender->item(line, ST_COLS::SENDTAB_COL_MODS)->text().toUpper().trimmed().replace("AND", "&").replace("XOR", "^").replace("OR", "|").replace(" ", "");
     if (modString != "")
     {
         QStringList mods = modString.split(',');
-        sendingData[line].modifiers.clear();
-        sendingData[line].modifiers.reserve(mods.length());
+        data.modifiers.clear();
+        data.modifiers.reserve(mods.length());
         for (int i = 0; i < mods.length(); i++)
         {
             Modifier thisMod;
@@ -780,8 +484,8 @@ void FrameSenderWindow::processModifierText(int line)
                         secondOp = secondOp.remove(0, 1); //remove the ~ character
                     }
                     else thisOp.second.notOper = false;
-                    thisOp.second.bus = sendingData[line].bus;
-                    thisOp.second.ID = sendingData[line].frameId();
+                    thisOp.second.bus = data.bus;
+                    thisOp.second.ID = data.frameId();
                     parseOperandString(secondOp.split(":"), thisOp.second);
                     thisMod.operations.append(thisOp);
                 }
@@ -790,13 +494,13 @@ void FrameSenderWindow::processModifierText(int line)
                 if (mods[i].length() < 2) abort = true;
             }
 
-            sendingData[line].modifiers.append(thisMod);
+            data.modifiers.append(thisMod);
         }
     }
     //there is no else for the modifiers. We'll accept there not being any
 }
 
-void FrameSenderWindow::processTriggerText(int line)
+void FrameSenderWindow::processTriggerText(int line, FrameSendData &data)
 {
     qDebug() << "processTriggerText";
     QString trigger;
@@ -809,8 +513,8 @@ void FrameSenderWindow::processTriggerText(int line)
     if (trigger != "")
     {
         QStringList triggers = trigger.split(',');
-        sendingData[line].triggers.clear();
-        sendingData[line].triggers.reserve(triggers.length());
+        data.triggers.clear();
+        data.triggers.reserve(triggers.length());
         for (int k = 0; k < triggers.length(); k++)
         {
             Trigger thisTrigger;
@@ -884,7 +588,7 @@ void FrameSenderWindow::processTriggerText(int line)
             //if (thisTrigger.maxCount == -1) thisTrigger.maxCount = 0;
             //if (thisTrigger.milliseconds == -1) thisTrigger.milliseconds = 100;
             //if (thisTrigger.ID == -1) thisTrigger.ID = 0;
-            sendingData[line].triggers.append(thisTrigger);
+            data.triggers.append(thisTrigger);
         }
     }
     else //setup a default single shot trigger
@@ -895,7 +599,7 @@ void FrameSenderWindow::processTriggerText(int line)
         thisTrigger.maxCount = 1;
         thisTrigger.milliseconds = 10;
         thisTrigger.triggerMask = TriggerMask::TRG_MS;
-        sendingData[line].triggers.append(thisTrigger);
+        data.triggers.append(thisTrigger);
     }
 }
 
@@ -945,34 +649,51 @@ ModifierOperationType FrameSenderWindow::parseOperation(QString op)
     return ADDITION;
 }
 
+void FrameSenderWindow::refreshGrid()
+{
+    for (int i = 0; i < ui->tableSender->rowCount() - 1; i++) updateGridRow(i);
+}
+
 /// <summary>
-/// Update the DataGridView with the newest info from sendingData
+/// Update the DataGridView with the newest info from the sender. Rows that haven't been sent since the last look are left alone
 /// </summary>
 /// <param name="idx"></param>
 void FrameSenderWindow::updateGridRow(int idx)
 {
     //qDebug() << "updateGridRow";
 
+    FrameSendData temp;
+    if (!frameSender->getSendRecord(idx, temp)) return;
+    QTableWidgetItem *item = ui->tableSender->item(idx, ST_COLS::SENDTAB_COL_COUNT);
+    const QString countString = QString::number(temp.count);
+    if (item != nullptr && item->text() == countString) return;
+
     inhibitChanged = true;
-    FrameSendData *temp = &sendingData[idx];
     int gridLine = idx;
     QString dataString;
-    QTableWidgetItem *item = ui->tableSender->item(gridLine, ST_COLS::SENDTAB_COL_COUNT);
-    const unsigned char *data = reinterpret_cast<const unsigned char *>(temp->payload().constData());
-    int dataLen = temp->payload().length();
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(temp.payload().constData());
+    int dataLen = temp.payload().length();
 
     if (item == nullptr)
     {
         item = new QTableWidgetItem();
-        item->setText(QString::number(temp->count));
+        item->setText(countString);
         ui->tableSender->setItem(gridLine, ST_COLS::SENDTAB_COL_COUNT, item);
     }
     else
     {
-        item->setText(QString::number(temp->count));
+        item->setText(countString);
     }
 
-    if (temp->frameType() != QCanBusFrame::RemoteRequestFrame)
+    const TimingStats jitter = frameSender->getJitterStats(idx);
+    if (jitter.count > 0)
+    {
+        item->setToolTip(tr("Period jitter: avg %1 us, min %2 us, max %3 us, std dev %4 us")
+                             .arg(jitter.meanNs / 1000.0, 0, 'f', 1).arg(jitter.minNs / 1000).arg(jitter.maxNs / 1000)
+                             .arg(jitter.stdDevNs() / 1000.0, 0, 'f', 1));
+    }
+
+    if (temp.frameType() != QCanBusFrame::RemoteRequestFrame)
     {
         for (int i = 0; i < dataLen; i++)
         {
@@ -991,105 +712,108 @@ void FrameSenderWindow::updateGridRow(int idx)
 void FrameSenderWindow::processCellChange(int line, int col)
 {
     qDebug() << "processCellChange";
-    FrameSendData tempData;
     QStringList tokens;
     int tempVal;
     DBC_MESSAGE *msg;
 
-    //if this is a new line then create the base object for the line
-    if (line >= sendingData.count())
-    {
-        FrameSendData tempData;
-        tempData.enabled = false;
-        tempData.setFrameType(QCanBusFrame::DataFrame);
-        tempData.setExtendedFrameFormat(false);
-        sendingData.append(tempData);
-    }
-
-    sendingData[line].count = 0;
-
     int numBuses = CANConManager::getInstance()->getNumBuses();
     QByteArray arr;
 
-    switch (col)
+    //the sending threads are locked out while the row changes
+    auto edit = [&](FrameSendData &data)
     {
-        case ST_COLS::SENDTAB_COL_EN: //Enable check box
-            if (ui->tableSender->item(line, 0)->checkState() == Qt::Checked)
-            {
-                sendingData[line].enabled = true;
-            }
-            else sendingData[line].enabled = false;
-            qDebug() << "Setting enabled to " << sendingData[line].enabled;
-            break;
-        case ST_COLS::SENDTAB_COL_BUS: //Bus designation
-            tempVal = Utility::ParseStringToNum(ui->tableSender->item(line, ST_COLS::SENDTAB_COL_BUS)->text());
-            if (tempVal < -1) tempVal = -1;
-            if (tempVal >= numBuses) tempVal = numBuses - 1;
-            sendingData[line].bus = tempVal;
-            qDebug() << "Setting bus to " << tempVal;
-            break;
-        case ST_COLS::SENDTAB_COL_ID: //ID field
-            tempVal = Utility::ParseStringToNum(ui->tableSender->item(line, ST_COLS::SENDTAB_COL_ID)->text());
-            if (tempVal < 0) tempVal = 0;
-            if (tempVal > 0x7FFFFFFF) tempVal = 0x7FFFFFFF;
-            sendingData[line].setFrameId(tempVal);
-            if (sendingData[line].frameId() > 0x7FF) {
-                sendingData[line].setExtendedFrameFormat(true);
-                ui->tableSender->blockSignals(true);
-                ui->tableSender->item(line, ST_COLS::SENDTAB_COL_EXT)->setCheckState(Qt::Checked);
-                ui->tableSender->blockSignals(false);
-            }
-            msg = dbcHandler->findMessage(sendingData[line].frameId());
-            if (msg)
-            {
-                ui->tableSender->blockSignals(true);
-                ui->tableSender->item(line, ST_COLS::SENDTAB_COL_MSGNAME)->setText(msg->name);
-                ui->tableSender->item(line, ST_COLS::SENDTAB_COL_LEN)->setText(QString::number(msg->len));
-                ui->tableSender->blockSignals(false);
-            }
-            qDebug() << "setting ID to " << tempVal;
-            break;
-        case ST_COLS::SENDTAB_COL_LEN:
-            tempVal = Utility::ParseStringToNum(ui->tableSender->item(line, 3)->text());
-            if (tempVal < 0) tempVal = 0;
-            if (tempVal > 8) tempVal = 8;            
-            arr.resize(tempVal);
-            sendingData[line].setPayload(arr);
-            break;
-        case ST_COLS::SENDTAB_COL_EXT:
-            if (ui->tableSender->item(line, 4)->checkState() == Qt::Checked) {
-                sendingData[line].setExtendedFrameFormat(true);
-            } else {
-                sendingData[line].setExtendedFrameFormat(false);
-            }
-            break;
-        case ST_COLS::SENDTAB_COL_REM:
-            if (ui->tableSender->item(line, 5)->checkState() == Qt::Checked) {
-                sendingData[line].setFrameType(QCanBusFrame::RemoteRequestFrame);
-            } else {
-                sendingData[line].setFrameType(QCanBusFrame::DataFrame);
-            }
-            break;
-        case ST_COLS::SENDTAB_COL_DATA: //Data bytes
+        data.count = 0;
+
+        switch (col)
+        {
+            case ST_COLS::SENDTAB_COL_EN: //Enable check box
+                if (ui->tableSender->item(line, ST_COLS::SENDTAB_COL_EN)->checkState() == Qt::Checked)
+                {
+                    data.enabled = true;
+                }
+                else data.enabled = false;
+                qDebug() << "Setting enabled to " << data.enabled;
+                break;
+            case ST_COLS::SENDTAB_COL_BUS: //Bus designation
+                tempVal = Utility::ParseStringToNum(ui->tableSender->item(line, ST_COLS::SENDTAB_COL_BUS)->text());
+                if (tempVal < -1) tempVal = -1;
+                if (tempVal >= numBuses) tempVal = numBuses - 1;
+                data.bus = tempVal;
+                qDebug() << "Setting bus to " << tempVal;
+                break;
+            case ST_COLS::SENDTAB_COL_ID: //ID field
+                tempVal = Utility::ParseStringToNum(ui->tableSender->item(line, ST_COLS::SENDTAB_COL_ID)->text());
+                if (tempVal < 0) tempVal = 0;
+                if (tempVal > 0x7FFFFFFF) tempVal = 0x7FFFFFFF;
+                data.setFrameId(tempVal);
+                if (data.frameId() > 0x7FF) {
+                    data.setExtendedFrameFormat(true);
+                    ui->tableSender->blockSignals(true);
+                    ui->tableSender->item(line, ST_COLS::SENDTAB_COL_EXT)->setCheckState(Qt::Checked);
+                    ui->tableSender->blockSignals(false);
+                }
+                msg = dbcHandler->findMessage(data.frameId());
+                if (msg)
+                {
+                    ui->tableSender->blockSignals(true);
+                    ui->tableSender->item(line, ST_COLS::SENDTAB_COL_MSGNAME)->setText(msg->name);
+                    ui->tableSender->item(line, ST_COLS::SENDTAB_COL_LEN)->setText(QString::number(msg->len));
+                    ui->tableSender->blockSignals(false);
+                }
+                qDebug() << "setting ID to " << tempVal;
+                break;
+            case ST_COLS::SENDTAB_COL_LEN:
+                tempVal = Utility::ParseStringToNum(ui->tableSender->item(line, ST_COLS::SENDTAB_COL_LEN)->text());
+                if (tempVal < 0) tempVal = 0;
+                if (tempVal > 8) tempVal = 8;
+                arr.resize(tempVal);
+                data.setPayload(arr);
+                break;
+            case ST_COLS::SENDTAB_COL_EXT:
+                if (ui->tableSender->item(line, ST_COLS::SENDTAB_COL_EXT)->checkState() == Qt::Checked) {
+                    data.setExtendedFrameFormat(true);
+                } else {
+                    data.setExtendedFrameFormat(false);
+                }
+                break;
+            case ST_COLS::SENDTAB_COL_REM:
+                if (ui->tableSender->item(line, ST_COLS::SENDTAB_COL_REM)->checkState() == Qt::Checked) {
+                    data.setFrameType(QCanBusFrame::RemoteRequestFrame);
+                } else {
+                    data.setFrameType(QCanBusFrame::DataFrame);
+                }
+                break;
+            case ST_COLS::SENDTAB_COL_DATA: //Data bytes
 #if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
-            tokens = ui->tableSender->item(line, ST_COLS::SENDTAB_COL_DATA)->text().split(" ", Qt::SkipEmptyParts);
+                tokens = ui->tableSender->item(line, ST_COLS::SENDTAB_COL_DATA)->text().split(" ", Qt::SkipEmptyParts);
 #else
-            tokens = ui->tableSender->item(line, ST_COLS::SENDTAB_COL_DATA)->text().split(" ", QString::SkipEmptyParts);
+                tokens = ui->tableSender->item(line, ST_COLS::SENDTAB_COL_DATA)->text().split(" ", QString::SkipEmptyParts);
 #endif
-            arr.clear();
-            arr.reserve(tokens.count());
-            for (int j = 0; j < tokens.count(); j++)
-            {
-                arr.append((uint8_t)Utility::ParseStringToNum(tokens[j]));
-            }
-            sendingData[line].setPayload(arr);
-            break;
-        case ST_COLS::SENDTAB_COL_TRIGGER: //triggers
-            processTriggerText(line);
-            break;
-        case ST_COLS::SENDTAB_COL_MODS: //modifiers
-            processModifierText(line);
-            break;
-    }
+                arr.clear();
+                arr.reserve(tokens.count());
+                for (int j = 0; j < tokens.count(); j++)
+                {
+                    arr.append((uint8_t)Utility::ParseStringToNum(tokens[j]));
+                }
+                data.setPayload(arr);
+                break;
+            case ST_COLS::SENDTAB_COL_TRIGGER: //triggers
+                processTriggerText(line, data);
+                break;
+            case ST_COLS::SENDTAB_COL_MODS: //modifiers
+                processModifierText(line, data);
+                break;
+        }
+    };
+
+    if (frameSender->editSendRecord(line, edit)) return;
+
+    //a new line, create the base object for it first
+    FrameSendData tempData;
+    tempData.enabled = false;
+    tempData.setFrameType(QCanBusFrame::DataFrame);
+    tempData.setExtendedFrameFormat(false);
+    frameSender->addSendRecord(tempData);
+    frameSender->editSendRecord(line, edit);
 }
 
@@ -3,14 +3,16 @@
 
 #include <QDialog>
 #include <QTimer>
-#include <QElapsedTimer>
 #include <QTime>
-#include <QMutex>
 #include "can_structs.h"
 #include "can_trigger_structs.h"
 #include "dbc/dbchandler.h"
+#include "framesenderobject.h"
 #include "triggerdialog.h"
 
+/* how often the counts and payloads in the grid are brought up to date with what has been sent */
+#define SENDER_REFRESH_MS   250
+
 namespace Ui {
 class FrameSenderWindow;
 }
@@ -41,41 +43,30 @@ public:
 private slots:
     void onCellChanged(int, int);
     void onCellDoubleTap(int, int);
-    void handleTick();
+    void refreshGrid();
     void enableAll();
     void disableAll();
     void clearGrid();
     void saveGrid();
     void loadGrid();
-    void updatedFrames(int);
 
 private:
     Ui::FrameSenderWindow *ui;
-    QList<FrameSendData> sendingData;
-    QHash<int, CANFrame> frameCache; //hash with frame ID as the key and the most recent frame as the value
-    const QVector<CANFrame> *modelFrames;
-    QTimer *intervalTimer;
-    QElapsedTimer elapsedTimer;
+    FrameSenderObject *frameSender;  //owns the rows and sends them from its own threads
+    QTimer *refreshTimer;
     bool inhibitChanged = false;
-    QMutex mutex;
     DBCHandler *dbcHandler;
     TriggerDialog *td;
-    FrameSendData *sendData;
 
     void createBlankRow();
-    void doModifiers(int);
-    int fetchOperand(int, ModifierOperand);
-    CANFrame* lookupFrame(int, int);
-    void processModifierText(int);
-    void processTriggerText(int);
+    void processModifierText(int, FrameSendData&);
+    void processTriggerText(int, FrameSendData&);
     void parseOperandString(QStringList tokens, ModifierOperand&);
     ModifierOperationType parseOperation(QString);
     void saveSenderFile(QString filename);
     void loadSenderFile(QString filename);
     void updateGridRow(int idx);
     void processCellChange(int line, int col);
-    void buildFrameCache();
-    void processIncomingFrame(CANFrame *frame);
     bool eventFilter(QObject *obj, QEvent *event);
     void setupGrid();
     void finishedTriggerDialog(int result);
@@ -0,0 +1,337 @@
+#include "framesendprogram.h"
+
+/* stands in for the bus or the ID of a bucket key when the trigger doesn't care which */
+#define SEND_ANY    0xFFFFFFFFu
+
+FrameSendProgram::FrameSendProgram()
+{
+    clear();
+}
+
+void FrameSendProgram::clear()
+{
+    triggers.clear();
+    triggerBuckets.clear();
+    anyBusTriggers = false;
+    anyIdTriggers = false;
+    specs.clear();
+    code.clear();
+    rowStart.clear();
+    rowStart.append(0);
+    watches.clear();
+    slotIndex.clear();
+    unfilledSlots = 0;
+}
+
+quint64 FrameSendProgram::key(int bus, uint32_t id)
+{
+    return ((quint64)(quint32)bus << 32) | id;
+}
+
+int FrameSendProgram::watchSlot(int bus, uint32_t id)
+{
+    const quint64 k = key(bus, id);
+    QHash<quint64, int>::const_iterator it = slotIndex.constFind(k);
+    if (it != slotIndex.constEnd()) return it.value();
+
+    WatchSlot slot;
+    slot.valid = false;
+    watches.append(slot);
+    slotIndex.insert(k, watches.count() - 1);
+    unfilledSlots++;
+    return watches.count() - 1;
+}
+
+/*
+ * Operand IDs as ModifierOperand has them: 0 is a constant, -1 the shadow register, -2 a byte of the
+ * frame being sent and anything positive the newest frame with that ID
+ */
+void FrameSendProgram::compileOperand(const ModifierOperand& operand, SendSignalResolver& resolver, SendInstruction& inst)
+{
+    inst.invert = operand.notOper;
+    inst.slot = -1;
+    inst.arg = operand.databyte;
+
+    if (operand.ID == 0) inst.source = SRC_CONST;
+    else if (operand.ID == -1) inst.source = SRC_ACC;
+    else if (operand.ID == -2) inst.source = SRC_OWN_BYTE;
+    else if (operand.ID > 0)
+    {
+        inst.slot = watchSlot(operand.bus, (uint32_t)operand.ID);
+        inst.source = SRC_FRAME_BYTE;
+        SignalCodecSpec spec;
+        if (!operand.signalName.isEmpty() && resolver && resolver((uint32_t)operand.ID, operand.signalName, spec))
+        {
+            specs.append(spec);
+            inst.source = SRC_FRAME_SIGNAL;
+            inst.arg = specs.count() - 1;
+        }
+    }
+    else inst.source = SRC_NONE;
+}
+
+void FrameSendProgram::compile(const QList<FrameSendData>& rows, SendSignalResolver resolver)
+{
+    clear();
+
+    for (int r = 0; r < rows.count(); r++)
+    {
+        const FrameSendData &row = rows[r];
+
+        for (int t = 0; t < row.triggers.count(); t++)
+        {
+            const Trigger &trig = row.triggers[t];
+            //only triggers on a bus and/or ID react to incoming frames. The rest are purely timed
+            if (!(trig.triggerMask & (TriggerMask::TRG_BUS | TriggerMask::TRG_ID))) continue;
+            if ((trig.triggerMask & TriggerMask::TRG_ID) && trig.ID < 0) continue; //nothing has that ID
+
+            CompiledTrigger ct;
+            ct.row = r;
+            ct.trigger = t;
+            ct.signal = -1;
+            ct.checkCount = (trig.triggerMask & TriggerMask::TRG_COUNT);
+            ct.checkValue = (trig.triggerMask & TriggerMask::TRG_SIGVAL);
+            ct.value = trig.sigValueDbl;
+            if (trig.triggerMask & TriggerMask::TRG_SIGNAL)
+            {
+                SignalCodecSpec spec;
+                ct.signal = -2;
+                if (trig.ID >= 0 && resolver && resolver((uint32_t)trig.ID, trig.sigName, spec))
+                {
+                    specs.append(spec);
+                    ct.signal = specs.count() - 1;
+                }
+            }
+            triggers.append(ct);
+
+            const quint32 bus = (trig.triggerMask & TriggerMask::TRG_BUS) ? (quint32)trig.bus : SEND_ANY;
+            const quint32 id = (trig.triggerMask & TriggerMask::TRG_ID) ? (quint32)trig.ID : SEND_ANY;
+            if (bus == SEND_ANY) anyBusTriggers = true;
+            if (id == SEND_ANY) anyIdTriggers = true;
+            triggerBuckets[key(bus, id)].append(triggers.count() - 1);
+        }
+
+        //D3 = D3 + ID:0x200:D1 & 0xF becomes LOAD own[3], ADD frame[0x200][1], AND 0xF, STORE_BYTE 3
+        for (int m = 0; m < row.modifiers.count(); m++)
+        {
+            const Modifier &mod = row.modifiers[m];
+            for (int o = 0; o < mod.operations.count(); o++)
+            {
+                const ModifierOp &op = mod.operations[o];
+                SendInstruction inst;
+                if (op.first.ID != -1)
+                {
+                    inst.code = SOP_LOAD;
+                    compileOperand(op.first, resolver, inst);
+                    code.append(inst);
+                }
+
+                switch (op.operation)
+                {
+                case ADDITION: inst.code = SOP_ADD; break;
+                case SUBTRACTION: inst.code = SOP_SUB; break;
+                case MULTIPLICATION: inst.code = SOP_MUL; break;
+                case DIVISION: inst.code = SOP_DIV; break;
+                case AND: inst.code = SOP_AND; break;
+                case OR: inst.code = SOP_OR; break;
+                case XOR: inst.code = SOP_XOR; break;
+                case MOD: inst.code = SOP_MOD; break;
+                }
+                compileOperand(op.second, resolver, inst);
+                code.append(inst);
+            }
+
+            SendInstruction store;
+            store.source = SRC_NONE;
+            store.invert = false;
+            store.slot = -1;
+            store.arg = mod.destByte;
+            store.code = SOP_STORE_BYTE;
+            if (mod.destByte < 0) //one of our own signals
+            {
+                SignalCodecSpec spec;
+                if (!resolver || !resolver(row.frameId(), mod.signalName, spec)) continue;
+                specs.append(spec);
+                store.code = SOP_STORE_SIGNAL;
+                store.arg = specs.count() - 1;
+            }
+            code.append(store);
+        }
+        rowStart.append(code.count());
+    }
+}
+
+bool FrameSendProgram::watchFrame(const CANFrame& frame)
+{
+    if (watches.isEmpty()) return false;
+    bool found = false;
+    const quint64 keys[2] = {key(frame.bus, frame.frameId()), key(-1, frame.frameId())};
+    for (int k = 0; k < 2; k++)
+    {
+        QHash<quint64, int>::const_iterator it = slotIndex.constFind(keys[k]);
+        if (it == slotIndex.constEnd()) continue;
+        WatchSlot &slot = watches[it.value()];
+        if (!slot.valid) unfilledSlots--;
+        slot.valid = true;
+        slot.payload = frame.payload();
+        found = true;
+    }
+    return found;
+}
+
+bool FrameSendProgram::seedFrame(const CANFrame& frame)
+{
+    if (unfilledSlots == 0) return false;
+    bool found = false;
+    const quint64 keys[2] = {key(frame.bus, frame.frameId()), key(-1, frame.frameId())};
+    for (int k = 0; k < 2; k++)
+    {
+        QHash<quint64, int>::const_iterator it = slotIndex.constFind(keys[k]);
+        if (it == slotIndex.constEnd() || watches[it.value()].valid) continue;
+        watches[it.value()].valid = true;
+        watches[it.value()].payload = frame.payload();
+        unfilledSlots--;
+        found = true;
+    }
+    return found;
+}
+
+int FrameSendProgram::emptySlots() const
+{
+    return unfilledSlots;
+}
+
+bool FrameSendProgram::hasWatches() const
+{
+    return !watches.isEmpty();
+}
+
+int FrameSendProgram::getTriggerCount() const
+{
+    return triggers.count();
+}
+
+int FrameSendProgram::getInstructionCount() const
+{
+    return code.count();
+}
+
+void FrameSendProgram::runBucket(quint64 bucketKey, const CANFrame& frame, QList<FrameSendData>& rows, QList<CANFrame>& out, int& sent, QVector<QPair<int, int>> *armed)
+{
+    QHash<quint64, QVector<int>>::const_iterator it = triggerBuckets.constFind(bucketKey);
+    if (it == triggerBuckets.constEnd()) return;
+
+    foreach (int idx, it.value())
+    {
+        const CompiledTrigger &ct = triggers[idx];
+        if (ct.row >= rows.count() || ct.trigger >= rows[ct.row].triggers.count()) continue; //changed under us, compile again
+        FrameSendData &row = rows[ct.row];
+        Trigger &trig = row.triggers[ct.trigger];
+
+        if (ct.checkCount && trig.currCount >= trig.maxCount) continue;
+        if (ct.signal == -2) continue;
+        if (ct.signal >= 0)
+        {
+            double value;
+            if (!SignalCodec::decode(specs[ct.signal], frame.payload(), value)) continue;
+            if (ct.checkValue && qAbs(value - ct.value) > 0.001) continue;
+        }
+
+        //a trigger with a delay only arms the timed sending, otherwise the row goes out right away
+        if (trig.milliseconds == 0)
+        {
+            trig.currCount++;
+            row.count++;
+            runModifiers(ct.row, row);
+            out.append(row);
+            sent++;
+        }
+        else if (!trig.readyCount)
+        {
+            trig.readyCount = true;
+            if (armed) armed->append(qMakePair(ct.row, ct.trigger));
+        }
+    }
+}
+
+int FrameSendProgram::processFrame(const CANFrame& frame, QList<FrameSendData>& rows, QList<CANFrame>& out, QVector<QPair<int, int>> *armed)
+{
+    watchFrame(frame);
+    if (triggers.isEmpty()) return 0;
+
+    int sent = 0;
+    runBucket(key(frame.bus, frame.frameId()), frame, rows, out, sent, armed);
+    if (anyBusTriggers) runBucket(key(SEND_ANY, frame.frameId()), frame, rows, out, sent, armed);
+    if (anyIdTriggers) runBucket(key(frame.bus, SEND_ANY), frame, rows, out, sent, armed);
+    return sent;
+}
+
+int FrameSendProgram::fetch(const SendInstruction& inst, const QByteArray& own) const
+{
+    int value;
+    switch (inst.source)
+    {
+    case SRC_CONST:
+        value = inst.arg;
+        break;
+    case SRC_OWN_BYTE:
+        if (inst.arg < 0 || inst.arg >= own.length()) return 0;
+        value = (unsigned char)own[inst.arg];
+        break;
+    case SRC_FRAME_BYTE:
+    {
+        const WatchSlot &slot = watches[inst.slot];
+        if (!slot.valid || inst.arg < 0 || inst.arg >= slot.payload.length()) return 0;
+        value = (unsigned char)slot.payload[inst.arg];
+        break;
+    }
+    case SRC_FRAME_SIGNAL:
+    {
+        const WatchSlot &slot = watches[inst.slot];
+        double sigVal;
+        if (!slot.valid || !SignalCodec::decode(specs[inst.arg], slot.payload, sigVal)) return 0;
+        value = (int)sigVal;
+        break;
+    }
+    default:
+        return 0;
+    }
+    return inst.invert ? ~value : value;
+}
+
+void FrameSendProgram::runModifiers(int row, FrameSendData& data)
+{
+    if (row < 0 || row + 1 >= rowStart.count()) return;
+    const int start = rowStart[row];
+    const int end = rowStart[row + 1];
+    if (start == end) return;
+
+    QByteArray payload = data.payload();
+    int acc = 0; //shadow register, carries over from one modifier to the next
+
+    for (int i = start; i < end; i++)
+    {
+        const SendInstruction &inst = code[i];
+        const int value = (inst.source == SRC_ACC) ? (inst.invert ? ~acc : acc) : fetch(inst, payload);
+        switch (inst.code)
+        {
+        case SOP_LOAD: acc = value; break;
+        case SOP_ADD: acc = acc + value; break;
+        case SOP_SUB: acc = acc - value; break;
+        case SOP_MUL: acc = acc * value; break;
+        case SOP_DIV: acc = value ? acc / value : 0; break;
+        case SOP_AND: acc = acc & value; break;
+        case SOP_OR: acc = acc | value; break;
+        case SOP_XOR: acc = acc ^ value; break;
+        case SOP_MOD: acc = value ? acc % value : 0; break;
+        case SOP_STORE_BYTE:
+            if (inst.arg >= payload.length()) payload.append(QByteArray(inst.arg + 1 - payload.length(), 0));
+            payload[inst.arg] = (char)acc;
+            break;
+        case SOP_STORE_SIGNAL:
+            SignalCodec::encode(specs[inst.arg], acc, payload);
+            break;
+        }
+    }
+    data.setPayload(payload);
+}
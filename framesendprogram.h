@@ -0,0 +1,130 @@
+#ifndef FRAMESENDPROGRAM_H
+#define FRAMESENDPROGRAM_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QPair>
+#include <functional>
+#include "can_structs.h"
+#include "can_trigger_structs.h"
+#include "dbc/signalcodec.h"
+
+/* looks a signal of a message up in the DBC. Returns false if there is no such signal */
+typedef std::function<bool(uint32_t id, const QString& sigName, SignalCodecSpec& spec)> SendSignalResolver;
+
+/* what a modifier instruction does with the accumulator */
+enum SendOpCode
+{
+    SOP_LOAD,
+    SOP_ADD,
+    SOP_SUB,
+    SOP_MUL,
+    SOP_DIV,
+    SOP_AND,
+    SOP_OR,
+    SOP_XOR,
+    SOP_MOD,
+    SOP_STORE_BYTE,
+    SOP_STORE_SIGNAL
+};
+
+/* where the operand of a modifier instruction comes from */
+enum SendOperandSource
+{
+    SRC_CONST,
+    SRC_ACC,
+    SRC_OWN_BYTE,
+    SRC_FRAME_BYTE,
+    SRC_FRAME_SIGNAL,
+    SRC_NONE
+};
+
+struct SendInstruction
+{
+    quint8 code;
+    quint8 source;
+    bool invert;
+    int slot;       //watched frame for SRC_FRAME_*
+    int arg;        //constant, byte index or index into the signal specs
+};
+
+/*
+  The sender rows compiled into a form that is quick to run for every frame on the bus. compile() is
+  called whenever the rows change and does all the looking up: triggers that react to incoming frames
+  are put in buckets by (bus, ID), either of which can be "any", signals are resolved against the DBC
+  once into codec specs, and each row's modifiers become a flat list of accumulator instructions.
+
+  Frames that modifiers read from are kept in watch slots per (bus, ID) so a modifier that asks for a
+  frame on bus 1 gets the newest one from bus 1 even if the same ID has been seen on bus 0 since.
+
+  The trigger counters and the payloads still live in the rows. The program only keeps indexes into
+  them, so it has to be compiled again whenever rows or their triggers and modifiers are changed.
+*/
+class FrameSendProgram
+{
+public:
+    FrameSendProgram();
+
+    void compile(const QList<FrameSendData>& rows, SendSignalResolver resolver);
+    void clear();
+
+    /* newest frame for every watch slot. Returns true if this frame filled one */
+    bool watchFrame(const CANFrame& frame);
+    /* like watchFrame but only fills slots that are still empty. For walking a capture backwards */
+    bool seedFrame(const CANFrame& frame);
+    int emptySlots() const;
+    bool hasWatches() const;
+
+    /**
+     * @brief runs the frame triggers against one incoming frame
+     * @param out - appended with every row that has to be sent right away. Rows with a delay are set ready instead
+     * @param armed - if given, appended with the (row, trigger) of every delayed trigger this frame set ready
+     * @return number of rows appended to out
+     */
+    int processFrame(const CANFrame& frame, QList<FrameSendData>& rows, QList<CANFrame>& out, QVector<QPair<int, int>> *armed = nullptr);
+
+    /* runs the modifiers of one row on its payload */
+    void runModifiers(int row, FrameSendData& data);
+
+    int getTriggerCount() const;
+    int getInstructionCount() const;
+
+private:
+    struct CompiledTrigger
+    {
+        int row;
+        int trigger;
+        int signal;         //index into specs, -1 for none, -2 if it couldn't be resolved and so never matches
+        bool checkCount;
+        bool checkValue;
+        double value;
+    };
+
+    struct WatchSlot
+    {
+        bool valid;
+        QByteArray payload;
+    };
+
+    static quint64 key(int bus, uint32_t id);
+    int watchSlot(int bus, uint32_t id);
+    void compileOperand(const ModifierOperand& operand, SendSignalResolver& resolver, SendInstruction& inst);
+    int fetch(const SendInstruction& inst, const QByteArray& own) const;
+    void runBucket(quint64 bucketKey, const CANFrame& frame, QList<FrameSendData>& rows, QList<CANFrame>& out, int& sent, QVector<QPair<int, int>> *armed);
+
+    QVector<CompiledTrigger> triggers;
+    QHash<quint64, QVector<int>> triggerBuckets;
+    bool anyBusTriggers;
+    bool anyIdTriggers;
+
+    QVector<SignalCodecSpec> specs;
+    QVector<SendInstruction> code;
+    QVector<int> rowStart;      //first instruction of each row, one past the end as the last entry
+
+    QVector<WatchSlot> watches;
+    QHash<quint64, int> slotIndex;
+    int unfilledSlots;
+};
+
+#endif // FRAMESENDPROGRAM_H
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include "framesendschedule.h"
+
+//std heaps keep the largest on top so "later" puts the earliest deadline there
+bool FrameSendSchedule::later(const SendScheduleEntry& a, const SendScheduleEntry& b)
+{
+    if (a.dueNs != b.dueNs) return a.dueNs > b.dueNs;
+    if (a.row != b.row) return a.row > b.row;
+    return a.trigger > b.trigger;
+}
+
+void FrameSendSchedule::clear()
+{
+    heap.clear();
+}
+
+void FrameSendSchedule::add(const SendScheduleEntry& entry)
+{
+    heap.append(entry);
+    std::push_heap(heap.begin(), heap.end(), later);
+}
+
+int FrameSendSchedule::count() const
+{
+    return heap.count();
+}
+
+qint64 FrameSendSchedule::nextDue() const
+{
+    if (heap.isEmpty()) return -1;
+    return heap.first().dueNs;
+}
+
+int FrameSendSchedule::takeDue(qint64 untilNs, QVector<SendScheduleEntry>& out)
+{
+    int taken = 0;
+    while (!heap.isEmpty() && heap.first().dueNs <= untilNs)
+    {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        out.append(heap.last());
+        heap.removeLast();
+        taken++;
+    }
+    return taken;
+}
+
+int FrameSendSchedule::takeSlot(qint64 nowNs, QVector<SendScheduleEntry>& out)
+{
+    return takeDue(nowNs + FRAMESEND_SLOT_NS, out);
+}
+
+void FrameSendSchedule::reschedule(SendScheduleEntry entry, qint64 nowNs)
+{
+    if (entry.periodNs <= 0) return;
+    entry.dueNs += entry.periodNs;
+    if (entry.dueNs <= nowNs) entry.dueNs += ((nowNs - entry.dueNs) / entry.periodNs + 1) * entry.periodNs;
+    add(entry);
+}
+
+const QVector<SendScheduleEntry>& FrameSendSchedule::getEntries() const
+{
+    return heap;
+}
@@ -0,0 +1,62 @@
+#ifndef FRAMESENDSCHEDULE_H
+#define FRAMESENDSCHEDULE_H
+
+#include <QVector>
+
+/* timed frames due within this long of the earliest one are sent in the same batch */
+#define FRAMESEND_SLOT_NS       50000
+/* how long before a deadline a sending thread stops sleeping. Less than a slot so it sleeps between batches however dense the schedule is */
+#define FRAMESEND_SPIN_NS       30000
+
+/* one timed trigger waiting for its turn */
+struct SendScheduleEntry
+{
+    qint64 dueNs;
+    qint64 periodNs;
+    qint64 lastSentNs;  //-1 until it has been sent once since it was scheduled
+    int row;
+    int trigger;
+    bool oneShot;       //delayed reply to a frame rather than a periodic send
+};
+
+/*
+  The timed triggers of the frame sender ordered by when they are next due, kept as a binary min-heap.
+  The sending thread only ever looks at the top to know how long it can sleep and then takes everything
+  that falls within one slot of the earliest deadline so frames due together go out as one batch.
+  Adding, taking and rescheduling are all O(log n) in the number of timed triggers.
+*/
+class FrameSendSchedule
+{
+public:
+    void clear();
+    void add(const SendScheduleEntry& entry);
+    int count() const;
+
+    /* deadline of the earliest entry or -1 if there are none */
+    qint64 nextDue() const;
+
+    /**
+     * @brief removes every entry due at or before untilNs
+     * @param out - the entries in deadline order
+     * @return how many were taken
+     */
+    int takeDue(qint64 untilNs, QVector<SendScheduleEntry>& out);
+
+    /* takeDue for everything within one FRAMESEND_SLOT_NS of nowNs, the batch a sending thread sends on waking */
+    int takeSlot(qint64 nowNs, QVector<SendScheduleEntry>& out);
+
+    /**
+     * @brief puts a periodic entry back one period on from its last deadline
+     * @note periods that were missed entirely (the machine stalled) are skipped instead of sent in a burst
+     */
+    void reschedule(SendScheduleEntry entry, qint64 nowNs);
+
+    const QVector<SendScheduleEntry>& getEntries() const;
+
+private:
+    static bool later(const SendScheduleEntry& a, const SendScheduleEntry& b);
+
+    QVector<SendScheduleEntry> heap;
+};
+
+#endif // FRAMESENDSCHEDULE_H
@@ -248,7 +248,7 @@ MainWindow::MainWindow(QWidget *parent) :
     frameSender = new FrameSenderObject(model->getListReference());
 
     frameSender->initialize(); //creates the thread and sets things up
-    frameSender->startSending(); //start the timer in the object so enabled things can send
+    frameSender->startSending(); //start the timed sending thread so enabled things can send
 
     installEventFilter(this);
 }
@@ -477,121 +477,117 @@ void MainWindow::onSenderCellChanged(int row, int col)
 void MainWindow::processSenderCellChange(int line, int col)
 {
     qDebug() << "processSenderCellChange";
-    FrameSendData *tempData;
     QStringList tokens;
     int tempVal;
 
     int numBuses = CANConManager::getInstance()->getNumBuses();
     QByteArray arr;
 
-    tempData = frameSender->getSendRecordRef(line);
-
-    if (!tempData)
-    {
-        qDebug() << "Need to set up a new entry in senders";
-        FrameSendData dat;
-        dat.enabled = false;
-        dat.count = 0;
-        dat.frameCount = 0;
-        dat.bus = 0;
-        frameSender->addSendRecord(dat);
-        tempData = frameSender->getSendRecordRef(line);
-    }
-
-    if (!tempData)
+    //the sending thread is locked out while the row changes
+    auto edit = [&](FrameSendData &data)
     {
-        qDebug() << "No data to modify in processSenderCellChange. This is a bug!";
-        return;
-    }
-
-    switch (col)
-    {
-    case SIMP_COL::SC_COL_EN: //Enable check box
-        if (ui->tableSimpleSender->item(line, 0)->checkState() == Qt::Checked)
+        switch (col)
         {
-            tempData->enabled = true;
-        }
-        else tempData->enabled = false;
-        qDebug() << "Setting enabled to " << tempData->enabled;
-        break;
-    case SIMP_COL::SC_COL_BUS: //Bus designation
-        tempVal = Utility::ParseStringToNum(ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_BUS)->text());
-        if (tempVal < -1) tempVal = -1;
-        if (tempVal >= numBuses) tempVal = numBuses - 1;
-        tempData->bus = tempVal;
-        qDebug() << "Setting bus to " << tempVal;
-        break;
-    case SIMP_COL::SC_COL_ID: //ID field
-        tempVal = Utility::ParseStringToNum(ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_ID)->text());
-        if (tempVal < 0) tempVal = 0;
-        if (tempVal > 0x7FFFFFFF) tempVal = 0x7FFFFFFF;
-        tempData->setFrameId(tempVal);
-        if (tempData->frameId() > 0x7FF) {
-            tempData->setExtendedFrameFormat(true);
-            ui->tableSimpleSender->blockSignals(true);
-            ui->tableSimpleSender->item(line, ST_COLS::SENDTAB_COL_EXT)->setCheckState(Qt::Checked);
-            ui->tableSimpleSender->blockSignals(false);
-        }
-        qDebug() << "setting ID to " << tempVal;
-        break;
-    case SIMP_COL::SC_COL_EXT:
-        if (ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_EXT)->checkState() == Qt::Checked) {
-            tempData->setExtendedFrameFormat(true);
-        } else {
-            tempData->setExtendedFrameFormat(false);
-        }
-        break;
-    case SIMP_COL::SC_COL_REM:
-        if (ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_REM)->checkState() == Qt::Checked) {
-            tempData->setFrameType(QCanBusFrame::RemoteRequestFrame);
-        } else {
-            tempData->setFrameType(QCanBusFrame::DataFrame);
-        }
-        break;
-    case SIMP_COL::SC_COL_DATA: //Data bytes
-        for (int i = 0; i < 8; i++) tempData->payload().data()[i] = 0;
-
+        case SIMP_COL::SC_COL_EN: //Enable check box
+            if (ui->tableSimpleSender->item(line, 0)->checkState() == Qt::Checked)
+            {
+                data.enabled = true;
+            }
+            else data.enabled = false;
+            qDebug() << "Setting enabled to " << data.enabled;
+            break;
+        case SIMP_COL::SC_COL_BUS: //Bus designation
+            tempVal = Utility::ParseStringToNum(ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_BUS)->text());
+            if (tempVal < -1) tempVal = -1;
+            if (tempVal >= numBuses) tempVal = numBuses - 1;
+            data.bus = tempVal;
+            qDebug() << "Setting bus to " << tempVal;
+            break;
+        case SIMP_COL::SC_COL_ID: //ID field
+            tempVal = Utility::ParseStringToNum(ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_ID)->text());
+            if (tempVal < 0) tempVal = 0;
+            if (tempVal > 0x7FFFFFFF) tempVal = 0x7FFFFFFF;
+            data.setFrameId(tempVal);
+            if (data.frameId() > 0x7FF) {
+                data.setExtendedFrameFormat(true);
+                ui->tableSimpleSender->blockSignals(true);
+                ui->tableSimpleSender->item(line, ST_COLS::SENDTAB_COL_EXT)->setCheckState(Qt::Checked);
+                ui->tableSimpleSender->blockSignals(false);
+            }
+            qDebug() << "setting ID to " << tempVal;
+            break;
+        case SIMP_COL::SC_COL_EXT:
+            if (ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_EXT)->checkState() == Qt::Checked) {
+                data.setExtendedFrameFormat(true);
+            } else {
+                data.setExtendedFrameFormat(false);
+            }
+            break;
+        case SIMP_COL::SC_COL_REM:
+            if (ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_REM)->checkState() == Qt::Checked) {
+                data.setFrameType(QCanBusFrame::RemoteRequestFrame);
+            } else {
+                data.setFrameType(QCanBusFrame::DataFrame);
+            }
+            break;
+        case SIMP_COL::SC_COL_DATA: //Data bytes
 #if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
-        tokens = ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_DATA)->text().split(" ", Qt::SkipEmptyParts);
+            tokens = ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_DATA)->text().split(" ", Qt::SkipEmptyParts);
 #else
-        tokens = ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_DATA)->text().split(" ", QString::SkipEmptyParts);
+            tokens = ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_DATA)->text().split(" ", QString::SkipEmptyParts);
 #endif
-        arr.clear();
-        arr.reserve(tokens.count());
-        for (int j = 0; j < tokens.count(); j++)
-        {
-            arr.append((uint8_t)Utility::ParseStringToNum(tokens[j]));
-        }
-        tempData->setPayload(arr);
-        break;
-    case SIMP_COL::SC_COL_INTERVAL: //interval in ms
-
-        QString trigger = ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_INTERVAL)->text().toUpper();
-
-        Trigger thisTrigger;
-        thisTrigger.bus = -1; //-1 means we don't care which
-        thisTrigger.ID = -1; //the rest of these being -1 means nothing has changed it
-        thisTrigger.maxCount = -1;
-        thisTrigger.milliseconds = -1;
-        thisTrigger.currCount = 0;
-        thisTrigger.msCounter = 0;
-        thisTrigger.triggerMask = 0;
-        thisTrigger.readyCount = true;
-
-        tempData->triggers.clear();
-        tempData->triggers.reserve(1);
-
-        if (trigger != "")
-        {
-            thisTrigger.milliseconds = Utility::ParseStringToNum(trigger);
-            thisTrigger.triggerMask |= TriggerMask::TRG_MS;
+            arr.clear();
+            arr.reserve(tokens.count());
+            for (int j = 0; j < tokens.count(); j++)
+            {
+                arr.append((uint8_t)Utility::ParseStringToNum(tokens[j]));
+            }
+            data.setPayload(arr);
+            break;
+        case SIMP_COL::SC_COL_INTERVAL: //interval in ms
+
+            QString trigger = ui->tableSimpleSender->item(line, SIMP_COL::SC_COL_INTERVAL)->text().toUpper();
+
+            Trigger thisTrigger;
+            thisTrigger.bus = -1; //-1 means we don't care which
+            thisTrigger.ID = -1; //the rest of these being -1 means nothing has changed it
+            thisTrigger.maxCount = -1;
+            thisTrigger.milliseconds = -1;
+            thisTrigger.currCount = 0;
+            thisTrigger.msCounter = 0;
+            thisTrigger.triggerMask = 0;
+            thisTrigger.readyCount = true;
+
+            data.triggers.clear();
+            data.triggers.reserve(1);
+
+            if (trigger != "")
+            {
+                thisTrigger.milliseconds = Utility::ParseStringToNum(trigger);
+                thisTrigger.triggerMask |= TriggerMask::TRG_MS;
+            }
+
+            if (thisTrigger.milliseconds < 1) thisTrigger.milliseconds = 1;
+
+            data.triggers.append(thisTrigger);
+
+            break;
         }
+    };
 
-        if (thisTrigger.milliseconds < 1) thisTrigger.milliseconds = 1;
+    if (frameSender->editSendRecord(line, edit)) return;
 
-        tempData->triggers.append(thisTrigger);
+    qDebug() << "Need to set up a new entry in senders";
+    FrameSendData dat;
+    dat.enabled = false;
+    dat.count = 0;
+    dat.frameCount = 0;
+    dat.bus = 0;
+    frameSender->addSendRecord(dat);
 
-        break;
+    if (!frameSender->editSendRecord(line, edit))
+    {
+        qDebug() << "No data to modify in processSenderCellChange. This is a bug!";
     }
 }
 
@@ -955,7 +951,7 @@ void MainWindow::filterClearAll()
     model->setAllFilters(false);
 }
 
-void MainWindow::logReceivedFrame(CANConnection* conn, QVector<CANFrame> frames)
+void MainWindow::logReceivedFrame(CANConnection* conn, const QVector<CANFrame>& frames)
 {
     Q_UNUSED(conn);
     if (continuousLogging)
@@ -1015,14 +1011,21 @@ void MainWindow::tickGUIUpdate()
         }
 
         //refresh the count for all the frame senders
-        FrameSendData *tempData;
         int numRows = ui->tableSimpleSender->rowCount();
         for (int i = 0; i < numRows; i++)
         {
-            tempData = frameSender->getSendRecordRef(i);
-            if (tempData)
+            const int sendCount = frameSender->getSendCount(i);
+            if (sendCount > -1)
             {
-                ui->tableSimpleSender->item(i, SIMP_COL::SC_COL_COUNT)->setText(QString::number( tempData->count ));
+                ui->tableSimpleSender->item(i, SIMP_COL::SC_COL_COUNT)->setText(QString::number(sendCount));
+                const TimingStats jitter = frameSender->getJitterStats(i);
+                if (jitter.count > 0)
+                {
+                    ui->tableSimpleSender->item(i, SIMP_COL::SC_COL_COUNT)->setToolTip(
+                        tr("Period jitter: avg %1 us, min %2 us, max %3 us, std dev %4 us")
+                            .arg(jitter.meanNs / 1000.0, 0, 'f', 1).arg(jitter.minNs / 1000).arg(jitter.maxNs / 1000)
+                            .arg(jitter.stdDevNs() / 1000.0, 0, 'f', 1));
+                }
             }
         }
 
@@ -115,7 +115,7 @@ private slots:
     void interpretToggled(bool);
     void overwriteToggled(bool);
     void presistentFiltersToggled(bool state);
-    void logReceivedFrame(CANConnection*, QVector<CANFrame>);
+    void logReceivedFrame(CANConnection*, const QVector<CANFrame>&);
     void tickGUIUpdate();
     void toggleCapture();
     void normalizeTiming();
@@ -0,0 +1,224 @@
+#include <QtAlgorithms>
+#include <algorithm>
+
+#include "discretestatesolver.h"
+
+namespace
+{
+    /* 256 bit set of the values seen by one candidate */
+    struct ValueSet
+    {
+        quint64 words[4];
+
+        void add(int v) { words[v >> 6] |= 1ULL << (v & 63); }
+        int count() const
+        {
+            return qPopulationCount(words[0]) + qPopulationCount(words[1]) + qPopulationCount(words[2]) + qPopulationCount(words[3]);
+        }
+        QVector<int> values() const
+        {
+            QVector<int> out;
+            for (int v = 0; v < 256; v++) if (words[v >> 6] & (1ULL << (v & 63))) out.append(v);
+            return out;
+        }
+    };
+
+    inline int candidateIndex(int startBit, int bitLength)
+    {
+        return startBit * DISCRETE_MAX_BITS + bitLength - 1;
+    }
+
+    inline bool bitVaries(const QVector<quint8> &seenZero, const QVector<quint8> &seenOne, int bit)
+    {
+        return (seenZero[bit / 8] & seenOne[bit / 8]) & (1 << (bit % 8));
+    }
+
+    inline void noteBits(QVector<quint8> &seenZero, QVector<quint8> &seenOne, const unsigned char *data, int len)
+    {
+        for (int c = 0; c < len; c++)
+        {
+            seenZero[c] |= ~data[c];
+            seenOne[c] |= data[c];
+        }
+    }
+
+    /*
+     * Largest first. A field whose lowest or highest bit never changes is just a smaller match padded
+     * with a constant bit, so it is left for the smaller size to find. Anything inside an earlier match
+     * is the same signal seen through a smaller window
+     */
+    template<typename Check>
+    QVector<DiscreteStateMatch> collectMatches(uint32_t id, int lenBits, int minBits, int maxBits,
+                                               const QVector<quint8> &seenZero, const QVector<quint8> &seenOne, Check check)
+    {
+        QVector<DiscreteStateMatch> matches;
+        for (int bits = maxBits; bits >= minBits; bits--)
+        {
+            for (int start = 0; start + bits <= lenBits; start++)
+            {
+                if (bits > minBits && (!bitVaries(seenZero, seenOne, start) || !bitVaries(seenZero, seenOne, start + bits - 1))) continue;
+
+                bool inside = false;
+                foreach (const DiscreteStateMatch &match, matches)
+                {
+                    if (start >= match.startBit && start + bits <= match.startBit + match.bitLength)
+                    {
+                        inside = true;
+                        break;
+                    }
+                }
+                if (inside) continue;
+
+                DiscreteStateMatch match;
+                if (!check(start, bits, match.values)) continue;
+                match.id = id;
+                match.startBit = start;
+                match.bitLength = bits;
+                matches.append(match);
+            }
+        }
+        return matches;
+    }
+}
+
+QHash<uint32_t, QVector<CANFrame>> DiscreteStateSolver::bucketFrames(const QVector<CANFrame>& frames, const QSet<uint32_t>& ids)
+{
+    QHash<uint32_t, QVector<CANFrame>> buckets;
+    buckets.reserve(ids.count());
+
+    foreach (const CANFrame &frame, frames)
+    {
+        if (!ids.contains(frame.frameId())) continue;
+        buckets[frame.frameId()].append(frame);
+    }
+    return buckets;
+}
+
+QVector<DiscreteStateMatch> DiscreteStateSolver::solveID(uint32_t id, const QVector<CANFrame>& frames, int numStates, int minBits, int maxBits)
+{
+    minBits = qBound(1, minBits, DISCRETE_MAX_BITS);
+    maxBits = qBound(minBits, maxBits, DISCRETE_MAX_BITS);
+
+    int lenBits = 0;
+    foreach (const CANFrame &frame, frames) lenBits = qMax(lenBits, qMin(frame.payload().length(), DISCRETE_MAX_PAYLOAD) * 8);
+    if (lenBits == 0) return QVector<DiscreteStateMatch>();
+
+    //one pass over the frames fills the value sets of every candidate
+    QVector<ValueSet> seen(lenBits * DISCRETE_MAX_BITS, ValueSet{{0, 0, 0, 0}});
+    QVector<quint8> seenZero(lenBits / 8, 0), seenOne(lenBits / 8, 0);
+    foreach (const CANFrame &frame, frames)
+    {
+        const QByteArray payload = frame.payload();
+        const unsigned char *data = (const unsigned char *)payload.constData();
+        const int len = qMin(payload.length(), DISCRETE_MAX_PAYLOAD);
+        const int frameBits = len * 8;
+
+        noteBits(seenZero, seenOne, data, len);
+        for (int start = 0; start + minBits <= frameBits; start++)
+        {
+            const int win = window(data, len, start);
+            for (int bits = minBits; bits <= maxBits && start + bits <= frameBits; bits++)
+                seen[candidateIndex(start, bits)].add(win & ((1 << bits) - 1));
+        }
+    }
+
+    return collectMatches(id, lenBits, minBits, maxBits, seenZero, seenOne, [&](int start, int bits, QVector<int> &values)
+    {
+        const ValueSet &set = seen[candidateIndex(start, bits)];
+        if (set.count() != numStates) return false;
+        values = set.values();
+        return true;
+    });
+}
+
+DiscreteStateTracker::DiscreteStateTracker()
+{
+    numStates = 0;
+    minBits = 1;
+    maxBits = DISCRETE_MAX_BITS;
+}
+
+void DiscreteStateTracker::start(int states, int min, int max)
+{
+    tracked.clear();
+    numStates = qMax(1, states);
+    minBits = qBound(1, min, DISCRETE_MAX_BITS);
+    maxBits = qBound(minBits, max, DISCRETE_MAX_BITS);
+}
+
+void DiscreteStateTracker::clear()
+{
+    tracked.clear();
+}
+
+int DiscreteStateTracker::getNumStates() const
+{
+    return numStates;
+}
+
+void DiscreteStateTracker::addFrame(const CANFrame& frame, int state)
+{
+    if (state < 0 || state >= numStates) return;
+
+    const QByteArray payload = frame.payload();
+    const unsigned char *data = (const unsigned char *)payload.constData();
+    const int len = qMin(payload.length(), DISCRETE_MAX_PAYLOAD);
+    const int frameBits = len * 8;
+
+    TrackedID &entry = tracked[frame.frameId()];
+    if (entry.bits < frameBits)
+    {
+        //start bit is the outer index so growing keeps what is already there in place
+        entry.bits = frameBits;
+        entry.values.resize(frameBits * DISCRETE_MAX_BITS * numStates);
+        entry.flags.resize(frameBits * DISCRETE_MAX_BITS * numStates);
+        entry.seenZero.resize(len);
+        entry.seenOne.resize(len);
+    }
+    noteBits(entry.seenZero, entry.seenOne, data, len);
+
+    quint8 *values = entry.values.data();
+    quint8 *flags = entry.flags.data();
+    for (int start = 0; start + minBits <= frameBits; start++)
+    {
+        const int win = DiscreteStateSolver::window(data, len, start);
+        for (int bits = minBits; bits <= maxBits && start + bits <= frameBits; bits++)
+        {
+            const int idx = candidateIndex(start, bits) * numStates + state;
+            const quint8 v = win & ((1 << bits) - 1);
+            if (!(flags[idx] & SEEN))
+            {
+                flags[idx] = SEEN;
+                values[idx] = v;
+            }
+            else if (values[idx] != v) flags[idx] |= UNSTABLE;
+        }
+    }
+}
+
+QVector<DiscreteStateMatch> DiscreteStateTracker::getMatches() const
+{
+    QVector<DiscreteStateMatch> matches;
+    QList<uint32_t> ids = tracked.keys();
+    std::sort(ids.begin(), ids.end());
+
+    foreach (uint32_t id, ids)
+    {
+        const TrackedID &entry = tracked[id];
+        matches += collectMatches(id, entry.bits, minBits, maxBits, entry.seenZero, entry.seenOne, [&](int start, int bits, QVector<int> &out)
+        {
+            const int base = candidateIndex(start, bits) * numStates;
+            ValueSet set = {{0, 0, 0, 0}};
+            for (int s = 0; s < numStates; s++)
+            {
+                if (entry.flags[base + s] != SEEN) return false; //never seen in this state or not steady
+                set.add(entry.values[base + s]);
+            }
+            if (set.count() != numStates) return false;
+            out.clear();
+            for (int s = 0; s < numStates; s++) out.append(entry.values[base + s]);
+            return true;
+        });
+    }
+    return matches;
+}
@@ -0,0 +1,89 @@
+#ifndef DISCRETESTATESOLVER_H
+#define DISCRETESTATESOLVER_H
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include "can_structs.h"
+
+/* the window limits signals to 8 bits so every value fits a 256 bit set */
+#define DISCRETE_MAX_BITS       8
+/* bits above this are never looked at */
+#define DISCRETE_MAX_PAYLOAD    64
+
+struct DiscreteStateMatch
+{
+    uint32_t id;
+    int startBit;       //intel bit numbering, least significant bit of the signal
+    int bitLength;
+    QVector<int> values;
+};
+
+/*
+  Finds bit fields of a frame ID that take exactly as many distinct values as the thing being
+  reverse engineered has states. All candidates from maxBits down to minBits at every start bit are
+  checked in one pass over the frames. Fields padded with bits that never change and fields inside a larger
+  match aren't reported, so each signal shows up once.
+
+  bucketFrames splits a capture into per ID lists in one pass so the IDs can then be solved
+  independently, one per worker thread.
+*/
+class DiscreteStateSolver
+{
+public:
+    static QHash<uint32_t, QVector<CANFrame>> bucketFrames(const QVector<CANFrame>& frames, const QSet<uint32_t>& ids);
+    static QVector<DiscreteStateMatch> solveID(uint32_t id, const QVector<CANFrame>& frames, int numStates, int minBits, int maxBits);
+
+    /* value of the 8 bits starting at startBit. Bits past the end of the payload read as zero */
+    static inline int window(const unsigned char *data, int len, int startBit)
+    {
+        const int byte = startBit / 8;
+        const int shift = startBit % 8;
+        int v = data[byte] >> shift;
+        if (shift && (byte + 1) < len) v |= data[byte + 1] << (8 - shift);
+        return v & 0xFF;
+    }
+};
+
+/*
+  Realtime side of the discrete state search. While the user steps through the states every frame
+  that arrives is fed in along with the state the user was told to be in. Nothing is kept but the
+  first value each candidate had in each state and whether it ever changed within that state, so
+  results are available at any time without going back over the frames.
+
+  A match is a candidate that held one steady value in every state, with a different value per state.
+*/
+class DiscreteStateTracker
+{
+public:
+    DiscreteStateTracker();
+
+    void start(int numStates, int minBits, int maxBits);
+    void clear();
+    void addFrame(const CANFrame& frame, int state);
+    QVector<DiscreteStateMatch> getMatches() const;
+    int getNumStates() const;
+
+private:
+    enum
+    {
+        SEEN = 1,
+        UNSTABLE = 2
+    };
+
+    struct TrackedID
+    {
+        int bits = 0;           //payload bits covered so far
+        QVector<quint8> values; //[start bit][length - 1][state]
+        QVector<quint8> flags;
+        QVector<quint8> seenZero;   //per payload byte, bits that have been 0 / 1 at least once
+        QVector<quint8> seenOne;
+    };
+
+    int numStates;
+    int minBits;
+    int maxBits;
+    QHash<uint32_t, TrackedID> tracked;
+};
+
+#endif // DISCRETESTATESOLVER_H
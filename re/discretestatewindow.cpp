@@ -3,6 +3,12 @@
 #include "mainwindow.h"
 #include "helpwindow.h"
 
+#include <algorithm>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QtConcurrent/QtConcurrentMap>
+
 DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DiscreteStateWindow)
@@ -16,6 +22,8 @@ DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidge
     timer = new QTimer();
     timer->setInterval(100);
 
+    ui->treeMatches->setHeaderLabels(QStringList() << tr("ID") << tr("Start Bit") << tr("Length") << tr("Values"));
+
     isRealtime = ui->rbRealtime->isChecked();
     typeChanged();
 
@@ -65,12 +73,6 @@ DiscreteStateWindow::~DiscreteStateWindow()
     removeEventFilter(this);
     timer->stop();
 
-    for (int i = 0; i < stateFrames.count(); i++)
-    {
-        stateFrames[i]->clear();
-        delete(stateFrames[i]);
-    }
-
     delete timer;
     delete ui;
 }
@@ -112,8 +114,8 @@ void DiscreteStateWindow::typeChanged()
         ui->spinFreq->setEnabled(true);
         ui->spinIterations->setEnabled(true);
         ui->lblStatus->setEnabled(true);
-        ui->spinMaxBits->setEnabled(false);
-        ui->spinMinBits->setEnabled(false);
+        ui->spinMaxBits->setEnabled(true);
+        ui->spinMinBits->setEnabled(true);
         ui->listID->setEnabled(false);
         ui->btnAll->setEnabled(false);
         ui->btnNone->setEnabled(false);
@@ -128,6 +130,7 @@ void DiscreteStateWindow::updatedFrames(int numFrames)
     {
         ui->listID->clear();
         idFilters.clear();
+        tracker.clear();
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
@@ -148,8 +151,8 @@ void DiscreteStateWindow::updatedFrames(int numFrames)
                 listItem->setCheckState(Qt::Checked); //default all filters to be set active
             }
 
-            //if (operatingState == DWStates::IDLE) stateFrames[0]->append(thisFrame);
-            //else stateFrames[currToggleState + 1]->append(thisFrame);
+            //realtime mode only keeps frames that arrived while the user was holding a state
+            if (isRealtime && operatingState == DWStates::GETTING_SIGNAL) tracker.addFrame(thisFrame, currToggleState);
         }
     }
 }
@@ -265,16 +268,8 @@ void DiscreteStateWindow::handleStartButton()
         currToggleState = 0;
         currIteration = 0;
 
-        for (int i = stateFrames.count() - 1; i > 0; i--)
-        {
-            stateFrames[i]->clear();
-            stateFrames.removeAt(i);
-        }
-
-        for (int j = 0; j <= numToggleStates; j++)
-        {
-            stateFrames.append(new QVector<CANFrame>());
-        }
+        tracker.start(numToggleStates, ui->spinMinBits->value(), ui->spinMaxBits->value());
+        ui->treeMatches->clear();
 
         timer->start();
     }
@@ -322,7 +317,7 @@ void DiscreteStateWindow::handleTick()
             ticksUntilStateChange = ticksPerStateChange;
             operatingState = DWStates::COUNTDOWN_WAITING;
             currToggleState++;
-            if (currToggleState > numToggleStates) currToggleState = 0;
+            if (currToggleState >= numToggleStates) currToggleState = 0;
         }
         break;
     }
@@ -331,41 +326,91 @@ void DiscreteStateWindow::handleTick()
 
 void DiscreteStateWindow::calculateResults()
 {
-    int minBits, maxBits;
     if (isRealtime)
     {
-
+        //the tracker has been updated as the frames came in so there is nothing left to scan
+        showMatches(tracker.getMatches());
     }
     else //use already loaded frames from main cache
     {
-        //basic overview: run through all ID filters and see if it is enabled.
-        //If so add it to a giant list of messages by ID where each ID has its own
-        //list of messages
-        //Then, for each ID start a loop that runs from largest bits to smallest bits for scan
-        //For each value run through the algorithm for all messages. At the end list any matches
-        //the simplest approach seems to be to grab that number of bits and then record every
-        //unique value. IF the # of unique values is the same as the number of states then
-        //we've got a match.It should be noted that the # of states must be at least 2 - the idle
+        //basic overview: bucket the frames of every enabled ID in one pass over the capture.
+        //Then each ID is handed to a worker thread that records every unique value of every
+        //bit range from largest to smallest. If the # of unique values is the same as the number
+        //of states then we've got a match. It should be noted that the # of states must be at least 2 - the idle
         //state is 1 and then a second state at the minimum. Turn signals might be 3 states then
 
-        minBits = ui->spinMinBits->value();
-        maxBits = ui->spinMaxBits->value();
+        int minBits = ui->spinMinBits->value();
+        int maxBits = ui->spinMaxBits->value();
+        int numStates = ui->spinStates->value();
+        QSet<uint32_t> ids;
         QHash<int, bool>::const_iterator it;
-        QList<CANFrame> frameCache;
         for (it = idFilters.begin(); it != idFilters.end(); ++it)
         {
-            if (it.value())
-            {
-                frameCache.clear();
-                for (int i = 0; i < modelFrames->count(); i++)
-                {
-                    if (modelFrames->at(i).frameId() == (unsigned int)it.key()) frameCache.append(modelFrames->at(i));
-                }
-                for (int bits = maxBits; bits >= minBits; bits--)
-                {
-                    QList<int> values;
-                }
-            }
+            if (it.value()) ids.insert((uint32_t)it.key());
+        }
+
+        QHash<uint32_t, QVector<CANFrame>> buckets = DiscreteStateSolver::bucketFrames(*modelFrames, ids);
+        QVector<DiscreteSolveJob> jobs;
+        jobs.reserve(buckets.count());
+        QHash<uint32_t, QVector<CANFrame>>::iterator bucket;
+        for (bucket = buckets.begin(); bucket != buckets.end(); ++bucket)
+        {
+            DiscreteSolveJob job;
+            job.id = bucket.key();
+            job.frames.swap(bucket.value());
+            jobs.append(job);
+        }
+        buckets.clear();
+        std::sort(jobs.begin(), jobs.end(), [](const DiscreteSolveJob &a, const DiscreteSolveJob &b) { return a.id < b.id; });
+
+        QProgressDialog progress(qApp->activeWindow());
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setLabelText("Calculating");
+        progress.setRange(0, jobs.count());
+        progress.setMinimumDuration(0);
+
+        QEventLoop loop;
+        QFutureWatcher<void> watcher;
+        connect(&watcher, &QFutureWatcher<void>::progressValueChanged, &progress, &QProgressDialog::setValue);
+        connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+        connect(&progress, &QProgressDialog::canceled, &watcher, &QFutureWatcher<void>::cancel);
+
+        watcher.setFuture(QtConcurrent::map(jobs, [numStates, minBits, maxBits](DiscreteSolveJob &job)
+        {
+            job.matches = DiscreteStateSolver::solveID(job.id, job.frames, numStates, minBits, maxBits);
+            job.frames.clear();
+        }));
+        if (!watcher.isFinished()) loop.exec();
+        watcher.waitForFinished();
+        progress.reset();
+
+        QVector<DiscreteStateMatch> matches;
+        foreach (const DiscreteSolveJob &job, jobs) matches += job.matches;
+        showMatches(matches);
+    }
+}
+
+void DiscreteStateWindow::showMatches(const QVector<DiscreteStateMatch> &matches)
+{
+    QTreeWidgetItem *idItem = nullptr;
+
+    ui->treeMatches->clear();
+    foreach (const DiscreteStateMatch &match, matches)
+    {
+        if (!idItem || idItem->data(0, Qt::UserRole).toUInt() != match.id)
+        {
+            idItem = new QTreeWidgetItem(ui->treeMatches);
+            idItem->setText(0, Utility::formatCANID(match.id));
+            idItem->setData(0, Qt::UserRole, match.id);
         }
+
+        QStringList values;
+        foreach (int value, match.values) values.append(Utility::formatNumber(value));
+
+        QTreeWidgetItem *item = new QTreeWidgetItem(idItem);
+        item->setText(1, QString::number(match.startBit));
+        item->setText(2, QString::number(match.bitLength));
+        item->setText(3, values.join(", "));
     }
+    ui->treeMatches->expandAll();
 }
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTimer>
 #include "can_structs.h"
+#include "discretestatesolver.h"
 
 namespace Ui {
 class DiscreteStateWindow;
@@ -21,6 +22,13 @@ enum DiscreteWindowState
 }
 
 using namespace DWStates;
+struct DiscreteSolveJob
+{
+    uint32_t id;
+    QVector<CANFrame> frames;
+    QVector<DiscreteStateMatch> matches;
+};
+
 class DiscreteStateWindow : public QDialog
 {
     Q_OBJECT
@@ -39,7 +47,7 @@ private slots:
 private:
     Ui::DiscreteStateWindow *ui;
     const QVector<CANFrame> *modelFrames;
-    QList< QVector<CANFrame> *> stateFrames;
+    DiscreteStateTracker tracker;
     QTimer *timer;
     DiscreteWindowState operatingState;
     int ticksUntilStateChange;
@@ -58,6 +66,7 @@ private:
     void writeSettings();
     void updateStateLabel();
     void calculateResults();
+    void showMatches(const QVector<DiscreteStateMatch> &matches);
 };
 
 #endif // DISCRETESTATEWINDOW_H
@@ -0,0 +1,222 @@
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cstring>
+
+#include "filecomparator.h"
+#include "framefileio.h"
+#include "dbc/dbchandler.h"
+
+FileComparator::FileComparator(DBCHandler *dbc) :
+    dbcHandler(dbc)
+{
+    //two blocks per core keeps the workers fed while the loader reads the next one
+    maxInFlight = qMax(2, QThread::idealThreadCount() * 2);
+    inFlight.release(maxInFlight);
+    frameCount.storeRelaxed(0);
+}
+
+FileComparator::~FileComparator()
+{
+    qDeleteAll(tables);
+    qDeleteAll(layouts);
+}
+
+bool FileComparator::streamFrameFile(QString &fileName)
+{
+    bool result = FrameFileIO::streamFrameFile(fileName, [this](QVector<CANFrame>& block)
+    {
+        //wait for a slot so no more than maxInFlight blocks are ever held in memory
+        inFlight.acquire();
+        QtConcurrent::run([this, block]()
+        {
+            addFrames(block);
+            inFlight.release();
+        });
+    }, FILECOMPARE_CHUNK_FRAMES);
+
+    inFlight.acquire(maxInFlight);
+    inFlight.release(maxInFlight);
+    return result;
+}
+
+quint64 FileComparator::getFrameCount() const
+{
+    return frameCount.loadRelaxed();
+}
+
+//called by the workers the first time they see an ID. Every worker gets the same layout
+const FileComparator::MessageLayout *FileComparator::getLayout(uint32_t id)
+{
+    QMutexLocker locker(&layoutMutex);
+
+    MessageLayout *layout = layouts.value(id, nullptr);
+    if (layout) return layout;
+
+    layout = new MessageLayout;
+    layout->msg = dbcHandler ? dbcHandler->findMessage(id) : nullptr;
+    layout->sigs = SignalValueKey::layoutMessage(layout->msg);
+    layouts.insert(id, layout);
+    return layout;
+}
+
+void FileComparator::addFrames(const QVector<CANFrame>& frames)
+{
+    Table *table;
+    {
+        QMutexLocker locker(&poolMutex);
+        if (freeTables.isEmpty())
+        {
+            tables.append(new Table);
+            freeTables.append(tables.count() - 1);
+        }
+        table = tables[freeTables.takeLast()];
+    }
+
+    foreach (const CANFrame &frame, frames)
+    {
+        const uint32_t id = frame.frameId();
+        int rowIdx = table->index.value(id, -1);
+        if (rowIdx < 0)
+        {
+            Row row;
+            memset(&row.data.bitmap, 0, sizeof(row.data.bitmap));
+            memset(&row.data.values, 0, sizeof(row.data.values));
+            row.data.ID = id;
+            row.data.dataLen = 0;
+            row.data.numFrames = 0;
+            row.layout = getLayout(id);
+            row.samples.resize(row.layout->sigs.count());
+            rowIdx = table->rows.count();
+            table->rows.append(row);
+            table->index.insert(id, rowIdx);
+        }
+        Row &row = table->rows[rowIdx];
+
+        const QByteArray payload = frame.payload();
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+        const int dataLen = qMin(payload.length(), FILECOMPARE_MAX_BYTES);
+
+        row.data.numFrames++;
+        if (dataLen > row.data.dataLen) row.data.dataLen = dataLen;
+        for (int y = 0; y < dataLen; y++)
+        {
+            row.data.values[y][data[y] >> 6] |= 1ULL << (data[y] & 63);
+            row.data.bitmap[y / 8] |= (quint64)data[y] << (8 * (y % 8));
+        }
+
+        for (int i = 0; i < row.layout->sigs.count(); i++)
+        {
+            const SignalKeyLayout &sig = row.layout->sigs[i];
+            if (sig.keyBits < 0) continue;
+            addSample(row.samples[i], SignalValueKey::key(sig, payload), payload);
+        }
+    }
+
+    frameCount.fetchAndAddRelaxed(frames.count());
+
+    QMutexLocker locker(&poolMutex);
+    freeTables.append(tables.indexOf(table));
+}
+
+void FileComparator::merge(FrameData& into, const FrameData& from)
+{
+    into.numFrames += from.numFrames;
+    into.dataLen = qMax(into.dataLen, from.dataLen);
+    for (int w = 0; w < FILECOMPARE_MAX_BYTES / 8; w++) into.bitmap[w] |= from.bitmap[w];
+    for (int y = 0; y < FILECOMPARE_MAX_BYTES; y++)
+        for (int w = 0; w < 4; w++) into.values[y][w] |= from.values[y][w];
+
+    const QString moreValues(FILECOMPARE_MORE_VALUES);
+    QHash<QString, QList<QString>>::const_iterator it;
+    for (it = from.signalInstances.constBegin(); it != from.signalInstances.constEnd(); ++it)
+    {
+        QList<QString> &vals = into.signalInstances[it.key()];
+        bool more = vals.removeOne(moreValues);
+        foreach (const QString &str, it.value())
+        {
+            if (str == moreValues) more = true;
+            else if (vals.contains(str)) continue;
+            else if (vals.count() >= FILECOMPARE_MAX_SAMPLES) more = true;
+            else vals.append(str);
+        }
+        if (more) vals.append(moreValues);
+    }
+}
+
+void FileComparator::merge(QMap<uint32_t, FrameData>& into, const QMap<uint32_t, FrameData>& from)
+{
+    QMap<uint32_t, FrameData>::const_iterator it;
+    for (it = from.constBegin(); it != from.constEnd(); ++it)
+    {
+        if (into.contains(it.key())) merge(into[it.key()], it.value());
+        else into.insert(it.key(), it.value());
+    }
+}
+
+void FileComparator::mergeRow(Row& into, const Row& from)
+{
+    merge(into.data, from.data);
+    for (int i = 0; i < into.samples.count(); i++)
+    {
+        into.samples[i].more |= from.samples[i].more;
+        QHash<QByteArray, QByteArray>::const_iterator it;
+        for (it = from.samples[i].payloads.constBegin(); it != from.samples[i].payloads.constEnd(); ++it)
+            addSample(into.samples[i], it.key(), it.value());
+    }
+}
+
+void FileComparator::addSample(SignalSamples& samples, const QByteArray& key, const QByteArray& payload)
+{
+    if (samples.payloads.contains(key)) return;
+    if (samples.payloads.count() >= FILECOMPARE_MAX_SAMPLES)
+    {
+        samples.more = true;
+        return;
+    }
+    samples.payloads.insert(key, payload);
+}
+
+QMap<uint32_t, FrameData> FileComparator::takeResults()
+{
+    QHash<uint32_t, Row> rows;
+    foreach (Table *table, tables)
+    {
+        foreach (const Row &row, table->rows)
+        {
+            if (rows.contains(row.data.ID)) mergeRow(rows[row.data.ID], row);
+            else rows.insert(row.data.ID, row);
+        }
+        delete table;
+    }
+    tables.clear();
+    freeTables.clear();
+
+    //the decoding the workers skipped. Once per distinct value instead of once per frame
+    QMap<uint32_t, FrameData> results;
+    QHash<uint32_t, Row>::iterator it;
+    for (it = rows.begin(); it != rows.end(); ++it)
+    {
+        Row &row = it.value();
+        DBC_MESSAGE *msg = row.layout->msg;
+        for (int i = 0; msg && i < row.samples.count(); i++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+            if (!sig) continue;
+            CANFrame frame;
+            frame.setFrameId(row.data.ID);
+            foreach (const QByteArray &payload, row.samples[i].payloads)
+            {
+                QString sigVal;
+                frame.setPayload(payload);
+                if (sig->isSignalInMessage(frame) && sig->processAsText(frame, sigVal, false))
+                {
+                    QList<QString> &vals = row.data.signalInstances[sig->name];
+                    if (!vals.contains(sigVal)) vals.append(sigVal);
+                }
+            }
+            if (row.samples[i].more) row.data.signalInstances[sig->name].append(FILECOMPARE_MORE_VALUES);
+        }
+        results.insert(it.key(), row.data);
+    }
+    return results;
+}
@@ -0,0 +1,116 @@
+#ifndef FILECOMPARATOR_H
+#define FILECOMPARATOR_H
+
+#include <QMap>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <QSemaphore>
+#include <QVector>
+#include "can_structs.h"
+#include "signalvaluekey.h"
+
+class DBCHandler;
+
+/* frames handed from the loader to the workers in one go */
+#define FILECOMPARE_CHUNK_FRAMES    20000
+/* CAN-FD payloads are covered in full */
+#define FILECOMPARE_MAX_BYTES       64
+/* distinct values listed per signal. A signal that took more gets FILECOMPARE_MORE_VALUES after them */
+#define FILECOMPARE_MAX_SAMPLES     256
+#define FILECOMPARE_MORE_VALUES     "more..."
+
+struct FrameData
+{
+    uint32_t ID;
+    int dataLen;                                //longest payload seen
+    quint64 numFrames;
+    quint64 bitmap[FILECOMPARE_MAX_BYTES / 8];  //every bit that was set at least once
+    quint64 values[FILECOMPARE_MAX_BYTES][4];   //per byte, 256 bit set of the values it took
+    QHash<QString, QList<QString>> signalInstances;
+
+    bool bitSet(int bit) const { return bitmap[bit / 64] & (1ULL << (bit % 64)); }
+    bool sawValue(int byte, int value) const { return values[byte][value >> 6] & (1ULL << (value & 63)); }
+};
+
+/*
+  Collects what the file comparator window reports on from a capture without keeping the capture.
+  The file is streamed through FrameFileIO in blocks. Each block is run on the thread pool into one
+  of a few flat tables (one per block in flight) and the tables are merged once the file is done,
+  so memory depends on the number of IDs and not on the size of the file.
+
+  DBC messages are looked up once per ID. Decoding signals to text isn't thread safe and is slow,
+  so the workers only remember one sample payload per distinct raw value of each signal (including the
+  multiplexor values it depends on), up to FILECOMPARE_MAX_SAMPLES of them. A counter or a float signal
+  would otherwise keep one per frame. The samples are decoded in the GUI thread when the results are taken.
+*/
+class FileComparator
+{
+public:
+    FileComparator(DBCHandler *dbc);
+    ~FileComparator();
+
+    /**
+     * @brief asks the user for a file and streams it in. Blocks until every block has been processed
+     * @param fileName - set to the name of the file that was picked
+     */
+    bool streamFrameFile(QString &fileName);
+
+    /**
+     * @brief accumulate a block of frames. Thread safe
+     */
+    void addFrames(const QVector<CANFrame>& frames);
+
+    /**
+     * @brief merge the tables and decode the signal samples. Call from the GUI thread once all frames are in
+     */
+    QMap<uint32_t, FrameData> takeResults();
+
+    quint64 getFrameCount() const;
+
+    /* adds everything seen in from to into. Used when more than one reference file is loaded */
+    static void merge(FrameData& into, const FrameData& from);
+    static void merge(QMap<uint32_t, FrameData>& into, const QMap<uint32_t, FrameData>& from);
+
+private:
+    struct MessageLayout
+    {
+        DBC_MESSAGE *msg;
+        QVector<SignalKeyLayout> sigs;
+    };
+
+    struct SignalSamples
+    {
+        QHash<QByteArray, QByteArray> payloads;     //raw value -> one payload that had it
+        bool more = false;                          //there were more distinct values than were kept
+    };
+
+    struct Row
+    {
+        FrameData data;
+        const MessageLayout *layout;
+        QVector<SignalSamples> samples;             //per signal
+    };
+
+    struct Table
+    {
+        QHash<uint32_t, int> index;
+        QVector<Row> rows;
+    };
+
+    const MessageLayout *getLayout(uint32_t id);
+    static void mergeRow(Row& into, const Row& from);
+    static void addSample(SignalSamples& samples, const QByteArray& key, const QByteArray& payload);
+
+    DBCHandler *dbcHandler;
+    int maxInFlight;
+    QSemaphore inFlight;
+    QMutex poolMutex;
+    QVector<Table *> tables;
+    QVector<int> freeTables;
+    QMutex layoutMutex;
+    QHash<uint32_t, MessageLayout *> layouts;
+    QAtomicInteger<quint64> frameCount;
+};
+
+#endif // FILECOMPARATOR_H
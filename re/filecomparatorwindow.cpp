@@ -19,6 +19,7 @@ FileComparatorWindow::FileComparatorWindow(QWidget *parent) :
 
     ui->lblFirstFile->setText("");
     ui->lblRefFrames->setText("Loaded frames: 0");
+    referenceFrameCount = 0;
 
     dbcHandler = DBCHandler::getReference();
 
@@ -83,50 +84,50 @@ void FileComparatorWindow::writeSettings()
 
 void FileComparatorWindow::loadInterestedFile()
 {
-    interestedFrames.clear();
     QString resultingFileName;
+    FileComparator comparator(dbcHandler);
 
     qApp->processEvents();
 
-    if (FrameFileIO::loadFrameFile(resultingFileName, &interestedFrames))
+    if (comparator.streamFrameFile(resultingFileName))
     {
+        interestedIDs = comparator.takeResults();
         ui->lblFirstFile->setText(resultingFileName);
         interestedFilename = resultingFileName;
-        if (interestedFrames.count() > 0 && referenceFrames.count() > 0) calculateDetails();
+        if (interestedIDs.count() > 0 && referenceIDs.count() > 0) calculateDetails();
     }
 
 }
 
 void FileComparatorWindow::loadReferenceFile()
 {
-    //secondFileFrames.clear();
+    //more than one reference file can be loaded. They all add up
     QString resultingFileName;
+    FileComparator comparator(dbcHandler);
 
     qApp->processEvents();
 
-    if (FrameFileIO::loadFrameFile(resultingFileName, &referenceFrames))
+    if (comparator.streamFrameFile(resultingFileName))
     {
-        ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceFrames.length()));
-        if (interestedFrames.count() > 0 && referenceFrames.count() > 0) calculateDetails();
+        FileComparator::merge(referenceIDs, comparator.takeResults());
+        referenceFrameCount += comparator.getFrameCount();
+        ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceFrameCount));
+        if (interestedIDs.count() > 0 && referenceIDs.count() > 0) calculateDetails();
     }
 }
 
 void FileComparatorWindow::clearReference()
 {
-    referenceFrames.clear();
+    referenceIDs.clear();
+    referenceFrameCount = 0;
     ui->treeDetails->clear();
-    ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceFrames.length()));
+    ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceFrameCount));
 }
 
 void FileComparatorWindow::calculateDetails()
 {
-    QMap<uint32_t, FrameData> interestedIDs;
-    QMap<uint32_t, FrameData> referenceIDs;
     QTreeWidgetItem *interestedOnlyBase, *referenceOnlyBase = nullptr, *sharedBase, *bitmapBaseInterested, *bitmapBaseReference = nullptr;
     QTreeWidgetItem *valuesBase, *detail, *sharedItem, *valuesInterested, *valuesReference = nullptr;
-    uint64_t tmp;
-    const unsigned char *data;
-    int dataLen;
 
     bool uniqueInterested = ui->ckUniqueToInterested->isChecked();
 
@@ -152,187 +153,7 @@ void FileComparatorWindow::calculateDetails()
     sharedBase = new QTreeWidgetItem();
     sharedBase->setText(0,"IDs found on both sides");
 
-    //first we have to fill out the data structures to get ready to do the report
-    for (int x = 0; x < interestedFrames.count(); x++)
-    {
-        CANFrame frame = interestedFrames.at(x);
-        DBC_MESSAGE *msg = dbcHandler->findMessage(frame.frameId());
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        dataLen = frame.payload().count();
-
-        if (interestedIDs.contains(frame.frameId())) //if we saw this ID before then add to the QList in there
-        {
-            for (int y = 0; y < dataLen; y++)
-            {
-                interestedIDs[frame.frameId()].values[y][data[y]]++;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                interestedIDs[frame.frameId()].bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(interestedIDs[frame.frameId()].bitmap, 16);
-            }            
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList = interestedIDs[frame.frameId()].signalInstances[sig->name];
-                                if (!tempList.contains(sigVal)) tempList.append(sigVal);
-                                interestedIDs[frame.frameId()].signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-                qApp->processEvents();
-            }
-        }
-        else //never seen this ID before so add one
-        {
-            FrameData *newData = new FrameData();
-            newData->ID = frame.frameId();
-            newData->dataLen = dataLen;
-            //it would be possible to implement a constructor for FrameData
-            //that sets the bitmap and values to zero. That would be cleaner and better.
-            newData->bitmap = 0;
-            for (int x = 0; x < 8; x++)
-            {
-                for (int y = 0; y < 256; y++)
-                {
-                    newData->values[x][y] = 0;
-                }
-            }
-            //memset(newData->values, 0, 256 * 8);
-            for (int y = 0; y < dataLen; y++)
-            {
-                newData->values[y][data[y]] = 1;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                newData->bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(newData->bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList;
-                                tempList.append(sigVal);
-                                newData->signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
-
-            interestedIDs.insert(frame.frameId(), *newData);
-        }
-    }
-
-    qApp->processEvents();
-
-    for (int x = 0; x < referenceFrames.count(); x++)
-    {
-        CANFrame frame = referenceFrames.at(x);
-        DBC_MESSAGE *msg = dbcHandler->findMessage(frame.frameId());
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        dataLen = frame.payload().count();
-
-        if (referenceIDs.contains(frame.frameId())) //if we saw this ID before then add to the QList in there
-        {
-            for (int y = 0; y < dataLen; y++)
-            {
-                referenceIDs[frame.frameId()].values[y][data[y]]++;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                referenceIDs[frame.frameId()].bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(referenceIDs[frame.frameId()].bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList = referenceIDs[frame.frameId()].signalInstances[sig->name];
-                                if (!tempList.contains(sigVal)) tempList.append(sigVal);
-                                referenceIDs[frame.frameId()].signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        else //never seen this ID before so add one
-        {
-            FrameData *newData = new FrameData();
-            newData->ID = frame.frameId();
-            newData->dataLen = dataLen;
-            newData->bitmap = 0;
-            for (int x = 0; x < 8; x++)
-            {
-                for (int y = 0; y < 256; y++)
-                {
-                    newData->values[x][y] = 0;
-                }
-            }
-            //memset(newData->values, 0, 256 * 8);
-            for (int y = 0; y < dataLen; y++)
-            {
-                newData->values[y][data[y]] = 1;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                newData->bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(newData->bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList;
-                                tempList.append(sigVal);
-                                newData->signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
-            referenceIDs.insert(frame.frameId(), *newData);
-        }
-    }
-
-    qApp->processEvents();
-
+    //the per ID data was already gathered while the files streamed in. Only the report is left
     //now we iterate through the IDs within both files and see which are unique to one file and which
     //are shared
     bool interestedHadUnique = false;
@@ -372,8 +193,8 @@ void FileComparatorWindow::calculateDetails()
             //if the ID was in both files then we can use the data accumulated above in bitmap
             //and values to figure out what has changed between the two files
 
-            FrameData interested = interestedIDs[keyone];
-            FrameData reference = referenceIDs[keyone];
+            const FrameData &interested = i.value();
+            const FrameData &reference = referenceIDs[keyone];
 
             bitmapBaseInterested = new QTreeWidgetItem();
             bitmapBaseInterested->setText(0, "Bits set only in " + interestedFilename);
@@ -385,26 +206,20 @@ void FileComparatorWindow::calculateDetails()
             sharedItem->addChild(bitmapBaseInterested);
             if (!uniqueInterested) sharedItem->addChild(bitmapBaseReference);
 
-            uint64_t interestedBits = interested.bitmap;
-            uint64_t referenceBits = reference.bitmap;
-
             //first up, which bits were set in one file but not the other
             for (int b = 0; b < (8 * interested.dataLen); b++)
             {
                 detail = new QTreeWidgetItem();
                 detail->setText(0, QString::number(b) + " (" + QString::number(b / 8) + ":" + QString::number(b % 8) + ")");
-                if ( (interestedBits & 1) && !(referenceBits & 1) )
+                if ( interested.bitSet(b) && !reference.bitSet(b) )
                 {
                     bitmapBaseInterested->addChild(detail);
                     interestedHadUnique = true;
                 }
-                else if ( !(interestedBits & 1) && (referenceBits & 1) )
+                else if ( !interested.bitSet(b) && reference.bitSet(b) )
                 {
                     if (!uniqueInterested) bitmapBaseReference->addChild(detail);
                 }
-                //qDebug() << b << "  " << QString::number(interestedBits, 16) << "  " << QString::number(referenceBits, 16);
-                interestedBits = interestedBits >> 1;
-                referenceBits = referenceBits >> 1;
             }
 
             for (int i = 0; i < qMax(interested.dataLen, reference.dataLen); i++)
@@ -425,12 +240,12 @@ void FileComparatorWindow::calculateDetails()
                 {
                     detail = new QTreeWidgetItem();
                     detail->setText(0, Utility::formatHexNum(static_cast<unsigned int>(j)));
-                    if ((interested.values[i][j] > 0) && (reference.values[i][j] == 0) )
+                    if (interested.sawValue(i, j) && !reference.sawValue(i, j))
                     {
                         valuesInterested->addChild(detail);
                         interestedHadUnique = true;
                     }
-                    if ((reference.values[i][j] > 0) && (interested.values[i][j] == 0) )
+                    if (reference.sawValue(i, j) && !interested.sawValue(i, j))
                     {
                         if (!uniqueInterested) valuesReference->addChild(detail);
                     }
@@ -458,7 +273,7 @@ void FileComparatorWindow::calculateDetails()
                 if (!uniqueInterested) valuesBase->addChild(valuesReference);
 
                 QList<QString> refVals = it.value();
-                QList<QString> interestedVals = interested.signalInstances[it.key()];
+                QList<QString> interestedVals = interested.signalInstances.value(it.key());
                 foreach (QString str, refVals)
                 {
                     if (!interestedVals.contains(str))
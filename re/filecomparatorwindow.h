@@ -8,20 +8,12 @@
 #include "can_structs.h"
 #include "utility.h"
 #include "dbc/dbchandler.h"
+#include "filecomparator.h"
 
 namespace Ui {
 class FileComparatorWindow;
 }
 
-struct FrameData
-{
-    uint32_t ID;
-    int dataLen;
-    uint64_t bitmap;
-    int values[8][256]; //first index is the data byte, second is # of times we saw that value
-    QHash<QString, QList<QString>> signalInstances;
-};
-
 class FileComparatorWindow : public QDialog
 {
     Q_OBJECT
@@ -38,8 +30,9 @@ private slots:
 
 private:
     Ui::FileComparatorWindow *ui;
-    QVector<CANFrame> interestedFrames;
-    QVector<CANFrame> referenceFrames;
+    QMap<uint32_t, FrameData> interestedIDs;
+    QMap<uint32_t, FrameData> referenceIDs;
+    quint64 referenceFrameCount;
     QString interestedFilename;
     DBCHandler *dbcHandler;
 
@@ -489,7 +489,7 @@ void FlowViewWindow::updatedFrames(int numFrames)
 
             if (!foundID.contains(thisFrame->frameId()))
             {
-                foundID.append(thisFrame->frameId());
+                foundID.insert(thisFrame->frameId());
                 FilterUtility::createFilterItem(thisFrame->frameId(), ui->listFrameID);
             }
 
@@ -607,14 +607,11 @@ void FlowViewWindow::createGraph(int byteNum)
 
 void FlowViewWindow::refreshIDList()
 {
-    int id;
-    for (int i = 0; i < modelFrames->count(); i++)
+    foreach (uint32_t id, MainWindow::getReference()->getCANFrameModel()->getUniqueIDs(modelFrames))
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = thisFrame.frameId();
         if (!foundID.contains(id))
         {
-            foundID.append(id);
+            foundID.insert(id);
             FilterUtility::createFilterItem(id, ui->listFrameID);
         }
     }
@@ -639,15 +636,13 @@ void FlowViewWindow::changeID(QString newID)
     playbackTimer->stop();
     playbackActive = false;
     int maxBytes = 0;
-    for (int x = 0; x < modelFrames->count(); x++)
+    const QVector<int> rows = MainWindow::getReference()->getCANFrameModel()->getRowsForID(id, modelFrames);
+    frameCache.reserve(rows.count());
+    foreach (int row, rows)
     {
-        CANFrame thisFrame = modelFrames->at(x);
-        if (thisFrame.frameId() == id)
-        {
-            thisFrame.payload().clear();
-            frameCache.append(thisFrame);
-            if (thisFrame.payload().length() > maxBytes) maxBytes = thisFrame.payload().length();
-        }
+        const CANFrame &thisFrame = modelFrames->at(row);
+        frameCache.append(thisFrame);
+        if (thisFrame.payload().length() > maxBytes) maxBytes = thisFrame.payload().length();
     }
     ui->flowView->setBytesToDraw(maxBytes);
     currentPosition = 0;
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QLocale>
 #include <QSlider>
+#include <QSet>
 #include "qcustomplot.h"
 #include "can_structs.h"
 
@@ -48,7 +49,7 @@ signals:
 
 private:
     Ui::FlowViewWindow *ui;
-    QList<quint32> foundID;
+    QSet<quint32> foundID;
     QList<CANFrame> frameCache;
     const QVector<CANFrame> *modelFrames;
     unsigned char refBytes[64];
@@ -3,6 +3,10 @@
 #include "mainwindow.h"
 #include "helpwindow.h"
 #include <QtDebug>
+#include <QProgressDialog>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentMap>
 #include <vector>
 #include "filterutility.h"
 #include "qcpaxistickerhex.h"
@@ -12,6 +16,8 @@ const QColor FrameInfoWindow::byteGraphColors[8] = {Qt::blue, Qt::green,  Qt::bl
 QPen FrameInfoWindow::bytePens[8];
 
 const int numIntervalHistBars = 20;
+//rows of one ID worked on in one go. Busy IDs are split so they don't end up on a single core
+const int statsChunkRows = 50000;
 
 FrameInfoWindow::FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
@@ -23,6 +29,9 @@ FrameInfoWindow::FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *paren
     readSettings();
 
     modelFrames = frames;
+    statsValid = false;
+    rebuilding = false;
+    rebuildStale = false;
 
     // Using lambda expression to strip away the possible filter label before passing the ID to updateDetailsWindow
     connect(ui->listFrameID, &QListWidget::currentTextChanged, 
@@ -233,6 +242,7 @@ void FrameInfoWindow::showEvent(QShowEvent* event)
     QDialog::showEvent(event);
     readSettings();
     refreshIDList();
+    if (!statsValid && !rebuilding) rebuildStatistics();
     if (ui->listFrameID->count() > 0)
     {
         updateDetailsWindow(FilterUtility::getId(ui->listFrameID->item(0)));
@@ -312,6 +322,10 @@ void FrameInfoWindow::updatedFrames(int numFrames)
         ui->listFrameID->clear();
         ui->treeDetails->clear();
         foundID.clear();
+        frameStats.clear();
+        signalLayouts.clear();
+        statsValid = true; //nothing left to count
+        if (rebuilding) rebuildStale = true;
         refreshIDList();
     }
     else if (numFrames == -2) //all new set of frames. Reset
@@ -320,7 +334,13 @@ void FrameInfoWindow::updatedFrames(int numFrames)
         ui->listFrameID->clear();
         ui->treeDetails->clear();
         foundID.clear();
+        frameStats.clear();
+        signalLayouts.clear();
+        statsValid = false;
         refreshIDList();
+        //while hidden the statistics are left for showEvent to build. A running rebuild starts over by itself
+        if (rebuilding) rebuildStale = true;
+        else if (isVisible()) rebuildStatistics();
         if (ui->listFrameID->count() > 0)
         {
             updateDetailsWindow(FilterUtility::getId(ui->listFrameID->item(0)));
@@ -338,27 +358,27 @@ void FrameInfoWindow::updatedFrames(int numFrames)
         bool thisID = false;
         for (int x = modelFrames->count() - numFrames; x < modelFrames->count(); x++)
         {
-            CANFrame thisFrame = modelFrames->at(x);
+            const CANFrame &thisFrame = modelFrames->at(x);
             int32_t id = static_cast<int32_t>(thisFrame.frameId());
             if (!foundID.contains(id))
             {
-                foundID.append(id);
+                foundID.insert(id);
                 FilterUtility::createFilterItem(id, ui->listFrameID);
+                if (statsValid) frameStats[thisFrame.frameId()].addFrame(thisFrame, layoutForID(thisFrame.frameId()));
             }
+            //IDs without statistics yet get them in full when they are shown
+            else if (frameStats.contains(thisFrame.frameId()))
+                frameStats[thisFrame.frameId()].addFrame(thisFrame, layoutForID(thisFrame.frameId()));
 
-            if (currID == modelFrames->at(x).frameId())
-            {
-                thisID = true;
-                break;
-            }
+            if (currID == thisFrame.frameId()) thisID = true;
         }
         if (thisID)
         {
             //the problem here is that it'll blast us out of the details as soon as this
             //happens. The only way to do this properly is to actually traverse
             //the details structure and change the text. We don't do that yet.
-            //so, the line is commented out. If people need to see the updated
-            //data they can click another ID and back and it'll be OK
+            //so, the line is commented out. The statistics are kept current as frames
+            //come in so clicking another ID and back shows the new data right away
 
             //updateDetailsWindow(ui->listFrameID->currentItem()->text());
         }
@@ -371,28 +391,13 @@ void FrameInfoWindow::updatedFrames(int numFrames)
 void FrameInfoWindow::updateDetailsWindow(QString newID)
 {
     int targettedID;
-    int minLen, maxLen, thisLen;
-    int64_t avgInterval;
-    int64_t minInterval;
-    int64_t maxInterval;
-    int64_t thisInterval;
-    int minData[8];
-    int maxData[8];
-    int dataHistogram[256][8];
-    int bitfieldHistogram[64];
     QVector<double> histGraphX, histGraphY;
     QVector<double> byteGraphX, byteGraphY[8];
     QVector<double> timeGraphX, timeGraphY;
     QHash<QString, QHash<QString, int>> signalInstances;
     double maxY = -1000.0;
-    uint8_t changedBits[8];
-    uint8_t referenceBits[8];
     uint8_t heatVals[512];
 
-    //these two used by bitflip heatmap functionality
-    uint8_t refByte[8];
-    double bitFlipHeat[64];
-
     QTreeWidgetItem *baseNode, *dataBase, *histBase, *tempItem;
 
     if (modelFrames->count() == 0) return;
@@ -401,31 +406,28 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
     qDebug() << "Started update details window with id " << targettedID;
 
-    avgInterval = 0;
-
     if (targettedID > -1)
     {
+        const uint32_t id = static_cast<uint32_t>(targettedID);
 
-        frameCache.clear();
-        for (int i = 0; i < modelFrames->count(); i++)
+        //IDs left out when the initial pass was canceled are worked out on demand
+        if (!frameStats.contains(id))
         {
-            CANFrame thisFrame = modelFrames->at(i);
-            if (thisFrame.frameId() == static_cast<uint32_t>(targettedID)) frameCache.append(thisFrame);
+            FrameStatistics stats;
+            const QVector<SignalKeyLayout> &sigs = layoutForID(id);
+            foreach (int row, MainWindow::getReference()->getCANFrameModel()->getRowsForID(id, modelFrames))
+                stats.addFrame(modelFrames->at(row), sigs);
+            if (stats.numFrames == 0) return; //nothing to do if there are no frames!
+            frameStats.insert(id, stats);
         }
-
-        if (frameCache.count() == 0) return; //nothing to do if there are no frames!
-
-        const unsigned char *data = reinterpret_cast<const unsigned char *>(frameCache.at(0).payload().constData());
-        int dataLen = frameCache.at(0).payload().length();
+        const FrameStatistics &stats = frameStats[id];
 
         ui->treeDetails->clear();
 
-        if (frameCache.count() == 0) return;
-
         baseNode = new QTreeWidgetItem();
         baseNode->setText(0, QString("ID: ") + newID );
 
-        if (frameCache[0].hasExtendedFrameFormat()) //if these frames seem to be extended then try for J1939 decoding
+        if (stats.extended) //if these frames seem to be extended then try for J1939 decoding
         {
             // ------- J1939 decoding ----------
             J1939ID jid;
@@ -488,179 +490,51 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         }
 
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("# of frames: ") + QString::number(frameCache.count(),10));
+        tempItem->setText(0, tr("# of frames: ") + QString::number(stats.numFrames,10));
         baseNode->addChild(tempItem);
 
-        //clear out all the counters and accumulators
-        minLen = 8;
-        maxLen = 0;
-        minInterval = 0x7FFFFFFF;
-        maxInterval = 0;
-        for (int i = 0; i < 8; i++)
-        {
-            minData[i] = 256;
-            maxData[i] = -1;
-            for (int k = 0; k < 256; k++) dataHistogram[k][i] = 0;
-        }
-        for (int j = 0; j < 64; j++)
-        {
-            bitfieldHistogram[j] = 0;
-            bitFlipHeat[j] = 0;
-        }
-        signalInstances.clear();
-
-        data = reinterpret_cast<const unsigned char *>(frameCache.at(0).payload().constData());
-        dataLen = frameCache.at(0).payload().length();
+        //order statistics need every interval but are one linear pass, the rest was kept up to date per frame
+        int64_t intervalPctl5, intervalPctl95;
+        stats.intervalPercentiles(intervalPctl5, intervalPctl95);
+        stats.intervalHistogram(numIntervalHistBars, timeGraphX, timeGraphY);
+        int64_t avgInterval = stats.intervals.count() ? stats.intervalSum / stats.intervals.count() : 0;
 
-        for (int c = 0; c < dataLen; c++)
+        for (int j = 0; j < stats.byteSeries[0].count(); j++) byteGraphX.append(j);
+        for (int c = 0; c < FRAMESTATS_GRAPH_BYTES; c++)
         {
-            changedBits[c] = 0;
-            referenceBits[c] = data[c];
-            refByte[c] = data[c];
-            //qDebug() << referenceBits[c];
+            byteGraphY[c].reserve(stats.byteSeries[c].count());
+            foreach (quint8 val, stats.byteSeries[c]) byteGraphY[c].append(val);
         }
 
-        std::vector<int64_t> sortedIntervals;
-        int64_t intervalSum = 0;
-
+        //Decode one frame per distinct raw value of every signal in the selected message and give output of
+        //the range the signal took and how many messages contained each discrete value.
         DBC_MESSAGE *msg = dbcHandler->findMessageForFilter(targettedID, nullptr);
-
-        //then find all data points
-        for (int j = 0; j < frameCache.count(); j++)
+        if (msg)
         {
-            data = reinterpret_cast<const unsigned char *>(frameCache.at(j).payload().constData());
-            dataLen = frameCache.at(j).payload().length();
-
-            byteGraphX.append(j);
-            for (int bytcnt = 0; bytcnt < dataLen; bytcnt++)
+            int numSignals = qMin(msg->sigHandler->getCount(), stats.signalValues.count());
+            for (int i = 0; i < numSignals; i++)
             {
-                byteGraphY[bytcnt].append(data[bytcnt]);
-            }
-
-            if (j != 0)
-            {
-                //TODO - we try the interval whichever way doesn't go negative. But, we should probably sort the frame list before
-                //starting so that the intervals are all correct.
-                if (frameCache[j].timeStamp().microSeconds() > frameCache[j-1].timeStamp().microSeconds())
-                    thisInterval = (frameCache[j].timeStamp().microSeconds() - frameCache[j-1].timeStamp().microSeconds());
-                else
-                    thisInterval = (frameCache[j-1].timeStamp().microSeconds() - frameCache[j].timeStamp().microSeconds());
-
-                sortedIntervals.push_back(thisInterval);
-                intervalSum += thisInterval;
-                if (thisInterval > maxInterval) maxInterval = thisInterval;
-                if (thisInterval < minInterval) minInterval = thisInterval;
-                avgInterval += thisInterval;
-            }
-            thisLen = dataLen;
-            if (thisLen > maxLen) maxLen = thisLen;
-            if (thisLen < minLen) minLen = thisLen;
-            for (int c = 0; c < thisLen; c++)
-            {
-                unsigned char dat = data[c];
-                if (minData[c] > dat) minData[c] = dat;
-                if (maxData[c] < dat) maxData[c] = dat;
-                dataHistogram[dat][c]++; //add one to count for this
-                for (int l = 0; l < 8; l++)
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+                if (!sig) continue;
+                foreach (const FrameSignalValue &value, stats.signalValues[i])
                 {
-                    int bit = dat & (1 << l);
-                    if (bit == (1 << l))
+                    QString sigVal;
+                    if (sig->isSignalInMessage(value.sample) && sig->processAsText(value.sample, sigVal, false))
                     {
-                        bitfieldHistogram[c * 8 + l]++;
-                    }
-                }
-                changedBits[c] |= referenceBits[c] ^ dat;
-
-                if (refByte[c] != dat) //if this byte doesn't match the value it last had
-                {
-                    uint8_t newBits = refByte[c] ^ dat; //get changed bits since last ref
-                    for (int l = 0; l < 8; l++)
-                    {
-                        if (newBits & (1 << l)) bitFlipHeat[(c * 8) + l]++;
-                    }
-                    refByte[c] = dat; //set the reference to this current byte now that processing is done
-                }
-            }
-
-            //Search every signal in the selected message and give output of the range the signal took and
-            //how many messages contained each discrete value.
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frameCache.at(j)))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frameCache.at(j), sigVal, false))
-                            {
-                                signalInstances[sig->name][sigVal] = signalInstances[sig->name][sigVal] + 1;
-                            }
-                        }
+                        signalInstances[sig->name][sigVal] += static_cast<int>(value.count);
                     }
                 }
             }
         }
 
-        //Divide all the bit flip heat values by the number of frames to get a ratio
-        for (int j = 0; j < 64; j++) bitFlipHeat[j] /= (double)frameCache.count();
-
-        std::sort(sortedIntervals.begin(), sortedIntervals.end());
-        int64_t intervalStdDiv = 0, intervalPctl5 = 0, intervalPctl95 = 0, intervalMean = 0, intervalVariance = 0;
-
-        int maxTimeCounter = -1;
-        if (sortedIntervals.size() > 0)
-        {
-            intervalMean = intervalSum / sortedIntervals.size();
-
-            for(int l = 0; l < static_cast<int>(sortedIntervals.size()); l++) {
-                intervalVariance += ((sortedIntervals[l] - intervalMean) * (sortedIntervals[l] - intervalMean));
-            }
-
-            intervalVariance /= sortedIntervals.size();
-            intervalStdDiv = static_cast<int>(sqrt(intervalVariance));
-
-            intervalPctl5 = sortedIntervals[static_cast<unsigned int>(floor(0.05 * sortedIntervals.size()))];
-            intervalPctl95 = sortedIntervals[static_cast<unsigned int>(floor(0.95 * sortedIntervals.size()))];
-
-            uint64_t step = static_cast<unsigned int>(ceil((maxInterval - minInterval) / numIntervalHistBars));
-            qDebug() << "Step: " << step << " minInt: " << minInterval << " maxInt: " << maxInterval;
-            unsigned int index = 0;
-            int counter = 0;
-            for(int l = 0; l <= numIntervalHistBars; l++) {
-                int64_t currentMax = maxInterval - ((numIntervalHistBars - l) * step);	// avoid missing the biggest value due to rounding errors
-                qDebug() << "CurrentMax: " << currentMax;
-                while(index < sortedIntervals.size()) {
-                    if(sortedIntervals[index] <= currentMax) {
-                        counter++;
-                        index++;
-                    }
-                    else {
-                        break;
-                    }
-                }
-                timeGraphX.append(currentMax / 1000.0);
-                timeGraphY.append(counter);
-                if(counter > maxTimeCounter) maxTimeCounter = counter;
-                counter = 0;
-            }
-        }
-
-        if (frameCache.count() > 1)
-            avgInterval = avgInterval / (frameCache.count() - 1);
-        else avgInterval = 0;
-
         //now that data processing is done, create all of our output
 
         tempItem = new QTreeWidgetItem();
 
-        if (minLen < maxLen)
-            tempItem->setText(0, tr("Data Length: ") + QString::number(minLen) + tr(" to ") + QString::number(maxLen));
+        if (stats.minLen < stats.maxLen)
+            tempItem->setText(0, tr("Data Length: ") + QString::number(stats.minLen) + tr(" to ") + QString::number(stats.maxLen));
         else
-            tempItem->setText(0, tr("Data Length: ") + QString::number(minLen));
+            tempItem->setText(0, tr("Data Length: ") + QString::number(stats.minLen));
 
         baseNode->addChild(tempItem);
 
@@ -668,24 +542,25 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         tempItem->setText(0, tr("Average inter-frame interval: ") + QString::number(avgInterval / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("Minimum inter-frame interval: ") + QString::number(minInterval / 1000.0) + "ms");
+        tempItem->setText(0, tr("Minimum inter-frame interval: ") + QString::number(stats.minInterval / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("Maximum inter-frame interval: ") + QString::number(maxInterval / 1000.0) + "ms");
+        tempItem->setText(0, tr("Maximum inter-frame interval: ") + QString::number(stats.maxInterval / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("Inter-frame interval variation: ") + QString::number((maxInterval - minInterval) / 1000.0) + "ms");
+        tempItem->setText(0, tr("Inter-frame interval variation: ") + QString::number((stats.maxInterval - stats.minInterval) / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("Interval standard deviation: ") + QString::number(intervalStdDiv / 1000.0) + "ms");
+        tempItem->setText(0, tr("Interval standard deviation: ") + QString::number(static_cast<int64_t>(stats.intervalStdDev()) / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
         tempItem->setText(0, tr("Minimum range to fit 90% of inter-frame intervals: ") + QString::number((intervalPctl95 - intervalPctl5) / 1000.0) + "ms");
         baseNode->addChild(tempItem);
 
         //display accumulated data for all the bytes in the message
-        for (int c = 0; c < maxLen; c++)
+        for (int c = 0; c < stats.maxLen; c++)
         {
+            const FrameByteStats &byte = stats.bytes[c];
             dataBase = new QTreeWidgetItem();
             histBase = new QTreeWidgetItem();
 
@@ -694,22 +569,22 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
             tempItem = new QTreeWidgetItem();
             QString builder;
-            builder = tr("Changed bits: 0x") + QString::number(changedBits[c], 16) + "  (" + Utility::formatByteAsBinary(changedBits[c]) + ")";
+            builder = tr("Changed bits: 0x") + QString::number(byte.changedBits, 16) + "  (" + Utility::formatByteAsBinary(byte.changedBits) + ")";
             tempItem->setText(0, builder);
             dataBase->addChild(tempItem);
 
             tempItem = new QTreeWidgetItem();
-            tempItem->setText(0, tr("Range: ") + Utility::formatNumber((unsigned int)minData[c]) + tr(" to ") + Utility::formatNumber((unsigned int)maxData[c]));
+            tempItem->setText(0, tr("Range: ") + Utility::formatNumber((unsigned int)byte.min) + tr(" to ") + Utility::formatNumber((unsigned int)byte.max));
             dataBase->addChild(tempItem);
             histBase->setText(0, tr("Histogram"));
             dataBase->addChild(histBase);
 
             for (int d = 0; d < 256; d++)
             {
-                if (dataHistogram[d][c] > 0)
+                if (byte.histogram[d] > 0)
                 {
                     tempItem = new QTreeWidgetItem();
-                    tempItem->setText(0, QString::number(d) + "/0x" + QString::number(d, 16) +" (" + Utility::formatByteAsBinary(static_cast<uint8_t>(d)) +") -> " + QString::number(dataHistogram[d][c]));
+                    tempItem->setText(0, QString::number(d) + "/0x" + QString::number(d, 16) +" (" + Utility::formatByteAsBinary(static_cast<uint8_t>(d)) +") -> " + QString::number(byte.histogram[d]));
                     histBase->addChild(tempItem);
                 }
             }
@@ -717,16 +592,17 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
         dataBase = new QTreeWidgetItem();
         dataBase->setText(0, tr("Bitfield Histogram"));
-        for (int c = 0; c < 8 * maxLen; c++)
+        for (int c = 0; c < 8 * stats.maxLen; c++)
         {
+            const quint32 bitCount = stats.bytes[c / 8].bitCount[c % 8];
             tempItem = new QTreeWidgetItem();
             tempItem->setText(0, QString::number(c) + " (Byte " + QString::number(c / 8) + " Bit "
-                            + QString::number(c % 8) + ") : " + QString::number(bitfieldHistogram[c]));
+                            + QString::number(c % 8) + ") : " + QString::number(bitCount));
 
             dataBase->addChild(tempItem);
             histGraphX.append(c);
-            histGraphY.append(bitfieldHistogram[c]);
-            if (bitfieldHistogram[c] > maxY) maxY = bitfieldHistogram[c];
+            histGraphY.append(bitCount);
+            if (bitCount > maxY) maxY = bitCount;
         }
         baseNode->addChild(dataBase);
 
@@ -734,18 +610,21 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         dataBase = new QTreeWidgetItem();
         dataBase->setText(0, tr("Bitchange Heatmap"));
         memset(heatVals, 0, 512); //always clear the array before populating it.
-        for (int c = 0; c < 8 * maxLen; c++)
+        for (int c = 0; c < 8 * stats.maxLen; c++)
         {
+            //Divide the bit flip counts by the number of frames to get a ratio
+            const double bitFlipHeat = stats.bytes[c / 8].bitFlips[c % 8] / (double)stats.numFrames;
+            const quint32 bitCount = stats.bytes[c / 8].bitCount[c % 8];
             tempItem = new QTreeWidgetItem();
             tempItem->setText(0, QString::number(c) + " (Byte " + QString::number(c / 8) + " Bit "
-                            + QString::number(c % 8) + ") : " + QString::number(bitFlipHeat[c] * 100.0, 'f', 2));
+                            + QString::number(c % 8) + ") : " + QString::number(bitFlipHeat * 100.0, 'f', 2));
 
             dataBase->addChild(tempItem);
             histGraphX.append(c);
-            histGraphY.append(bitfieldHistogram[c]);
-            if (bitfieldHistogram[c] > maxY) maxY = bitfieldHistogram[c];
-            uint8_t heat = bitFlipHeat[c] * 255;
-            if ((heat < 1) && (bitFlipHeat[c] > 0.0001)) heat = 1; //make sure any little bit of heat causes at least some output
+            histGraphY.append(bitCount);
+            if (bitCount > maxY) maxY = bitCount;
+            uint8_t heat = bitFlipHeat * 255;
+            if ((heat < 1) && (bitFlipHeat > 0.0001)) heat = 1; //make sure any little bit of heat causes at least some output
             //qDebug() << "Heat for bit " << c <<  " is " << heat;
             heatVals[c] = heat;
         }
@@ -820,17 +699,107 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
     }
 }
 
+//the DBC lookup isn't thread safe so it's done here, before any worker needs the layout
+const QVector<SignalKeyLayout> &FrameInfoWindow::layoutForID(uint32_t id)
+{
+    QHash<uint32_t, QVector<SignalKeyLayout>>::iterator it = signalLayouts.find(id);
+    if (it == signalLayouts.end())
+        it = signalLayouts.insert(id, SignalValueKey::layoutMessage(dbcHandler->findMessageForFilter(id, nullptr)));
+    return it.value();
+}
+
+//work out the statistics for every ID at once. Each ID is split into stretches of rows that are
+//processed in parallel and then appended back together in capture order
+void FrameInfoWindow::rebuildStatistics()
+{
+    frameStats.clear();
+    if (modelFrames->count() == 0)
+    {
+        statsValid = true;
+        return;
+    }
+
+    //the event loop below lets frames come in and the model's vector may reallocate, so the jobs read a copy
+    const QVector<CANFrame> snapshot = *modelFrames;
+    CANFrameModel *model = MainWindow::getReference()->getCANFrameModel();
+    QVector<FrameStatsJob> jobs;
+    foreach (uint32_t id, model->getUniqueIDs(&snapshot))
+    {
+        layoutForID(id);
+        const QVector<int> rows = model->getRowsForID(id, &snapshot);
+        for (int start = 0; start < rows.count(); start += statsChunkRows)
+        {
+            FrameStatsJob job;
+            job.id = id;
+            job.rows = rows.mid(start, statsChunkRows);
+            job.done = false;
+            jobs.append(job);
+        }
+    }
+
+    QProgressDialog progress(qApp->activeWindow());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setLabelText("Calculating frame statistics");
+    progress.setRange(0, jobs.count());
+    progress.setMinimumDuration(0);
+
+    QEventLoop loop;
+    QFutureWatcher<void> watcher;
+    connect(&watcher, &QFutureWatcher<void>::progressValueChanged, &progress, &QProgressDialog::setValue);
+    connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+    connect(&progress, &QProgressDialog::canceled, &watcher, &QFutureWatcher<void>::cancel);
+
+    //statsValid stays false until the jobs are in so updatedFrames leaves the statistics alone meanwhile
+    statsValid = false;
+    rebuilding = true;
+    rebuildStale = false;
+
+    const QVector<CANFrame> *frames = &snapshot;
+    const QHash<uint32_t, QVector<SignalKeyLayout>> layouts = signalLayouts;
+    watcher.setFuture(QtConcurrent::map(jobs, [frames, &layouts](FrameStatsJob &job)
+    {
+        const QVector<SignalKeyLayout> &sigs = layouts.constFind(job.id).value();
+        foreach (int row, job.rows) job.stats.addFrame(frames->at(row), sigs);
+        job.done = true;
+    }));
+    if (!watcher.isFinished()) loop.exec();
+    watcher.waitForFinished();
+    progress.reset();
+    rebuilding = false;
+
+    if (rebuildStale)
+    {
+        rebuildStale = false;
+        if (!statsValid && isVisible()) rebuildStatistics();
+        return;
+    }
+
+    //jobs are in ID then row order. An ID with any stretch left over after a cancel is dropped and done on demand
+    QSet<uint32_t> incomplete;
+    foreach (const FrameStatsJob &job, jobs)
+    {
+        if (job.done) frameStats[job.id].append(job.stats);
+        else incomplete.insert(job.id);
+    }
+    foreach (uint32_t id, incomplete) frameStats.remove(id);
+
+    //frames that arrived while the jobs ran were skipped by updatedFrames
+    for (int x = snapshot.count(); x < modelFrames->count(); x++)
+    {
+        const CANFrame &frame = modelFrames->at(x);
+        if (!incomplete.contains(frame.frameId())) frameStats[frame.frameId()].addFrame(frame, layoutForID(frame.frameId()));
+    }
+    statsValid = true;
+}
+
 void FrameInfoWindow::refreshIDList()
 {
-    int id;
-    for (int i = 0; i < modelFrames->count(); i++)
+    foreach (uint32_t id, MainWindow::getReference()->getCANFrameModel()->getUniqueIDs(modelFrames))
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = (int)thisFrame.frameId();
-        if (!foundID.contains(id))
+        if (!foundID.contains((int)id))
         {
-            foundID.append(id);
-            FilterUtility::createFilterItem(id, ui->listFrameID);
+            foundID.insert((int)id);
+            FilterUtility::createFilterItem((int)id, ui->listFrameID);
         }
     }
     //default is to sort in ascending order
@@ -5,10 +5,12 @@
 #include <QFile>
 #include <QListWidget>
 #include <QTreeWidget>
+#include <QSet>
 #include <candatagrid.h>
 #include "can_structs.h"
 #include "bus_protocols/j1939_handler.h"
 #include "dbc/dbchandler.h"
+#include "framestatistics.h"
 
 #include "qcustomplot.h"
 
@@ -16,6 +18,14 @@ namespace Ui {
 class FrameInfoWindow;
 }
 
+struct FrameStatsJob
+{
+    uint32_t id;
+    QVector<int> rows;      //one stretch of the ID's rows, in capture order
+    FrameStatistics stats;
+    bool done;
+};
+
 class FrameInfoWindow : public QDialog
 {
     Q_OBJECT
@@ -39,8 +49,12 @@ private:
     QCustomPlot *graphHistogram;
     CANDataGrid *heatmap;
 
-    QList<int> foundID;
-    QList<CANFrame> frameCache;
+    QSet<int> foundID;
+    QHash<uint32_t, FrameStatistics> frameStats;
+    QHash<uint32_t, QVector<SignalKeyLayout>> signalLayouts;
+    bool statsValid;    //every ID has statistics unless a rebuild was canceled
+    bool rebuilding;    //rebuildStatistics is waiting on its jobs. New frames are counted once it is done
+    bool rebuildStale;  //the frames were cleared or replaced while rebuilding so its results are thrown away
     const QVector<CANFrame> *modelFrames;
     bool useOpenGL;
     bool useHexTicker;
@@ -51,6 +65,8 @@ private:
     QCPGraph *graphRef[8];
 
     void refreshIDList();
+    void rebuildStatistics();
+    const QVector<SignalKeyLayout> &layoutForID(uint32_t id);
     void closeEvent(QCloseEvent *event);
     bool eventFilter(QObject *obj, QEvent *event);
     void setupByteGraph(QCustomPlot *plot, int num);
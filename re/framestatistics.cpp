@@ -0,0 +1,207 @@
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "framestatistics.h"
+
+static inline void countBits(quint32 *counts, quint8 bits)
+{
+    while (bits)
+    {
+        counts[qCountTrailingZeroBits(bits)]++;
+        bits &= bits - 1;
+    }
+}
+
+static inline void addInterval(FrameStatistics &stats, int64_t interval)
+{
+    if (stats.intervals.isEmpty())
+    {
+        stats.minInterval = interval;
+        stats.maxInterval = interval;
+    }
+    else
+    {
+        if (interval < stats.minInterval) stats.minInterval = interval;
+        if (interval > stats.maxInterval) stats.maxInterval = interval;
+    }
+    stats.intervals.append(interval);
+    stats.intervalSum += interval;
+    stats.intervalSquares += (double)interval * interval;
+}
+
+FrameStatistics::FrameStatistics()
+{
+    id = 0;
+    extended = false;
+    numFrames = 0;
+    minLen = 0;
+    maxLen = 0;
+    firstTime = 0;
+    lastTime = 0;
+    intervalSum = 0;
+    intervalSquares = 0.0;
+    minInterval = 0;
+    maxInterval = 0;
+}
+
+void FrameStatistics::addFrame(const CANFrame& frame, const QVector<SignalKeyLayout>& sigs)
+{
+    const QByteArray payload = frame.payload();
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    const int len = qMin(payload.length(), FRAMESTATS_MAX_BYTES);
+    const int64_t time = frame.timeStamp().microSeconds();
+
+    if (numFrames == 0)
+    {
+        id = frame.frameId();
+        extended = frame.hasExtendedFrameFormat();
+        firstTime = time;
+        minLen = len;
+    }
+    //TODO - we take the interval whichever way doesn't go negative. But, we should probably sort the frame list before
+    //starting so that the intervals are all correct.
+    else addInterval(*this, (time > lastTime) ? (time - lastTime) : (lastTime - time));
+    lastTime = time;
+    numFrames++;
+    if (len < minLen) minLen = len;
+
+    //bytes seen for the first time start out at the value they have now
+    for (int c = maxLen; c < len; c++)
+    {
+        FrameByteStats byte;
+        memset(&byte, 0, sizeof(byte));
+        byte.first = byte.last = byte.min = byte.max = data[c];
+        bytes.append(byte);
+    }
+    if (len > maxLen) maxLen = len;
+
+    for (int c = 0; c < len; c++)
+    {
+        FrameByteStats &byte = bytes[c];
+        const quint8 dat = data[c];
+        if (dat < byte.min) byte.min = dat;
+        if (dat > byte.max) byte.max = dat;
+        byte.histogram[dat]++;
+        countBits(byte.bitCount, dat);
+        byte.changedBits |= byte.first ^ dat;
+        countBits(byte.bitFlips, byte.last ^ dat);
+        byte.last = dat;
+    }
+    for (int c = 0; c < qMin(len, FRAMESTATS_GRAPH_BYTES); c++) byteSeries[c].append(data[c]);
+
+    if (signalValues.count() < sigs.count()) signalValues.resize(sigs.count());
+    for (int i = 0; i < sigs.count(); i++)
+    {
+        if (sigs[i].keyBits < 0) continue;
+        QHash<QByteArray, FrameSignalValue> &values = signalValues[i];
+        const QByteArray key = SignalValueKey::key(sigs[i], payload);
+        QHash<QByteArray, FrameSignalValue>::iterator it = values.find(key);
+        if (it == values.end()) values.insert(key, FrameSignalValue{frame, 1});
+        else it->count++;
+    }
+}
+
+void FrameStatistics::append(const FrameStatistics& later)
+{
+    if (later.numFrames == 0) return;
+    if (numFrames == 0)
+    {
+        *this = later;
+        return;
+    }
+
+    //the interval across the seam, then the ones inside later
+    addInterval(*this, (later.firstTime > lastTime) ? (later.firstTime - lastTime) : (lastTime - later.firstTime));
+    if (!later.intervals.isEmpty())
+    {
+        minInterval = qMin(minInterval, later.minInterval);
+        maxInterval = qMax(maxInterval, later.maxInterval);
+        intervals += later.intervals;
+        intervalSum += later.intervalSum;
+        intervalSquares += later.intervalSquares;
+    }
+    lastTime = later.lastTime;
+    numFrames += later.numFrames;
+    minLen = qMin(minLen, later.minLen);
+
+    for (int c = 0; c < later.maxLen; c++)
+    {
+        const FrameByteStats &from = later.bytes[c];
+        if (c >= maxLen)
+        {
+            bytes.append(from);
+            continue;
+        }
+
+        FrameByteStats &byte = bytes[c];
+        //a bit changed relative to our first value if it moved within later or later started out different
+        byte.changedBits |= from.changedBits | (byte.first ^ from.first);
+        countBits(byte.bitFlips, byte.last ^ from.first);
+        byte.last = from.last;
+        byte.min = qMin(byte.min, from.min);
+        byte.max = qMax(byte.max, from.max);
+        for (int d = 0; d < 256; d++) byte.histogram[d] += from.histogram[d];
+        for (int l = 0; l < 8; l++)
+        {
+            byte.bitCount[l] += from.bitCount[l];
+            byte.bitFlips[l] += from.bitFlips[l];
+        }
+    }
+    maxLen = qMax(maxLen, later.maxLen);
+
+    for (int c = 0; c < FRAMESTATS_GRAPH_BYTES; c++) byteSeries[c] += later.byteSeries[c];
+
+    if (signalValues.count() < later.signalValues.count()) signalValues.resize(later.signalValues.count());
+    for (int i = 0; i < later.signalValues.count(); i++)
+    {
+        QHash<QByteArray, FrameSignalValue>::const_iterator it;
+        for (it = later.signalValues[i].constBegin(); it != later.signalValues[i].constEnd(); ++it)
+        {
+            QHash<QByteArray, FrameSignalValue>::iterator found = signalValues[i].find(it.key());
+            if (found == signalValues[i].end()) signalValues[i].insert(it.key(), it.value());
+            else found->count += it->count;
+        }
+    }
+}
+
+void FrameStatistics::intervalPercentiles(int64_t &pctl5, int64_t &pctl95) const
+{
+    pctl5 = pctl95 = 0;
+    if (intervals.isEmpty()) return;
+
+    QVector<int64_t> work = intervals;
+    const int idx5 = static_cast<int>(floor(0.05 * work.count()));
+    const int idx95 = static_cast<int>(floor(0.95 * work.count()));
+    std::nth_element(work.begin(), work.begin() + idx95, work.end());
+    pctl95 = work[idx95];
+    std::nth_element(work.begin(), work.begin() + idx5, work.begin() + idx95);
+    pctl5 = work[idx5];
+}
+
+void FrameStatistics::intervalHistogram(int numBars, QVector<double> &upperBounds, QVector<double> &counts) const
+{
+    upperBounds.clear();
+    counts.clear();
+    if (intervals.isEmpty()) return;
+
+    const int64_t step = (maxInterval - minInterval) / numBars;
+    counts.fill(0.0, numBars + 1);
+    foreach (int64_t interval, intervals)
+    {
+        //first bar whose upper bound holds the interval
+        int bar = step ? static_cast<int>(numBars - (maxInterval - interval) / step) : 0;
+        counts[qMax(0, bar)] += 1.0;
+    }
+    for (int l = 0; l <= numBars; l++)
+        upperBounds.append((maxInterval - ((numBars - l) * step)) / 1000.0); // avoid missing the biggest value due to rounding errors
+}
+
+double FrameStatistics::intervalStdDev() const
+{
+    if (intervals.isEmpty()) return 0.0;
+    const double mean = (double)intervalSum / intervals.count();
+    const double variance = intervalSquares / intervals.count() - mean * mean;
+    return (variance > 0.0) ? sqrt(variance) : 0.0;
+}
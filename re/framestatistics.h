@@ -0,0 +1,77 @@
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <QVector>
+#include <QHash>
+#include "can_structs.h"
+#include "signalvaluekey.h"
+
+/* CAN-FD payloads are covered in full */
+#define FRAMESTATS_MAX_BYTES    64
+/* bytes that get a value over time graph */
+#define FRAMESTATS_GRAPH_BYTES  8
+
+struct FrameByteStats
+{
+    quint8 first;           //value the first frame had. Changed bits are relative to it
+    quint8 last;            //value the latest frame had. Bit flips are counted against it
+    quint8 min;
+    quint8 max;
+    quint8 changedBits;
+    quint32 histogram[256];
+    quint32 bitCount[8];    //frames with the bit set
+    quint32 bitFlips[8];    //times the bit differed from the frame before
+};
+
+struct FrameSignalValue
+{
+    CANFrame sample;        //one frame with this value, decoded when the value is shown
+    quint64 count;
+};
+
+/*
+  Running statistics for one frame ID, everything the frame info window shows about it. Each frame is added
+  in constant time so the statistics can be kept up to date while frames come in.
+
+  Statistics over consecutive stretches of a capture can be built independently and then appended in capture
+  order. The result is the same as adding every frame to one object, so a capture can be split into chunks that
+  are worked on in parallel.
+
+  Signal values are counted by the raw bits they decode from (see SignalValueKey) so no DBC decoding happens
+  in here. Nothing is shared between objects, each one may be filled in its own thread.
+*/
+class FrameStatistics
+{
+public:
+    FrameStatistics();
+
+    void addFrame(const CANFrame& frame, const QVector<SignalKeyLayout>& sigs);
+    /* later holds the frames right after the ones in this object */
+    void append(const FrameStatistics& later);
+
+    /* the 5th and 95th percentile of the intervals. Linear in the number of intervals */
+    void intervalPercentiles(int64_t &pctl5, int64_t &pctl95) const;
+    /* numBars + 1 bars up to maxInterval, each counting only the intervals that fall in its own bin */
+    void intervalHistogram(int numBars, QVector<double> &upperBounds, QVector<double> &counts) const;
+    double intervalStdDev() const;
+
+    uint32_t id;
+    bool extended;
+    quint64 numFrames;
+    int minLen;
+    int maxLen;
+    int64_t firstTime;
+    int64_t lastTime;
+
+    int64_t intervalSum;
+    double intervalSquares;
+    int64_t minInterval;
+    int64_t maxInterval;
+    QVector<int64_t> intervals;                         //in capture order
+
+    QVector<FrameByteStats> bytes;                      //maxLen entries
+    QVector<quint8> byteSeries[FRAMESTATS_GRAPH_BYTES]; //every value of the first bytes in order
+    QVector<QHash<QByteArray, FrameSignalValue>> signalValues; //per signal index
+};
+
+#endif // FRAMESTATISTICS_H
@@ -38,6 +38,7 @@ FuzzingWindow::FuzzingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
 
 
     connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    connect(MainWindow::getReference()->getCANFrameModel(), &CANFrameModel::idsAdded, this, &FuzzingWindow::newIDsSeen);
 
     refreshIDList();
 
@@ -86,7 +87,6 @@ bool FuzzingWindow::eventFilter(QObject *obj, QEvent *event)
 
 void FuzzingWindow::updatedFrames(int numFrames)
 {
-    int id;
     if (numFrames == -1) //all frames deleted. Kill the display
     {
         ui->listID->clear();
@@ -99,20 +99,22 @@ void FuzzingWindow::updatedFrames(int numFrames)
         foundIDs.clear();
         refreshIDList();
     }
-    else //just got some new frames. See if they are relevant.
+    //new frames with IDs we haven't seen come in through newIDsSeen
+}
+
+//the model hands over only the IDs it hadn't seen before so nothing has to be scanned here
+void FuzzingWindow::newIDsSeen(const QVector<uint32_t> &newIDs)
+{
+    foreach (uint32_t id, newIDs)
     {
-        if (numFrames > modelFrames->count()) return;
-        for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
+        if (!foundIDs.contains((int)id))
         {
-            id = modelFrames->at(i).frameId();
-            if (!foundIDs.contains(id))
-            {
-                foundIDs.append(id);
-                selectedIDs.append(id);
-                FilterUtility::createCheckableFilterItem(id, true, ui->listID);
-            }
+            foundIDs.insert((int)id);
+            selectedIDs.append((int)id);
+            FilterUtility::createCheckableFilterItem((int)id, true, ui->listID);
         }
     }
+    if (!newIDs.isEmpty()) ui->listID->sortItems();
 }
 
 void FuzzingWindow::changePlaybackSpeed(int newSpeed)
@@ -415,17 +417,11 @@ void FuzzingWindow::refreshIDList()
     ui->listID->clear();
     foundIDs.clear();
 
-    int id;
-    for (int i = 0; i < modelFrames->count(); i++)
+    foreach (uint32_t id, MainWindow::getReference()->getCANFrameModel()->getUniqueIDs(modelFrames))
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = thisFrame.frameId();
-        if (!foundIDs.contains(id))
-        {
-            foundIDs.append(id);
-            selectedIDs.append(id);
-            FilterUtility::createCheckableFilterItem(id, true, ui->listID);
-        }
+        foundIDs.insert((int)id);
+        selectedIDs.append((int)id);
+        FilterUtility::createCheckableFilterItem((int)id, true, ui->listID);
     }
     //default is to sort in ascending order
     ui->listID->sortItems();
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QListWidget>
 #include <QTimer>
+#include <QSet>
 #include "can_structs.h"
 
 namespace Ui {
@@ -42,12 +43,13 @@ private slots:
     void bitfieldClicked(int);
     void changedNumDataBytes(int newVal);
     void updatedFrames(int numFrames);
+    void newIDsSeen(const QVector<uint32_t> &newIDs);
 
 private:
     Ui::FuzzingWindow *ui;
     const QVector<CANFrame> *modelFrames;
     QTimer *fuzzTimer;
-    QList<int> foundIDs;
+    QSet<int> foundIDs;
     QList<int> selectedIDs;
     QList<CANFrame> sendingBuffer;
     int startID, endID, currentID, currentIdx;
@@ -0,0 +1,127 @@
+#include <QDateTime>
+#include <QMutexLocker>
+
+#include "graphbuilder.h"
+
+GraphBuilder::GraphBuilder(const GraphDecodeSpec& spec, const QVector<CANFrame>& frames, const QVector<int>& rows)
+    : spec(spec)
+{
+    if (this->spec.stride < 1) this->spec.stride = 1;
+
+    //sharing the whole capture would make it detach into a full copy as soon as the GUI adds a frame
+    this->frames.reserve(rows.count());
+    foreach (int row, rows) this->frames.append(frames.at(row));
+}
+
+bool GraphBuilder::signalPresent(const QByteArray& payload) const
+{
+    return !spec.hasSignal || SignalCodec::isPresent(spec.signal, payload);
+}
+
+void GraphBuilder::run()
+{
+    const int numRows = frames.count();
+    const CANFrame *frameData = frames.constData();
+    GraphColumns chunk;
+
+    //the stride counts frames of the right bus and type, same as when they were gathered up front
+    int matched = 0;
+    int row = 0;
+    while (row < numRows && !canceled.loadAcquire())
+    {
+        const int chunkEnd = qMin(numRows, row + GRAPHBUILD_CHUNK_ROWS);
+        chunk.x.clear();
+        chunk.y.clear();
+        chunk.raw.clear();
+
+        for (; row < chunkEnd; row++)
+        {
+            const CANFrame &frame = frameData[row];
+            if (frame.frameType() != QCanBusFrame::DataFrame) continue;
+            if (spec.bus != -1 && spec.bus != frame.bus) continue;
+            if ((matched++ % spec.stride) != 0) continue;
+
+            const QByteArray payload = frame.payload();
+            if (!signalPresent(payload)) continue;
+
+            const int64_t tempVal = Utility::processIntegerSignal(payload, spec.startBit, spec.numBits, spec.intelFormat, spec.isSigned);
+            double x;
+            if (spec.timeStyle == TS_SECONDS)
+            {
+                x = (frame.timeStamp().microSeconds()) / 1000000.0;
+            }
+            else if (spec.timeStyle == TS_CLOCK)
+            {
+                QDateTime dt = QDateTime::fromMSecsSinceEpoch((frame.timeStamp().microSeconds() / 1000) - spec.xbias);
+                x = (dt.time().msecsSinceStartOfDay() / 1000.0);
+            }
+            else
+            {
+                x = frame.timeStamp().microSeconds();
+            }
+
+            chunk.x.append(x);
+            chunk.y.append((tempVal * spec.scale) + spec.bias);
+            chunk.raw.append(tempVal);
+        }
+
+        {
+            QMutexLocker locker(&mutex);
+            ready.x += chunk.x;
+            ready.y += chunk.y;
+            ready.raw += chunk.raw;
+        }
+        rowsDone.storeRelease(row);
+    }
+
+    finished.storeRelease(1);
+}
+
+void GraphBuilder::cancel()
+{
+    canceled.storeRelease(1);
+}
+
+bool GraphBuilder::isCanceled() const
+{
+    return canceled.loadAcquire();
+}
+
+bool GraphBuilder::isFinished() const
+{
+    return finished.loadAcquire();
+}
+
+bool GraphBuilder::takeSamples(GraphColumns& out)
+{
+    QMutexLocker locker(&mutex);
+    if (ready.x.isEmpty()) return false;
+
+    if (out.x.isEmpty())
+    {
+        //hand the buffers over instead of copying them
+        out.x.swap(ready.x);
+        out.y.swap(ready.y);
+        out.raw.swap(ready.raw);
+    }
+    else
+    {
+        out.x += ready.x;
+        out.y += ready.y;
+        out.raw += ready.raw;
+        ready.x.clear();
+        ready.y.clear();
+        ready.raw.clear();
+    }
+    return true;
+}
+
+int GraphBuilder::getRowsDone() const
+{
+    return rowsDone.loadAcquire();
+}
+
+int GraphBuilder::getRowCount() const
+{
+    return frames.count();
+}
@@ -0,0 +1,83 @@
+#ifndef GRAPHBUILDER_H
+#define GRAPHBUILDER_H
+
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+#include "can_structs.h"
+#include "utility.h"
+#include "dbc/signalcodec.h"
+
+/* rows decoded between checks for cancel and hand overs to the GUI */
+#define GRAPHBUILD_CHUNK_ROWS   20000
+
+/* everything needed to turn a frame into a point, copied out of the graph and its signal in the GUI thread */
+struct GraphDecodeSpec
+{
+    int bus;
+    int startBit;
+    int numBits;
+    bool intelFormat;
+    bool isSigned;
+    double scale;
+    double bias;
+    int stride;
+    double xbias;
+    TimeStyle timeStyle;
+    bool hasSignal;                 //graph of a DBC signal. Frames it isn't present in are skipped
+    SignalCodecSpec signal;
+};
+
+/* decoded samples, one column per quantity */
+struct GraphColumns
+{
+    QVector<double> x, y;
+    QVector<int64_t> raw;           //integer signal value before scale and bias, for the value table brackets
+};
+
+/*
+  Decodes one graph from a capture on a worker thread so adding graphs or loading a set of definitions
+  doesn't freeze the window.
+
+  The builder keeps its own copy of just the frames of the graph's rows, taken when the build starts, so
+  frames the GUI adds meanwhile don't disturb the worker and the capture itself is never duplicated. Decoding goes a chunk of rows at a time. Each chunk is added to
+  a hand over buffer the GUI empties with takeSamples() whenever it likes, which is how partial graphs show
+  up before the build is done. cancel() stops the worker at the next chunk. A removed graph simply drops
+  its reference and the worker frees the builder when it gets there.
+*/
+class GraphBuilder
+{
+public:
+    GraphBuilder(const GraphDecodeSpec& spec, const QVector<CANFrame>& frames, const QVector<int>& rows);
+
+    /* decodes every row. Meant for a worker thread but also fine to call directly for small graphs */
+    void run();
+
+    void cancel();
+    bool isCanceled() const;
+
+    /* true once run() has returned, canceled or not */
+    bool isFinished() const;
+
+    /**
+     * @brief moves the samples decoded since the last call into out, appending
+     * @return true if anything was added
+     */
+    bool takeSamples(GraphColumns& out);
+
+    int getRowsDone() const;
+    int getRowCount() const;
+
+private:
+    bool signalPresent(const QByteArray& payload) const;
+
+    GraphDecodeSpec spec;
+    QVector<CANFrame> frames;       //the frames of the rows, in row order
+    QMutex mutex;
+    GraphColumns ready;
+    QAtomicInt rowsDone;
+    QAtomicInt canceled;
+    QAtomicInt finished;
+};
+
+#endif // GRAPHBUILDER_H
@@ -5,6 +5,7 @@
 #include "helpwindow.h"
 #include "utility.h"
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <algorithm>
 #include <limits>
@@ -77,6 +78,8 @@ GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent)
     // make bottom and left axes transfer their ranges to top and right axes:
     connect(ui->graphingView->xAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->xAxis2, SLOT(setRange(QCPRange)));
     connect(ui->graphingView->yAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->yAxis2, SLOT(setRange(QCPRange)));
+    //panning and zooming picks the level of detail each graph is shown at
+    connect(ui->graphingView->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(xRangeChanged(QCPRange)));
 
     //connect(ui->graphingView, SIGNAL(titleDoubleClick(QMouseEvent*,QCPTextElement*)), this, SLOT(titleDoubleClick(QMouseEvent*,QCPTextElement*)));
     connect(ui->graphingView, SIGNAL(axisDoubleClick(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)), this, SLOT(axisDoubleClick(QCPAxis*,QCPAxis::SelectablePart)));
@@ -85,6 +88,11 @@ GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent)
 
     connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
 
+    //graphs built in the background are picked up from here
+    buildTimer = new QTimer(this);
+    buildTimer->setInterval(100);
+    connect(buildTimer, SIGNAL(timeout()), this, SLOT(collectBuilds()));
+
     // setup policy and connect slot for context menu popup:
     ui->graphingView->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->graphingView, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(contextMenuRequest(QPoint)));
@@ -116,6 +124,7 @@ GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent)
 
 GraphingWindow::~GraphingWindow()
 {
+    cancelBuilds();
     delete ui;
 }
 
@@ -127,6 +136,14 @@ void GraphingWindow::showEvent(QShowEvent* event)
     ui->graphingView->replot();
 }
 
+void GraphingWindow::resizeEvent(QResizeEvent *event)
+{
+    QDialog::resizeEvent(event);
+    //a wider plot can show more detail
+    for (int i = 0; i < graphParams.count(); i++) updateGraphView(graphParams[i]);
+    ui->graphingView->replot(QCustomPlot::rpQueuedReplot);
+}
+
 void GraphingWindow::closeEvent(QCloseEvent *event)
 {
     Q_UNUSED(event);
@@ -177,11 +194,20 @@ void GraphingWindow::writeSettings()
     }
 }
 
+static inline quint64 graphRouteKey(int bus, uint32_t ID)
+{
+    return ((quint64)(quint32)bus << 32) | ID;
+}
+
+void GraphingWindow::rebuildGraphRoutes()
+{
+    graphRoutes.clear();
+    for (int i = 0; i < graphParams.count(); i++)
+        graphRoutes[graphRouteKey(graphParams[i].bus, graphParams[i].ID)].append(i);
+}
+
 void GraphingWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
-    QVector<double> x, y;
-    bool appendedToGraph = false;
     bool needReplot = false;
 
     if (numFrames == -1) //all frames deleted. Kill the display
@@ -211,27 +237,35 @@ void GraphingWindow::updatedFrames(int numFrames)
     }
     else //just got some new frames. See if they are relevant.
     {  
-        if (numFrames > modelFrames->count()) return;
+        if (numFrames > modelFrames->count() || graphRoutes.isEmpty()) return;
 
-        for (int j = 0; j < graphParams.count(); j++)
+        //one pass over the new frames, each one goes straight to the graphs of its bus and ID
+        QVector<bool> appendedToGraph(graphParams.count(), false);
+        const CANFrame *frames = modelFrames->constData();
+        for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
-            appendedToGraph = false;
-            x.clear();
-            y.clear();
-            for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
+            const CANFrame &thisFrame = frames[i];
+            for (int anyBus = 0; anyBus < 2; anyBus++)
             {
-                thisFrame = modelFrames->at(i);
-                if ( graphParams[j].ID == thisFrame.frameId() && ( (graphParams[j].bus == -1) || (graphParams[j].bus == thisFrame.bus) ) )
+                if (anyBus && thisFrame.bus == -1) break; //already looked up as any bus
+                QHash<quint64, QVector<int>>::const_iterator route = graphRoutes.constFind(graphRouteKey(anyBus ? -1 : thisFrame.bus, thisFrame.frameId()));
+                if (route == graphRoutes.constEnd()) continue;
+                const QVector<int> &graphs = route.value();
+                for (int j = 0; j < graphs.count(); j++)
                 {
-                    appendToGraph(graphParams[j], thisFrame, x, y);
-                    appendedToGraph = true;
+                    if (graphParams[graphs[j]].build.builder) continue; //gets these once its build is done
+                    appendToGraph(graphParams[graphs[j]], thisFrame);
+                    appendedToGraph[graphs[j]] = true;
                 }
             }
-            if (appendedToGraph)
-            {
-                graphParams[j].ref->addData(x, y);
-                needReplot = true;
-            }
+        }
+
+        for (int j = 0; j < graphParams.count(); j++)
+        {
+            if (!appendedToGraph[j]) continue;
+            graphParams[j].pyramid.update(graphParams[j].x, graphParams[j].y);
+            updateGraphView(graphParams[j]);
+            needReplot = true;
         }
 
         if (needReplot)
@@ -257,6 +291,28 @@ void GraphingWindow::updatedFrames(int numFrames)
     }
 }
 
+void GraphingWindow::xRangeChanged(const QCPRange &range)
+{
+    Q_UNUSED(range);
+    for (int i = 0; i < graphParams.count(); i++) updateGraphView(graphParams[i]);
+}
+
+/*
+ * Hands the plot no more than about two points per pixel of the visible range, full resolution
+ * once zoomed in far enough. Outside the visible range only a coarse outline is given.
+ */
+void GraphingWindow::updateGraphView(GraphParams &params)
+{
+    //graphs get torn down and rebuilt one by one when the frames are reset
+    if (!params.ref || !ui->graphingView->hasPlottable(params.ref)) return;
+
+    QCPRange range = ui->graphingView->xAxis->range();
+    int maxBuckets = qMax(64, ui->graphingView->axisRect()->width());
+    QVector<double> x, y;
+    params.pyramid.query(params.x, params.y, range.lower, range.upper, maxBuckets, x, y);
+    params.ref->setData(x, y);
+}
+
 void GraphingWindow::plottableClick(QCPAbstractPlottable* plottable, int dataIdx, QMouseEvent* event)
 {
     Q_UNUSED(dataIdx);
@@ -442,6 +498,13 @@ void GraphingWindow::mousePress()
   // if an axis is selected, only allow the direction of that axis to be dragged
   // if no axis is selected, both directions may be dragged
 
+  // the user takes over the view from graphs that are still coming in
+  for (int i = 0; i < graphParams.count(); i++)
+  {
+    graphParams[i].build.setupScale = false;
+    graphParams[i].build.rescaleValues = false;
+  }
+
   if (ui->graphingView->xAxis->selectedParts().testFlag(QCPAxis::spAxis))
     ui->graphingView->axisRect()->setRangeDrag(ui->graphingView->xAxis->orientation());
   else if (ui->graphingView->yAxis->selectedParts().testFlag(QCPAxis::spAxis))
@@ -455,6 +518,13 @@ void GraphingWindow::mouseWheel()
   // if an axis is selected, only allow the direction of that axis to be zoomed
   // if no axis is selected, both directions may be zoomed
 
+  // the user takes over the view from graphs that are still coming in
+  for (int i = 0; i < graphParams.count(); i++)
+  {
+    graphParams[i].build.setupScale = false;
+    graphParams[i].build.rescaleValues = false;
+  }
+
   if (ui->graphingView->xAxis->selectedParts().testFlag(QCPAxis::spAxis))
     ui->graphingView->axisRect()->setRangeZoom(ui->graphingView->xAxis->orientation());
   else if (ui->graphingView->yAxis->selectedParts().testFlag(QCPAxis::spAxis))
@@ -588,7 +658,9 @@ void GraphingWindow::removeSelectedGraph()
             ui->graphingView->removeItem(txt);
         }
 
+        if (graphParams[idx].build.builder) graphParams[idx].build.builder->cancel();
         graphParams.removeAt(idx);
+        rebuildGraphRoutes();
 
         ui->graphingView->removeGraph(ui->graphingView->selectedGraphs().constFirst());
 
@@ -627,9 +699,11 @@ void GraphingWindow::removeAllGraphs()
                                   QMessageBox::Yes|QMessageBox::No);
     if (confirmDialog == QMessageBox::Yes)
     {
+        cancelBuilds();
         ui->graphingView->clearGraphs();
         ui->graphingView->clearItems();
         graphParams.clear();
+        graphRoutes.clear();
         needScaleSetup = true;
         ui->graphingView->replot();
     }
@@ -680,6 +754,11 @@ void GraphingWindow::contextMenuRequest(QPoint pos)
         menu->addSeparator();
         menu->addAction(tr("Edit selected graph"), this, SLOT(editSelectedGraph()));
         menu->addAction(tr("Remove selected graph"), this, SLOT(removeSelectedGraph()));
+        foreach (const GraphParams &params, graphParams)
+        {
+            if (params.ref == ui->graphingView->selectedGraphs().constFirst() && params.build.builder)
+                menu->addAction(tr("Stop building selected graph"), this, SLOT(stopSelectedGraphBuild()));
+        }
     }
     if (ui->graphingView->graphCount() > 0)
     {
@@ -1219,7 +1298,9 @@ void GraphingWindow::showParamsDialog(int idx = -1)
     {
         if (idx > -1) //if there was an existing graph then delete it
         {
+            if (graphParams[idx].build.builder) graphParams[idx].build.builder->cancel();
             graphParams.removeAt(idx);
+            rebuildGraphRoutes();
             ui->graphingView->removeGraph(idx);
         }
         //create a new graph with the returned parameters.
@@ -1235,7 +1316,7 @@ void GraphingWindow::addNewGraph()
     showParamsDialog(-1);
 }
 
-void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector<double> &x, QVector<double> &y)
+void GraphingWindow::appendToGraph(GraphParams &params, const CANFrame &frame)
 {
     params.strideSoFar++;
     if (params.strideSoFar >= params.stride)
@@ -1260,8 +1341,6 @@ void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector
         yVal = (tempVal * params.scale) + params.bias;
         params.x.append(xVal);
         params.y.append(yVal);
-        x.append(xVal);
-        y.append(yVal);
 
         //now see if we've got to do anything with the brackets and labels for value table stuff
         QString tempStr;
@@ -1315,12 +1394,7 @@ void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector
 
 void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
 {
-    int64_t tempVal; //64 bit temp value.
-    double yminval=10000000.0, ymaxval = -1000000.0;
-    double xminval=10000000000.0, xmaxval = -10000000000.0;
     GraphParams *refParam = &params;
-    QString tempStr;
-    double x{}, y{};
 
     qDebug() << "New Graph ID: " << params.ID;
     qDebug() << "Start bit: " << params.startBit;
@@ -1329,79 +1403,219 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     qDebug() << "Signed: " << params.isSigned;
     qDebug() << "Mask: " << params.mask;
 
-    frameCache.clear();
-    for (int i = 0; i < modelFrames->count(); i++)
+    //only visit the rows of this ID instead of the whole capture
+    CANFrameModel *frameModel = MainWindow::getReference()->getCANFrameModel();
+    QVector<int> rows;
+    if (params.bus > -1 && modelFrames == frameModel->getListReference())
+    {
+        const QVector<int> *busRows = frameModel->getRowsForBusID(params.bus, params.ID);
+        if (busRows) rows = *busRows;
+    }
+    else rows = frameModel->getRowsForID(params.ID, modelFrames);
+
+    //everything the worker needs is copied out here. It never touches the graph or the DBC
+    GraphDecodeSpec spec;
+    spec.bus = params.bus;
+    spec.startBit = params.startBit;
+    spec.numBits = params.numBits;
+    spec.intelFormat = params.intelFormat;
+    spec.isSigned = params.isSigned;
+    spec.scale = params.scale;
+    spec.bias = params.bias;
+    spec.stride = params.stride;
+    spec.xbias = params.xbias;
+    spec.timeStyle = Utility::timeStyle;
+    spec.hasSignal = (params.associatedSignal != nullptr);
+    if (spec.hasSignal) spec.signal = SignalCodec::fromSignal(params.associatedSignal);
+
+    params.x.clear();
+    params.y.clear();
+    params.xbias = 0;
+
+    if (params.graphName == nullptr || params.graphName.length() == 0)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        if ( (thisFrame.frameId() == params.ID) && (thisFrame.frameType() == QCanBusFrame::DataFrame)
-       &&  ( ( params.bus == -1) ||  (params.bus == thisFrame.bus) ) ) frameCache.append(thisFrame);
+        params.graphName = QString("0x") + QString::number(params.ID, 16) + ":" + QString::number(params.startBit);
+        params.graphName += "-" + QString::number(params.numBits);
+    }
+
+    //a regenerated graph may still be building from the frames it had before
+    if (params.build.builder) params.build.builder->cancel();
+    params.build = GraphBuildState();
+
+    ui->graphingView->addGraph();
+    params.ref = ui->graphingView->graph();
+    if (createGraphParam)
+    {
+        graphParams.append(params);
+        refParam = &graphParams.last();
+        rebuildGraphRoutes();
+    }
+
+    selDecorator = new QCPSelectionDecorator(); //this has to be a pointer as it is freed internally to qcustomplot classes
+    selDecorator->setBrush(Qt::NoBrush);
+    selDecorator->setPen(selectedPen);
+    ui->graphingView->graph()->setSelectionDecorator(selDecorator);
+
+    ui->graphingView->graph()->setName(params.graphName);
+    ui->graphingView->graph()->setProperty("id", params.ID);
+
+    ui->graphingView->graph()->setScatterStyle(QCPScatterStyle((QCPScatterStyle::ScatterShape)params.pointType));
+
+    if (params.drawOnlyPoints) ui->graphingView->graph()->setLineStyle(QCPGraph::lsNone); //Draw only the points, no connections, no fills
+    else
+    {
+        ui->graphingView->graph()->setLineStyle(QCPGraph::lsLine); //connect points with lines
+    }
+
+    QPen graphPen;
+    graphPen.setColor(params.lineColor);
+    graphPen.setWidth(params.lineWidth);
+    ui->graphingView->graph()->setPen(graphPen);
+    if (params.fillColor.alpha() > 0) //only if there is some opacity will we set up a fill brush
+    {
+        qDebug() << "Drawing filled graph";
+        QBrush fillBrush;
+        fillBrush.setColor(params.fillColor);
+        fillBrush.setStyle(Qt::SolidPattern);
+        ui->graphingView->graph()->setBrush(fillBrush);
+    }
+
+    //the view follows the first graph as it comes in until the user takes over
+    refParam->pyramid.clear();
+    refParam->build.spec = spec;
+    refParam->build.frameCount = modelFrames->count();
+    refParam->build.setupScale = needScaleSetup;
+    refParam->build.rescaleValues = true;
+    refParam->build.builder = QSharedPointer<GraphBuilder>(new GraphBuilder(spec, *modelFrames, rows));
+    needScaleSetup = false;
+
+    if (rows.count() <= GRAPHBUILD_CHUNK_ROWS)
+    {
+        //not worth a thread, and the graph is complete right away
+        refParam->build.builder->run();
+        collectGraph(*refParam);
+    }
+    else
+    {
+        QSharedPointer<GraphBuilder> builder = refParam->build.builder;
+        QtConcurrent::run([builder]()
+        {
+            builder->run();
+        });
+        buildTimer->start();
+    }
+
+    ui->graphingView->replot();
+}
+
+/*
+ * Takes whatever the graph's builder decoded since the last call and adds it to the graph. Once the build is
+ * over the graph gets the frames that came in meanwhile and turns into a normal graph.
+ * Returns true if the graph changed.
+ */
+bool GraphingWindow::collectGraph(GraphParams &params)
+{
+    GraphBuildState &build = params.build;
+    if (!build.builder) return false;
+
+    //checked before taking so samples added right before the end can't be missed
+    const bool finished = build.builder->isFinished();
+    GraphColumns cols;
+    const bool gotSamples = build.builder->takeSamples(cols);
+    if (gotSamples) addBuiltSamples(params, cols);
+
+    if (!finished)
+    {
+        if (!gotSamples) return false;
+        const int percent = (int)(100.0 * build.builder->getRowsDone() / qMax(1, build.builder->getRowCount()));
+        params.ref->setName(params.graphName + " (" + QString::number(percent) + "%)");
+        params.pyramid.update(params.x, params.y);
+        if (build.setupScale || build.rescaleValues) fitViewToGraph(params, build.setupScale);
+        updateGraphView(params);
+        return true;
     }
 
     //to fix weirdness where a graph that has no data won't be able to be edited, selected, or deleted properly
-    //we'll check for the condition that there is nothing to graph and add a single dummy frame to the cache
+    //we'll check for the condition that there is nothing to graph and add a single dummy frame
     //that has all data bytes = 0. This allows the graph to be edited and deleted. No idea why you can't otherwise.
-    if (frameCache.count() == 0)
+    if (params.x.isEmpty() && !build.builder->isCanceled())
     {
         CANFrame dummy;
         dummy.setFrameId(params.ID);
         dummy.bus = 0;
         dummy.setPayload(QByteArray(8, 0));
         dummy.setFrameType(QCanBusFrame::DataFrame);
-        frameCache.append(dummy);
+        GraphDecodeSpec dummySpec = build.spec;
+        dummySpec.bus = -1;
+        GraphBuilder dummyBuild(dummySpec, QVector<CANFrame>(1, dummy), QVector<int>(1, 0));
+        dummyBuild.run();
+        if (dummyBuild.takeSamples(cols)) addBuiltSamples(params, cols);
     }
 
-    int numEntries = frameCache.count() / params.stride;
-    if (numEntries < 1) numEntries = 1; //could happen if stride is larger than frame count
+    if (params.prevValLocation != QPointF(0,0))
+    {
+        QCPItemBracket *bracket = new QCPItemBracket(ui->graphingView);
+        bracket->left->setCoords(params.prevValLocation);
+        bracket->right->setCoords(params.x.last(), params.prevValLocation.y());
+        bracket->setLength(12);
 
-    params.x.clear();
-    params.y.clear();
-    params.x.reserve(numEntries);
-    params.y.reserve(numEntries);
-    //params.x.fill(0, numEntries);
-    //params.y.fill(0, numEntries);
+        // add text label for this value table entry
+        QCPItemText *valueText = new QCPItemText(ui->graphingView);
+        valueText->position->setParentAnchor(bracket->center);
+        valueText->position->setCoords(0, -10.0); // move 10 pixels to the top from bracket center anchor
+        valueText->setPositionAlignment(Qt::AlignBottom|Qt::AlignHCenter);
+        valueText->setText(params.prevValStr);
+        valueText->setFont(QFont(font().family(), 10));
+        params.prevValLocation = QPointF(params.x.last(), params.y.last());
+        params.lastBracket = bracket;
+    }
 
-    int sBit = params.startBit;
-    int bits = params.numBits;
-    bool intelFormat = params.intelFormat;
-    bool isSigned = params.isSigned;
+    const bool setupScale = build.setupScale;
+    const bool rescaleValues = build.rescaleValues;
+    const int frameCount = build.frameCount;
+    build.builder.clear();
 
-    for (int j = 0; j < numEntries; j++)
+    //frames that arrived during the build skipped this graph
+    for (int i = frameCount; i < modelFrames->count(); i++)
     {
-        int k = j * params.stride;
-        if (params.associatedSignal)
-        {
-            //skip all the rest of the stuff in this loop and don't add this to the graph if this signal isn't in this frame
-            if (!params.associatedSignal->isSignalInMessage(frameCache[k]))
-            {
-                qDebug() << "Signal was not in this frame";
-                continue;
-            }
-            else qDebug() << "Signal in the frame!";
-        }
-        tempVal = Utility::processIntegerSignal(frameCache[k].payload(), sBit, bits, intelFormat, isSigned); //& params.mask;
-        //qDebug() << tempVal;
-        y = (tempVal * params.scale) + params.bias;
-        params.y.append( y );
+        const CANFrame &thisFrame = modelFrames->at(i);
+        if (thisFrame.frameId() == params.ID && (params.bus == -1 || params.bus == thisFrame.bus))
+            appendToGraph(params, thisFrame);
+    }
 
-        if (Utility::timeStyle == TS_SECONDS)
-        {
-            x = (frameCache[k].timeStamp().microSeconds()) / 1000000.0;
-        }
-        else if (Utility::timeStyle == TS_CLOCK)
+    params.ref->setName(params.graphName);
+    params.pyramid.update(params.x, params.y);
+    if (setupScale || rescaleValues) fitViewToGraph(params, setupScale);
+    updateGraphView(params);
+    return true;
+}
+
+/* bracket the runs of equal value table entries, the same way appendToGraph does for live frames */
+void GraphingWindow::addBuiltSamples(GraphParams &params, const GraphColumns &cols)
+{
+    GraphBuildState &build = params.build;
+    QString tempStr;
+
+    for (int i = 0; i < cols.x.count(); i++)
+    {
+        const double x = cols.x[i];
+        const double y = cols.y[i];
+        const int64_t tempVal = cols.raw[i];
+
+        if (!build.haveRange)
         {
-            QDateTime dt = QDateTime::fromMSecsSinceEpoch((frameCache[k].timeStamp().microSeconds() / 1000) - params.xbias);
-            x = (dt.time().msecsSinceStartOfDay() / 1000.0);
+            build.keyRange = QCPRange(x, x);
+            build.valueRange = QCPRange(y, y);
+            build.haveRange = true;
         }
         else
         {
-            x = frameCache[k].timeStamp().microSeconds();
+            build.keyRange.expand(x);
+            build.valueRange.expand(y);
         }
 
-        params.x.append( x );
-
-        if (params.associatedSignal && numEntries > 1)
+        if (params.associatedSignal && build.builder->getRowCount() > params.stride)
         {
-
             bool isValid = params.associatedSignal->getValueString(tempVal, tempStr);
             if (isValid)
             {
@@ -1441,34 +1655,23 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
                 params.prevValTable = tempVal;
             }
         }
-
-        if (y < yminval) yminval = y;
-        if (y > ymaxval) ymaxval = y;
-        if (x < xminval) xminval = x;
-        if (x > xmaxval) xmaxval = x;
     }
 
-    if (params.prevValLocation != QPointF(0,0))
-    {
-        QCPItemBracket *bracket = new QCPItemBracket(ui->graphingView);
-        bracket->left->setCoords(params.prevValLocation);
-        bracket->right->setCoords(x, params.prevValLocation.y());
-        bracket->setLength(12);
+    params.x += cols.x;
+    params.y += cols.y;
+}
 
-        // add text label for this value table entry
-        QCPItemText *valueText = new QCPItemText(ui->graphingView);
-        valueText->position->setParentAnchor(bracket->center);
-        valueText->position->setCoords(0, -10.0); // move 10 pixels to the top from bracket center anchor
-        valueText->setPositionAlignment(Qt::AlignBottom|Qt::AlignHCenter);
-        valueText->setText(params.prevValStr);
-        valueText->setFont(QFont(font().family(), 10));
-        params.prevValLocation = QPointF(x, y);
-        params.prevValStr = tempStr;
-        params.prevValTable = tempVal;
-        params.lastBracket = bracket;
+void GraphingWindow::fitViewToGraph(const GraphParams &params, bool setupKeys)
+{
+    double yminval, ymaxval, xminval, xmaxval;
+    if (params.build.haveRange)
+    {
+        xminval = params.build.keyRange.lower;
+        xmaxval = params.build.keyRange.upper;
+        yminval = params.build.valueRange.lower;
+        ymaxval = params.build.valueRange.upper;
     }
-
-    if (numEntries == 0)
+    else
     {
         yminval = -128.0;
         ymaxval = 128.0;
@@ -1476,52 +1679,6 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
         xmaxval = 100;
     }
 
-    params.xbias = 0;
-
-    ui->graphingView->addGraph();
-    params.ref = ui->graphingView->graph();
-    if (createGraphParam)
-    {
-        graphParams.append(params);
-        refParam = &graphParams.last();
-    }
-
-    selDecorator = new QCPSelectionDecorator(); //this has to be a pointer as it is freed internally to qcustomplot classes
-    selDecorator->setBrush(Qt::NoBrush);
-    selDecorator->setPen(selectedPen);
-    ui->graphingView->graph()->setSelectionDecorator(selDecorator);
-
-    if (params.graphName == nullptr || params.graphName.length() == 0)
-    {
-        params.graphName = QString("0x") + QString::number(params.ID, 16) + ":" + QString::number(params.startBit);
-        params.graphName += "-" + QString::number(params.numBits);
-    }
-    ui->graphingView->graph()->setName(params.graphName);
-    ui->graphingView->graph()->setProperty("id", params.ID);
-
-    ui->graphingView->graph()->setData(refParam->x,refParam->y);
-
-    ui->graphingView->graph()->setScatterStyle(QCPScatterStyle((QCPScatterStyle::ScatterShape)params.pointType));
-
-    if (params.drawOnlyPoints) ui->graphingView->graph()->setLineStyle(QCPGraph::lsNone); //Draw only the points, no connections, no fills
-    else
-    {
-        ui->graphingView->graph()->setLineStyle(QCPGraph::lsLine); //connect points with lines
-    }
-
-    QPen graphPen;
-    graphPen.setColor(params.lineColor);
-    graphPen.setWidth(params.lineWidth);
-    ui->graphingView->graph()->setPen(graphPen);
-    if (params.fillColor.alpha() > 0) //only if there is some opacity will we set up a fill brush
-    {
-        qDebug() << "Drawing filled graph";
-        QBrush fillBrush;
-        fillBrush.setColor(params.fillColor);
-        fillBrush.setStyle(Qt::SolidPattern);
-        ui->graphingView->graph()->setBrush(fillBrush);
-    }
-
     double xRange = (xmaxval - xminval);
     double yRange = (ymaxval - yminval);
     double xMid = xminval + (xRange / 2.0);
@@ -1538,16 +1695,45 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     qDebug() << "ymin: " << yminval;
     qDebug() << "ymax: " << ymaxval;
 
-    if (needScaleSetup)
+    if (setupKeys)
     {
-        needScaleSetup = false;
-        ui->graphingView->xAxis->setRange(xminval, xmaxval);        
+        ui->graphingView->xAxis->setRange(xminval, xmaxval);
         ui->graphingView->axisRect()->setupFullAxesBox();
     }
     //always recalculate Y range so that new graphs actually show up in view
     ui->graphingView->yAxis->setRange(yminval, ymaxval);
+}
 
-    ui->graphingView->replot();
+void GraphingWindow::collectBuilds()
+{
+    bool changed = false;
+    bool building = false;
+    for (int i = 0; i < graphParams.count(); i++)
+    {
+        if (collectGraph(graphParams[i])) changed = true;
+        if (graphParams[i].build.builder) building = true;
+    }
+    if (!building) buildTimer->stop();
+    if (changed) ui->graphingView->replot();
+}
+
+void GraphingWindow::stopSelectedGraphBuild()
+{
+    if (ui->graphingView->selectedGraphs().size() == 0) return;
+    for (int i = 0; i < graphParams.count(); i++)
+    {
+        if (graphParams[i].ref == ui->graphingView->selectedGraphs().constFirst() && graphParams[i].build.builder)
+            graphParams[i].build.builder->cancel(); //the next collect keeps what was decoded and finishes the graph
+    }
+}
+
+void GraphingWindow::cancelBuilds()
+{
+    for (int i = 0; i < graphParams.count(); i++)
+    {
+        if (graphParams[i].build.builder) graphParams[i].build.builder->cancel();
+        graphParams[i].build.builder.clear();
+    }
 }
 
 void GraphingWindow::moveLegend()
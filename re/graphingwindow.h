@@ -4,13 +4,29 @@
 #include "qcustomplot.h"
 #include "can_structs.h"
 #include "dbc/dbchandler.h"
+#include "graphpyramid.h"
+#include "graphbuilder.h"
 
 #include <QDialog>
+#include <QSharedPointer>
+#include <QTimer>
 
 namespace Ui {
 class GraphingWindow;
 }
 
+/* a graph whose frames are still being decoded in the background */
+struct GraphBuildState
+{
+    QSharedPointer<GraphBuilder> builder;   //null once the graph is complete
+    GraphDecodeSpec spec;
+    int frameCount = 0;         //frames in the capture when the build started. Later ones are added when it is done
+    bool setupScale = false;    //fit the x axis to the graph as it comes in
+    bool rescaleValues = false; //fit the y axis to the graph as it comes in
+    bool haveRange = false;
+    QCPRange keyRange, valueRange;
+};
+
 class GraphParams
 {
 public:
@@ -37,6 +53,8 @@ public:
 
     //the below stuff is used for internal purposes only - code should be refactored so these can be private
     QVector<double> x, y;
+    GraphPyramid pyramid; //min/max summary of x/y. The plot itself only gets what the visible range needs
+    GraphBuildState build;
     double xbias;
     int64_t prevValTable;
     QPointF prevValLocation;
@@ -80,13 +98,16 @@ private slots:
     void rescaleToData();
     void toggleFollowMode();
     void addNewGraph();    
-    void appendToGraph(GraphParams &params, CANFrame &frame, QVector<double> &x, QVector<double> &y);
+    void appendToGraph(GraphParams &params, const CANFrame &frame);
     void editSelectedGraph();
     void updatedFrames(int);
     void gotCenterTimeID(uint32_t ID, double timestamp);
     void resetView();
     void zoomIn();
     void zoomOut();
+    void xRangeChanged(const QCPRange &range);
+    void collectBuilds();
+    void stopSelectedGraphBuild();
 
 signals:
     void sendCenterTimeID(uint32_t ID, double timestamp);
@@ -94,9 +115,9 @@ signals:
 private:
     Ui::GraphingWindow *ui;
     DBCHandler *dbcHandler;
-    QList<CANFrame> frameCache;
     const QVector<CANFrame> *modelFrames;
     QList<GraphParams> graphParams;
+    QHash<quint64, QVector<int>> graphRoutes; //(bus, ID) -> indexes into graphParams. Bus -1 takes every bus
     QPen selectedPen;
     QCPSelectionDecorator *selDecorator;
     QCPItemText *locationText;
@@ -104,8 +125,16 @@ private:
     bool needScaleSetup; //do we need to set x,y graphing extents?
     bool useOpenGL;
     bool followGraphEnd;
+    QTimer *buildTimer;
 
     void showParamsDialog(int idx);
+    void updateGraphView(GraphParams &params);
+    void rebuildGraphRoutes();
+    bool collectGraph(GraphParams &params);
+    void addBuiltSamples(GraphParams &params, const GraphColumns &cols);
+    void fitViewToGraph(const GraphParams &params, bool setupKeys);
+    void cancelBuilds();
+    void resizeEvent(QResizeEvent *event);
     void closeEvent(QCloseEvent *event);
     void readSettings();
     void writeSettings();
@@ -0,0 +1,120 @@
+#include <algorithm>
+
+#include "graphpyramid.h"
+
+static inline int bucketSize(int level)
+{
+    return 1 << (2 * (level + 1)); //GRAPH_PYRAMID_FANOUT ^ (level + 1)
+}
+
+GraphPyramid::GraphPyramid()
+{
+    numSamples = 0;
+}
+
+void GraphPyramid::clear()
+{
+    for (int L = 0; L < GRAPH_PYRAMID_LEVELS; L++) levels[L].clear();
+    numSamples = 0;
+}
+
+int GraphPyramid::getSampleCount() const
+{
+    return numSamples;
+}
+
+void GraphPyramid::update(const QVector<double>& x, const QVector<double>& y)
+{
+    const int count = qMin(x.count(), y.count());
+    const double *vals = y.constData();
+
+    for (int i = numSamples; i < count; i++)
+    {
+        for (int L = 0; L < GRAPH_PYRAMID_LEVELS; L++)
+        {
+            const int b = i / bucketSize(L);
+            if (b == levels[L].count())
+            {
+                levels[L].append(Bucket{i, i});
+                continue;
+            }
+            Bucket &bucket = levels[L][b];
+            if (vals[i] < vals[bucket.minIdx]) bucket.minIdx = i;
+            if (vals[i] > vals[bucket.maxIdx]) bucket.maxIdx = i;
+        }
+    }
+    if (count > numSamples) numSamples = count;
+}
+
+/*
+ * The coarsest level that still gives no more than maxBuckets buckets is picked. The range is then
+ * walked in whole buckets as large as their alignment allows, which only leaves a few finer buckets
+ * and raw samples at the two ends.
+ */
+void GraphPyramid::emitRange(const QVector<double>& x, const QVector<double>& y, int begin, int end, int maxBuckets,
+                             QVector<double>& outX, QVector<double>& outY) const
+{
+    if (begin >= end) return;
+
+    int topLevel = -1;
+    while (topLevel + 1 < GRAPH_PYRAMID_LEVELS && (end - begin) / (topLevel < 0 ? 1 : bucketSize(topLevel)) > maxBuckets)
+        topLevel++;
+
+    int idx = begin;
+    while (idx < end)
+    {
+        int L = topLevel;
+        while (L >= 0 && ((idx % bucketSize(L)) != 0 || idx + bucketSize(L) > end)) L--;
+        if (L < 0)
+        {
+            outX.append(x[idx]);
+            outY.append(y[idx]);
+            idx++;
+            continue;
+        }
+
+        const Bucket &bucket = levels[L][idx / bucketSize(L)];
+        const int first = qMin(bucket.minIdx, bucket.maxIdx);
+        const int second = qMax(bucket.minIdx, bucket.maxIdx);
+        outX.append(x[first]);
+        outY.append(y[first]);
+        if (second != first)
+        {
+            outX.append(x[second]);
+            outY.append(y[second]);
+        }
+        idx += bucketSize(L);
+    }
+}
+
+void GraphPyramid::query(const QVector<double>& x, const QVector<double>& y, double lo, double hi, int maxBuckets,
+                         QVector<double>& outX, QVector<double>& outY) const
+{
+    outX.clear();
+    outY.clear();
+    const int n = qMin(numSamples, qMin(x.count(), y.count()));
+    if (n == 0) return;
+
+    //one sample past each edge so the lines run out of the visible range
+    const double *keys = x.constData();
+    int first = std::lower_bound(keys, keys + n, lo) - keys;
+    int last = std::upper_bound(keys, keys + n, hi) - keys;
+    if (first > 0) first--;
+    if (last < n) last++;
+    if (last < first) last = first;
+
+    outX.reserve(2 * (maxBuckets + 2 * GRAPH_PYRAMID_OVERVIEW) + 64);
+    outY.reserve(2 * (maxBuckets + 2 * GRAPH_PYRAMID_OVERVIEW) + 64);
+
+    //the ends are always there so the key range of the output is that of the whole graph
+    outX.append(x[0]);
+    outY.append(y[0]);
+    if (n == 1) return;
+    first = qBound(1, first, n - 1);
+    last = qBound(first, last, n - 1);
+    emitRange(x, y, 1, first, GRAPH_PYRAMID_OVERVIEW, outX, outY);
+    emitRange(x, y, first, last, qMax(1, maxBuckets), outX, outY);
+    emitRange(x, y, last, n - 1, GRAPH_PYRAMID_OVERVIEW, outX, outY);
+    outX.append(x[n - 1]);
+    outY.append(y[n - 1]);
+}
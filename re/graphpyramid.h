@@ -0,0 +1,60 @@
+#ifndef GRAPHPYRAMID_H
+#define GRAPHPYRAMID_H
+
+#include <QVector>
+
+/* samples per bucket grow by this much from one level to the next */
+#define GRAPH_PYRAMID_FANOUT    4
+/* buckets of the top level hold 4^12 (about 16 million) samples */
+#define GRAPH_PYRAMID_LEVELS    12
+/* buckets used for the parts of a graph outside of the visible range */
+#define GRAPH_PYRAMID_OVERVIEW  64
+
+/*
+  Multi resolution min/max summary of one graph so only about as many points as there are pixels are
+  handed to the plot no matter how long the capture is.
+
+  Level L splits the samples into buckets of 4^(L+1) and keeps which sample was the lowest and which the
+  highest in each. Drawing those two for every bucket keeps every spike visible. New samples update the last
+  bucket of each level, so keeping the pyramid current costs a few compares per sample.
+
+  The samples themselves stay in the graph's x/y vectors. They are passed in on every call and have to be
+  sorted by key, which samples in capture order are.
+*/
+class GraphPyramid
+{
+public:
+    GraphPyramid();
+
+    void clear();
+
+    /* takes in the samples appended to x/y since the last call */
+    void update(const QVector<double>& x, const QVector<double>& y);
+
+    /**
+     * @brief points to plot for the key range lo to hi
+     * @param maxBuckets - upper limit on min/max pairs inside the range. Full resolution is used once the range holds no more samples than this
+     *
+     * The rest of the graph is added as a coarse outline. It still holds the extremes, so the key and value
+     * ranges of the output are those of the whole graph and rescaling to the data still works.
+     */
+    void query(const QVector<double>& x, const QVector<double>& y, double lo, double hi, int maxBuckets,
+               QVector<double>& outX, QVector<double>& outY) const;
+
+    int getSampleCount() const;
+
+private:
+    struct Bucket
+    {
+        int minIdx;
+        int maxIdx;
+    };
+
+    void emitRange(const QVector<double>& x, const QVector<double>& y, int begin, int end, int maxBuckets,
+                   QVector<double>& outX, QVector<double>& outY) const;
+
+    QVector<Bucket> levels[GRAPH_PYRAMID_LEVELS];
+    int numSamples;
+};
+
+#endif // GRAPHPYRAMID_H
@@ -0,0 +1,270 @@
+#include <QtAlgorithms>
+#include <cstdlib>
+
+#include "rangesignalsearch.h"
+#include "utility.h"
+
+RangeSignalSearch::RangeSignalSearch()
+{
+    numFrames = 0;
+    numWords = 0;
+    numPlanes = 0;
+    firstLen = 0;
+    minLen = 0;
+    maxLen = 0;
+    frameID = 0;
+}
+
+RangeSignalSearch::RangeSignalSearch(const QVector<CANFrame>& frames) : RangeSignalSearch()
+{
+    numFrames = frames.count();
+    if (numFrames == 0) return;
+
+    numWords = (numFrames + 63) / 64;
+    frameID = frames.at(0).frameId();
+    firstLen = frames.at(0).payload().length();
+    minLen = firstLen;
+    foreach (const CANFrame& frame, frames)
+    {
+        minLen = qMin(minLen, frame.payload().length());
+        maxLen = qMax(maxLen, frame.payload().length());
+    }
+    numPlanes = qMin(maxLen * 8, RANGE_SEARCH_MAX_BITS);
+
+    planes.fill(0, numPlanes * numWords);
+    lenAtLeast.fill(0, (maxLen + 1) * numWords);
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        const QByteArray payload = frames.at(i).payload();
+        const unsigned char *data = (const unsigned char *)payload.constData();
+        const int len = payload.length();
+        const int word = i / 64;
+        const quint64 frameBit = 1ULL << (i % 64);
+
+        for (int l = 0; l <= len; l++) lenAtLeast[l * numWords + word] |= frameBit;
+
+        for (int c = 0; c < qMin(len, numPlanes / 8); c++)
+        {
+            unsigned char byte = data[c];
+            while (byte)
+            {
+                int b = qCountTrailingZeroBits(byte);
+                planes[(c * 8 + b) * numWords + word] |= frameBit;
+                byte &= byte - 1;
+            }
+        }
+    }
+
+    //frames that aren't there in the last word don't count as set or clear
+    const quint64 lastMask = (numFrames % 64) ? ((1ULL << (numFrames % 64)) - 1) : ~0ULL;
+    bitVaries.fill(false, numPlanes);
+    for (int b = 0; b < numPlanes; b++)
+    {
+        bool anySet = false, anyClear = false;
+        for (int w = 0; w < numWords; w++)
+        {
+            const quint64 mask = (w == numWords - 1) ? lastMask : ~0ULL;
+            const quint64 word = planes[b * numWords + w] & mask;
+            if (word) anySet = true;
+            if (word != mask) anyClear = true;
+        }
+        bitVaries[b] = anySet && anyClear;
+    }
+}
+
+int RangeSignalSearch::getFrameCount() const
+{
+    return numFrames;
+}
+
+uint32_t RangeSignalSearch::getID() const
+{
+    return frameID;
+}
+
+QVector<RangeSignalCandidate> RangeSignalSearch::makeCandidates(int minSig, int maxSig, int granularity, int sigType, int signedType) const
+{
+    QVector<RangeSignalCandidate> cands;
+    const int maxBits = firstLen * 8;
+    if (granularity < 1) return cands;
+
+    for (int sigSize = maxSig; sigSize >= minSig; sigSize -= granularity)
+    {
+        for (int startBit = 0; startBit < maxBits; startBit += granularity)
+        {
+            //have to try both types even with 8 bit and smaller signals
+            //because they could cross byte boundaries.
+            if (sigType & 1)
+            {
+                if (signedType & 1) cands.append({startBit, sigSize, true, true});
+                if (signedType & 2) cands.append({startBit, sigSize, true, false});
+            }
+            if (sigType & 2)
+            {
+                if (signedType & 1) cands.append({startBit, sigSize, false, true});
+                if (signedType & 2) cands.append({startBit, sigSize, false, false});
+            }
+        }
+    }
+    return cands;
+}
+
+int64_t RangeSignalSearch::requiredRange(int bitLength, bool isSigned, int sensitivity)
+{
+    double lerpPoint = ((double)sensitivity - 10.0) / 240.0;
+    int64_t maxRange = isSigned?(1<<(bitLength - 1)):(1 << bitLength);
+    //at highest sensitivity require signal to at least range 20% of max range
+    //at lowest  sensitivity require signal to at least range 1%  of max range
+    return Utility::Lerp(maxRange * 0.01, maxRange * 0.2, lerpPoint);
+}
+
+bool RangeSignalSearch::evaluate(const RangeSignalCandidate& cand, int sensitivity) const
+{
+    if (numFrames == 0) return false;
+
+    const int bitLength = cand.bitLength;
+    int positions[64];
+    int weights[64];
+    int numBits = 0;
+
+    //walk the signal the same way processIntegerSignal does and note which bytes a frame needs to have
+    int needLen = (cand.startBit + bitLength) / 8;
+    int bit = cand.startBit;
+    for (int bitpos = 0; bitpos < bitLength && bitpos < 64; bitpos++)
+    {
+        if (bit < RANGE_SEARCH_MAX_BITS)
+        {
+            needLen = qMax(needLen, bit / 8 + 1);
+            positions[numBits] = bit;
+            weights[numBits] = cand.bigEndian ? (bitLength - bitpos - 1) : bitpos;
+            numBits++;
+        }
+        if (!cand.bigEndian) bit++;
+        else if ((bit % 8) == 0) bit += 15;
+        else bit--;
+    }
+
+    //frames shorter than needLen read as zero. If they all are then nothing ever changes
+    if (needLen > maxLen) return false;
+
+    const bool allValid = (needLen <= minLen);
+    if (allValid)
+    {
+        //the range can't be more than the weights of the bits that ever change. Sign bit excepted
+        quint64 bound = 0;
+        bool anyVaries = false, signVaries = false;
+        for (int k = 0; k < numBits; k++)
+        {
+            if (!bitVaries[positions[k]]) continue;
+            anyVaries = true;
+            if (cand.isSigned && weights[k] == bitLength - 1) signVaries = true;
+            else bound += 1ULL << weights[k];
+        }
+        if (!anyVaries) return false;
+        if (!signVaries && (int64_t)bound < requiredRange(bitLength, cand.isSigned, sensitivity)) return false;
+    }
+
+    QVector<int64_t> values(numFrames, 0);
+    uint64_t *vals = (uint64_t *)values.data();
+    const quint64 *valid = lenAtLeast.constData() + needLen * numWords;
+
+    for (int w = 0; w < numWords; w++)
+    {
+        uint64_t *out = vals + w * 64;
+        for (int k = 0; k < numBits; k++)
+        {
+            quint64 word = planes[positions[k] * numWords + w];
+            if (!allValid) word &= valid[w];
+            const uint64_t weight = 1ULL << weights[k];
+            while (word)
+            {
+                out[qCountTrailingZeroBits(word)] |= weight;
+                word &= word - 1;
+            }
+        }
+    }
+
+    if (cand.isSigned)
+    {
+        const uint64_t mask = 1ULL << (bitLength - 1);
+        const uint64_t signedMask = ~((1ULL << bitLength) - 1);
+        for (int i = 0; i < numFrames; i++)
+            if (vals[i] & mask) vals[i] |= signedMask;
+    }
+
+    return judgeValues(values.constData(), numFrames, bitLength, cand.isSigned, sensitivity);
+}
+
+bool RangeSignalSearch::evaluateReference(const QVector<CANFrame>& frames, const RangeSignalCandidate& cand, int sensitivity)
+{
+    QVector<int64_t> values;
+    values.reserve(frames.count());
+    foreach (const CANFrame& frame, frames)
+        values.append(Utility::processIntegerSignal(frame.payload(), cand.startBit, cand.bitLength, !cand.bigEndian, cand.isSigned));
+
+    return judgeValues(values.constData(), values.count(), cand.bitLength, cand.isSigned, sensitivity);
+}
+
+/*
+ * Given the values of the signal figure out whether this signal seems to be a smooth range signal.
+ * The intermediate values are kept as int like they always have been so the verdicts don't change.
+*/
+bool RangeSignalSearch::judgeValues(const int64_t *values, int numFrames, int bitLength, bool isSigned, int sensitivity)
+{
+    int64_t highestValue = -1000000000000LL;
+    int64_t lowestValue = 1000000000000LL;
+    double lerpPoint = ((double)sensitivity - 10.0) / 240.0;
+    int i;
+
+    for (i = 0; i < numFrames; i++)
+    {
+        if (values[i] < lowestValue) lowestValue = values[i];
+        if (values[i] > highestValue) highestValue = values[i];
+    }
+
+    if (lowestValue == highestValue) return false; //a signal that never changes is worthless and not a range signal
+
+    int64_t range = highestValue - lowestValue;
+    if (range < requiredRange(bitLength, isSigned, sensitivity))
+        return false; //doesn't range enough.
+
+    //now see if first order diffs seem to suggest a ramping sort of signal or not.
+    //for a first test lets let through any signal where the first order diff doesn't seem too large
+    int comparisonValue = Utility::Lerp((double)range * 0.55, 0, lerpPoint);
+    int maxOvers = Utility::Lerp(numFrames / 30.0, 2, lerpPoint);
+    int overValues = 0;
+    int prevScaled = (int)(values[0] - lowestValue);
+    for (i = 1; i < numFrames; i++)
+    {
+        int scaled = (int)(values[i] - lowestValue);
+        if (abs((int)((int64_t)prevScaled - scaled)) > comparisonValue)
+        {
+            if (++overValues > maxOvers) return false;
+        }
+        prevScaled = scaled;
+    }
+
+    //now look at the second order differentials. This is acceleration. There shouldn't be hard acceleration in values for a ranging signal
+    comparisonValue = Utility::Lerp((double)range * 0.20, 1, lerpPoint);
+    maxOvers = Utility::Lerp(8, 2, lerpPoint); //really clamp down on second order over limits
+    overValues = 0;
+    if (numFrames < 3) return true;
+    int s0 = (int)(values[0] - lowestValue);
+    int s1 = (int)(values[1] - lowestValue);
+    int prevDiff = (int)((int64_t)s0 - s1);
+    prevScaled = s1;
+    for (i = 2; i < numFrames; i++)
+    {
+        int scaled = (int)(values[i] - lowestValue);
+        int diff = (int)((int64_t)prevScaled - scaled);
+        if (abs((int)((int64_t)prevDiff - diff)) > comparisonValue)
+        {
+            if (++overValues > maxOvers) return false;
+        }
+        prevDiff = diff;
+        prevScaled = scaled;
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef RANGESIGNALSEARCH_H
+#define RANGESIGNALSEARCH_H
+
+#include <QVector>
+#include "can_structs.h"
+
+/* bits above this are never looked at, same as Utility::processIntegerSignal */
+#define RANGE_SEARCH_MAX_BITS   512
+
+struct RangeSignalCandidate
+{
+    int startBit;
+    int bitLength;
+    bool bigEndian;
+    bool isSigned;
+};
+
+/*
+  Search engine behind the range state window. It checks candidate signals of one ID for values that
+  ramp smoothly instead of jumping around.
+
+  The frames are transposed once into bit planes: plane b holds bit b of every frame, 64 frames to a word.
+  A candidate signal is then a list of planes plus the weight each one carries. Whole words of frames are
+  assembled at once, and candidates made only of bits that never change (or that can't span the required
+  range) are thrown out before any value is built at all. After construction the object is read only, so
+  evaluate() can be called for many candidates from as many threads as you like.
+
+  The verdict for every candidate is exactly what the old per frame Utility::processIntegerSignal
+  search produced, including its handling of frames too short for the signal. evaluateReference() is that
+  old search, kept so the two can be compared. Signal sizes up to 32 bits are supported, which is what the
+  window allows.
+*/
+class RangeSignalSearch
+{
+public:
+    RangeSignalSearch();
+    RangeSignalSearch(const QVector<CANFrame>& frames);
+
+    /**
+     * @brief build the list of candidates in the order the window has always shown them. Largest signals first
+     * @param minSig, maxSig - signal size range in bits
+     * @param granularity - step for both start bit and size
+     * @param sigType - 1 = big endian, 2 = little endian, 3 = both
+     * @param signedType - 1 = signed, 2 = unsigned, 3 = both
+     */
+    QVector<RangeSignalCandidate> makeCandidates(int minSig, int maxSig, int granularity, int sigType, int signedType) const;
+
+    /**
+     * @brief evaluate one candidate. Thread safe
+     * @param sensitivity - slider value from the window, 10 to 250
+     * @return true if the signal looks like a smooth range signal
+     */
+    bool evaluate(const RangeSignalCandidate& cand, int sensitivity) const;
+
+    /**
+     * @brief the original bit by bit search over the frames, for comparison
+     */
+    static bool evaluateReference(const QVector<CANFrame>& frames, const RangeSignalCandidate& cand, int sensitivity);
+
+    int getFrameCount() const;
+    uint32_t getID() const;
+
+private:
+    /* decides on the extracted values. Shared by both evaluate paths so they can't drift apart */
+    static bool judgeValues(const int64_t *values, int numFrames, int bitLength, bool isSigned, int sensitivity);
+    static int64_t requiredRange(int bitLength, bool isSigned, int sensitivity);
+
+    int numFrames;
+    int numWords;       //64 frames per word
+    int numPlanes;      //bits actually present in the longest frame
+    int firstLen;       //payload length of the first frame. Candidates start inside it
+    int minLen;
+    int maxLen;
+    uint32_t frameID;
+    QVector<quint64> planes;        //numPlanes x numWords
+    QVector<quint64> lenAtLeast;    //(maxLen + 1) x numWords, frames with at least that many bytes
+    QVector<bool> bitVaries;        //per plane, whether the bit is not the same in every frame
+};
+
+#endif // RANGESIGNALSEARCH_H
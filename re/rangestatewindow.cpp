@@ -5,6 +5,10 @@
 #include "helpwindow.h"
 #include "filterutility.h"
 
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentMap>
+
 RangeStateWindow::RangeStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::RangeStateWindow)
@@ -191,205 +195,109 @@ void RangeStateWindow::refreshFilterList()
 void RangeStateWindow::recalcButton()
 {
     QMap<int, bool>::iterator iter;
-    uint32_t id;
+    QVector<RangeSignalSearch> searches;
+    QVector<RangeSearchJob> jobs;
 
     ui->listCandidates->clear();
     foundSignals.clear();
     ui->graphSignal->clearGraphs();
 
-    QProgressDialog progress(qApp->activeWindow());
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setLabelText("Calculating");
-    progress.setCancelButton(0);
-    progress.setRange(0,0);
-    progress.setMinimumDuration(0);
-    progress.show();
-
-
-
-    for (iter = idFilters.begin(); iter != idFilters.end(); ++iter)
-    {
-        if (iter.value() == true)
-        {
-            qDebug() << "Processing for ID: " << iter.key();
-            //so, we're supposed to process this frame ID. We'll need to create a frame cache for it
-            frameCache.clear();
-            frameCache.reserve(modelFrames->count()); //block allocate more than enough space
-            id = iter.key();
-            for (int j = 0; j < modelFrames->count(); j++)
-            {
-                if (modelFrames->at(j).frameId() == id) frameCache.append(modelFrames->at(j));
-            }
-            //now we've got a list with all the same ID. Time to send it off for processing
-            signalsFactory();
-        }
-    }
-
-    progress.cancel();
-    qDebug() << "Found " << foundSignals.count() << " signals total.";
-}
-
-/*
- * Uses the settings exposed to the user to generate a set of candidate signals that should be checked.
- * The user could specify signal sizes, granularity, endian type and we generate all the permutations from there
- * Should process from max to min and stop when a valid signal is found (at least as an option) to declutter a bit.
- * Mostly what we're interested in is the largest signal that matches
-*/
-void RangeStateWindow::signalsFactory()
-{
     int minSig = ui->spinMinSigSize->value();
     int maxSig = ui->spinMaxSigSize->value();
     int granularity = ui->spinGranularity->value();
     int sigType = ui->cbSignalMode->currentIndex() + 1;
     int signedType = ui->cbSignedMode->currentIndex() + 1;
-    int maxBits = frameCache.at(0).payload().length() * 8;
     int sens = ui->slideSensitivity->value();
 
-    for (int sigSize = maxSig; sigSize >= minSig; sigSize -= granularity)
+    //one search per checked ID, then every candidate of every ID goes in one list for the thread pool
+    for (iter = idFilters.begin(); iter != idFilters.end(); ++iter)
     {
-        qApp->processEvents();
-        for (int startBit = 0; startBit < maxBits; startBit += granularity)
+        if (iter.value() == true)
         {
-            if (sigType & 1)
-            {
-                if (signedType & 1) processSignal(startBit, sigSize, sens, true, true);
-                if (signedType & 2) processSignal(startBit, sigSize, sens, true, false);
-            }
-            if (sigType & 2)
+            loadFrameCache(iter.key());
+            if (frameCache.isEmpty()) continue;
+            searches.append(RangeSignalSearch(frameCache));
+            foreach (const RangeSignalCandidate &cand, searches.last().makeCandidates(minSig, maxSig, granularity, sigType, signedType))
             {
-                if (signedType & 1) processSignal(startBit, sigSize, sens, false, true);
-                if (signedType & 2) processSignal(startBit, sigSize, sens, false, false);
+                RangeSearchJob job;
+                job.search = searches.count() - 1;
+                job.cand = cand;
+                job.isGood = false;
+                jobs.append(job);
             }
-            //have to try both types even with 8 bit and smaller signals
-            //because they could cross byte boundaries. Could check whether they
-            //do and not try both types if it is impossible.
         }
     }
-}
-
-/*
- * Given the signal we generate the relevant data and figure out whether this signal seems to be a smooth range signal
-*/
-bool RangeStateWindow::processSignal(int startBit, int bitLength, int sensitivity, bool bigEndian, bool isSigned)
-{
-    qDebug() << "";
-    qDebug() << "S:" << startBit << " B:" << bitLength << " Sens:" << sensitivity << " Big E:" << bigEndian << " Signed: " << isSigned;
-
-    QVector<int> scaledVals;
-    QVector<int> diff1;
-    QVector<int> diff2;
-    int64_t valu;
-    int64_t highestValue = -1000000000000LL;
-    int64_t lowestValue = 1000000000000LL;
-    double lerpPoint = ((double)sensitivity - 10.0) / 240.0;
-    int numFrames = frameCache.count();
+    frameCache.clear();
 
-    scaledVals.reserve(frameCache.count());
-    diff1.reserve(frameCache.count() - 1);
-    diff2.reserve(frameCache.count() - 2);
+    QProgressDialog progress(qApp->activeWindow());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setLabelText("Calculating");
+    progress.setRange(0, jobs.count());
+    progress.setMinimumDuration(0);
 
-    int i;
+    QEventLoop loop;
+    QFutureWatcher<void> watcher;
+    connect(&watcher, &QFutureWatcher<void>::progressValueChanged, &progress, &QProgressDialog::setValue);
+    connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+    connect(&progress, &QProgressDialog::canceled, &watcher, &QFutureWatcher<void>::cancel);
 
-    for (i = 0; i < numFrames; i++)
+    const QVector<RangeSignalSearch> &searchRef = searches;
+    watcher.setFuture(QtConcurrent::map(jobs, [&searchRef, sens](RangeSearchJob &job)
+    {
+        job.isGood = searchRef[job.search].evaluate(job.cand, sens);
+    }));
+    if (!watcher.isFinished()) loop.exec();
+    watcher.waitForFinished();
+    progress.reset();
+
+    //candidates that never ran when the search was canceled are still false so whatever was found is shown
+    foreach (const RangeSearchJob &job, jobs)
     {
-        valu = Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !bigEndian, isSigned);
-        if (valu < lowestValue) lowestValue = valu;
-        if (valu > highestValue) highestValue = valu;
+        if (job.isGood) addFoundSignal(searches[job.search].getID(), job.cand);
     }
+}
 
-    qDebug() << "Min: " << lowestValue << " Max: " << highestValue;
-
-    if (lowestValue == highestValue) return false; //a signal that never changes is worthless and not a range signal
-
-    int64_t range = highestValue - lowestValue;
-
-    int64_t maxRange = isSigned?(1<<(bitLength - 1)):(1 << bitLength);
-    //at highest sensitivity require signal to at least range 20% of max range
-    //at lowest  sensitivity require signal to at least range 1%  of max range
-    int64_t requiredRange = Utility::Lerp(maxRange * 0.01, maxRange * 0.2, lerpPoint);
-    if (range < requiredRange)
-        return false; //doesn't range enough.
+//fill frameCache with every frame of one ID, straight from the model's per ID row lists
+void RangeStateWindow::loadFrameCache(uint32_t id)
+{
+    const QVector<int> rows = MainWindow::getReference()->getCANFrameModel()->getRowsForID(id, modelFrames);
 
-    for (i = 0; i < numFrames; i++)
-        scaledVals.append((int)((Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !bigEndian, isSigned) - lowestValue)));
+    frameCache.clear();
+    frameCache.reserve(rows.count());
+    foreach (int row, rows) frameCache.append(modelFrames->at(row));
+}
 
-    for (i = 1; i < numFrames; i++)
+void RangeStateWindow::addFoundSignal(uint32_t id, const RangeSignalCandidate &cand)
+{
+    QString temp;
+    temp = "ID: " + QString::number(id, 16) + " startBit: " + QString::number(cand.startBit) + "  len: " + QString::number(cand.bitLength);
+    int64_t foundSig;
+    foundSig = id;
+    foundSig += (int64_t)cand.startBit << 32;
+    foundSig += (int64_t)cand.bitLength << 40;
+
+    if (cand.isSigned)
     {
-        valu = scaledVals[i-1] - scaledVals[i];
-        diff1.append(valu);
+        temp += " Signed";
+        foundSig += (int64_t)1 << 48;
     }
-
-    for (i = 1; i < diff1.count(); i++)
+    else
     {
-        valu = diff1[i-1] - diff1[i];
-        diff2.append(valu);
+        temp += " Unsigned";
     }
 
-    //now the differences are all stored so let's go through and see if first order diffs seem to suggest a ramping sort of signal or not.
-    //for a first test lets let through any signal where the first order diff doesn't seem too large
-    bool isGood = true;
-    int comparisonValue = Utility::Lerp((double)range * 0.55, 0, lerpPoint);
-    qDebug() << " 1st Delta comparisonvalue: " << comparisonValue;
-    int overValues = 0;
-    for (i = 0; i < diff1.count(); i++)
+    if (cand.bigEndian)
     {
-        if (abs(diff1[i]) > comparisonValue) overValues++;
+        temp += " BigEndian";
+        foundSig += (int64_t)1 << 49;
     }
-    int maxOvers = Utility::Lerp(numFrames / 30.0, 2, lerpPoint);
-    qDebug() << "1st order overages: " << overValues << "   Max Overs: " << maxOvers;
-    if (overValues > maxOvers) isGood = false;
-
-    if (isGood)
+    else
     {
-        //now look at the second order differentials. This is acceleration. There shouldn't be hard acceleration in values for a ranging signal
-        comparisonValue = Utility::Lerp((double)range * 0.20, 1, lerpPoint);
-        maxOvers = Utility::Lerp(8, 2, lerpPoint); //really clamp down on second order over limits
-        qDebug() << "2nd Delta comparisonvalue: " << comparisonValue;
-        overValues = 0;
-        for (i = 0; i < diff2.count(); i++)
-        {
-            if (abs(diff2[i]) > comparisonValue) overValues++;
-        }
-        if (overValues > maxOvers) isGood = false;
-        qDebug() << "2nd order overages: " << overValues << "   Max Overs: " << maxOvers;
-        if (overValues > maxOvers) isGood = false;
+        temp += " LittleEndian";
     }
 
-    qDebug() << "Is this signal good: " << isGood << " Num overs: " << overValues;
-    if (isGood)
-    {
-        //createGraph(scaledVals);
-        QString temp;
-        temp = "ID: " + QString::number(frameCache.at(0).frameId(), 16) + " startBit: " + QString::number(startBit) + "  len: " + QString::number(bitLength);
-        int64_t foundSig;
-        foundSig = frameCache.at(0).frameId();
-        foundSig += (int64_t)startBit << 32;
-        foundSig += (int64_t)bitLength << 40;
-
-        if (isSigned)
-        {
-            temp += " Signed";
-            foundSig += (int64_t)1 << 48;
-        }
-        else
-        {
-            temp += " Unsigned";
-        }
-
-        if (bigEndian)
-        {
-            temp += " BigEndian";
-            foundSig += (int64_t)1 << 49;
-        }
-        else
-        {
-            temp += " LittleEndian";
-        }
-
-        ui->listCandidates->addItem(temp);
-        foundSignals.append(foundSig);
-    }
-    return isGood;
+    ui->listCandidates->addItem(temp);
+    foundSignals.append(foundSig);
 }
 
 //graphs the vector such that the X axis is just the index into the vector and Y is perfectly graphed within the window
@@ -464,13 +372,7 @@ void RangeStateWindow::clickedSignalList(int idx)
 
     qDebug() << "I:" << id << " sb:" << startBit << " len:" << bitLength << " signed:" << isSigned << " big:" << isBigEndian;
 
-    frameCache.clear();
-    frameCache.reserve(modelFrames->count()); //block allocate more than enough space
-
-    for (int j = 0; j < modelFrames->count(); j++)
-    {
-        if (modelFrames->at(j).frameId() == id) frameCache.append(modelFrames->at(j));
-    }
+    loadFrameCache(id);
 
     int numFrames = frameCache.count();
     QVector<int> values;
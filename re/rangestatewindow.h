@@ -4,11 +4,19 @@
 #include <QDialog>
 #include <QMap>
 #include "can_structs.h"
+#include "rangesignalsearch.h"
 
 namespace Ui {
 class RangeStateWindow;
 }
 
+struct RangeSearchJob
+{
+    int search;     //index into the searches built for this run
+    RangeSignalCandidate cand;
+    bool isGood;
+};
+
 class RangeStateWindow : public QDialog
 {
     Q_OBJECT
@@ -34,8 +42,8 @@ private:
     void closeEvent(QCloseEvent *event);
     void readSettings();
     void writeSettings();
-    void signalsFactory();
-    bool processSignal(int startBit, int bitLength, int sensitivity, bool bigEndian, bool isSigned);
+    void loadFrameCache(uint32_t id);
+    void addFoundSignal(uint32_t id, const RangeSignalCandidate &cand);
     void createGraph(QVector<int> values);
     bool eventFilter(QObject *obj, QEvent *event);
 };
@@ -0,0 +1,52 @@
+#include "signalvaluekey.h"
+#include "dbc/dbc_classes.h"
+
+SignalKeyLayout SignalValueKey::layoutSignal(const DBC_SIGNAL *sig)
+{
+    SignalKeyLayout layout;
+    layout.startBit = sig->startBit;
+    layout.intelByteOrder = sig->intelByteOrder;
+    layout.stringBytes = 0;
+    switch (sig->valType)
+    {
+    case STRING:
+        layout.keyBits = 0;
+        layout.stringBytes = sig->signalSize / 8;
+        break;
+    case SP_FLOAT:
+        layout.keyBits = 32;
+        break;
+    case DP_FLOAT:
+        layout.keyBits = 64;
+        break;
+    default:
+        layout.keyBits = qMin(sig->signalSize, 64);
+        break;
+    }
+    return layout;
+}
+
+QVector<SignalKeyLayout> SignalValueKey::layoutMessage(DBC_MESSAGE *msg)
+{
+    QVector<SignalKeyLayout> sigs;
+    if (!msg) return sigs;
+
+    int numSignals = msg->sigHandler->getCount();
+    for (int i = 0; i < numSignals; i++)
+    {
+        DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+        SignalKeyLayout sigLayout;
+        if (sig)
+        {
+            sigLayout = layoutSignal(sig);
+            if (sig->isMultiplexed && msg->multiplexorSignal)
+            {
+                for (DBC_SIGNAL *parent = sig->multiplexParent; parent; parent = parent->isMultiplexed ? parent->multiplexParent : nullptr)
+                    sigLayout.muxChain.append(layoutSignal(parent));
+            }
+        }
+        else sigLayout.keyBits = -1;
+        sigs.append(sigLayout);
+    }
+    return sigs;
+}
@@ -0,0 +1,59 @@
+#ifndef SIGNALVALUEKEY_H
+#define SIGNALVALUEKEY_H
+
+#include <QVector>
+#include <QByteArray>
+#include "can_structs.h"
+#include "utility.h"
+
+class DBC_MESSAGE;
+class DBC_SIGNAL;
+
+/* the parts of a frame one signal's decoded text depends on */
+struct SignalKeyLayout
+{
+    int startBit;
+    int keyBits;        //0 for string signals which use whole bytes, -1 if there is no signal at this index
+    int stringBytes;
+    bool intelByteOrder;
+    QVector<SignalKeyLayout> muxChain;  //multiplexors this signal depends on, nearest first
+};
+
+/*
+  Decoding signals to text isn't thread safe (the signals cache their last value) and it is slow. Code that
+  wants per value results from many frames can instead key the frames by the raw bits a signal's text is made
+  from, including the multiplexor values deciding whether the signal is present at all. Frames with the same
+  key decode to the same text, so only one frame per key has to be decoded later on in the GUI thread.
+
+  The layouts are built from the DBC in the GUI thread. key() only reads them and can run anywhere.
+*/
+class SignalValueKey
+{
+public:
+    /* one layout per signal index of the message */
+    static QVector<SignalKeyLayout> layoutMessage(DBC_MESSAGE *msg);
+    static SignalKeyLayout layoutSignal(const DBC_SIGNAL *sig);
+
+    static inline QByteArray key(const SignalKeyLayout& sig, const QByteArray& payload)
+    {
+        QByteArray key;
+        key.append((char)qMin(payload.length(), 255));
+
+        foreach (const SignalKeyLayout &mux, sig.muxChain)
+        {
+            int64_t val = Utility::processIntegerSignal(payload, mux.startBit, mux.keyBits, mux.intelByteOrder, false);
+            key.append((const char *)&val, sizeof(val));
+        }
+
+        if (sig.keyBits > 0)
+        {
+            int64_t val = Utility::processIntegerSignal(payload, sig.startBit, sig.keyBits, sig.intelByteOrder, false);
+            key.append((const char *)&val, sizeof(val));
+        }
+        else key.append(payload.mid(sig.startBit / 8, sig.stringBytes));
+
+        return key;
+    }
+};
+
+#endif // SIGNALVALUEKEY_H
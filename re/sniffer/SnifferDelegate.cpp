@@ -3,7 +3,8 @@
 #include <QApplication>
 #include <QDebug>
 #include "utility.h"
-#include "re/sniffer/snifferitem.h"
+#include "re/sniffer/sniffermodel.h"
+#include "re/sniffer/snifferwindow.h"
 
 SnifferDelegate::SnifferDelegate(QWidget *parent) : QItemDelegate(parent)
 {
@@ -43,17 +44,17 @@ void SnifferDelegate::paint(QPainter *painter, const QStyleOptionViewItem &optio
 {
     //qDebug() << "SnifferDelegate Paint Event";
 
-    if (index.column() < 3) //allow default handling of the first two columns
+    if (index.column() < tc::DATA_0) //allow default handling of the first three columns
     {
         QItemDelegate::paint(painter, option, index);
         return;
     }
 
-    if (index.column() > 10) return;
-
     int x;
-    SnifferItem *item = static_cast<SnifferItem*>(index.internalPointer());
-    int idx = index.column() - 3;
+    const SnifferItem *item = static_cast<const SnifferModel*>(index.model())->getItem(index);
+    if (!item) return;
+    int idx = index.column() - tc::DATA_0;
+    if (index.column() >= index.model()->columnCount() - 1) return; //filler column
     int val = item->getData(idx);
     int prevVal = item->getLastData(idx);
     int notchPattern = item->getNotchPattern(idx);
@@ -70,7 +71,7 @@ void SnifferDelegate::paint(QPainter *painter, const QStyleOptionViewItem &optio
     //qDebug() << "XSpan" << xSpan << " YSpan " << ySpan;
 
     int xSector = xSpan / 8;
-    int v = item->getSeqInterval(index.column() - 3) * 10;
+    int v = item->getSeqInterval(idx) * 10;
     if (v > 225) v = 225;
     if (v < 0) v = 0;
 
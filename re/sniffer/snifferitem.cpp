@@ -1,23 +1,38 @@
 #include <QVariant>
 #include <QDebug>
+#include <cstring>
 #include "snifferitem.h"
 
 
+SnifferItem::SnifferItem():
+    mID(0),
+    mBus(0),
+    mLastTime(0),
+    mCurrentTime(0),
+    mCurrSeqVal(0),
+    mChanged(false),
+    mStaleShown(false)
+{
+    memset(&mLast, 0, sizeof(mLast));
+    memset(&mCurrent, 0, sizeof(mCurrent));
+    memset(&mMarker, 0, sizeof(mMarker));
+    memset(&mLastMarker, 0, sizeof(mLastMarker));
+    memset(mNotch, 0, sizeof(mNotch));
+}
+
 SnifferItem::SnifferItem(const CANFrame& pFrame, quint32 seq):
-    mID(pFrame.frameId())
+    SnifferItem()
 {
+    mID = pFrame.frameId();
+    mBus = pFrame.bus;
+
     const unsigned char *data = reinterpret_cast<const unsigned char *>(pFrame.payload().constData());
-    int dataLen = pFrame.payload().length();
+    int dataLen = qMin(pFrame.payload().length(), SNIFFER_MAX_BYTES);
 
     for (int i = 0; i < dataLen; i++) {
-        mNotch[i] = 0;
-        mMarker.data[i] = 0;
-        mMarker.dataTimestamp[i] = 0;
-        if (i < dataLen) mCurrent.data[i] = data[i];
-        else mCurrent.data[i] = 0;
+        mCurrent.data[i] = data[i];
         mCurrent.dataTimestamp[i] = seq;
     }
-    mLastMarker = mMarker;
     mCurrent.len = dataLen;
 
     /* that's dirty */
@@ -36,12 +51,42 @@ quint64 SnifferItem::getId() const
     return mID;
 }
 
+int SnifferItem::getBus() const
+{
+    return mBus;
+}
+
+int SnifferItem::getLength() const
+{
+    return mCurrent.len;
+}
+
+bool SnifferItem::isChanged() const
+{
+    return mChanged;
+}
+
+void SnifferItem::setChanged(bool changed)
+{
+    mChanged = changed;
+}
+
+bool SnifferItem::isStaleShown() const
+{
+    return mStaleShown;
+}
+
+void SnifferItem::setStaleShown(bool stale)
+{
+    mStaleShown = stale;
+}
+
 float SnifferItem::getDelta() const
 {
     return ((float)(mCurrentTime-mLastTime))/1000000;
 }
 
-//Get a data byte by index 0-7 (but not more than the length of the actual frame)
+//Get a data byte by index (but not more than the length of the actual frame)
 int SnifferItem::getData(uchar i) const
 {
     return (i >= mCurrent.len) ? -1 : mCurrent.data[i];
@@ -67,7 +112,7 @@ quint32 SnifferItem::getSeqInterval(uchar i) const
     return mCurrSeqVal - getDataTimestamp(i);
 }
 
-//Return whether a given data byte (by index 0-7) has incremented, deincremented, or stayed the same
+//Return whether a given data byte (by index) has incremented, deincremented, or stayed the same
 //since the last message
 //The If checks first that we aren't past the actual data length
 // then checks whether lastMarker shows that some bits have changed in the previous 200ms cycle
@@ -118,7 +163,7 @@ void SnifferItem::update(const CANFrame& pFrame, quint32 timeSeq, bool mute)
     mCurrSeqVal = timeSeq;
 
     const unsigned char *data = reinterpret_cast<const unsigned char *>(pFrame.payload().constData());
-    int dataLen = pFrame.payload().length();
+    int dataLen = qMin(pFrame.payload().length(), SNIFFER_MAX_BYTES);
 
     /* copy new value */
     for (int i = 0; i < dataLen; i++)
@@ -139,19 +184,23 @@ void SnifferItem::update(const CANFrame& pFrame, quint32 timeSeq, bool mute)
     /* update marker */
     //We "OR" our stored marker with the changed bits.
     //this accumulates changed bits into the marker
-    for (int i = 0 ; i < 8; i++) mMarker.data[i] |= mLast.data[i] ^ mCurrent.data[i]; //XOR causes only changed bits to be 1's
+    for (int i = 0 ; i < qMax(mLast.len, dataLen); i++) mMarker.data[i] |= mLast.data[i] ^ mCurrent.data[i]; //XOR causes only changed bits to be 1's
     mMarker.len  |= mLast.len ^ mCurrent.len;
 
     /* restart timeout */
     mTime.restart();
+    mChanged = true;
+    mStaleShown = false;
 }
 
 //Called in refresh from the model. Interval about 200ms currently.
 //So, this means the marker only accumulates for 200ms then resets
 void SnifferItem::updateMarker()
 {
+    //the change colors come from the last marker so the row only needs a repaint if that differs
+    if (memcmp(mLastMarker.data, mMarker.data, sizeof(mMarker.data))) mChanged = true;
     mLastMarker = mMarker;
-    for (int i = 0; i < 8; i++) mMarker.data[i] = 0;
+    memset(mMarker.data, 0, sizeof(mMarker.data));
 }
 
 //Notch or un-notch this snifferitem / frame
@@ -159,9 +208,10 @@ void SnifferItem::notch(bool pNotch)
 {
     if(pNotch)
     {
-        for (int i = 0; i < 8; i++) mNotch[i] |= mLastMarker.data[i]; //add changed bits to notch value
+        for (int i = 0; i < SNIFFER_MAX_BYTES; i++) mNotch[i] |= mLastMarker.data[i]; //add changed bits to notch value
     }
 
     else
-        for (int i = 0; i < 8; i++) mNotch[i] = 0;
+        for (int i = 0; i < SNIFFER_MAX_BYTES; i++) mNotch[i] = 0;
+    mChanged = true;
 }
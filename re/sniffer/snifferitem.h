@@ -5,10 +5,13 @@
 #include <QElapsedTimer>
 #include "can_structs.h"
 
+/* CAN-FD frames are shown in full */
+#define SNIFFER_MAX_BYTES   64
+
 struct fstCan
 {
-    quint8 data[8];
-    quint32 dataTimestamp[8];
+    quint8 data[SNIFFER_MAX_BYTES];
+    quint32 dataTimestamp[SNIFFER_MAX_BYTES];
     int len;
 };
 
@@ -23,10 +26,13 @@ enum dc
 class SnifferItem
 {
 public:
+    SnifferItem();
     explicit SnifferItem(const CANFrame& pFrame, quint32 seq);
     virtual ~SnifferItem();
 
     quint64 getId() const;
+    int getBus() const;
+    int getLength() const;
     float getDelta() const;
     int getData(uchar i) const;
     quint8 getNotchPattern(uchar i) const;
@@ -39,16 +45,26 @@ public:
     void updateMarker();
     void notch(bool);
 
+    /* set whenever something shown for this item changed. The model clears it once the row was refreshed */
+    bool isChanged() const;
+    void setChanged(bool changed);
+    /* whether the row is currently drawn as timed out */
+    bool isStaleShown() const;
+    void setStaleShown(bool stale);
+
 private:
     quint32         mID;
+    int             mBus;
     struct fstCan   mLast;
     struct fstCan   mCurrent;
     struct fstCan   mLastMarker;
     struct fstCan   mMarker;
-    quint8          mNotch[8];
+    quint8          mNotch[SNIFFER_MAX_BYTES];
     quint64         mLastTime;
     quint64         mCurrentTime;
     quint64         mCurrSeqVal;
+    bool            mChanged;
+    bool            mStaleShown;
 
     QElapsedTimer   mTime;
 };
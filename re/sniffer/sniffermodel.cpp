@@ -1,12 +1,15 @@
 #include <QDebug>
 #include <Qt>
 #include <QApplication>
+#include <algorithm>
 #include "sniffermodel.h"
 #include "snifferwindow.h"
 #include "SnifferDelegate.h"
 
 SnifferModel::SnifferModel(QObject *parent)
     : QAbstractItemModel(parent),
+      mNumItems(0),
+      mDataColumns(8),
       mFilter(false),
       mNeverExpire(false),
       mFadeInactive(false),
@@ -20,13 +23,113 @@ SnifferModel::SnifferModel(QObject *parent)
         mDarkMode = false;
     }
     else mDarkMode = true;
+
+    mSlots.fill(Slot{0, -1}, 256);
 }
 
 SnifferModel::~SnifferModel()
 {
-    qDeleteAll(mMap);
-    mMap.clear();
-    mFilters.clear();
+}
+
+quint64 SnifferModel::makeKey(int bus, quint32 id)
+{
+    return ((quint64)(quint32)bus << 32) | id;
+}
+
+static inline int slotHome(quint64 key, int mask)
+{
+    //fibonacci hashing, the high bits of the product are well mixed even for IDs that count up
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+int SnifferModel::findItem(quint64 key) const
+{
+    const int mask = mSlots.count() - 1;
+    const Slot *slots = mSlots.constData();
+    for (int i = slotHome(key, mask); slots[i].item >= 0; i = (i + 1) & mask)
+    {
+        if (slots[i].key == key) return slots[i].item;
+    }
+    return -1;
+}
+
+void SnifferModel::insertSlot(quint64 key, int item)
+{
+    if ((mNumItems + 1) * 2 > mSlots.count())
+    {
+        QVector<Slot> old = mSlots;
+        mSlots.fill(Slot{0, -1}, old.count() * 2);
+        mNumItems = 0;
+        foreach (const Slot &slot, old)
+            if (slot.item >= 0) insertSlot(slot.key, slot.item);
+    }
+
+    const int mask = mSlots.count() - 1;
+    int i = slotHome(key, mask);
+    while (mSlots[i].item >= 0) i = (i + 1) & mask;
+    mSlots[i].key = key;
+    mSlots[i].item = item;
+    mNumItems++;
+}
+
+void SnifferModel::removeSlot(quint64 key)
+{
+    const int mask = mSlots.count() - 1;
+    int i = slotHome(key, mask);
+    while (mSlots[i].item >= 0 && mSlots[i].key != key) i = (i + 1) & mask;
+    if (mSlots[i].item < 0) return;
+
+    //shift the rest of the run back so no tombstones are needed
+    mSlots[i].item = -1;
+    for (int j = (i + 1) & mask; mSlots[j].item >= 0; j = (j + 1) & mask)
+    {
+        const int home = slotHome(mSlots[j].key, mask);
+        const bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) continue;
+        mSlots[i] = mSlots[j];
+        mSlots[j].item = -1;
+        i = j;
+    }
+    mNumItems--;
+}
+
+bool SnifferModel::lessThan(int a, int b) const
+{
+    const SnifferItem &itemA = mItems[a];
+    const SnifferItem &itemB = mItems[b];
+    if (itemA.getId() != itemB.getId()) return itemA.getId() < itemB.getId();
+    return itemA.getBus() < itemB.getBus();
+}
+
+int SnifferModel::findRow(const QVector<int>& rows, int item) const
+{
+    auto pos = std::lower_bound(rows.begin(), rows.end(), item, [this](int a, int b){ return lessThan(a, b); });
+    if (pos == rows.end() || *pos != item) return -1;
+    return pos - rows.begin();
+}
+
+bool SnifferModel::isVisible(const SnifferItem& item) const
+{
+    return !mFilter || mFilters.contains(item.getId());
+}
+
+const QVector<int>& SnifferModel::visibleRows() const
+{
+    return mFilter ? mVisible : mRows;
+}
+
+void SnifferModel::rebuildVisible()
+{
+    mVisible.clear();
+    if (!mFilter) return;
+    foreach (int item, mRows)
+        if (isVisible(mItems[item])) mVisible.append(item);
+}
+
+const SnifferItem* SnifferModel::getItem(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.internalId() >= (quintptr)mItems.count()) return nullptr;
+    return &mItems[(int)index.internalId()];
 }
 
 void SnifferModel::setExpireInterval(int newVal)
@@ -36,14 +139,14 @@ void SnifferModel::setExpireInterval(int newVal)
 
 int SnifferModel::columnCount(const QModelIndex &parent) const
 {
-    return parent.isValid() ? 0 : tc::LAST+1;
+    //data columns grow with the longest payload seen. The last column is an empty filler
+    return parent.isValid() ? 0 : tc::DATA_0 + mDataColumns + 1;
 }
 
 
 int SnifferModel::rowCount(const QModelIndex &parent) const
 {
-    const QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-    return parent.isValid() ? 0 : map.size();
+    return parent.isValid() ? 0 : visibleRows().count();
 }
 
 
@@ -52,10 +155,11 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
     if (!index.isValid())
         return QVariant();
 
-    SnifferItem *item = static_cast<SnifferItem*>(index.internalPointer());
-    if(!item) QVariant();
+    const SnifferItem *item = getItem(index);
+    if(!item) return QVariant();
 
     int col = index.column();
+    bool dataCol = (col >= tc::DATA_0 && col < tc::DATA_0 + mDataColumns);
 
     switch(role)
     {
@@ -69,11 +173,15 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
                     if (item->getDelta() == 0) return QString("0 hz");
                     return QString("%1 hz").arg(qRound(1.00 / item->getDelta()));
                 case tc::ID:
-                    return "0x" + QString("%1").arg(item->getId(), 5, 16, QLatin1Char('0')).toUpper();
+                {
+                    QString text = "0x" + QString("%1").arg(item->getId(), 5, 16, QLatin1Char('0')).toUpper();
+                    if (mBusItems.count() > 1) text += QString(" (%1)").arg(item->getBus());
+                    return text;
+                }
                 default:
                     break;
             }
-            if(tc::DATA_0<=col && col <=tc::DATA_7)
+            if(dataCol)
             {
                 int data = item->getData(col-tc::DATA_0);
                 if(data >= 0)
@@ -85,9 +193,8 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
         }
         case Qt::ForegroundRole:
         {
-            if (!mFadeInactive ||  col < 2) return QApplication::palette().brush(QPalette::Text);
-            int v = item->getSeqInterval(col - 2) * 10;
-            //qDebug() << "mTS: " << mTimeSequence << " gDT(" << (col - 2) << ") " << item->getDataTimestamp(col - 2);
+            if (!mFadeInactive || !dataCol) return QApplication::palette().brush(QPalette::Text);
+            int v = item->getSeqInterval(col - tc::DATA_0) * 10;
             if (v > 225) v = 225;
             if (v < 0) v = 0;
 
@@ -111,7 +218,7 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
                     return QBrush(QColor(128,0,0));
                 }
             }
-            else if(tc::DATA_0<=col && col<=tc::DATA_7)
+            else if(dataCol)
             {
                 dc change = item->dataChange(col-tc::DATA_0);
                 switch(change)
@@ -158,7 +265,7 @@ QVariant SnifferModel::headerData(int section, Qt::Orientation orientation, int
             default:
                 break;
         }
-        if(tc::DATA_0<=section && section <=tc::DATA_7)
+        if(tc::DATA_0<=section && section < tc::DATA_0 + mDataColumns)
             return QString::number(section-tc::DATA_0);
     }
 
@@ -171,17 +278,12 @@ QModelIndex SnifferModel::index(int row, int column, const QModelIndex &parent)
     if (parent.isValid())
         return QModelIndex();
 
-    const QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
+    const QVector<int>& rows = visibleRows();
 
-    if(column>tc::LAST || row>=map.size())
+    if(row < 0 || column < 0 || column >= columnCount() || row >= rows.count())
         return QModelIndex();
 
-    /* ugly but I can't find best without creating a list to keep indexes */
-    QMap<quint32, SnifferItem*>::const_iterator iter;
-    int i;
-    for(iter = map.begin(), i=0 ; i<row ; ++i, ++iter);
-
-    return createIndex(row, column, iter.value());
+    return createIndex(row, column, (quintptr)rows[row]);
 }
 
 
@@ -223,58 +325,117 @@ void SnifferModel::setMuteNotched(bool val)
 void SnifferModel::clear()
 {
     beginResetModel();
-    qDeleteAll(mMap);
-    mMap.clear();
+    mItems.clear();
+    mFreeItems.clear();
+    mSlots.fill(Slot{0, -1}, 256);
+    mNumItems = 0;
+    mRows.clear();
+    mVisible.clear();
     mFilters.clear();
+    mIDItems.clear();
+    mBusItems.clear();
     mFilter = false;
     endResetModel();
 }
 
 void SnifferModel::updateNotchPoint()
 {
-    QMap<quint32, SnifferItem*>::iterator i;
-
     /* update markers */
-    for (i = mMap.begin(); i != mMap.end(); ++i)
+    foreach (int item, mRows)
+        mItems[item].updateMarker();
+}
+
+//the ID column shows the bus only while more than one is around so every row changes with it
+static void markAllChanged(QVector<SnifferItem>& items, const QVector<int>& rows)
+{
+    foreach (int item, rows) items[item].setChanged(true);
+}
+
+void SnifferModel::removeItem(int idx)
+{
+    SnifferItem &item = mItems[idx];
+    const quint32 id = item.getId();
+    const int bus = item.getBus();
+
+    int row = findRow(mRows, idx);
+    if (!mFilter)
+    {
+        beginRemoveRows(QModelIndex(), row, row);
+        mRows.remove(row);
+        endRemoveRows();
+    }
+    else
+    {
+        int visibleRow = findRow(mVisible, idx);
+        mRows.remove(row);
+        if (visibleRow >= 0)
+        {
+            beginRemoveRows(QModelIndex(), visibleRow, visibleRow);
+            mVisible.remove(visibleRow);
+            endRemoveRows();
+        }
+    }
+
+    removeSlot(makeKey(bus, id));
+    item = SnifferItem();
+    mFreeItems.append(idx);
+
+    if (--mBusItems[bus] == 0)
+    {
+        mBusItems.remove(bus);
+        if (mBusItems.count() == 1) markAllChanged(mItems, mRows);
+    }
+    if (--mIDItems[id] == 0)
     {
-        i.value()->updateMarker();
+        mIDItems.remove(id);
+        mFilters.remove(id);
+        /* send notification */
+        emit idChange(id, false);
     }
 }
 
 //Called from window with a timer (currently 200ms)
 void SnifferModel::refresh()
 {
-    QMap<quint32, SnifferItem*>::iterator i;
-    QVector<quint32> toRemove;
-    SnifferItem* item;
+    QVector<int> toRemove;
 
     mTimeSequence++;
 
-    for (i = mMap.begin(); i != mMap.end(); ++i)
+    foreach (int idx, mRows)
     {
-        //i.value()->updateMarker();
-        if(i.value()->elapsed() > (int)mExpireInterval && !mNeverExpire)
-            toRemove.append(i.key());
+        SnifferItem &item = mItems[idx];
+        int elapsed = item.elapsed();
+        if(elapsed > (int)mExpireInterval && !mNeverExpire)
+            toRemove.append(idx);
+        else if (elapsed > 4000 && !item.isStaleShown())
+        {
+            //turns the ID red without a frame having come in
+            item.setStaleShown(true);
+            item.setChanged(true);
+        }
     }
 
-    if(toRemove.size())
+    foreach (int idx, toRemove) removeItem(idx);
+
+    /* refresh data, one notification per run of changed rows */
+    const QVector<int>& rows = visibleRows();
+    int lastColumn = columnCount() - 1;
+    int first = -1;
+    for (int row = 0; row <= rows.count(); row++)
     {
-        beginResetModel();
-        foreach(quint32 id, toRemove)
+        bool changed = (row < rows.count()) && mItems[rows[row]].isChanged();
+        if (changed)
+        {
+            mItems[rows[row]].setChanged(false);
+            if (first < 0) first = row;
+        }
+        else if (first >= 0)
         {
-            /* remove element */
-            item = mMap.take(id);
-            mFilters.remove(id);
-            delete item;
-            /* send notification */
-            emit idChange(id, false);
+            emit dataChanged(createIndex(first, 0, (quintptr)rows[first]),
+                             createIndex(row - 1, lastColumn, (quintptr)rows[row - 1]));
+            first = -1;
         }
-        endResetModel();
     }
-    else
-        /* refresh data */
-        emit dataChanged(createIndex(0, 0),
-                    createIndex(rowCount()-1, columnCount()-1), QVector<int>(Qt::DisplayRole));
 }
 
 
@@ -291,12 +452,16 @@ void SnifferModel::filter(fltType pType, int pId)
         case fltType::ADD:
             /* add filter to list */
             mFilter = true;
-            mFilters[pId] = mMap[pId];
+            mFilters.insert(pId);
             break;
         case fltType::REMOVE:
             /* remove filter */
             if(!mFilter)
-                mFilters = mMap;
+            {
+                mFilters.clear();
+                for (auto it = mIDItems.constBegin(); it != mIDItems.constEnd(); ++it)
+                    mFilters.insert(it.key());
+            }
             mFilter = true;
             mFilters.remove(pId);
             break;
@@ -306,6 +471,7 @@ void SnifferModel::filter(fltType pType, int pId)
             mFilters.clear();
             break;
     }
+    rebuildVisible();
     endResetModel();
 }
 
@@ -314,41 +480,76 @@ void SnifferModel::filter(fltType pType, int pId)
 /**********         slots       ****************/
 /***********************************************/
 
-void SnifferModel::update(CANConnection*, QVector<CANFrame>& pFrames)
+void SnifferModel::update(CANConnection*, const QVector<CANFrame>& pFrames)
 {
     foreach(const CANFrame& frame, pFrames)
     {
-        if(!mMap.contains(frame.frameId()))
+        /* longer payload than anything so far, add its columns first */
+        int len = qMin(frame.payload().length(), SNIFFER_MAX_BYTES);
+        if (len > mDataColumns)
         {
-            int index = std::distance(mMap.begin(), mMap.lowerBound(frame.frameId()));
-            /* add the frame */
-            beginInsertRows(QModelIndex(), index, index);
-            mMap[frame.frameId()] = new SnifferItem(frame, mTimeSequence);
-            mMap[frame.frameId()]->update(frame, mTimeSequence, mMuteNotched);
-            endInsertRows();
+            beginInsertColumns(QModelIndex(), tc::DATA_0 + mDataColumns, tc::DATA_0 + len - 1);
+            mDataColumns = len;
+            endInsertColumns();
+        }
+
+        quint64 key = makeKey(frame.bus, frame.frameId());
+        int idx = findItem(key);
+        if (idx >= 0)
+        {
+            //updateData
+            mItems[idx].update(frame, mTimeSequence, mMuteNotched);
+            continue;
+        }
 
-            emit idChange(frame.frameId(), true);
+        /* add the frame */
+        if (mFreeItems.isEmpty())
+        {
+            idx = mItems.count();
+            mItems.append(SnifferItem(frame, mTimeSequence));
         }
         else
-            //updateData
-            mMap[frame.frameId()]->update(frame, mTimeSequence, mMuteNotched);
+        {
+            idx = mFreeItems.takeLast();
+            mItems[idx] = SnifferItem(frame, mTimeSequence);
+        }
+        mItems[idx].update(frame, mTimeSequence, mMuteNotched);
+        insertSlot(key, idx);
+
+        auto pos = std::lower_bound(mRows.begin(), mRows.end(), idx, [this](int a, int b){ return lessThan(a, b); });
+        int row = pos - mRows.begin();
+        if (!mFilter)
+        {
+            beginInsertRows(QModelIndex(), row, row);
+            mRows.insert(row, idx);
+            endInsertRows();
+        }
+        else
+        {
+            mRows.insert(row, idx);
+            if (isVisible(mItems[idx]))
+            {
+                auto visiblePos = std::lower_bound(mVisible.begin(), mVisible.end(), idx, [this](int a, int b){ return lessThan(a, b); });
+                int visibleRow = visiblePos - mVisible.begin();
+                beginInsertRows(QModelIndex(), visibleRow, visibleRow);
+                mVisible.insert(visibleRow, idx);
+                endInsertRows();
+            }
+        }
+
+        if (mBusItems[frame.bus]++ == 0 && mBusItems.count() == 2) markAllChanged(mItems, mRows);
+        if (mIDItems[frame.frameId()]++ == 0) emit idChange(frame.frameId(), true);
     }
 }
 
 void SnifferModel::notch()
 {
-    QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    foreach(SnifferItem* item, map)
-        item->notch(true);
+    foreach(int item, visibleRows())
+        mItems[item].notch(true);
 }
 
 void SnifferModel::unNotch()
 {
-    QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    foreach(SnifferItem* item, map)
-        item->notch(false);
+    foreach(int item, visibleRows())
+        mItems[item].notch(false);
 }
-
-
@@ -5,6 +5,9 @@
 #include <QModelIndex>
 #include <QVariant>
 #include <QTimer>
+#include <QVector>
+#include <QHash>
+#include <QSet>
 
 #include "can_structs.h"
 #include "connections/canconnection.h"
@@ -19,6 +22,16 @@ enum fltType
     NONE
 };
 
+/*
+  The sniffer keeps one item per bus and ID. Items sit in one flat vector and are found through an open
+  addressing table keyed by bus and ID, so a frame costs a single probe in the common case. Slots of
+  expired items are reused, which keeps the index of an item fixed for as long as it lives. That index is
+  what the model indexes carry.
+
+  Rows are a separate index into the items, sorted by ID and then bus. A new item is placed with a binary
+  search and items flag themselves when something shown for them changes, so the periodic refresh only
+  reports the rows that really changed.
+*/
 class SnifferModel : public QAbstractItemModel
 {
     Q_OBJECT
@@ -48,10 +61,11 @@ public:
     void setMuteNotched(bool val);
     void setExpireInterval(int newVal);
     void updateNotchPoint();
+    const SnifferItem* getItem(const QModelIndex &index) const;
 
 
 public slots:
-    void update(CANConnection*, QVector<CANFrame>&);
+    void update(CANConnection*, const QVector<CANFrame>&);
     void notch();
     void unNotch();
 
@@ -59,8 +73,33 @@ signals:
     void idChange(int, bool);
 
 private:
-    QMap<quint32, SnifferItem*> mMap;
-    QMap<quint32, SnifferItem*> mFilters;
+    struct Slot
+    {
+        quint64 key;
+        int     item;   //-1 when empty
+    };
+
+    static quint64 makeKey(int bus, quint32 id);
+    int findItem(quint64 key) const;
+    void insertSlot(quint64 key, int item);
+    void removeSlot(quint64 key);
+    int findRow(const QVector<int>& rows, int item) const;
+    bool lessThan(int a, int b) const;
+    bool isVisible(const SnifferItem& item) const;
+    const QVector<int>& visibleRows() const;
+    void rebuildVisible();
+    void removeItem(int item);
+
+    QVector<SnifferItem>        mItems;
+    QVector<int>                mFreeItems;
+    QVector<Slot>               mSlots;     //size is a power of two, never more than half full
+    int                         mNumItems;
+    QVector<int>                mRows;      //every live item, sorted by ID then bus
+    QVector<int>                mVisible;   //the rows that pass the filter, only kept while filtering
+    QSet<quint32>               mFilters;
+    QHash<quint32, int>         mIDItems;   //items per ID, idChange is about IDs and not buses
+    QHash<int, int>             mBusItems;  //items per bus, the bus is only shown once there is more than one
+    int                         mDataColumns;
     bool                        mFilter;
     bool                        mNeverExpire;
     bool                        mFadeInactive;
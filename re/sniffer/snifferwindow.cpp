@@ -27,6 +27,15 @@ SnifferWindow::SnifferWindow(QWidget *parent) :
     ui->treeView->setColumnWidth(tc::LAST, 1);
     for(int i=tc::DATA_0 ; i<=tc::DATA_7 ; i++)
         ui->treeView->setColumnWidth(i, 92);
+    /* CAN-FD payloads add data columns in front of the filler */
+    connect(&mModel, &QAbstractItemModel::columnsInserted, this,
+            [this](const QModelIndex &, int first, int last)
+            {
+                for (int i = first; i <= last; i++)
+                    ui->treeView->setColumnWidth(i, 92);
+                ui->treeView->setColumnWidth(mModel.columnCount() - 1, 1);
+            }
+    );
     ui->treeView->setUniformRowHeights(true);
     ui->treeView->header()->setDefaultAlignment(Qt::AlignCenter);
     //ui->treeView->setItemDelegate(new SnifferDelegate());
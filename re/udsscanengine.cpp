@@ -0,0 +1,428 @@
+#include <QtMath>
+
+#include "udsscanengine.h"
+#include "bus_protocols/uds_handler.h"
+
+namespace
+{
+    /* how many values lower to upper in steps of increment gives */
+    inline qint64 rangeCount(qint64 lower, qint64 upper, qint64 increment)
+    {
+        if (upper < lower) return 0;
+        return (upper - lower) / qMax(increment, (qint64)1) + 1;
+    }
+
+    inline qint64 subfunctCount(const ScanEntry& entry)
+    {
+        return rangeCount(entry.subfunctLower, entry.subfunctUpper, entry.subfunctIncrement);
+    }
+}
+
+UDSScanEngine::UDSScanEngine()
+{
+    window = 1;
+    cursorEntry = 0;
+    cursorStep = 0;
+    totalRequests = 0;
+    completedRequests = 0;
+}
+
+qint64 UDSScanEngine::requestsPerTarget(const ScanEntry& entry)
+{
+    qint64 count = 0;
+    switch (entry.scanType)
+    {
+    case ST_TESTER_PRESENT:
+    case ST_COMM_CTRL:
+    case ST_CLEAR_DTC:
+    case ST_READ_DTC:
+        count = 1;
+        break;
+    case ST_SESS_CTRL:
+    case ST_ECU_RESET:
+        count = 3;
+        break;
+    case ST_SEC_ACCESS:
+        count = 0x21; //1, 3, 5 ... 0x41
+        break;
+    case ST_READ_ID:
+    case ST_READ_ADDR:
+    case ST_READ_SCALING:
+    case ST_IO_CTRL:
+    case ST_ROUTINE_CTRL:
+        count = subfunctCount(entry);
+        break;
+    case ST_CUSTOM:
+        count = rangeCount(entry.serviceLower, entry.serviceUpper, 1) * subfunctCount(entry);
+        break;
+    }
+    if (entry.sessType > 0) count++;
+    return count;
+}
+
+/*
+ * Same requests, in the same order, as the list the scan window used to build up front
+ */
+UDSScanRequest UDSScanEngine::makeRequest(const ScanEntry& entry, int entryIdx, uint32_t id, qint64 k)
+{
+    UDSScanRequest req;
+    req.id = id;
+    req.bus = entry.busToScan;
+    req.entry = entryIdx;
+    req.service = 0;
+    req.subFunc = 0;
+    req.subFuncLen = 1;
+
+    if (entry.sessType > 0)
+    {
+        if (k == 0)
+        {
+            req.service = UDS_SERVICES::DIAG_CONTROL;
+            req.subFunc = entry.sessType;
+            return req;
+        }
+        k--;
+    }
+
+    const qint64 increment = qMax((qint64)entry.subfunctIncrement, (qint64)1);
+    const int subf = (int)(entry.subfunctLower + k * increment);
+
+    switch (entry.scanType)
+    {
+    case ST_TESTER_PRESENT:
+        req.service = UDS_SERVICES::TESTER_PRESENT;
+        break;
+    case ST_SESS_CTRL:
+        req.service = UDS_SERVICES::DIAG_CONTROL;
+        req.subFunc = (int)k + 1;
+        break;
+    case ST_COMM_CTRL:
+        req.service = UDS_SERVICES::COMM_CTRL;
+        req.subFuncLen = 2; //need two bytes for this one
+        req.subFunc = 0x100; //00 01 on the bus = enable Rx/Tx
+        break;
+    case ST_ECU_RESET:
+        req.service = UDS_SERVICES::ECU_RESET;
+        req.subFunc = (int)k + 1;
+        break;
+    case ST_CLEAR_DTC:
+        req.service = UDS_SERVICES::CLEAR_DIAG;
+        req.subFuncLen = 3; //DTC groups are sent as 3 bytes
+        req.subFunc = 0xFFFFFF; //clear everything!
+        break;
+    case ST_READ_DTC:
+        req.service = UDS_SERVICES::READ_DTC;
+        req.subFuncLen = 2;
+        req.subFunc = 0x02FF; //get DTCs by mask (FF is the mask)
+        break;
+    case ST_SEC_ACCESS:
+        req.service = UDS_SERVICES::SECURITY_ACCESS;
+        req.subFunc = 1 + 2 * (int)k;
+        break;
+    case ST_READ_ID:
+        req.service = UDS_SERVICES::READ_BY_ID;
+        req.subFuncLen = entry.subfunctLen;
+        req.subFunc = subf;
+        break;
+    case ST_READ_ADDR:
+        req.service = UDS_SERVICES::READ_BY_ADDR;
+        req.subFuncLen = entry.subfunctLen;
+        req.subFunc = subf;
+        break;
+    case ST_READ_SCALING:
+        req.service = UDS_SERVICES::READ_SCALING_ID;
+        req.subFuncLen = 2;
+        req.subFunc = subf;
+        break;
+    case ST_IO_CTRL:
+        req.service = UDS_SERVICES::IO_CTRL;
+        req.subFuncLen = 3;
+        req.subFunc = subf; //the upper byte will be 0 which is what we want. 0 = Return control to ECU
+        break;
+    case ST_ROUTINE_CTRL:
+        //only ever ask for results. Starting or stopping arbitrary routines is dangerous
+        req.service = UDS_SERVICES::ROUTINE_CTRL;
+        req.subFuncLen = 3;
+        req.subFunc = (subf << 8) + 3;
+        break;
+    case ST_CUSTOM:
+    {
+        const qint64 perService = qMax(subfunctCount(entry), (qint64)1);
+        req.service = entry.serviceLower + (int)(k / perService);
+        req.subFuncLen = entry.subfunctLen;
+        req.subFunc = (int)(entry.subfunctLower + (k % perService) * increment);
+        break;
+    }
+    }
+    return req;
+}
+
+qint64 UDSScanEngine::planLength(const ScanEntry& entry)
+{
+    const qint64 ids = rangeCount(entry.startID, entry.endID, 1);
+    if (!entry.bAdaptiveOffset || ids <= UDSSCAN_ADAPTIVE_RANGE) return ids;
+    return ((ids + UDSSCAN_ADAPTIVE_RANGE - 1) / UDSSCAN_ADAPTIVE_RANGE) * UDSSCAN_ADAPTIVE_RANGE;
+}
+
+/*
+ * Plain entries go through their IDs in order. Adaptive ones are split into lanes a range wide and take
+ * one ID from each lane in turn so targets next to each other in the walk are a range apart.
+ */
+qint64 UDSScanEngine::planID(const ScanEntry& entry, qint64 k)
+{
+    const qint64 lanes = planLength(entry) / UDSSCAN_ADAPTIVE_RANGE;
+    if (!entry.bAdaptiveOffset || lanes <= 1) return entry.startID + k;
+    return entry.startID + (k % lanes) * UDSSCAN_ADAPTIVE_RANGE + k / lanes;
+}
+
+quint64 UDSScanEngine::targetKey(int bus, uint32_t id)
+{
+    return ((quint64)(quint32)bus << 32) | id;
+}
+
+bool UDSScanEngine::offsetKnown(const Target& target) const
+{
+    return !entries[target.entry].bAdaptiveOffset || learnedOffsets.contains(targetKey(target.request.bus, target.id));
+}
+
+/* whether two targets without a known offset could get the same reply ID */
+bool UDSScanEngine::rangesOverlap(const Target& a, const Target& b) const
+{
+    if (serialEntries.contains(a.entry) || serialEntries.contains(b.entry)) return true;
+    return qAbs((qint64)a.id - (qint64)b.id) < UDSSCAN_ADAPTIVE_RANGE;
+}
+
+void UDSScanEngine::start(const QVector<ScanEntry>& scanEntries, int windowSize, qint64 nowMs)
+{
+    Q_UNUSED(nowMs);
+    entries = scanEntries;
+    window = qMax(1, windowSize);
+    cursorEntry = 0;
+    cursorStep = 0;
+    active.clear();
+    latencies.clear();
+    learnedOffsets.clear();
+    serialEntries.clear();
+    completedRequests = 0;
+
+    totalRequests = 0;
+    foreach (const ScanEntry &entry, entries)
+        totalRequests += rangeCount(entry.startID, entry.endID, 1) * requestsPerTarget(entry);
+}
+
+void UDSScanEngine::stop()
+{
+    entries.clear();
+    active.clear();
+    cursorEntry = 0;
+}
+
+bool UDSScanEngine::isRunning() const
+{
+    return cursorEntry < entries.count() || !active.isEmpty();
+}
+
+qint64 UDSScanEngine::getTotalRequests() const
+{
+    return totalRequests;
+}
+
+qint64 UDSScanEngine::getCompletedRequests() const
+{
+    return completedRequests;
+}
+
+int UDSScanEngine::getTimeout(int entry, uint32_t id) const
+{
+    const ScanEntry &scan = entries[entry];
+    QHash<quint64, Latency>::const_iterator lat = latencies.constFind(targetKey(scan.busToScan, id));
+    if (lat == latencies.constEnd()) return scan.maxWaitTime;
+    const int rto = qCeil(lat->srtt + 4.0 * lat->rttvar) + UDSSCAN_TIMEOUT_MARGIN_MS;
+    return qMin(rto, (int)scan.maxWaitTime);
+}
+
+/* takes the next (entry, ID) off the plan. Returns false if there is none or it has to wait for a target on the same ID */
+bool UDSScanEngine::nextTarget(Target& target)
+{
+    while (cursorEntry < entries.count())
+    {
+        if (cursorStep >= planLength(entries[cursorEntry]))
+        {
+            cursorEntry++;
+            cursorStep = 0;
+        }
+        else if (planID(entries[cursorEntry], cursorStep) > entries[cursorEntry].endID) cursorStep++;
+        else break;
+    }
+    if (cursorEntry >= entries.count()) return false;
+
+    const ScanEntry &entry = entries[cursorEntry];
+    const qint64 id = planID(entry, cursorStep);
+    foreach (const Target &t, active)
+    {
+        if (t.id == id && entries[t.entry].busToScan == entry.busToScan) return false;
+    }
+
+    target.entry = cursorEntry;
+    target.id = (uint32_t)id;
+    target.nextRequest = 0;
+    target.numRequests = requestsPerTarget(entry);
+    target.waiting = false;
+    target.retry = false;
+    target.sentMs = 0;
+    target.deadlineMs = 0;
+    cursorStep++;
+    return true;
+}
+
+void UDSScanEngine::complete(int idx, UDSScanResult::Kind kind, uint32_t replyID, const QByteArray& data, QVector<UDSScanResult>& results)
+{
+    Target &target = active[idx];
+    UDSScanResult result;
+    result.request = target.request;
+    result.kind = kind;
+    result.replyID = replyID;
+    result.data = data;
+    results.append(result);
+    target.waiting = false;
+    target.retry = false;
+    completedRequests++;
+}
+
+void UDSScanEngine::poll(qint64 nowMs, QVector<UDSScanRequest>& toSend, QVector<UDSScanResult>& results)
+{
+    for (int i = 0; i < active.count(); i++)
+    {
+        if (!active[i].waiting || nowMs < active[i].deadlineMs) continue;
+        if (active[i].retry)
+        {
+            active[i].waiting = false;
+            active[i].retry = false;
+            active[i].nextRequest--;
+        }
+        else complete(i, UDSScanResult::NO_REPLY, 0, QByteArray(), results);
+    }
+
+    for (int i = active.count() - 1; i >= 0; i--)
+    {
+        if (!active[i].waiting && active[i].nextRequest >= active[i].numRequests) active.removeAt(i);
+    }
+
+    Target target;
+    while (active.count() < window && nextTarget(target))
+    {
+        if (target.numRequests > 0) active.append(target);
+    }
+
+    //replies to targets without a known offset are told apart by ID range, so only ones with their own range go out together
+    QVector<int> unknownWaiting;
+    for (int i = 0; i < active.count(); i++)
+    {
+        if (active[i].waiting && !offsetKnown(active[i])) unknownWaiting.append(i);
+    }
+
+    for (int i = 0; i < active.count(); i++)
+    {
+        Target &t = active[i];
+        if (t.waiting || t.nextRequest >= t.numRequests) continue;
+        t.request = makeRequest(entries[t.entry], t.entry, t.id, t.nextRequest);
+        if (!offsetKnown(t))
+        {
+            bool overlaps = false;
+            foreach (int other, unknownWaiting)
+            {
+                if (rangesOverlap(t, active[other])) overlaps = true;
+            }
+            if (overlaps) continue;
+            unknownWaiting.append(i);
+        }
+        t.nextRequest++;
+        t.waiting = true;
+        t.sentMs = nowMs;
+        t.deadlineMs = nowMs + getTimeout(t.entry, t.id);
+        toSend.append(t.request);
+    }
+}
+
+bool UDSScanEngine::gotReply(uint32_t replyID, int bus, int service, bool isErrorReply, const QByteArray& data,
+                             qint64 nowMs, QVector<UDSScanResult>& results)
+{
+    int match = -1;
+    QVector<int> guesses;   //waiting targets without a known offset
+    int inRange = -1;
+    for (int i = 0; i < active.count(); i++)
+    {
+        const Target &t = active[i];
+        if (!t.waiting) continue;
+        if (bus >= 0 && bus != t.request.bus) continue;
+        const bool serviceMatches = isErrorReply ? (service == t.request.service) : (service == 0x40 + t.request.service);
+        if (!serviceMatches) continue;
+
+        const ScanEntry &entry = entries[t.entry];
+        const quint64 key = targetKey(t.request.bus, t.id);
+        int offset = entry.idOffset;
+        if (entry.bAdaptiveOffset)
+        {
+            QHash<quint64, int>::const_iterator learned = learnedOffsets.constFind(key);
+            if (learned == learnedOffsets.constEnd())
+            {
+                const qint64 distance = (qint64)replyID - (qint64)t.id;
+                if (distance > 0 && distance <= UDSSCAN_ADAPTIVE_RANGE) inRange = i;
+                guesses.append(i);
+                continue;
+            }
+            offset = learned.value();
+        }
+        if (replyID == (uint32_t)(t.id + offset))
+        {
+            match = i;
+            break;
+        }
+    }
+
+    //poll keeps the ranges of waiting targets apart so at most one can hold the reply ID. Outside all of them
+    //only a lone guess is safe, otherwise the entries go one at a time and the guesses are asked again
+    if (match == -1 && !guesses.isEmpty())
+    {
+        if (inRange >= 0) match = inRange;
+        else if (guesses.count() == 1) match = guesses.first();
+        else
+        {
+            foreach (int i, guesses)
+            {
+                serialEntries.insert(active[i].entry);
+                active[i].retry = true;
+            }
+            return false;
+        }
+        learnedOffsets.insert(targetKey(active[match].request.bus, active[match].id), (int)(replyID - active[match].id));
+    }
+    if (match == -1) return false;
+
+    Target &target = active[match];
+    const ScanEntry &entry = entries[target.entry];
+
+    //the ECU will answer later. Only the deadline moves, the time until the real answer is the latency sample
+    if (isErrorReply && !data.isEmpty() && (quint8)data[0] == UDSSCAN_RESPONSE_PENDING)
+    {
+        target.deadlineMs = nowMs + entry.maxWaitTime;
+        return true;
+    }
+
+    Latency &lat = latencies[targetKey(target.request.bus, target.id)];
+    const double sample = nowMs - target.sentMs;
+    if (lat.samples == 0)
+    {
+        lat.srtt = sample;
+        lat.rttvar = sample / 2.0;
+    }
+    else
+    {
+        lat.rttvar = 0.75 * lat.rttvar + 0.25 * qAbs(lat.srtt - sample);
+        lat.srtt = 0.875 * lat.srtt + 0.125 * sample;
+    }
+    lat.samples++;
+
+    complete(match, isErrorReply ? UDSScanResult::NEGATIVE : UDSScanResult::POSITIVE, replyID, data, results);
+    return true;
+}
@@ -0,0 +1,181 @@
+#ifndef UDSSCANENGINE_H
+#define UDSSCANENGINE_H
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QByteArray>
+
+/* requests to targets that have answered before time out this long after their usual latency */
+#define UDSSCAN_TIMEOUT_MARGIN_MS   10
+/* NRC 0x78, the ECU got the request but needs more time */
+#define UDSSCAN_RESPONSE_PENDING    0x78
+/* with adaptive offset a reply is taken to come from at most this far above the request ID */
+#define UDSSCAN_ADAPTIVE_RANGE      0x40
+
+enum SCAN_TYPE
+{
+    ST_TESTER_PRESENT,
+    ST_SESS_CTRL,
+    ST_COMM_CTRL,
+    ST_ECU_RESET,
+    ST_CLEAR_DTC,
+    ST_READ_DTC,
+    ST_SEC_ACCESS,
+    ST_READ_ID,
+    ST_READ_ADDR,
+    ST_READ_SCALING,
+    ST_IO_CTRL,
+    ST_ROUTINE_CTRL,
+    ST_CUSTOM,
+};
+
+//stores the parameters for one scan
+class ScanEntry
+{
+public:
+    uint32_t startID, endID;
+    int32_t idOffset;
+    bool bAdaptiveOffset;
+    bool bShowNoReplies;
+    uint32_t busToScan;
+    uint32_t maxWaitTime; //in milliseconds
+    SCAN_TYPE scanType;
+    uint32_t sessType;
+    uint32_t subfunctLen;
+    qint64 subfunctLower;
+    qint64 subfunctUpper;
+    uint32_t subfunctIncrement;
+    uint32_t serviceLower;
+    uint32_t serviceUpper;
+};
+
+/* one UDS request of a scan */
+struct UDSScanRequest
+{
+    uint32_t id;
+    int bus;
+    int service;
+    int subFunc;
+    int subFuncLen;
+    int entry;          //index of the scan entry it belongs to
+};
+
+struct UDSScanResult
+{
+    enum Kind
+    {
+        POSITIVE,
+        NEGATIVE,
+        NO_REPLY
+    };
+
+    UDSScanRequest request;
+    Kind kind;
+    uint32_t replyID;
+    QByteArray data;    //reply payload after the service byte
+};
+
+/*
+  Runs the UDS scans of the scan window with more than one request on the bus at a time.
+
+  Each ID of each scan entry is a target that gets its requests one after the other, same order as
+  they always went out. Up to window targets are worked on at once, never two with the same bus and ID.
+  Requests aren't built up front: the plan for a target is just its entry and ID and request k is worked
+  out when it is due, so even a scan of every sub function of every service costs no memory.
+
+  Replies are matched to the outstanding request by their ID (request ID plus the entry's reply offset)
+  and service. With adaptive offset the first reply to a target teaches the offset. Until then a target owns
+  the reply IDs up to UDSSCAN_ADAPTIVE_RANGE above its own and only targets whose ranges don't overlap have
+  requests out together. Adaptive entries are walked a range apart (start, start + range, ... then start + 1
+  and so on) so the window still fills. A reply outside every range can't be placed if more than one of those
+  targets is waiting. The entry then drops back to one at a time and the requests it could have answered are
+  sent again. The latency of every reply is tracked per target like TCP does its round trip time, and targets
+  that have answered before get a timeout of their smoothed latency plus four deviations instead of the
+  entry's maximum wait. Response pending replies only push the deadline out, they aren't a latency sample.
+
+  No timers or buses in here. The caller hands in the time and does the sending, which is what lets the
+  engine be driven against a simulated ECU in the tests.
+*/
+class UDSScanEngine
+{
+public:
+    UDSScanEngine();
+
+    void start(const QVector<ScanEntry>& entries, int window, qint64 nowMs);
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * @brief expires overdue requests and hands out the next ones to send
+     * @param toSend - appended with the requests to go out now
+     * @param results - appended with the requests that timed out
+     */
+    void poll(qint64 nowMs, QVector<UDSScanRequest>& toSend, QVector<UDSScanResult>& results);
+
+    /**
+     * @brief offer a UDS reply
+     * @param bus - bus it came in on, -1 if unknown
+     * @param service - service byte of the reply, 0x40 + request service if positive
+     * @param data - the reply after the service byte. For a negative reply data[0] is the response code
+     * @return true if it answered an outstanding request
+     */
+    bool gotReply(uint32_t replyID, int bus, int service, bool isErrorReply, const QByteArray& data,
+                  qint64 nowMs, QVector<UDSScanResult>& results);
+
+    qint64 getTotalRequests() const;
+    qint64 getCompletedRequests() const;
+
+    /* timeout a request to this target gets right now */
+    int getTimeout(int entry, uint32_t id) const;
+
+    /* number of requests the scan entry sends to each of its IDs */
+    static qint64 requestsPerTarget(const ScanEntry& entry);
+    /* request k of the sequence an entry sends to one ID */
+    static UDSScanRequest makeRequest(const ScanEntry& entry, int entryIdx, uint32_t id, qint64 k);
+
+    /* number of steps in the walk over an entry's IDs, some of them past endID when it is adaptive */
+    static qint64 planLength(const ScanEntry& entry);
+    /* ID at step k of that walk */
+    static qint64 planID(const ScanEntry& entry, qint64 k);
+
+private:
+    struct Target
+    {
+        int entry;
+        uint32_t id;
+        qint64 nextRequest;
+        qint64 numRequests;
+        bool waiting;
+        bool retry;         //an unplaceable reply may have been for this request, send it again instead of timing out
+        UDSScanRequest request;
+        qint64 sentMs;
+        qint64 deadlineMs;
+    };
+
+    struct Latency
+    {
+        double srtt = 0;
+        double rttvar = 0;
+        int samples = 0;
+    };
+
+    static quint64 targetKey(int bus, uint32_t id);
+    bool offsetKnown(const Target& target) const;
+    bool rangesOverlap(const Target& a, const Target& b) const;
+    bool nextTarget(Target& target);
+    void complete(int idx, UDSScanResult::Kind kind, uint32_t replyID, const QByteArray& data, QVector<UDSScanResult>& results);
+
+    QVector<ScanEntry> entries;
+    int window;
+    int cursorEntry;            //next target to start
+    qint64 cursorStep;          //step of planID within that entry
+    QVector<Target> active;
+    QHash<quint64, Latency> latencies;
+    QHash<quint64, int> learnedOffsets;
+    QSet<int> serialEntries;    //adaptive entries that had a reply no range could place
+    qint64 totalRequests;
+    qint64 completedRequests;
+};
+
+#endif // UDSSCANENGINE_H
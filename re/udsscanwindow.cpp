@@ -6,6 +6,8 @@
 #include "utility.h"
 #include "helpwindow.h"
 
+#include <climits>
+
 
 static QVector<QString> SCANTYPE_NAMES = {
     QString("Tester Present"),
@@ -34,8 +36,9 @@ UDSScanWindow::UDSScanWindow(const QVector<CANFrame> *frames, QWidget *parent) :
 
     currentlyRunning = false;
 
-    waitTimer = new QTimer;
-    waitTimer->setInterval(100);
+    //requests go out and time out from here. Replies also push the scan along straight away
+    scanTimer = new QTimer;
+    scanTimer->setInterval(5);
 
     udsHandler = new UDS_HANDLER;
     inhibitUpdates = false;
@@ -52,7 +55,7 @@ UDSScanWindow::UDSScanWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     connect(udsHandler, &UDS_HANDLER::newUDSMessage, this, &UDSScanWindow::gotUDSReply);
     connect(ui->btnScanAll, &QPushButton::clicked, this, &UDSScanWindow::scanAll);
     connect(ui->btnScanSelected, &QPushButton::clicked, this, &UDSScanWindow::scanSelected);
-    connect(waitTimer, &QTimer::timeout, this, &UDSScanWindow::timeOut);
+    connect(scanTimer, &QTimer::timeout, this, &UDSScanWindow::pollScan);
     connect(ui->btnSaveResults, &QPushButton::clicked, this, &UDSScanWindow::saveResults);
     connect(ui->cbScanType, &QComboBox::currentTextChanged, this, &UDSScanWindow::changedScanType);
     connect(ui->cbAllowAdaptiveOffset, &QCheckBox::toggled, this, &UDSScanWindow::adaptiveToggled);
@@ -93,8 +96,8 @@ UDSScanWindow::~UDSScanWindow()
 {
     removeEventFilter(this);
     delete ui;
-    waitTimer->stop();
-    delete waitTimer;
+    scanTimer->stop();
+    delete scanTimer;
     delete udsHandler;
 }
 
@@ -562,60 +565,50 @@ void UDSScanWindow::dumpNode(QTreeWidgetItem* item, QFile *file, int indent)
     if (indent == 1) file->write("\n");
 }
 
-void UDSScanWindow::sendOnBuses(UDS_MESSAGE test, int buses)
-{
-    test.bus = buses;
-    sendingFrames.append(test);
-}
-
 void UDSScanWindow::scanAll()
 {
-    sendingFrames.clear();
-    for (int i = 0; i < scanEntries.count(); i++)
-    {
-        setupScan(i);
-    }
-    startScan();
+    startScan(scanEntries);
 }
 
 void UDSScanWindow::scanSelected()
 {
-    sendingFrames.clear();
     int idx = ui->listScansToRun->currentRow();
     if (idx < 0) return;
-    setupScan(idx);
-    startScan();
+    startScan(QVector<ScanEntry>(1, scanEntries[idx]));
 }
 
-void UDSScanWindow::startScan()
+void UDSScanWindow::startScan(const QVector<ScanEntry> &entries)
 {
-    if (sendingFrames.isEmpty()) return;
+    scanClock.start();
+    scanEngine.start(entries, ui->spinParallel->value(), scanClock.elapsed());
+    if (scanEngine.getTotalRequests() == 0)
+    {
+        scanEngine.stop();
+        return;
+    }
 
     udsHandler->setReception(true);
     udsHandler->setProcessAllIDs(true);
     udsHandler->setFlowCtrl(true);
 
-    waitTimer->setInterval(ui->spinDelay->value());
-
     ui->treeResults->clear();
+    idNodes.clear();
     nodeService = nullptr;
-    nodeID = nullptr;
     nodeSubFunc = nullptr;
 
-    waitTimer->start();
-    currIdx = -1;
     currentlyRunning = true;
     //ui->btnScan->setText("Abort Scan");
     ui->progressBar->setValue(0);
-    ui->progressBar->setMaximum(sendingFrames.length());
-    qDebug() << "Number of operations: " << sendingFrames.length();
-    sendNextMsg();
+    ui->progressBar->setMaximum((int)qMin(scanEngine.getTotalRequests(), (qint64)INT_MAX));
+    qDebug() << "Number of operations: " << scanEngine.getTotalRequests();
+    scanTimer->start();
+    pollScan();
 }
 
 void UDSScanWindow::stopScan()
 {
-    waitTimer->stop();
-    sendingFrames.clear();
+    scanTimer->stop();
+    scanEngine.stop();
     udsHandler->setReception(false);
     udsHandler->setProcessAllIDs(false);
     udsHandler->setFlowCtrl(false);
@@ -623,148 +616,6 @@ void UDSScanWindow::stopScan()
     //ui->btnScan->setText("Start Scan");
 }
 
-void UDSScanWindow::setupScan(int idx)
-{
-    UDS_MESSAGE test;
-
-    qDebug() << "Generating scan id: " << idx;
-
-    for (uint32_t id = scanEntries[idx].startID; id <= scanEntries[idx].endID; id++)
-    {
-        test.setFrameId( id );
-
-        if (scanEntries[idx].sessType > 0)
-        {
-            test.payload().clear();
-            test.service = UDS_SERVICES::DIAG_CONTROL;
-            test.subFuncLen = 1;
-            test.subFunc = scanEntries[ idx].sessType;
-            sendOnBuses(test, scanEntries[idx].busToScan);
-        }
-
-        test.payload().clear();
-
-        qDebug() << "Generating scan on ID " << QString::number(id, 16) << " of type " << scanEntries[idx].scanType;
-
-        switch (scanEntries[idx].scanType)
-        {
-        case ST_TESTER_PRESENT:
-            test.service = UDS_SERVICES::TESTER_PRESENT;
-            test.subFuncLen = 1;
-            test.subFunc = 0;
-            sendOnBuses(test, scanEntries[idx].busToScan);
-            break;
-        case ST_SESS_CTRL:
-            for (int typ = 1; typ < 4; typ++) //try each type of session access
-            {
-                test.service = UDS_SERVICES::DIAG_CONTROL;
-                test.subFuncLen = 1;
-                test.subFunc = typ;
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_COMM_CTRL:
-            test.service = UDS_SERVICES::COMM_CTRL;
-            test.subFuncLen = 2; //need two bytes for this one
-            test.subFunc = 0x100; //00 01 on the bus = enable Rx/Tx
-            sendOnBuses(test, scanEntries[idx].busToScan);
-            break;
-        case ST_ECU_RESET:
-            for (int typ = 1; typ < 4; typ++) //try each type of session access
-            {
-                test.service = UDS_SERVICES::ECU_RESET;
-                test.subFuncLen = 1;
-                test.subFunc = typ;
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_CLEAR_DTC:
-            test.service = UDS_SERVICES::CLEAR_DIAG;
-            test.subFuncLen = 3; //DTC groups are sent as 3 bytes
-            test.subFunc = 0xFFFFFF; //clear everything!
-            sendOnBuses(test, scanEntries[idx].busToScan);
-            break;
-        case ST_READ_DTC:
-            test.service = UDS_SERVICES::READ_DTC;
-            test.subFuncLen = 2;
-            test.subFunc = 0x02FF; //get DTCs by mask (FF is the mask)
-            sendOnBuses(test, scanEntries[idx].busToScan);
-            break;
-        case ST_SEC_ACCESS:
-            for (int typ = 1; typ < 0x42; typ = typ + 2) //try each type of session access. In practice only the first 1-3 are likely to work
-            {
-                test.service = UDS_SERVICES::SECURITY_ACCESS;
-                test.subFuncLen = 1;
-                test.subFunc = typ;
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_READ_ID:
-            test.subFuncLen = scanEntries[idx].subfunctLen;
-            test.service = UDS_SERVICES::READ_BY_ID;
-            for (int subf = scanEntries[idx].subfunctLower; subf <= scanEntries[idx].subfunctUpper; subf += scanEntries[idx].subfunctIncrement)
-            {
-                test.subFunc = subf;
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_READ_ADDR:
-            test.subFuncLen = scanEntries[idx].subfunctLen;
-            test.service = UDS_SERVICES::READ_BY_ADDR;
-            for (int subf = scanEntries[idx].subfunctLower; subf <= scanEntries[idx].subfunctUpper; subf += scanEntries[idx].subfunctIncrement)
-            {
-                test.subFunc = subf;
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_READ_SCALING:
-            //sub function should always be a length of 2 though. Should conform to this in the GUI
-            test.subFuncLen = 2;
-            test.service = UDS_SERVICES::READ_SCALING_ID;
-            for (int subf = scanEntries[idx].subfunctLower; subf <= scanEntries[idx].subfunctUpper; subf += scanEntries[idx].subfunctIncrement)
-            {
-                test.subFunc = subf;
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_IO_CTRL:
-            test.subFuncLen = 3;
-            test.service = UDS_SERVICES::IO_CTRL;
-            for (int subf = scanEntries[idx].subfunctLower; subf <= scanEntries[idx].subfunctUpper; subf += scanEntries[idx].subfunctIncrement)
-            {
-                test.subFunc = subf; //the upper byte will be 0 which is what we want. 0 = Return control to ECU
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_ROUTINE_CTRL:
-            test.subFuncLen = 3;
-            test.service = UDS_SERVICES::ROUTINE_CTRL;
-            for (int subf = scanEntries[idx].subfunctLower; subf <= scanEntries[idx].subfunctUpper; subf += scanEntries[idx].subfunctIncrement)
-            {
-                //request results of routine for all the addresses we're testing. This is the safest thing to do.
-                //starting or stopping arbitrary routines is super dangerous. Don't do that unless you really know
-                //what the hell you're doing or something really crazy might happen.
-                test.subFunc = (subf << 8) + 3;
-                sendOnBuses(test, scanEntries[idx].busToScan);
-            }
-            break;
-        case ST_CUSTOM:
-            test.subFuncLen = scanEntries[idx].subfunctLen;
-
-            for (uint32_t typ = scanEntries[idx].serviceLower; typ <= scanEntries[idx].serviceUpper; typ++)
-            {
-                test.service = typ;
-                for (int subTyp = scanEntries[idx].subfunctLower; subTyp <= scanEntries[idx].subfunctUpper; subTyp += scanEntries[idx].subfunctIncrement)
-                {
-                    test.subFunc = subTyp;
-                    sendOnBuses(test, scanEntries[idx].busToScan);
-                }
-            }
-            break;
-        }
-    }
-}
-
 //Updates here are sent about every 1/4 second. That's fine for most windows but not this one.
 void UDSScanWindow::updatedFrames(int numFrames)
 {
@@ -781,31 +632,30 @@ void UDSScanWindow::updatedFrames(int numFrames)
 
 void UDSScanWindow::gotUDSReply(UDS_MESSAGE msg)
 {
-    QString result;
-    QString serviceShortName;
-    uint32_t id;
-    int offset = ui->spinReplyOffset->value();
-    UDS_MESSAGE sentFrame;
-    bool gotReply = false;
-    const unsigned char *data = reinterpret_cast<const unsigned char *>(msg.payload().constData());
-    int dataLen = msg.payload().length();
-
-    int numSending = sendingFrames.length();
-    if (numSending == 0) return;
-    if (currIdx >= numSending) return;
-    sentFrame = sendingFrames[currIdx];
-
-    id = msg.frameId();
+    if (!currentlyRunning) return;
 
     qDebug() << "UDS message ID " << QString::number(msg.frameId(),16) << "  service: " << QString::number(msg.service, 16) << " subfunc: " << QString::number(msg.subFunc, 16);
 
-    if ((id == (uint32_t)(sentFrame.frameId() + offset)) || ui->cbAllowAdaptiveOffset->isChecked())
+    QVector<UDSScanResult> results;
+    if (scanEngine.gotReply(msg.frameId(), msg.bus, msg.service, msg.isErrorReply, msg.payload(), scanClock.elapsed(), results))
     {
-        serviceShortName = udsHandler->getServiceShortDesc(sentFrame.service);
-        if (serviceShortName.length() < 3) serviceShortName = QString::number(sentFrame.service, 16);
-        if (msg.service == (0x40 + sendingFrames[currIdx].service) )
+        showResults(results);
+        pollScan(); //that target can have its next request right away
+    }
+}
+
+void UDSScanWindow::showResults(const QVector<UDSScanResult> &results)
+{
+    foreach (const UDSScanResult &result, results)
+    {
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(result.data.constData());
+        const int dataLen = result.data.length();
+
+        switch (result.kind)
         {
-            setupNodes(id);
+        case UDSScanResult::POSITIVE:
+        {
+            setupNodes(result.request, result.replyID);
 
             QTreeWidgetItem *nodePositive = new QTreeWidgetItem();
             QString reply = "POSITIVE ";
@@ -818,42 +668,43 @@ void UDSScanWindow::gotUDSReply(UDS_MESSAGE msg)
             nodePositive->setForeground(0, QBrush(Qt::darkGreen));
             nodeSubFunc->addChild(nodePositive);
             nodeSubFunc->setForeground(0, QBrush(Qt::darkGreen));
-            gotReply = true;
+            break;
         }
-        else if ( msg.isErrorReply && (msg.service == sendingFrames[currIdx].service) )
+        case UDSScanResult::NEGATIVE:
         {
-            if (dataLen)
+            setupNodes(result.request, result.replyID);
+            QTreeWidgetItem *nodeNegative = new QTreeWidgetItem();
+            nodeNegative->setText(0, "NEGATIVE - " + (dataLen ? udsHandler->getNegativeResponseShort(data[0]) : QString()));
+            nodeNegative->setForeground(0, QBrush(Qt::darkRed));
+            nodeSubFunc->addChild(nodeNegative);
+            nodeSubFunc->setForeground(0, QBrush(Qt::darkRed));
+            break;
+        }
+        case UDSScanResult::NO_REPLY:
+            if (ui->ckShowNoReply->isChecked())
             {
-                setupNodes(id);
-                QTreeWidgetItem *nodeNegative = new QTreeWidgetItem();
-                qDebug() << ui->spinNumBytes->value();
-                nodeNegative->setText(0, "NEGATIVE - " + udsHandler->getNegativeResponseShort(data[0]));
-                nodeNegative->setForeground(0, QBrush(Qt::darkRed));
-                nodeSubFunc->addChild(nodeNegative);
-                nodeSubFunc->setForeground(0, QBrush(Qt::darkRed));
-                gotReply = true;
+                setupNodes(result.request, 0xDEAD5EA1);
+                nodeSubFunc->setForeground(0, QBrush(Qt::gray));
             }
+            break;
         }
     }
-    if (gotReply)
-    {
-        //ui->listResults->addItem(result);
-        sendNextMsg();
-    }
 }
 
-void UDSScanWindow::setupNodes(uint32_t replyID)
+void UDSScanWindow::setupNodes(const UDSScanRequest &sent, uint32_t replyID)
 {
-    QString serviceShortName = udsHandler->getServiceShortDesc(sendingFrames[currIdx].service);
-    if (serviceShortName.length() < 3) serviceShortName = QString::number(sendingFrames[currIdx].service, 16);
+    QString serviceShortName = udsHandler->getServiceShortDesc(sent.service);
+    if (serviceShortName.length() < 3) serviceShortName = QString::number(sent.service, 16);
     QTreeWidgetItem *replyNode = nullptr;
 
-    if (!nodeID || nodeID->text(0) != Utility::formatHexNum(sendingFrames[currIdx].frameId()))
+    //requests to several IDs are in flight at once so results don't arrive grouped by ID
+    QTreeWidgetItem *nodeID = idNodes.value(sent.id);
+    if (!nodeID)
     {
         nodeID = new QTreeWidgetItem();
-        nodeID->setText(0, Utility::formatHexNum(sendingFrames[currIdx].frameId()));
+        nodeID->setText(0, Utility::formatHexNum(sent.id));
         ui->treeResults->addTopLevelItem(nodeID);
-        nodeService = nullptr;
+        idNodes.insert(sent.id, nodeID);
     }
 
     bool foundReplyMatch = false;
@@ -873,7 +724,6 @@ void UDSScanWindow::setupNodes(uint32_t replyID)
         else replyItem->setText(0, "NO REPLY");
         nodeID->addChild(replyItem);
         replyNode = replyItem;
-        nodeService = nullptr;
     }
 
     bool foundServiceMatch = false;
@@ -895,37 +745,30 @@ void UDSScanWindow::setupNodes(uint32_t replyID)
     }
 
     nodeSubFunc = new QTreeWidgetItem();
-    nodeSubFunc->setText(0, Utility::formatHexNum(sendingFrames[currIdx].subFunc));
+    nodeSubFunc->setText(0, Utility::formatHexNum(sent.subFunc));
     nodeService->addChild(nodeSubFunc);
 }
 
-void UDSScanWindow::timeOut()
+void UDSScanWindow::pollScan()
 {
-    if (ui->ckShowNoReply->isChecked())
-    {
-        setupNodes(0xDEAD5EA1);
-        nodeSubFunc->setForeground(0, QBrush(Qt::gray));
-    }
+    if (!currentlyRunning) return;
 
-    sendNextMsg();
-}
+    QVector<UDSScanRequest> toSend;
+    QVector<UDSScanResult> results;
+    scanEngine.poll(scanClock.elapsed(), toSend, results);
+    showResults(results);
 
-void UDSScanWindow::sendNextMsg()
-{
-    currIdx++;
-    if (currIdx < sendingFrames.count())
-    {
-        udsHandler->sendUDSFrame(sendingFrames[currIdx]);
-        waitTimer->start();
-    }
-    else
+    foreach (const UDSScanRequest &req, toSend)
     {
-        waitTimer->stop();
-        udsHandler->setReception(false);
-        udsHandler->setProcessAllIDs(false);
-        udsHandler->setFlowCtrl(false);
-        //ui->btnScan->setText("Start Scan");
-        currentlyRunning = false;
+        UDS_MESSAGE msg;
+        msg.setFrameId(req.id);
+        msg.bus = req.bus;
+        msg.service = req.service;
+        msg.subFunc = req.subFunc;
+        msg.subFuncLen = req.subFuncLen;
+        udsHandler->sendUDSFrame(msg);
     }
-    ui->progressBar->setValue(currIdx);
+
+    ui->progressBar->setValue((int)qMin(scanEngine.getCompletedRequests(), (qint64)INT_MAX));
+    if (!scanEngine.isRunning()) stopScan();
 }
@@ -4,49 +4,14 @@
 #include "can_structs.h"
 #include "connections/canconnection.h"
 #include "bus_protocols/uds_handler.h"
+#include "udsscanengine.h"
 
 #include <QDialog>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QTreeWidget>
 
 
-enum SCAN_TYPE
-{
-    ST_TESTER_PRESENT,
-    ST_SESS_CTRL,
-    ST_COMM_CTRL,
-    ST_ECU_RESET,
-    ST_CLEAR_DTC,
-    ST_READ_DTC,
-    ST_SEC_ACCESS,
-    ST_READ_ID,
-    ST_READ_ADDR,
-    ST_READ_SCALING,
-    ST_IO_CTRL,
-    ST_ROUTINE_CTRL,
-    ST_CUSTOM,
-};
-
-//stores the parameters for one scan
-class ScanEntry
-{
-public:
-    uint32_t startID, endID;
-    int32_t idOffset;
-    bool bAdaptiveOffset;
-    bool bShowNoReplies;
-    uint32_t busToScan;
-    uint32_t maxWaitTime; //in milliseconds
-    SCAN_TYPE scanType;
-    uint32_t sessType;
-    uint32_t subfunctLen;
-    qint64 subfunctLower;
-    qint64 subfunctUpper;
-    uint32_t subfunctIncrement;
-    uint32_t serviceLower;
-    uint32_t serviceUpper;
-};
-
 namespace Ui {
 class UDSScanWindow;
 }
@@ -65,7 +30,7 @@ private slots:
     void scanAll();
     void scanSelected();
     void saveResults();
-    void timeOut();
+    void pollScan();
     void adaptiveToggled();
     void changedScanType();
     void numBytesChanged();
@@ -87,25 +52,23 @@ private:
     Ui::UDSScanWindow *ui;
     const QVector<CANFrame> *modelFrames;
     UDS_HANDLER *udsHandler;
-    QTimer *waitTimer;
-    QList<UDS_MESSAGE> sendingFrames;
-    QTreeWidgetItem *nodeID;
+    QTimer *scanTimer;
+    UDSScanEngine scanEngine;
+    QElapsedTimer scanClock;
+    QHash<uint32_t, QTreeWidgetItem *> idNodes; //top level result node of each request ID
     QTreeWidgetItem *nodeService;
     QTreeWidgetItem *nodeSubFunc;
     QVector<ScanEntry> scanEntries;
     ScanEntry *currEditEntry;
-    int currIdx = 0;
     bool currentlyRunning;
     bool inhibitUpdates;
 
     void displayScanEntry(int idx);
     QString generateListDesc(int idx);
-    void setupScan(int idx);
-    void startScan();
+    void startScan(const QVector<ScanEntry> &entries);
     void stopScan();
-    void sendNextMsg();
-    void sendOnBuses(UDS_MESSAGE frame, int buses);
-    void setupNodes(uint32_t replyID);
+    void showResults(const QVector<UDSScanResult> &results);
+    void setupNodes(const UDSScanRequest &sent, uint32_t replyID);
     void dumpNode(QTreeWidgetItem* item, QFile *file, int indent);
     bool eventFilter(QObject *obj, QEvent *event);
 
@@ -0,0 +1,279 @@
+#include "restbusengine.h"
+
+//lead time before the first frames so loading doesn't eat into the first period
+#define RESTBUS_LEAD_NS         1000000
+//how often the timing statistics are handed over to getStats
+#define RESTBUS_REPORT_NS       250000000
+
+namespace
+{
+    //CRC-8 SAE J1850, the one AUTOSAR E2E profiles 1 and 2 use
+    struct Crc8Table
+    {
+        quint8 table[256];
+        Crc8Table()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                quint8 crc = (quint8)i;
+                for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (quint8)((crc << 1) ^ 0x1D) : (quint8)(crc << 1);
+                table[i] = crc;
+            }
+        }
+    };
+
+    //IDs are keyed in decimal so 0x prefixed hex is turned into that first
+    QString idKey(const QString& message)
+    {
+        bool ok;
+        const uint id = message.toUInt(&ok, 0);
+        return ok ? QString::number(id) : QString();
+    }
+}
+
+RestbusEngine::RestbusEngine(FrameSender sender, QObject *parent) : QThread(parent)
+{
+    qRegisterMetaType<TimingStats>("TimingStats");
+    this->sender = sender;
+}
+
+RestbusEngine::~RestbusEngine()
+{
+    stopSimulation();
+}
+
+void RestbusEngine::load(const QVector<RestbusMessage>& plan)
+{
+    messages = plan;
+    handles.clear();
+    handleIndex.clear();
+    messageIndex.clear();
+    framesSent.storeRelaxed(0);
+    abortFlag.storeRelaxed(0);
+    //values still queued for the old plan would land on whatever has the same indexes in the new one
+    updates.drain([](const RestbusUpdate&) {});
+
+    for (int m = 0; m < messages.count(); m++)
+    {
+        const RestbusMessage &msg = messages[m];
+        messageIndex.insert(msg.name.toLower(), m);
+        messageIndex.insert(QString::number(msg.id), m);
+        for (int s = 0; s < msg.signalNames.count(); s++)
+        {
+            if (msg.counters.contains(s) || msg.checksum == s) continue;
+            handles.append(qMakePair(m, s));
+            const QString sig = "." + msg.signalNames[s].toLower();
+            handleIndex.insert(msg.name.toLower() + sig, handles.count() - 1);
+            handleIndex.insert(QString::number(msg.id) + sig, handles.count() - 1);
+        }
+    }
+}
+
+void RestbusEngine::stopSimulation()
+{
+    if (isRunning())
+    {
+        abortFlag.storeRelaxed(1);
+        wait();
+    }
+}
+
+int RestbusEngine::getMessageCount() const
+{
+    return messages.count();
+}
+
+const RestbusMessage& RestbusEngine::getMessage(int idx) const
+{
+    return messages[idx];
+}
+
+int RestbusEngine::findMessage(const QString& message) const
+{
+    const int idx = messageIndex.value(message.toLower(), -1);
+    if (idx > -1) return idx;
+    const QString key = idKey(message);
+    return key.isEmpty() ? -1 : messageIndex.value(key, -1);
+}
+
+int RestbusEngine::findSignal(const QString& message, const QString& signal) const
+{
+    const QString sig = "." + signal.toLower();
+    const int handle = handleIndex.value(message.toLower() + sig, -1);
+    if (handle > -1) return handle;
+    const QString key = idKey(message);
+    return key.isEmpty() ? -1 : handleIndex.value(key + sig, -1);
+}
+
+bool RestbusEngine::setSignal(int handle, double value)
+{
+    if (handle < 0 || handle >= handles.count()) return false;
+    RestbusUpdate update;
+    update.message = handles[handle].first;
+    update.signal = handles[handle].second;
+    update.value = value;
+    updates.push(update);
+    return true;
+}
+
+bool RestbusEngine::setChecksumType(int message, RestbusChecksumType type)
+{
+    if (message < 0 || message >= messages.count() || messages[message].checksum < 0) return false;
+    RestbusUpdate update;
+    update.message = message;
+    update.signal = -1;
+    update.value = type;
+    updates.push(update);
+    return true;
+}
+
+quint64 RestbusEngine::getFramesSent() const
+{
+    return framesSent.loadRelaxed();
+}
+
+TimingStats RestbusEngine::getStats()
+{
+    QMutexLocker locker(&statsMutex);
+    return stats;
+}
+
+quint8 RestbusEngine::checksum(RestbusChecksumType type, const unsigned char *data, int len)
+{
+    static const Crc8Table crc8;
+    quint8 result;
+    switch (type)
+    {
+    case RB_CHECKSUM_CRC8:
+        result = 0xFF;
+        for (int i = 0; i < len; i++) result = crc8.table[result ^ data[i]];
+        return result ^ 0xFF;
+    case RB_CHECKSUM_XOR:
+        result = 0;
+        for (int i = 0; i < len; i++) result ^= data[i];
+        return result;
+    case RB_CHECKSUM_SUM:
+        result = 0;
+        for (int i = 0; i < len; i++) result += data[i];
+        return result;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * The counters go out with their current value and then step on, wrapping at the size of the signal.
+ * The checksum covers every payload byte, in order, except the ones the checksum signal itself sits in.
+ */
+void RestbusEngine::prepareFrame(RestbusMessage& msg, CANFrame& frame)
+{
+    unsigned char *data = reinterpret_cast<unsigned char *>(msg.payload.data());
+
+    for (int c = 0; c < msg.counters.count(); c++)
+    {
+        const SignalCodecSpec &spec = msg.specs[msg.counters[c]];
+        const quint64 mask = (spec.signalSize < 64) ? (1ULL << spec.signalSize) - 1 : ~0ULL;
+        SignalCodec::insert(spec.segments, msg.counterValues[c], data);
+        msg.counterValues[c] = (msg.counterValues[c] + 1) & mask;
+    }
+
+    if (msg.checksum > -1 && msg.checksumType != RB_CHECKSUM_NONE)
+    {
+        const SignalCodecSpec &spec = msg.specs[msg.checksum];
+        unsigned char covered[64];
+        int len = 0;
+        for (int i = 0; i < msg.payload.length() && i < 64; i++)
+        {
+            bool own = false;
+            foreach (const SignalCodecSegment &seg, spec.segments) if (seg.byteIdx == i) own = true;
+            if (!own) covered[len++] = data[i];
+        }
+        SignalCodec::insert(spec.segments, checksum(msg.checksumType, covered, len), data);
+    }
+
+    frame.setFrameId(msg.id);
+    frame.setExtendedFrameFormat(msg.extended);
+    frame.setFlexibleDataRateFormat(msg.payload.length() > 8);
+    frame.bus = msg.bus;
+    frame.isReceived = false;
+    frame.setPayload(msg.payload);
+}
+
+/* runs on the sending thread. Values are only encoded here so the payloads have a single writer */
+void RestbusEngine::applyUpdates()
+{
+    updates.drain([this](const RestbusUpdate& update)
+    {
+        if (update.message < 0 || update.message >= messages.count()) return;
+        RestbusMessage &msg = messages[update.message];
+        if (update.signal < 0) msg.checksumType = (RestbusChecksumType)(int)update.value;
+        else if (update.signal < msg.specs.count()) SignalCodec::encode(msg.specs[update.signal], update.value, msg.payload);
+    });
+}
+
+void RestbusEngine::run()
+{
+    TimingStats local;
+    QVector<SendScheduleEntry> due;
+    QList<CANFrame> batch;
+
+    {
+        QMutexLocker locker(&statsMutex);
+        stats.reset();
+    }
+
+    schedule.clear();
+    const qint64 base = HiResClock::nowNs() + RESTBUS_LEAD_NS;
+    for (int m = 0; m < messages.count(); m++)
+    {
+        if (messages[m].periodNs <= 0) continue;
+        SendScheduleEntry entry;
+        entry.dueNs = base + messages[m].offsetNs;
+        entry.periodNs = messages[m].periodNs;
+        entry.lastSentNs = -1;
+        entry.row = m;
+        entry.trigger = 0;
+        entry.oneShot = false;
+        schedule.add(entry);
+    }
+    qint64 lastReport = HiResClock::nowNs();
+
+    while (!abortFlag.loadRelaxed() && schedule.count() > 0)
+    {
+        HiResClock::sleepUntil(schedule.nextDue(), FRAMESEND_SPIN_NS, &abortFlag);
+        if (abortFlag.loadRelaxed()) break;
+
+        applyUpdates();
+        const qint64 now = HiResClock::nowNs();
+        due.clear();
+        batch.clear();
+        schedule.takeSlot(now, due);
+
+        foreach (const SendScheduleEntry &entry, due)
+        {
+            CANFrame frame;
+            prepareFrame(messages[entry.row], frame);
+            batch.append(frame);
+            local.add(now - entry.dueNs);
+            schedule.reschedule(entry, now);
+        }
+
+        if (!batch.isEmpty())
+        {
+            sender(batch);
+            framesSent.fetchAndAddRelaxed(batch.count());
+        }
+
+        if ((now - lastReport) > RESTBUS_REPORT_NS)
+        {
+            lastReport = now;
+            QMutexLocker locker(&statsMutex);
+            stats = local;
+        }
+    }
+
+    {
+        QMutexLocker locker(&statsMutex);
+        stats = local;
+    }
+}
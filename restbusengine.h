@@ -0,0 +1,124 @@
+#ifndef RESTBUSENGINE_H
+#define RESTBUSENGINE_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QPair>
+#include <QList>
+#include <QStringList>
+#include <functional>
+#include "can_structs.h"
+#include "dbc/signalcodec.h"
+#include "framesendschedule.h"
+#include "utils/hiresclock.h"
+#include "utils/lfinbox.h"
+
+/* how a message's checksum signal is worked out. See RestbusEngine::prepareFrame */
+enum RestbusChecksumType
+{
+    RB_CHECKSUM_NONE,
+    RB_CHECKSUM_CRC8,   //SAE J1850: poly 0x1D, init 0xFF, final xor 0xFF
+    RB_CHECKSUM_XOR,
+    RB_CHECKSUM_SUM
+};
+
+/* one periodic message of a simulated node, everything already looked up */
+struct RestbusMessage
+{
+    QString name;
+    uint32_t id;
+    bool extended;
+    int bus;
+    qint64 periodNs;
+    qint64 offsetNs;                //start delay, so messages don't all start on the same tick
+    QByteArray payload;             //current signal values. Counters and checksum are filled in per send
+    QStringList signalNames;
+    QVector<SignalCodecSpec> specs; //one per signal name
+    QVector<int> counters;          //indexes into specs of the rolling counters
+    QVector<quint64> counterValues;
+    int checksum;                   //index into specs, -1 if the message has none
+    RestbusChecksumType checksumType;
+};
+
+/* a new value for one signal, queued up for the sending thread */
+struct RestbusUpdate
+{
+    int message;
+    int signal;     //-1 changes the checksum type of the message to (int)value instead
+    double value;
+};
+
+/*
+  Plays the periodic traffic of whole ECUs that aren't on the bench. The messages come in already
+  compiled (see RestbusPlanner) so the thread never touches the DBC: every message has its signal
+  encoders, its counters and its checksum worked out beforehand.
+
+  The thread keeps every message in a FrameSendSchedule and sleeps on HiResClock until the next one is
+  due, then sends everything due within one slot as a single batch. Before a message goes out its
+  counters step on and its checksum is recomputed over the finished payload. Signal values can be changed
+  from any thread while it runs. They go through a lock free inbox and show up from the next send on.
+  Nothing here involves the GUI thread so thousands of frames a second are no problem.
+*/
+class RestbusEngine : public QThread
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void(const QList<CANFrame>&)> FrameSender;
+
+    RestbusEngine(FrameSender sender, QObject *parent = nullptr);
+    ~RestbusEngine();
+
+    /* replaces the messages to send. Must not be called while the thread runs */
+    void load(const QVector<RestbusMessage>& plan);
+    void stopSimulation();
+
+    int getMessageCount() const;
+    const RestbusMessage& getMessage(int idx) const;
+
+    /* index of a loaded message by name or ID, -1 if there is none */
+    int findMessage(const QString& message) const;
+
+    /**
+     * @brief handle for a signal of one of the loaded messages, for setSignal
+     * @param message - message name or ID
+     * @return -1 if there is no such signal
+     */
+    int findSignal(const QString& message, const QString& signal) const;
+
+    /* queues a new scaled value for a signal. Safe from any thread. Counters and checksums are ignored */
+    bool setSignal(int handle, double value);
+
+    /* queues a change of how a message's checksum is worked out. Safe from any thread */
+    bool setChecksumType(int message, RestbusChecksumType type);
+
+    quint64 getFramesSent() const;
+    TimingStats getStats();
+
+    /* steps the counters, puts the checksum in and fills frame in for sending */
+    static void prepareFrame(RestbusMessage& msg, CANFrame& frame);
+    static quint8 checksum(RestbusChecksumType type, const unsigned char *data, int len);
+
+protected:
+    void run() override;
+
+private:
+    void applyUpdates();
+
+    FrameSender sender;
+    QVector<RestbusMessage> messages;
+    QVector<QPair<int, int>> handles;   //(message, signal) for every handle given out
+    QHash<QString, int> handleIndex;    //"message.signal" in lower case, message by name and by ID
+    QHash<QString, int> messageIndex;
+    LFInbox<RestbusUpdate> updates;
+    FrameSendSchedule schedule;
+    QAtomicInt abortFlag;
+    QAtomicInteger<quint64> framesSent;
+    QMutex statsMutex;
+    TimingStats stats;
+};
+
+#endif // RESTBUSENGINE_H
@@ -0,0 +1,114 @@
+#include <QRegularExpression>
+#include "restbusplanner.h"
+#include "dbc/dbchandler.h"
+
+//the words of a signal name in lower case. Underscores and changes of case split it: AliveCounter_2 is alive, counter, 2
+QStringList RestbusPlanner::nameTokens(const QString& name)
+{
+    static const QRegularExpression word("[A-Z]+(?![a-z])|[A-Z]?[a-z]+|[0-9]+");
+    QStringList tokens;
+    QRegularExpressionMatchIterator it = word.globalMatch(name);
+    while (it.hasNext()) tokens.append(it.next().captured().toLower());
+    return tokens;
+}
+
+bool RestbusPlanner::isCounterName(const QString& name)
+{
+    static const QStringList counter = {"counter", "cntr", "cnt", "alive", "rolling", "sqc"};
+    foreach (const QString &token, nameTokens(name)) if (counter.contains(token)) return true;
+    return false;
+}
+
+bool RestbusPlanner::isChecksumName(const QString& name)
+{
+    static const QStringList crc = {"crc", "checksum", "chksum", "chks"};
+    foreach (const QString &token, nameTokens(name)) if (crc.contains(token)) return true;
+    return false;
+}
+
+//value the message has for the attribute, or the attribute's default if it doesn't set one. 0 if there is no such attribute
+double RestbusPlanner::attributeValue(DBCFile *file, DBC_MESSAGE *msg, const QString& name)
+{
+    DBC_ATTRIBUTE_VALUE *val = msg->findAttrValByName(name);
+    if (val) return val->value.toDouble();
+    DBC_ATTRIBUTE *attr = file->findAttributeByName(name, ATTR_TYPE_MESSAGE);
+    if (attr) return attr->defaultValue.toDouble();
+    return 0.0;
+}
+
+QVector<RestbusMessage> RestbusPlanner::plan(DBCFile *file, const QStringList& nodes, int bus, QStringList *skipped,
+                                             const QHash<QString, bool> *counters)
+{
+    QVector<RestbusMessage> plan;
+    if (!file) return plan;
+
+    if (bus < 0) bus = qMax(file->getAssocBus(), 0);
+    DBC_ATTRIBUTE *startAttr = file->findAttributeByName("GenSigStartValue", ATTR_TYPE_SIG);
+
+    for (int m = 0; m < file->messageHandler->getCount(); m++)
+    {
+        DBC_MESSAGE *msg = file->messageHandler->findMsgByIdx(m);
+        if (!msg) continue;
+        if (!nodes.isEmpty() && (!msg->sender || !nodes.contains(msg->sender->name, Qt::CaseInsensitive))) continue;
+
+        const double cycleMs = attributeValue(file, msg, "GenMsgCycleTime");
+        if (cycleMs <= 0.0)
+        {
+            if (skipped) skipped->append(msg->name + ": no cycle time");
+            continue;
+        }
+
+        RestbusMessage rb;
+        rb.name = msg->name;
+        rb.id = msg->ID;
+        rb.extended = msg->extendedID;
+        rb.bus = bus;
+        rb.periodNs = (qint64)(cycleMs * 1000000.0);
+        rb.offsetNs = (qint64)(qMax(attributeValue(file, msg, "GenMsgStartDelayTime"), 0.0) * 1000000.0);
+        rb.payload = QByteArray((int)msg->len, 0);
+        rb.checksum = -1;
+        rb.checksumType = RB_CHECKSUM_NONE;
+
+        for (int s = 0; s < msg->sigHandler->getCount(); s++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+            if (sig->valType == STRING) continue;
+            const SignalCodecSpec spec = SignalCodec::fromSignal(sig);
+            rb.signalNames.append(sig->name);
+            rb.specs.append(spec);
+            const int idx = rb.specs.count() - 1;
+
+            //a name the caller decided about wins over the guess
+            const QString sigKey = "." + sig->name.toLower();
+            int forced = -1;
+            if (counters)
+            {
+                if (counters->contains(msg->name.toLower() + sigKey)) forced = counters->value(msg->name.toLower() + sigKey);
+                else if (counters->contains(QString::number(msg->ID) + sigKey)) forced = counters->value(QString::number(msg->ID) + sigKey);
+            }
+
+            if (forced < 0 && sig->valType == UNSIGNED_INT && rb.checksum < 0 && sig->signalSize <= 8 && isChecksumName(sig->name))
+            {
+                rb.checksum = idx;
+                rb.checksumType = RB_CHECKSUM_CRC8;
+                continue;
+            }
+            const bool counter = (forced < 0) ? (sig->valType == UNSIGNED_INT && isCounterName(sig->name)) : (forced == 1);
+            if (counter && sig->signalSize <= 32)
+            {
+                rb.counters.append(idx);
+                rb.counterValues.append(0);
+                continue;
+            }
+            if (sig->isMultiplexed) continue;
+
+            DBC_ATTRIBUTE_VALUE *start = sig->findAttrValByName("GenSigStartValue");
+            double raw = 0.0;
+            if (start) raw = start->value.toDouble();
+            else if (startAttr) raw = startAttr->defaultValue.toDouble();
+            if (raw != 0.0) SignalCodec::encode(spec, (raw * sig->factor) + sig->bias, rb.payload);
+        }
+        plan.append(rb);
+    }
+    return plan;
+}
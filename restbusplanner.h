@@ -0,0 +1,48 @@
+#ifndef RESTBUSPLANNER_H
+#define RESTBUSPLANNER_H
+
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include "restbusengine.h"
+
+class DBCFile;
+class DBC_MESSAGE;
+
+/*
+  Turns the messages a set of DBC nodes send into RestbusMessages for the RestbusEngine.
+  Only messages with a cycle time are taken. It comes from the GenMsgCycleTime attribute of the message
+  or else the attribute's default, the same goes for GenMsgStartDelayTime. Signals start out at their
+  GenSigStartValue (a raw value, as Vector tools use it) and at 0 without one. Multiplexed signals are
+  left at 0 since only one of them can be in the frame at a time.
+
+  DBC files don't say which signals are counters or checksums so that is guessed from the words of the
+  names, split at underscores and changes of case: unsigned signals with a word counter, cntr, cnt, alive,
+  rolling or sqc count up and ones with crc, checksum, chksum or chks that fit in a byte get a CRC-8
+  SAE J1850. So AliveCounter and MSG_CNT are counters but Content and Account are not. Where the guess
+  is wrong the caller can say which signals are counters. Scripts can change the checksum type per
+  message afterwards.
+*/
+class RestbusPlanner
+{
+public:
+    /**
+     * @brief collects the periodic messages sent by nodes
+     * @param nodes - node names, case doesn't matter. Empty takes every node in the file
+     * @param bus - bus to send on. -1 uses the bus the file is associated with, or bus 0 if that is all buses
+     * @param skipped - if given, appended with the name of every message that was left out and why
+     * @param counters - if given, "message.signal" in lower case (or the decimal ID instead of the message name) to
+     * true for a counter or false for a plain signal, in place of the guess from the name
+     */
+    static QVector<RestbusMessage> plan(DBCFile *file, const QStringList& nodes, int bus, QStringList *skipped = nullptr,
+                                        const QHash<QString, bool> *counters = nullptr);
+
+    static bool isCounterName(const QString& name);
+    static bool isChecksumName(const QString& name);
+    static QStringList nameTokens(const QString& name);
+
+private:
+    static double attributeValue(DBCFile *file, DBC_MESSAGE *msg, const QString& name);
+};
+
+#endif // RESTBUSPLANNER_H
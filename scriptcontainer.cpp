@@ -1,58 +1,123 @@
 #include <QJSValueIterator>
+#include <QCoreApplication>
+#include <QSemaphore>
+#include <QSharedPointer>
 #include <QDebug>
 
 #include "scriptcontainer.h"
+#include "scriptingwindow.h"
+#include "mainwindow.h"
 #include "connections/canconmanager.h"
+#include "dbc/dbchandler.h"
+#include "restbusplanner.h"
+#include "utils/hiresclock.h"
 
 ScriptContainer::ScriptContainer()
 {
-    qDebug() << "Script Container Constructor";
-    scriptEngine = new QJSEngine();
-    canHelper = new CANScriptHelper(scriptEngine);
-    isoHelper = new ISOTPScriptHelper(scriptEngine);
-    udsHelper = new UDSScriptHelper(scriptEngine);
-    connect(&timer, SIGNAL(timeout()), this, SLOT(tick()));
+    qRegisterMetaType<ScriptStats>("ScriptStats");
+
+    scriptEngine = nullptr;
+    timer = nullptr;
+    statsTimer = nullptr;
+    window = nullptr;
+    canHelper = nullptr;
+    isoHelper = nullptr;
+    udsHelper = nullptr;
+    j1939Helper = nullptr;
+    dbcHelper = nullptr;
+    restbusHelper = nullptr;
+    stats = ScriptStats();
+    closing.storeRelaxed(0);
+
+    workerThread = new QThread();
+    workerThread->setObjectName("Script");
+    moveToThread(workerThread);
+    workerThread->start();
+    //the engine and everything the script can touch have to be created on the thread they will run on
+    QMetaObject::invokeMethod(this, "createEngine", Qt::BlockingQueuedConnection);
 }
 
 ScriptContainer::~ScriptContainer()
 {
-    qDebug() << "Script Container Destructor " << (uint64_t)this << "c: " << (uint64_t)canHelper;
-    timer.stop();
-    disconnect(&timer, SIGNAL(timeout()), this, SLOT(tick()));
-    if (scriptEngine)
-    {
-        scriptText = "";
-        compileScript();
-        //delete scriptEngine;   //doing this here seems to cause a crash. No crash if you don't.
-        //scriptEngine = nullptr;
-    }
-    if (canHelper)
-    {
-        delete canHelper;
-        canHelper = nullptr;
-    }
-    if (isoHelper)
-    {
-        delete isoHelper;
-        isoHelper = nullptr;
-    }
-    if (udsHelper)
-    {
-        delete udsHelper;
-        udsHelper = nullptr;
-    }
-    qDebug() << "end of destruct";
+    //a script stuck in a long loop or waiting on this thread would otherwise never get around to the teardown
+    closing.storeRelease(1);
+    if (scriptEngine) scriptEngine->setInterrupted(true);
+    QMetaObject::invokeMethod(this, "teardown", Qt::BlockingQueuedConnection);
+    workerThread->quit();
+    workerThread->wait();
+    delete workerThread;
+}
+
+void ScriptContainer::createEngine()
+{
+    scriptEngine = new QJSEngine();
+    canHelper = new CANScriptHelper(scriptEngine, this);
+    isoHelper = new ISOTPScriptHelper(scriptEngine, this);
+    udsHelper = new UDSScriptHelper(scriptEngine, this);
+    j1939Helper = new J1939ScriptHelper(scriptEngine, this);
+    dbcHelper = new DBCScriptHelper(scriptEngine, this);
+    restbusHelper = new RestbusScriptHelper(scriptEngine, this);
+
+    timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(tick()));
+    statsTimer = new QTimer(this);
+    connect(statsTimer, SIGNAL(timeout()), this, SLOT(publishStats()));
+    statsPeriod.start();
+    statsTimer->start(SCRIPT_STATS_PERIOD_MS);
+}
+
+void ScriptContainer::teardown()
+{
+    timer->stop();
+    statsTimer->stop();
+    canHelper->clearFilters();
+    isoHelper->clearFilters();
+    udsHelper->clearFilters();
+    j1939Helper->clearFilters();
+    restbusHelper->stop();
+
+    compiledScript = QJSValue();
+    setupFunction = QJSValue();
+    tickFunction = QJSValue();
+
+    //these go when the thread finishes, after anything still queued up for them
+    canHelper->deleteLater();
+    isoHelper->deleteLater();
+    udsHelper->deleteLater();
+    j1939Helper->deleteLater();
+    dbcHelper->deleteLater();
+    restbusHelper->deleteLater();
+    scriptEngine->deleteLater();
+    canHelper = nullptr;
+    isoHelper = nullptr;
+    udsHelper = nullptr;
+    j1939Helper = nullptr;
+    dbcHelper = nullptr;
+    restbusHelper = nullptr;
+    scriptEngine = nullptr;
+
+    //the container itself is deleted by the window once this returns
+    moveToThread(QCoreApplication::instance()->thread());
 }
 
+//Called by the window. The script text is handed over with the call so the two threads never share it
 void ScriptContainer::compileScript()
 {
-    QJSValue result = scriptEngine->evaluate(scriptText, fileName);
+    QMetaObject::invokeMethod(this, "compile", Qt::QueuedConnection, Q_ARG(QString, scriptText));
+}
+
+void ScriptContainer::compile(QString source)
+{
+    QJSValue result = scriptEngine->evaluate(source, fileName);
 
     emit sendLog("Compiling script...");
 
     canHelper->clearFilters();
     isoHelper->clearFilters();
     udsHelper->clearFilters();
+    j1939Helper->clearFilters();
+    dbcHelper->clearHandles();
+    restbusHelper->stop();
 
     if (result.isError())
     {
@@ -77,33 +142,109 @@ void ScriptContainer::compileScript()
         scriptEngine->globalObject().setProperty("isotp", isoObj);
         QJSValue udsObj = scriptEngine->newQObject(udsHelper);
         scriptEngine->globalObject().setProperty("uds", udsObj);
+        QJSValue j1939Obj = scriptEngine->newQObject(j1939Helper);
+        scriptEngine->globalObject().setProperty("j1939", j1939Obj);
+        QJSValue dbcObj = scriptEngine->newQObject(dbcHelper);
+        scriptEngine->globalObject().setProperty("dbc", dbcObj);
+        QJSValue restbusObj = scriptEngine->newQObject(restbusHelper);
+        scriptEngine->globalObject().setProperty("restbus", restbusObj);
 
         //Find out which callbacks the script has created.
         setupFunction = scriptEngine->globalObject().property("setup");
         canHelper->setRxCallback(scriptEngine->globalObject().property("gotCANFrame"));
+        canHelper->setBatchRxCallback(scriptEngine->globalObject().property("gotCANFrames"));
         isoHelper->setRxCallback(scriptEngine->globalObject().property("gotISOTPMessage"));
+        isoHelper->setTxCallback(scriptEngine->globalObject().property("sentISOTPMessage"));
         udsHelper->setRxCallback(scriptEngine->globalObject().property("gotUDSMessage"));
+        udsHelper->setTxCallback(scriptEngine->globalObject().property("sentUDSMessage"));
+        j1939Helper->setRxCallback(scriptEngine->globalObject().property("gotJ1939Message"));
 
         tickFunction = scriptEngine->globalObject().property("tick");
 
-        if (setupFunction.isCallable())
-        {
-            qDebug() << "setup exists";
-            QJSValue res = setupFunction.call();
-            if (res.isError())
-            {
-                emit sendLog("Error in setup function on line " + res.property("lineNumber").toString());
-                emit sendLog(res.property("message").toString());
-            }
-        }
-        if (tickFunction.isCallable()) qDebug() << "tick exists";
+        if (setupFunction.isCallable()) callScript(setupFunction, QJSValueList(), "setup");
     }
+    flushOutbox();
+}
+
+QJSValue ScriptContainer::callScript(QJSValue& function, const QJSValueList& args, const QString& what, qint64 queuedNs)
+{
+    const qint64 startNs = HiResClock::nowNs();
+    if (queuedNs >= 0) frameDelivered(queuedNs, startNs);
+
+    QJSValue res = function.call(args);
+    stats.busyNs += HiResClock::nowNs() - startNs;
+    stats.callbacks++;
+
+    if (res.isError())
+    {
+        emit sendLog("Error in " + what + " function on line " + res.property("lineNumber").toString());
+        emit sendLog(res.property("message").toString());
+    }
+    return res;
+}
+
+void ScriptContainer::frameDelivered(qint64 queuedNs, qint64 nowNs)
+{
+    const qint64 latency = nowNs - queuedNs;
+    stats.frames++;
+    stats.totalLatencyNs += latency;
+    if (latency > stats.maxLatencyNs) stats.maxLatencyNs = latency;
+}
+
+void ScriptContainer::queueFrame(const CANFrame& frame)
+{
+    outbox.append(frame);
+}
+
+void ScriptContainer::flushOutbox()
+{
+    if (outbox.isEmpty()) return;
+    const QList<CANFrame> frames = outbox;
+    outbox.clear();
+    //sent from the GUI thread so the script never waits on a connection. That is one hop per batch instead of one per frame
+    QTimer::singleShot(0, CANConManager::getInstance(), [frames]()
+    {
+        CANConManager::getInstance()->sendFrames(frames);
+    });
+}
+
+bool ScriptContainer::runOnGuiThread(std::function<void()> work)
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    if (QThread::currentThread() == app->thread())
+    {
+        work();
+        return true;
+    }
+
+    //not a blocking queued call. The GUI thread may itself be blocked closing this script
+    QSharedPointer<QSemaphore> done(new QSemaphore());
+    QMetaObject::invokeMethod(app, [work, done]()
+    {
+        work();
+        done->release();
+    }, Qt::QueuedConnection);
+    while (!done->tryAcquire(1, 10))
+    {
+        if (closing.loadAcquire()) return false;
+    }
+    return true;
+}
+
+void ScriptContainer::publishStats()
+{
+    stats.periodMs = (int)statsPeriod.restart();
+    stats.dropped = canHelper->getDropped();
+    emit statsUpdated(stats);
+    stats = ScriptStats();
 }
 
 void ScriptContainer::setScriptWindow(ScriptingWindow *win)
 {
     window = win;
     connect(this, &ScriptContainer::sendLog, window, &ScriptingWindow::log);
+    connect(this, &ScriptContainer::sendValues, window, &ScriptingWindow::gotValues);
+    connect(this, &ScriptContainer::statsUpdated, window, &ScriptingWindow::gotStats);
 }
 
 void ScriptContainer::log(QJSValue logString)
@@ -115,26 +256,20 @@ void ScriptContainer::log(QJSValue logString)
 void ScriptContainer::setTickInterval(QJSValue interval)
 {
     int intervalValue = interval.toInt();
-    qDebug() << "called set tick interval with value " << intervalValue;
     if (intervalValue > 0)
     {
-        timer.setInterval(intervalValue);
-        timer.start();
+        timer->setInterval(intervalValue);
+        timer->start();
     }
-    else timer.stop();
+    else timer->stop();
 }
 
 void ScriptContainer::tick()
 {
     if (tickFunction.isCallable())
     {
-        //qDebug() << "Calling tick function";
-        QJSValue res = tickFunction.call();
-        if (res.isError())
-        {
-            emit sendLog("Error in tick function on line " + res.property("lineNumber").toString());
-            emit sendLog(res.property("message").toString());
-        }
+        callScript(tickFunction, QJSValueList(), "tick");
+        flushOutbox();
     }
 }
 
@@ -143,41 +278,18 @@ void ScriptContainer::addParameter(QJSValue name)
     scriptParams.append(name.toString());
 }
 
-void ScriptContainer::updateValuesTable(QTableWidget *widget)
+//Runs on the script thread so the values are read there. The window fills in its table from the signal
+void ScriptContainer::requestValues()
 {
-    QString value;
+    QStringList names;
+    QStringList values;
 
     foreach (QString paramName, scriptParams)
     {
-        value = scriptEngine->globalObject().property(paramName).toString();
-        qDebug() << paramName << " - " << value;
-        bool found = false;
-        for (int i = 0; i < widget->rowCount(); i++)
-        {
-            if (widget->item(i, 0) && widget->item(i, 0)->text().compare(paramName) == 0)
-            {
-                found = true;
-                if (!widget->item(i, 1)->isSelected())
-                {
-                    widget->item(i,1)->setText(value);
-                }
-                break;
-            }
-        }
-        if (!found)
-        {
-            int row = widget->rowCount();
-            widget->insertRow(widget->rowCount());
-            QTableWidgetItem *item;
-            item = new QTableWidgetItem();
-            item->setText(paramName);
-            item->setFlags(Qt::ItemIsEnabled);
-            widget->setItem(row, 0, item);
-            item = new QTableWidgetItem();
-            item->setText(value);
-            widget->setItem(row, 1, item);
-        }
+        names.append(paramName);
+        values.append(scriptEngine->globalObject().property(paramName).toString());
     }
+    emit sendValues(names, values);
 }
 
 void ScriptContainer::updateParameter(QString name, QString value)
@@ -192,9 +304,15 @@ void ScriptContainer::updateParameter(QString name, QString value)
 
 /* CANScriptHandler Methods */
 
-CANScriptHelper::CANScriptHelper(QJSEngine *engine)
+CANScriptHelper::CANScriptHelper(QJSEngine *engine, ScriptContainer *script) : batcher(engine)
 {
     scriptEngine = engine;
+    container = script;
+}
+
+int CANScriptHelper::getDropped() const
+{
+    return inbox.getDropped();
 }
 
 void CANScriptHelper::setRxCallback(QJSValue cb)
@@ -202,6 +320,11 @@ void CANScriptHelper::setRxCallback(QJSValue cb)
     gotFrameFunction = cb;
 }
 
+void CANScriptHelper::setBatchRxCallback(QJSValue cb)
+{
+    gotFramesFunction = cb;
+}
+
 void CANScriptHelper::setFilter(QJSValue id, QJSValue mask, QJSValue bus)
 {
     uint32_t idVal = id.toUInt();
@@ -213,7 +336,8 @@ void CANScriptHelper::setFilter(QJSValue id, QJSValue mask, QJSValue bus)
     filter.setFilter(idVal, maskVal, busVal);
     filters.append(filter);
 
-    CANConManager::getInstance()->addTargettedFrame(busVal, idVal, maskVal, this);
+    //gotTargettedFrame only pushes into the lock free inbox so it can take the frames right on the connection thread
+    CANConManager::getInstance()->addTargettedFrame(busVal, idVal, maskVal, this, Qt::DirectConnection);
 }
 
 void CANScriptHelper::clearFilters()
@@ -246,43 +370,102 @@ void CANScriptHelper::sendFrame(QJSValue bus, QJSValue id, QJSValue length, QJSV
 
     if (frame.frameId() > 0x7FF) frame.setExtendedFrameFormat(true);
 
-    qDebug() << "sending frame from script";
-    CANConManager::getInstance()->sendFrame(frame);
+    container->queueFrame(frame);
 }
 
-void CANScriptHelper::gotTargettedFrame(const CANFrame &frame)
+void CANScriptHelper::sendFrames(QJSValue batch)
 {
-    if (!gotFrameFunction.isCallable()) return; //nothing to do if we can't even call the function
-    //qDebug() << "Got frame in script interface";
-
-    const unsigned char *data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-    int dataLen = frame.payload().length();
+    const QList<CANFrame> frames = batcher.fromScript(batch);
+    foreach (const CANFrame &frame, frames) container->queueFrame(frame);
+}
 
+bool CANScriptHelper::matchesFilters(const CANFrame &frame)
+{
     for (int i = 0; i < filters.length(); i++)
     {
-        if (filters[i].checkFilter(frame.frameId(), frame.bus))
+        if (filters[i].checkFilter(frame.frameId(), frame.bus)) return true;
+    }
+    return false;
+}
+
+//Called on the connection's thread. Only queue the frame and make sure the script thread knows
+void CANScriptHelper::gotTargettedFrame(const CANFrame &frame)
+{
+    InboxFrame item;
+    item.frame = frame;
+    item.queuedNs = HiResClock::nowNs();
+    if (inbox.push(item)) QMetaObject::invokeMethod(this, "drainInbox", Qt::QueuedConnection);
+}
+
+void CANScriptHelper::drainInbox()
+{
+    if (gotFramesFunction.isCallable())
+    {
+        QVector<CANFrame> batch;
+        QVector<qint64> queued;
+        inbox.drain([this, &batch, &queued](const InboxFrame& item)
         {
-            QJSValueList args;
-            args << frame.bus << frame.frameId() << static_cast<uint>(frame.payload().length());
-            QJSValue dataBytes = scriptEngine->newArray(dataLen);
-
-            for (int j = 0; j < dataLen; j++) dataBytes.setProperty(j, QJSValue(data[j]));
-            args.append(dataBytes);
-            gotFrameFunction.call(args);
-            return; //as soon as one filter matches we jump out
-        }
+            if (!matchesFilters(item.frame)) return;
+            batch.append(item.frame);
+            queued.append(item.queuedNs);
+            if (batch.count() >= SCRIPT_BATCH_MAX_FRAMES) deliverBatch(batch, queued);
+        });
+        deliverBatch(batch, queued);
+    }
+    else
+    {
+        const bool callable = gotFrameFunction.isCallable();
+        inbox.drain([this, callable](const InboxFrame& item)
+        {
+            if (!callable) return; //nothing to do if we can't even call the function
+            //as soon as one filter matches the frame goes to the script
+            if (matchesFilters(item.frame))
+                container->callScript(gotFrameFunction, batcher.frameArgs(item.frame), "gotCANFrame", item.queuedNs);
+        });
     }
+    //everything the script sent in response to this lot goes out together
+    container->flushOutbox();
+}
+
+void CANScriptHelper::deliverBatch(QVector<CANFrame>& frames, QVector<qint64>& queuedNs)
+{
+    if (frames.isEmpty()) return;
+    QJSValueList args;
+    args << batcher.toScript(frames);
+
+    //the frames reach the script when the callback starts, not when they were put in the batch
+    const qint64 nowNs = HiResClock::nowNs();
+    foreach (qint64 queued, queuedNs) container->frameDelivered(queued, nowNs);
+    container->callScript(gotFramesFunction, args, "gotCANFrames");
+    frames.clear();
+    queuedNs.clear();
 }
 
 
 
 
 /* ISOTPScriptHelper methods */
-ISOTPScriptHelper::ISOTPScriptHelper(QJSEngine *engine)
+
+//single frames and flow control are sent on the script thread so they go through the outbox like can.sendFrame.
+//Flow control answers a frame rather than a script call so a flush is posted for it too. An empty outbox costs nothing
+static ISOTP_HANDLER::FrameSender outboxSender(ScriptContainer *container)
+{
+    return [container](const CANFrame &frame)
+    {
+        container->queueFrame(frame);
+        QMetaObject::invokeMethod(container, [container]() { container->flushOutbox(); }, Qt::QueuedConnection);
+    };
+}
+
+ISOTPScriptHelper::ISOTPScriptHelper(QJSEngine *engine, ScriptContainer *script)
 {
     scriptEngine = engine;
+    container = script;
     handler = new ISOTP_HANDLER;
+    handler->setParent(this);
     connect(handler, SIGNAL(newISOMessage(ISOTP_MESSAGE)), this, SLOT(newISOMessage(ISOTP_MESSAGE)));
+    connect(handler, &ISOTP_HANDLER::transmitFinished, this, &ISOTPScriptHelper::transmitFinished);
+    handler->setFrameSender(outboxSender(script));
     handler->setReception(true);
     handler->setFlowCtrl(true);
 }
@@ -324,16 +507,24 @@ void ISOTPScriptHelper::sendISOTP(QJSValue bus, QJSValue id, QJSValue length, QJ
 
     if (msg.frameId() > 0x7FF) msg.setExtendedFrameFormat(true);
 
-    qDebug() << "sending ISOTP message from script";
-    
     handler->sendISOTPFrame(msg.bus, msg.frameId(), msg.payload());
 }
 
+void ISOTPScriptHelper::setFrameSize(QJSValue size)
+{
+    handler->setFrameSize(size.toInt());
+}
+
 void ISOTPScriptHelper::setRxCallback(QJSValue cb)
 {
     gotFrameFunction = cb;
 }
 
+void ISOTPScriptHelper::setTxCallback(QJSValue cb)
+{
+    sentFunction = cb;
+}
+
 void ISOTPScriptHelper::newISOMessage(ISOTP_MESSAGE msg)
 {
     qDebug() << "isotpScriptHelper got a ISOTP message";
@@ -346,18 +537,34 @@ void ISOTPScriptHelper::newISOMessage(ISOTP_MESSAGE msg)
 
     for (int j = 0; j < msg.payload().length(); j++) dataBytes.setProperty(static_cast<quint32>(j), QJSValue((unsigned char)msg.payload()[j]));
     args.append(dataBytes);
-    gotFrameFunction.call(args);
+    container->callScript(gotFrameFunction, args, "gotISOTPMessage");
+    container->flushOutbox();
+}
+
+//queued over from the transmitter thread once a multi frame message is done
+void ISOTPScriptHelper::transmitFinished(ISOTPTransmitStats stats)
+{
+    if (!sentFunction.isCallable()) return;
+
+    QJSValueList args;
+    args << stats.bus << stats.id << stats.bytes << stats.frames << (double)(stats.elapsedNs / 1000) << stats.completed;
+    container->callScript(sentFunction, args, "sentISOTPMessage");
+    container->flushOutbox();
 }
 
 
 
 
 /* UDSScriptHelper methods */
-UDSScriptHelper::UDSScriptHelper(QJSEngine *engine)
+UDSScriptHelper::UDSScriptHelper(QJSEngine *engine, ScriptContainer *script)
 {
     scriptEngine = engine;
+    container = script;
     handler = new UDS_HANDLER;
+    handler->setParent(this);
     connect(handler, SIGNAL(newUDSMessage(UDS_MESSAGE)), this, SLOT(newUDSMessage(UDS_MESSAGE)));
+    connect(handler, &UDS_HANDLER::transmitFinished, this, &UDSScriptHelper::transmitFinished);
+    handler->setFrameSender(outboxSender(script));
     handler->setReception(true);
     handler->setFlowCtrl(true); //uds potentially requires flow control so turn it on
 }
@@ -402,16 +609,24 @@ void UDSScriptHelper::sendUDS(QJSValue bus, QJSValue id, QJSValue service, QJSVa
 
     if (msg.frameId() > 0x7FF) msg.setExtendedFrameFormat( true );
 
-    qDebug() << "sending UDS message from script";
-
     handler->sendUDSFrame(msg);
 }
 
+void UDSScriptHelper::setFrameSize(QJSValue size)
+{
+    handler->setFrameSize(size.toInt());
+}
+
 void UDSScriptHelper::setRxCallback(QJSValue cb)
 {
     gotFrameFunction = cb;
 }
 
+void UDSScriptHelper::setTxCallback(QJSValue cb)
+{
+    sentFunction = cb;
+}
+
 void UDSScriptHelper::newUDSMessage(UDS_MESSAGE msg)
 {
     //qDebug() << "udsScriptHelper got a UDS message";
@@ -425,6 +640,342 @@ void UDSScriptHelper::newUDSMessage(UDS_MESSAGE msg)
 
     for (int j = 0; j < msg.payload().length(); j++) dataBytes.setProperty(static_cast<quint32>(j), QJSValue((unsigned char)msg.payload()[j]));
     args.append(dataBytes);
-    gotFrameFunction.call(args);
+    container->callScript(gotFrameFunction, args, "gotUDSMessage");
+    container->flushOutbox();
+}
+
+void UDSScriptHelper::transmitFinished(ISOTPTransmitStats stats)
+{
+    if (!sentFunction.isCallable()) return;
+
+    QJSValueList args;
+    args << stats.bus << stats.id << stats.bytes << stats.frames << (double)(stats.elapsedNs / 1000) << stats.completed;
+    container->callScript(sentFunction, args, "sentUDSMessage");
+    container->flushOutbox();
+}
+
+
+
+
+/* J1939ScriptHelper methods */
+J1939ScriptHelper::J1939ScriptHelper(QJSEngine *engine, ScriptContainer *script)
+{
+    scriptEngine = engine;
+    container = script;
+    handler = new J1939_HANDLER;
+    handler->setParent(this);
+    connect(handler, &J1939_HANDLER::newJ1939Message, this, &J1939ScriptHelper::newJ1939Message);
+    if (MainWindow::getReference()) connect(MainWindow::getReference(), &MainWindow::framesUpdated, handler, &J1939_HANDLER::updatedFrames);
+    handler->setReception(true);
 }
 
+void J1939ScriptHelper::clearFilters()
+{
+    handler->clearPGNFilters();
+}
+
+void J1939ScriptHelper::setFilter(QJSValue pgn)
+{
+    handler->addPGNFilter(pgn.toInt());
+}
+
+//messages found in the loaded capture come in through the same callback once the run is done
+void J1939ScriptHelper::processCapture()
+{
+    handler->processCapture();
+}
+
+void J1939ScriptHelper::setRxCallback(QJSValue cb)
+{
+    gotFrameFunction = cb;
+}
+
+void J1939ScriptHelper::newJ1939Message(J1939_MESSAGE msg)
+{
+    if (!gotFrameFunction.isCallable()) return; //nothing to do if we can't even call the function
+
+    QJSValueList args;
+    args << msg.bus << msg.jid.pgn << msg.jid.src << msg.jid.dest << msg.jid.priority << static_cast<uint>(msg.payload().length());
+    QJSValue dataBytes = scriptEngine->newArray(static_cast<uint>(msg.payload().length()));
+
+    for (int j = 0; j < msg.payload().length(); j++) dataBytes.setProperty(static_cast<quint32>(j), QJSValue((unsigned char)msg.payload()[j]));
+    args.append(dataBytes);
+    container->callScript(gotFrameFunction, args, "gotJ1939Message");
+    container->flushOutbox();
+}
+
+
+
+
+/* DBCScriptHelper methods */
+DBCScriptHelper::DBCScriptHelper(QJSEngine *engine, ScriptContainer *script)
+{
+    scriptEngine = engine;
+    container = script;
+}
+
+void DBCScriptHelper::clearHandles()
+{
+    sets.clear();
+}
+
+const DBCScriptHelper::SignalSet *DBCScriptHelper::findSet(const QJSValue& handle) const
+{
+    const int idx = handle.toInt();
+    if (!handle.isNumber() || idx < 0 || idx >= sets.count()) return nullptr;
+    return &sets[idx];
+}
+
+QJSValue DBCScriptHelper::resolve(QJSValue message)
+{
+    return resolve(message, QJSValue());
+}
+
+//message is a name or an ID. Without signal names every signal of the message is taken, in DBC order
+QJSValue DBCScriptHelper::resolve(QJSValue message, QJSValue signalNames)
+{
+    const bool byName = message.isString();
+    const QString messageName = message.toString();
+    const uint32_t messageId = message.toUInt();
+    const bool allSignals = !signalNames.isArray();
+    QStringList names;
+    if (!allSignals)
+    {
+        const int count = signalNames.property("length").toInt();
+        for (int i = 0; i < count; i++) names.append(signalNames.property(static_cast<quint32>(i)).toString());
+    }
+
+    //the DBC files belong to the GUI thread so the layouts are copied out over there
+    QSharedPointer<SignalSet> set(new SignalSet);
+    QSharedPointer<QString> error(new QString);
+    const bool ran = container->runOnGuiThread([set, error, byName, messageName, messageId, allSignals, names]()
+    {
+        DBCHandler *dbcHandler = DBCHandler::getReference();
+        DBC_MESSAGE *msg = byName ? dbcHandler->findMessage(messageName) : dbcHandler->findMessage(messageId);
+        if (!msg)
+        {
+            *error = "dbc.resolve: no message " + messageName;
+            return;
+        }
+
+        set->id = msg->ID;
+        set->length = (int)msg->len;
+        if (!allSignals)
+        {
+            foreach (const QString &name, names)
+            {
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(name);
+                if (!sig)
+                {
+                    *error = "dbc.resolve: no signal " + name + " in " + msg->name;
+                    return;
+                }
+                set->names.append(sig->name);
+                set->specs.append(SignalCodec::fromSignal(sig));
+            }
+        }
+        else
+        {
+            for (int i = 0; i < msg->sigHandler->getCount(); i++)
+            {
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+                set->names.append(sig->name);
+                set->specs.append(SignalCodec::fromSignal(sig));
+            }
+        }
+    });
+    if (!ran) return QJSValue(-1);
+    if (!error->isEmpty())
+    {
+        container->log(*error);
+        return QJSValue(-1);
+    }
+
+    sets.append(*set);
+    return QJSValue(sets.count() - 1);
+}
+
+QJSValue DBCScriptHelper::signalNames(QJSValue handle)
+{
+    const SignalSet *set = findSet(handle);
+    if (!set) return QJSValue();
+    return scriptEngine->toScriptValue(set->names);
+}
+
+QJSValue DBCScriptHelper::messageId(QJSValue handle)
+{
+    const SignalSet *set = findSet(handle);
+    if (!set) return QJSValue();
+    return QJSValue(set->id);
+}
+
+QJSValue DBCScriptHelper::messageLength(QJSValue handle)
+{
+    const SignalSet *set = findSet(handle);
+    if (!set) return QJSValue();
+    return QJSValue(set->length);
+}
+
+//one value per signal of the handle, NaN for any that aren't in this payload
+QJSValue DBCScriptHelper::decode(QJSValue handle, QJSValue data)
+{
+    const SignalSet *set = findSet(handle);
+    if (!set) return QJSValue();
+
+    const QByteArray payload = ScriptFrameBatch::toBytes(data);
+    QJSValue values = scriptEngine->newArray(static_cast<uint>(set->specs.count()));
+    for (int i = 0; i < set->specs.count(); i++)
+    {
+        double value;
+        if (!SignalCodec::decode(set->specs[i], payload, value)) value = qQNaN();
+        values.setProperty(static_cast<quint32>(i), QJSValue(value));
+    }
+    return values;
+}
+
+QJSValue DBCScriptHelper::encode(QJSValue handle, QJSValue values)
+{
+    return encode(handle, values, QJSValue());
+}
+
+//puts the values into data (or a zeroed payload of the message length) and returns the bytes. NaN or missing values are skipped
+QJSValue DBCScriptHelper::encode(QJSValue handle, QJSValue values, QJSValue data)
+{
+    const SignalSet *set = findSet(handle);
+    if (!set) return QJSValue();
+
+    QByteArray payload = data.isUndefined() ? QByteArray(set->length, 0) : ScriptFrameBatch::toBytes(data);
+    for (int i = 0; i < set->specs.count(); i++)
+    {
+        const QJSValue value = values.property(static_cast<quint32>(i));
+        if (value.isNumber()) SignalCodec::encode(set->specs[i], value.toNumber(), payload);
+    }
+
+    QJSValue bytes = scriptEngine->newArray(static_cast<uint>(payload.length()));
+    for (int i = 0; i < payload.length(); i++) bytes.setProperty(static_cast<quint32>(i), QJSValue((unsigned char)payload[i]));
+    return bytes;
+}
+
+
+/* RestbusScriptHelper methods */
+RestbusScriptHelper::RestbusScriptHelper(QJSEngine *engine, ScriptContainer *script)
+{
+    scriptEngine = engine;
+    container = script;
+    //called on the restbus thread. CANConManager keeps its connections locked for the send
+    restbus = new RestbusEngine([](const QList<CANFrame>& frames)
+    {
+        CANConManager::getInstance()->sendFrames(frames);
+    });
+}
+
+RestbusScriptHelper::~RestbusScriptHelper()
+{
+    delete restbus; //stops the sending thread first
+}
+
+//names go through as they are, numbers become the decimal ID the engine keys messages by
+QString RestbusScriptHelper::messageKey(const QJSValue& message)
+{
+    return message.isNumber() ? QString::number(message.toUInt()) : message.toString();
+}
+
+QJSValue RestbusScriptHelper::start(QJSValue nodes)
+{
+    return start(nodes, QJSValue(-1));
+}
+
+//nodes is one name or an array of them. Returns how many messages are being sent
+QJSValue RestbusScriptHelper::start(QJSValue nodes, QJSValue bus)
+{
+    stop();
+
+    QStringList nodeNames;
+    if (nodes.isArray())
+    {
+        const int count = nodes.property("length").toInt();
+        for (int i = 0; i < count; i++) nodeNames.append(nodes.property(static_cast<quint32>(i)).toString());
+    }
+    else if (nodes.isString()) nodeNames.append(nodes.toString());
+
+    //planned on the GUI thread, which owns the DBC files. The plan is a copy the engine keeps to itself
+    const int busVal = bus.isNumber() ? bus.toInt() : -1;
+    const QHash<QString, bool> overrides = counterOverrides;
+    QSharedPointer<QVector<RestbusMessage>> planned(new QVector<RestbusMessage>);
+    QSharedPointer<QStringList> skipped(new QStringList);
+    const bool ran = container->runOnGuiThread([planned, skipped, nodeNames, busVal, overrides]()
+    {
+        DBCHandler *dbcHandler = DBCHandler::getReference();
+        for (int i = 0; i < dbcHandler->getFileCount(); i++)
+        {
+            *planned += RestbusPlanner::plan(dbcHandler->getFileByIdx(i), nodeNames, busVal, skipped.data(), &overrides);
+        }
+    });
+    if (!ran) return QJSValue(0);
+    const QVector<RestbusMessage> plan = *planned;
+    foreach (const QString &reason, *skipped) container->log("restbus: skipping " + reason);
+
+    if (plan.isEmpty())
+    {
+        container->log("restbus.start: no periodic messages for " + nodeNames.join(", "));
+        return QJSValue(0);
+    }
+
+    restbus->load(plan);
+    restbus->start(QThread::TimeCriticalPriority);
+    container->log("restbus: sending " + QString::number(plan.count()) + " messages");
+    return QJSValue(plan.count());
+}
+
+void RestbusScriptHelper::stop()
+{
+    restbus->stopSimulation();
+}
+
+//value is scaled like the DBC shows it. Takes effect from the next time the message is sent
+QJSValue RestbusScriptHelper::setSignal(QJSValue message, QJSValue signal, QJSValue value)
+{
+    const int handle = restbus->findSignal(messageKey(message), signal.toString());
+    if (handle < 0)
+    {
+        container->log("restbus.setSignal: no signal " + signal.toString() + " in " + message.toString());
+        return QJSValue(false);
+    }
+    return QJSValue(restbus->setSignal(handle, value.toNumber()));
+}
+
+//type is "crc8", "xor", "sum" or "none"
+QJSValue RestbusScriptHelper::setChecksum(QJSValue message, QJSValue type)
+{
+    const QString name = type.toString().toLower();
+    RestbusChecksumType checksumType;
+    if (name == "crc8") checksumType = RB_CHECKSUM_CRC8;
+    else if (name == "xor") checksumType = RB_CHECKSUM_XOR;
+    else if (name == "sum") checksumType = RB_CHECKSUM_SUM;
+    else if (name == "none") checksumType = RB_CHECKSUM_NONE;
+    else
+    {
+        container->log("restbus.setChecksum: unknown type " + type.toString());
+        return QJSValue(false);
+    }
+    return QJSValue(restbus->setChecksumType(restbus->findMessage(messageKey(message)), checksumType));
+}
+
+//overrides the guess from the signal name. Used by the next start
+void RestbusScriptHelper::setCounter(QJSValue message, QJSValue signal, QJSValue isCounter)
+{
+    counterOverrides.insert(messageKey(message).toLower() + "." + signal.toString().toLower(), isCounter.toBool());
+}
+
+QJSValue RestbusScriptHelper::stats()
+{
+    const TimingStats timing = restbus->getStats();
+    QJSValue obj = scriptEngine->newObject();
+    obj.setProperty("running", restbus->isRunning());
+    obj.setProperty("messages", restbus->getMessageCount());
+    obj.setProperty("frames", (double)restbus->getFramesSent());
+    obj.setProperty("lateAvgUs", timing.meanNs / 1000.0);
+    obj.setProperty("lateMaxUs", timing.maxNs / 1000.0);
+    obj.setProperty("lateStdDevUs", timing.stdDevNs() / 1000.0);
+    return obj;
+}
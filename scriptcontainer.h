@@ -6,50 +6,106 @@
 #include "bus_protocols/isotp_handler.h"
 #include "bus_protocols/isotp_message.h"
 #include "bus_protocols/uds_handler.h"
+#include "bus_protocols/j1939_handler.h"
+#include "utils/lfinbox.h"
+#include "scriptframebatch.h"
+#include "dbc/signalcodec.h"
+#include "restbusengine.h"
 
+#include <QAtomicInt>
 #include <QElapsedTimer>
 #include <QJSEngine>
+#include <QThread>
 #include <QTimer>
 #include <qlistwidget.h>
+#include <functional>
+
+/* how often each script reports its stats to the scripting window */
+#define SCRIPT_STATS_PERIOD_MS  1000
 
 class ScriptingWindow;
+class ScriptContainer;
+
+//What one script did over the last stats period
+struct ScriptStats
+{
+    int periodMs;
+    qint64 busyNs;          //time spent running script code on the script's own thread
+    int callbacks;
+    int frames;             //frames handed to gotCANFrame
+    qint64 totalLatencyNs;  //from a frame arriving at the connection to the script being called with it
+    qint64 maxLatencyNs;
+    int dropped;            //frames lost because the script couldn't keep up. Since the script was loaded
+
+    double cpuPercent() const
+    {
+        return periodMs > 0 ? (busyNs / 10000.0) / periodMs : 0.0;
+    }
+    double avgLatencyUs() const
+    {
+        return frames > 0 ? (totalLatencyNs / 1000.0) / frames : 0.0;
+    }
+};
+Q_DECLARE_METATYPE(ScriptStats)
 
 class CANScriptHelper: public QObject
 {
     Q_OBJECT
 public:
-    CANScriptHelper(QJSEngine *engine);
+    CANScriptHelper(QJSEngine *engine, ScriptContainer *container);
+    int getDropped() const;
 
 public slots:
     void setFilter(QJSValue id, QJSValue mask, QJSValue bus);
     void clearFilters();
     void sendFrame(QJSValue bus, QJSValue id, QJSValue length, QJSValue data);
+    void sendFrames(QJSValue batch);
     void setRxCallback(QJSValue cb);
+    void setBatchRxCallback(QJSValue cb);
 
 private slots:
     void gotTargettedFrame(const CANFrame &frame);
+    void drainInbox();
 
 private:
+    struct InboxFrame
+    {
+        CANFrame frame;
+        qint64 queuedNs;
+    };
+
+    bool matchesFilters(const CANFrame &frame);
+    void deliverBatch(QVector<CANFrame>& frames, QVector<qint64>& queuedNs);
+
     QList<CANFilter> filters;
     QJSValue gotFrameFunction;
+    QJSValue gotFramesFunction; //batch callback. Takes over from gotFrameFunction when the script has one
     QJSEngine *scriptEngine;
+    ScriptContainer *container;
+    ScriptFrameBatch batcher;
+    LFInbox<InboxFrame> inbox;  //filled from the connection threads, drained on the script thread
 };
 
 class ISOTPScriptHelper: public QObject
 {
     Q_OBJECT
 public:
-    ISOTPScriptHelper(QJSEngine *engine);
+    ISOTPScriptHelper(QJSEngine *engine, ScriptContainer *container);
 public slots:
     void setFilter(QJSValue id, QJSValue mask, QJSValue bus);
     void clearFilters();
     void sendISOTP(QJSValue bus, QJSValue id, QJSValue length, QJSValue data);
+    void setFrameSize(QJSValue size);
     void setRxCallback(QJSValue cb);
+    void setTxCallback(QJSValue cb);
 private slots:
     void newISOMessage(ISOTP_MESSAGE msg);
+    void transmitFinished(ISOTPTransmitStats stats);
 private:
     QJSValue gotFrameFunction;
+    QJSValue sentFunction;
     QJSEngine *scriptEngine;
+    ScriptContainer *container;
     ISOTP_HANDLER *handler;
 };
 
@@ -57,20 +113,121 @@ class UDSScriptHelper: public QObject
 {
     Q_OBJECT
 public:
-    UDSScriptHelper(QJSEngine *engine);
+    UDSScriptHelper(QJSEngine *engine, ScriptContainer *container);
 public slots:
     void setFilter(QJSValue id, QJSValue mask, QJSValue bus);
     void clearFilters();
     void sendUDS(QJSValue bus, QJSValue id, QJSValue service, QJSValue sublen, QJSValue subFunc, QJSValue length, QJSValue data);
+    void setFrameSize(QJSValue size);
     void setRxCallback(QJSValue cb);
+    void setTxCallback(QJSValue cb);
 private slots:
     void newUDSMessage(UDS_MESSAGE msg);
+    void transmitFinished(ISOTPTransmitStats stats);
 private:
     QJSValue gotFrameFunction;
+    QJSValue sentFunction;
     QJSEngine *scriptEngine;
+    ScriptContainer *container;
     UDS_HANDLER *handler;
 };
 
+class J1939ScriptHelper: public QObject
+{
+    Q_OBJECT
+public:
+    J1939ScriptHelper(QJSEngine *engine, ScriptContainer *container);
+public slots:
+    void setFilter(QJSValue pgn);
+    void clearFilters();
+    void processCapture();
+    void setRxCallback(QJSValue cb);
+private slots:
+    void newJ1939Message(J1939_MESSAGE msg);
+private:
+    QJSValue gotFrameFunction;
+    QJSEngine *scriptEngine;
+    ScriptContainer *container;
+    J1939_HANDLER *handler;
+};
+
+/*
+  Decoding and encoding DBC signals for scripts. resolve() looks a message and a list of its signals up
+  in the loaded DBC files once and returns a handle. decode and encode then do every signal of the handle
+  in one native call without any further name lookups. The signal layouts are copied out of the DBC at
+  resolve time, so later edits to the DBC need a new resolve.
+*/
+class DBCScriptHelper: public QObject
+{
+    Q_OBJECT
+public:
+    DBCScriptHelper(QJSEngine *engine, ScriptContainer *container);
+    void clearHandles();
+
+public slots:
+    QJSValue resolve(QJSValue message);
+    QJSValue resolve(QJSValue message, QJSValue signalNames);
+    QJSValue signalNames(QJSValue handle);
+    QJSValue messageId(QJSValue handle);
+    QJSValue messageLength(QJSValue handle);
+    QJSValue decode(QJSValue handle, QJSValue data);
+    QJSValue encode(QJSValue handle, QJSValue values);
+    QJSValue encode(QJSValue handle, QJSValue values, QJSValue data);
+
+private:
+    struct SignalSet
+    {
+        uint32_t id;
+        int length;
+        QStringList names;
+        QVector<SignalCodecSpec> specs;
+    };
+
+    const SignalSet *findSet(const QJSValue& handle) const;
+
+    QVector<SignalSet> sets;
+    QJSEngine *scriptEngine;
+    ScriptContainer *container;
+};
+
+/*
+  Simulating whole DBC nodes from a script. start() collects the periodic messages of the named nodes
+  from every loaded DBC file and hands them to a RestbusEngine, which sends them on a thread of its own
+  with their counters and checksums kept up. The script only steps in to change signal values, and those
+  frames never go through the script's outbox or wait on the script thread.
+*/
+class RestbusScriptHelper: public QObject
+{
+    Q_OBJECT
+public:
+    RestbusScriptHelper(QJSEngine *engine, ScriptContainer *container);
+    ~RestbusScriptHelper();
+
+public slots:
+    QJSValue start(QJSValue nodes);
+    QJSValue start(QJSValue nodes, QJSValue bus);
+    void stop();
+    QJSValue setSignal(QJSValue message, QJSValue signal, QJSValue value);
+    QJSValue setChecksum(QJSValue message, QJSValue type);
+    void setCounter(QJSValue message, QJSValue signal, QJSValue isCounter);
+    QJSValue stats();
+
+private:
+    static QString messageKey(const QJSValue& message);
+
+    RestbusEngine *restbus;
+    QHash<QString, bool> counterOverrides;  //see RestbusPlanner::plan
+    QJSEngine *scriptEngine;
+    ScriptContainer *container;
+};
+
+/*
+  Each script runs on a thread of its own with its own QJSEngine so a slow script only slows itself down.
+  The container and everything the script can reach (engine, helpers, timers, ISO-TP / UDS handlers) live
+  on that thread. Frames come in through a lock free inbox the connection threads push into directly and
+  frames the script sends are collected and handed to CANConManager in one batch per callback run.
+  The scripting window only talks to the container through queued calls and signals.
+*/
 class ScriptContainer : public QObject
 {
     Q_OBJECT
@@ -80,6 +237,18 @@ public:
     virtual ~ScriptContainer();
     void setScriptWindow(ScriptingWindow *win);
 
+    //script thread only. callScript times the call and logs errors, the frames it sent wait for flushOutbox
+    QJSValue callScript(QJSValue& function, const QJSValueList& args, const QString& what, qint64 queuedNs = -1);
+    void frameDelivered(qint64 queuedNs, qint64 nowNs);
+    void queueFrame(const CANFrame& frame);
+    void flushOutbox();
+    /**
+     * @brief runs work on the GUI thread and waits for it. For reading what the GUI thread owns, like the DBC files
+     * @return false if the script was closed in the meantime. work may then still run later, so it must only touch
+     * what it captured by value
+     */
+    bool runOnGuiThread(std::function<void()> work);
+
     QString fileName;
     QString filePath;
     QString scriptText;
@@ -93,26 +262,41 @@ public slots:
     void setTickInterval(QJSValue interval);
     void log(QJSValue logString);
     void addParameter(QJSValue name);
-    void updateValuesTable(QTableWidget *widget);
+    void requestValues();
     void updateParameter(QString name, QString value);
 
 signals:
     void sendLog(QString text);
+    void sendValues(QStringList names, QStringList values);
+    void statsUpdated(ScriptStats stats);
 
 private slots:
     void tick();
+    void compile(QString source);
+    void createEngine();
+    void teardown();
+    void publishStats();
 
 private:
+    QThread *workerThread;
     QJSEngine *scriptEngine;
     QJSValue compiledScript;
     QJSValue setupFunction;
     QJSValue tickFunction;
-    QTimer timer;
+    QTimer *timer;
+    QTimer *statsTimer;
+    QElapsedTimer statsPeriod;
+    ScriptStats stats;
+    QList<CANFrame> outbox;
     ScriptingWindow *window;
     CANScriptHelper *canHelper;
     ISOTPScriptHelper *isoHelper;
     UDSScriptHelper *udsHelper;
+    J1939ScriptHelper *j1939Helper;
+    DBCScriptHelper *dbcHelper;
+    RestbusScriptHelper *restbusHelper;
     QVector<QString> scriptParams;
+    QAtomicInt closing;     //set by the GUI thread before it blocks on the teardown
 };
 
 #endif // SCRIPTCONTAINER_H
@@ -0,0 +1,151 @@
+#include <cstring>
+#include "scriptframebatch.h"
+
+namespace
+{
+    //entries in a typed or plain array, 0 for anything else
+    int fieldLength(const QJSValue& field)
+    {
+        const QJSValue length = field.property("length");
+        return length.isNumber() ? length.toInt() : 0;
+    }
+
+    //the typed array whose elements are laid out exactly like T
+    template<typename T> bool sameLayout(const QString& type);
+    template<> bool sameLayout<quint8>(const QString& type) { return type == "Uint8Array" || type == "Uint8ClampedArray"; }
+    template<> bool sameLayout<quint32>(const QString& type) { return type == "Uint32Array"; }
+
+    //typed arrays of the matching type hand over their bytes as is, anything else is read an element at a time
+    template<typename T>
+    QVector<T> readField(const QJSValue& field, int count)
+    {
+        QVector<T> values(count, 0);
+        const QJSValue buffer = field.property("buffer");
+        if (buffer.isObject() && sameLayout<T>(field.property("constructor").property("name").toString()))
+        {
+            const QByteArray bytes = qjsvalue_cast<QByteArray>(buffer).mid(field.property("byteOffset").toInt(),
+                                                                            field.property("byteLength").toInt());
+            memcpy(values.data(), bytes.constData(), qMin(bytes.length(), count * (int)sizeof(T)));
+        }
+        else if (field.isObject())
+        {
+            const int available = qMin(count, fieldLength(field));
+            for (int i = 0; i < available; i++) values[i] = static_cast<T>(field.property(static_cast<quint32>(i)).toNumber());
+        }
+        return values;
+    }
+
+    template<typename T>
+    void put(QByteArray& field, int idx, T value)
+    {
+        memcpy(field.data() + idx * sizeof(T), &value, sizeof(T));
+    }
+}
+
+ScriptFrameBatch::ScriptFrameBatch(QJSEngine *engine)
+{
+    scriptEngine = engine;
+    makeBatch = scriptEngine->evaluate(
+        "(function (count, timestamps, ids, buses, lengths, offsets, data) {"
+        "    return { count: count, timestamps: new Float64Array(timestamps), ids: new Uint32Array(ids),"
+        "             buses: new Uint8Array(buses), lengths: new Uint8Array(lengths),"
+        "             offsets: new Uint32Array(offsets), data: new Uint8Array(data) };"
+        "})");
+}
+
+QJSValue ScriptFrameBatch::toScript(const QVector<CANFrame>& frames)
+{
+    const int count = frames.count();
+    QByteArray timestamps(count * (int)sizeof(double), Qt::Uninitialized);
+    QByteArray ids(count * (int)sizeof(quint32), Qt::Uninitialized);
+    QByteArray buses(count, Qt::Uninitialized);
+    QByteArray lengths(count, Qt::Uninitialized);
+    QByteArray offsets(count * (int)sizeof(quint32), Qt::Uninitialized);
+    QByteArray data;
+
+    int total = 0;
+    for (int i = 0; i < count; i++) total += frames[i].payload().length();
+    data.reserve(total);
+
+    for (int i = 0; i < count; i++)
+    {
+        const CANFrame &frame = frames[i];
+        const double stamp = frame.timeStamp().seconds() * 1000000.0 + frame.timeStamp().microSeconds();
+        put<double>(timestamps, i, stamp);
+        put<quint32>(ids, i, frame.frameId());
+        buses[i] = (char)frame.bus;
+        lengths[i] = (char)frame.payload().length();
+        put<quint32>(offsets, i, data.length());
+        data.append(frame.payload());
+    }
+
+    QJSValueList args;
+    args << count << scriptEngine->toScriptValue(timestamps) << scriptEngine->toScriptValue(ids)
+         << scriptEngine->toScriptValue(buses) << scriptEngine->toScriptValue(lengths)
+         << scriptEngine->toScriptValue(offsets) << scriptEngine->toScriptValue(data);
+    return makeBatch.call(args);
+}
+
+QList<CANFrame> ScriptFrameBatch::fromScript(const QJSValue& batch) const
+{
+    QList<CANFrame> frames;
+    const QJSValue idField = batch.property("ids");
+    const QJSValue busField = batch.property("buses");
+    const QJSValue lengthField = batch.property("lengths");
+    const QJSValue offsetField = batch.property("offsets");
+    const bool hasOffsets = !offsetField.isUndefined();
+
+    //a count larger than one of the arrays would send made up frames so only as many as every array has are taken
+    int count = batch.property("count").isNumber() ? batch.property("count").toInt() : fieldLength(idField);
+    count = qMin(count, qMin(fieldLength(idField), qMin(fieldLength(busField), fieldLength(lengthField))));
+    if (hasOffsets) count = qMin(count, fieldLength(offsetField));
+    if (count <= 0) return frames;
+
+    const QVector<quint32> ids = readField<quint32>(idField, count);
+    const QVector<quint8> buses = readField<quint8>(busField, count);
+    const QVector<quint8> lengths = readField<quint8>(lengthField, count);
+    const QJSValue dataField = batch.property("data");
+    const QVector<quint8> data = readField<quint8>(dataField, fieldLength(dataField));
+    const QVector<quint32> offsets = hasOffsets ? readField<quint32>(offsetField, count) : QVector<quint32>();
+
+    int pos = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const int len = qMin((int)lengths[i], 64);
+        if (hasOffsets) pos = (int)offsets[i];
+        if (pos < 0 || pos + len > data.count()) break;
+
+        CANFrame frame;
+        frame.setFrameId(ids[i]);
+        frame.setExtendedFrameFormat(ids[i] > 0x7FF);
+        frame.setFlexibleDataRateFormat(len > 8);
+        frame.setPayload(QByteArray(reinterpret_cast<const char *>(data.constData() + pos), len));
+        frame.bus = buses[i];
+        frames.append(frame);
+        pos += len;
+    }
+    return frames;
+}
+
+QJSValueList ScriptFrameBatch::frameArgs(const CANFrame& frame) const
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
+    int dataLen = frame.payload().length();
+
+    QJSValueList args;
+    args << frame.bus << frame.frameId() << static_cast<uint>(dataLen);
+    QJSValue dataBytes = scriptEngine->newArray(dataLen);
+
+    for (int j = 0; j < dataLen; j++) dataBytes.setProperty(j, QJSValue(data[j]));
+    args.append(dataBytes);
+    return args;
+}
+
+QByteArray ScriptFrameBatch::toBytes(const QJSValue& value)
+{
+    if (!value.property("buffer").isObject() && value.property("byteLength").isNumber()) //a bare ArrayBuffer
+        return qjsvalue_cast<QByteArray>(value);
+
+    const QVector<quint8> bytes = readField<quint8>(value, value.property("length").toInt());
+    return QByteArray(reinterpret_cast<const char *>(bytes.constData()), bytes.count());
+}
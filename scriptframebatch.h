@@ -0,0 +1,47 @@
+#ifndef SCRIPTFRAMEBATCH_H
+#define SCRIPTFRAMEBATCH_H
+
+#include <QJSEngine>
+#include <QJSValue>
+#include <QVector>
+#include "can_structs.h"
+
+/* most frames handed to a gotCANFrames callback in one call */
+#define SCRIPT_BATCH_MAX_FRAMES     1024
+
+/*
+  Moves frames between C++ and scripts a batch at a time. A batch is a plain object of typed arrays,
+  one entry per frame in each:
+
+    count       number of frames
+    timestamps  Float64Array, microseconds
+    ids         Uint32Array
+    buses       Uint8Array
+    lengths     Uint8Array
+    offsets     Uint32Array, where each frame's bytes start in data
+    data        Uint8Array, all payloads back to back
+
+  Each field is built as one QByteArray and handed over as an ArrayBuffer so the cost is a handful of
+  allocations per batch rather than an array plus a property set per byte per frame. A batch given back
+  to sendFrames can use the same typed arrays or plain arrays and may leave out timestamps and offsets.
+*/
+class ScriptFrameBatch
+{
+public:
+    ScriptFrameBatch(QJSEngine *engine);
+
+    QJSValue toScript(const QVector<CANFrame>& frames);
+    QList<CANFrame> fromScript(const QJSValue& batch) const;
+
+    /* the arguments the per frame gotCANFrame(bus, id, len, data) callback gets */
+    QJSValueList frameArgs(const CANFrame& frame) const;
+
+    /* bytes out of a typed array, an ArrayBuffer or a plain array of numbers */
+    static QByteArray toBytes(const QJSValue& value);
+
+private:
+    QJSEngine *scriptEngine;
+    QJSValue makeBatch;     //wraps the ArrayBuffers in their typed arrays on the script side
+};
+
+#endif // SCRIPTFRAMEBATCH_H
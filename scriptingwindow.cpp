@@ -167,7 +167,7 @@ void ScriptingWindow::changeCurrentScript()
 
     if (currentScript) {
         currentScript->scriptText = editor->toPlainText();
-        disconnect(this, SIGNAL(updateValueTable(QTableWidget*)), currentScript, SLOT(updateValuesTable(QTableWidget*)));
+        disconnect(this, SIGNAL(updateValueTable()), currentScript, SLOT(requestValues()));
         disconnect(this, SIGNAL(updatedParameter(QString,QString)), currentScript, SLOT(updateParameter(QString,QString)));
     }
 
@@ -175,7 +175,8 @@ void ScriptingWindow::changeCurrentScript()
     currentScript = container;
     editor->setPlainText(container->scriptText);
     editor->setEnabled(true);
-    connect(this, SIGNAL(updateValueTable(QTableWidget*)), currentScript, SLOT(updateValuesTable(QTableWidget*)));
+    ui->lblScriptStats->setText(ui->listLoadedScripts->item(sel)->toolTip());
+    connect(this, SIGNAL(updateValueTable()), currentScript, SLOT(requestValues()));
     connect(this, SIGNAL(updatedParameter(QString,QString)), currentScript, SLOT(updateParameter(QString,QString)));
 }
 
@@ -183,10 +184,65 @@ void ScriptingWindow::valuesTimerElapsed()
 {
     if (currentScript)
     {
-        emit updateValueTable(ui->tableVariables);
+        emit updateValueTable();
     }
 }
 
+void ScriptingWindow::gotValues(QStringList names, QStringList values)
+{
+    if (sender() != currentScript) return; //an answer from the script that was selected before
+    QTableWidget *widget = ui->tableVariables;
+
+    for (int p = 0; p < names.count(); p++)
+    {
+        const QString &paramName = names[p];
+        const QString &value = values[p];
+        bool found = false;
+        for (int i = 0; i < widget->rowCount(); i++)
+        {
+            if (widget->item(i, 0) && widget->item(i, 0)->text().compare(paramName) == 0)
+            {
+                found = true;
+                if (!widget->item(i, 1)->isSelected())
+                {
+                    widget->item(i,1)->setText(value);
+                }
+                break;
+            }
+        }
+        if (!found)
+        {
+            int row = widget->rowCount();
+            widget->insertRow(widget->rowCount());
+            QTableWidgetItem *item;
+            item = new QTableWidgetItem();
+            item->setText(paramName);
+            item->setFlags(Qt::ItemIsEnabled);
+            widget->setItem(row, 0, item);
+            item = new QTableWidgetItem();
+            item->setText(value);
+            widget->setItem(row, 1, item);
+        }
+    }
+}
+
+void ScriptingWindow::gotStats(ScriptStats stats)
+{
+    ScriptContainer *cont = qobject_cast<ScriptContainer*>(sender());
+    int idx = scripts.indexOf(cont);
+    if (idx < 0) return;
+
+    const double perSecond = stats.periodMs > 0 ? stats.callbacks * 1000.0 / stats.periodMs : 0.0;
+    QString text = "CPU " + QString::number(stats.cpuPercent(), 'f', 1) + "%, "
+                 + QString::number(perSecond, 'f', 0) + " calls/s, frame latency avg "
+                 + QString::number(stats.avgLatencyUs(), 'f', 0) + "us max "
+                 + QString::number(stats.maxLatencyNs / 1000) + "us";
+    if (stats.dropped > 0) text += ", " + QString::number(stats.dropped) + " frames dropped";
+
+    ui->listLoadedScripts->item(idx)->setToolTip(text);
+    if (cont == currentScript) ui->lblScriptStats->setText(text);
+}
+
 void ScriptingWindow::loadNewScript()
 {
     QString filename;
@@ -275,7 +331,7 @@ void ScriptingWindow::deleteCurrentScript()
         ui->listLoadedScripts->takeItem(sel);
         thisScript = scripts.at(sel);
         scripts.removeAt(sel);
-        delete thisScript;  //causes a seg fault. Seems to be due to currently running javascript code. No idea how to stop code from running
+        delete thisScript;  //interrupts the script if it is busy and waits for its thread to finish
         thisScript = nullptr;
         currentScript = nullptr;
 
@@ -288,6 +344,7 @@ void ScriptingWindow::deleteCurrentScript()
         {
             editor->setPlainText("");
             editor->setEnabled(false);
+            ui->lblScriptStats->clear();
         }
         break;
     case QMessageBox::No:
@@ -26,9 +26,11 @@ public:
 
 public slots:
     void log(QString text);
+    void gotValues(QStringList names, QStringList values);
+    void gotStats(ScriptStats stats);
 
 signals:
-    void updateValueTable(QTableWidget *widget);
+    void updateValueTable();
     void updatedParameter(QString name, QString value);
 
 private slots:
@@ -2,6 +2,27 @@
 
 #include "tst_lfqueue.h"
 #include "tst_cancon.h"
+#include "tst_socketcand.h"
+#include "tst_simulated.h"
+#include "tst_rangesearch.h"
+#include "tst_discretestate.h"
+#include "tst_framestats.h"
+#include "tst_graphpyramid.h"
+#include "tst_graphbuilder.h"
+#include "tst_udsscan.h"
+#include "tst_isotptransmit.h"
+#include "tst_isotpreassembly.h"
+#include "tst_j1939.h"
+#include "tst_lfinbox.h"
+#include "tst_scriptbatch.h"
+#include "tst_scriptisotp.h"
+#include "tst_signalcodec.h"
+#include "tst_framesendprogram.h"
+#include "tst_framesendschedule.h"
+#include "tst_restbus.h"
+#include "tst_restbusplanner.h"
+#include "tst_playbackscheduler.h"
+#include "tst_devclock.h"
 
 
 int main(int argc, char** argv)
@@ -15,7 +36,28 @@ int main(int argc, char** argv)
    };
 
    ASSERT_TEST(new TestLFQueue());
-   ASSERT_TEST(new TestCanCon(CANCon::SOCKETCAN, "vcan0", 1));
+   ASSERT_TEST(new TestCanCon(CANCon::SIMULATED, "ids=3;period=10", 1));
+   ASSERT_TEST(new TestSocketCANd());
+   ASSERT_TEST(new TestSimulated());
+   ASSERT_TEST(new TestRangeSearch());
+   ASSERT_TEST(new TestDiscreteState());
+   ASSERT_TEST(new TestFrameStats());
+   ASSERT_TEST(new TestGraphPyramid());
+   ASSERT_TEST(new TestGraphBuilder());
+   ASSERT_TEST(new TestUDSScan());
+   ASSERT_TEST(new TestISOTPTransmit());
+   ASSERT_TEST(new TestISOTPReassembly());
+   ASSERT_TEST(new TestJ1939());
+   ASSERT_TEST(new TestLFInbox());
+   ASSERT_TEST(new TestScriptBatch());
+   ASSERT_TEST(new TestScriptISOTP());
+   ASSERT_TEST(new TestSignalCodec());
+   ASSERT_TEST(new TestFrameSendProgram());
+   ASSERT_TEST(new TestFrameSendSchedule());
+   ASSERT_TEST(new TestRestbus());
+   ASSERT_TEST(new TestRestbusPlanner());
+   ASSERT_TEST(new TestPlaybackScheduler());
+   ASSERT_TEST(new TestDeviceClock());
 
    return status;
 }
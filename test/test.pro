@@ -1,33 +1,66 @@
-QT += core gui serialbus widgets testlib serialbus
+QT += testlib
 
+CONFIG += c++17 console
+CONFIG -= app_bundle
 
-CONFIG += c++11
+TARGET = SavvyCANTests
+TEMPLATE = app
 
-INCLUDEPATH += ../ ../connections
+#the tests link against the same sources as the application, everything but its main.cpp
+include(../SavvyCAN.pri)
+
+INCLUDEPATH += ../connections
 
 SOURCES += \
-    tst_lfqueue.cpp \
     main.cpp \
+    tst_lfqueue.cpp \
     tst_cancon.cpp \
-    ../connections/canconfactory.cpp \
-    ../connections/canconnection.cpp \
-    ../connections/gvretserial.cpp \
-    ../connections/socketcan.cpp \
-    ../canbus.cpp
-
-
-#HEADERS += \
-#    ../utils/lfqueue.h
-
-target.path= .
-INSTALLS += target
+    tst_socketcand.cpp \
+    tst_simulated.cpp \
+    tst_rangesearch.cpp \
+    tst_discretestate.cpp \
+    tst_framestats.cpp \
+    tst_graphpyramid.cpp \
+    tst_graphbuilder.cpp \
+    tst_udsscan.cpp \
+    tst_isotptransmit.cpp \
+    tst_isotpreassembly.cpp \
+    tst_j1939.cpp \
+    tst_lfinbox.cpp \
+    tst_scriptbatch.cpp \
+    tst_scriptisotp.cpp \
+    tst_signalcodec.cpp \
+    tst_framesendprogram.cpp \
+    tst_framesendschedule.cpp \
+    tst_restbus.cpp \
+    tst_restbusplanner.cpp \
+    tst_playbackscheduler.cpp \
+    tst_devclock.cpp
 
 HEADERS += \
     tst_lfqueue.h \
     tst_cancon.h \
-    ../connections/canconconst.h \
-    ../connections/canconfactory.h \
-    ../connections/canconnection.h \
-    ../connections/gvretserial.h \
-    ../connections/socketcan.h \
-    ../canbus.h
+    tst_socketcand.h \
+    tst_simulated.h \
+    tst_rangesearch.h \
+    tst_discretestate.h \
+    tst_framestats.h \
+    tst_graphpyramid.h \
+    tst_graphbuilder.h \
+    tst_udsscan.h \
+    tst_isotptransmit.h \
+    tst_isotpreassembly.h \
+    tst_j1939.h \
+    tst_lfinbox.h \
+    tst_scriptbatch.h \
+    tst_scriptisotp.h \
+    tst_signalcodec.h \
+    tst_framesendprogram.h \
+    tst_framesendschedule.h \
+    tst_restbus.h \
+    tst_restbusplanner.h \
+    tst_playbackscheduler.h \
+    tst_devclock.h
+
+target.path= .
+INSTALLS += target
@@ -1,5 +1,6 @@
 #include <QtTest>
 #include <QVector>
+#include <QSet>
 
 #include "tst_cancon.h"
 #include "canconnection.h"
@@ -18,9 +19,6 @@ do {\
         return false;\
 } while (0)
 
-Q_DECLARE_METATYPE(QVector<CANFlt>);
-
-
 
 TestCanCon::TestCanCon(CANCon::type pType, QString pPortName, int pNbBus):
     mType(pType),
@@ -43,7 +41,7 @@ void TestCanCon::connectToDevice()
     CANConnection* conn_p;
     QVERIFY(pCreate(conn_p));
 
-    QSignalSpy spy(conn_p, SIGNAL(status(CANCon::status)));
+    QSignalSpy spy(conn_p, SIGNAL(status(CANConStatus)));
 
     /* start connection */
     conn_p->start();
@@ -56,7 +54,8 @@ void TestCanCon::connectToDevice()
     QCOMPARE(spy.count(), 1); // make sure the signal was emitted exactly one time
     QList<QVariant> arguments = spy.takeFirst(); // take the first signal
 
-    QVERIFY(arguments.at(0).toInt() == CANCon::CONNECTED); // verify the first argument
+    QVERIFY(arguments.at(0).value<CANConStatus>().conStatus == CANCon::CONNECTED); // verify the first argument
+    QCOMPARE(conn_p->getStatus(), CANCon::CONNECTED);
 
     /* stop connection */
     conn_p->stop();
@@ -161,8 +160,8 @@ void TestCanCon::filter_data()
         CANFrame* canf_p = queue.peek();
         QVERIFY(pValidateFrame(conn_p, canf_p));
 
-        if(!ids.contains(canf_p->ID))
-            ids.append(canf_p->ID);
+        if(!ids.contains(canf_p->frameId()))
+            ids.append(canf_p->frameId());
 
         queue.dequeue();
     }
@@ -175,85 +174,53 @@ void TestCanCon::filter_data()
 
     /* prepare test vector */
 
-    QTest::addColumn<QVector<CANFlt>>("filters");
-    QTest::addColumn<bool>("filterOut");
-    QTest::addColumn<bool>("signalReceived");
-    QTest::addColumn<QVector<quint32>>("filtered");
-
-    QVector<CANFlt> filters;
-    QVector<quint32> filteredIds;
-
-    /* one filter no signal*/
-    filters.clear();
-    filteredIds.clear();
-    filters.append({ids[0], 0xFFFF, false});
-    filteredIds.append(ids[0]);
-    QTest::newRow("1filternosignal")        << filters << false << false << filteredIds;
-
-    /* one filter & signal*/
-    filters.clear();
-    filteredIds.clear();
-    filters.append({ids[0], 0xFFFF, true});
-    filteredIds.append(ids[0]);
-    QTest::newRow("1filtersignal")          << filters << false << true << filteredIds;
-
-    /* 3 filters */
-    filters.clear();
-    filteredIds.clear();
-    foreach(quint32 id, ids) {
-        filters.append({id, 0xFFFF, false});
-        filteredIds.append(id);
-    }
-    QTest::newRow("3filters")               << filters << false << false << filteredIds;
+    QTest::addColumn<QVector<quint32>>("targetted");
+    QTest::addColumn<quint32>("mask");
+
+    QVector<quint32> targetted;
+
+    /* one exact ID */
+    targetted.append(ids[0]);
+    QTest::newRow("1target")                << targetted << (quint32)0x7FF;
+
+    /* all 3 */
+    targetted = ids;
+    QTest::newRow("3targets")               << targetted << (quint32)0x7FF;
 }
 
 
 void TestCanCon::filter()
 {
-    QFETCH(QVector<CANFlt>, filters);
-    QFETCH(bool, filterOut);
-    QFETCH(bool, signalReceived);
-    QFETCH(QVector<quint32>, filtered);
+    QFETCH(QVector<quint32>, targetted);
+    QFETCH(quint32, mask);
 
     CANConnection* conn_p;
     QVERIFY(pCreate(conn_p));
 
+    TargettedFrameSink sink;
+    foreach(quint32 id, targetted)
+        QVERIFY(conn_p->addTargettedFrame(-1, id, mask, &sink));
+
     /* start connection */
     conn_p->start();
 
-    /* set filters */
-    for(int i=0 ; i<conn_p->getNumBuses() ; i++)
-        QVERIFY(conn_p->setFilters(i, filters, filterOut));
-
-    /* spy signal */
-    QSignalSpy spy(conn_p, SIGNAL(notify()));
-
     /* configure */
     QVERIFY(pConfig(conn_p));
 
-    LFQueue<CANFrame>& queue = conn_p->getQueue();
-
-    /* wait for frames to arrive */
+    /* wait for frames to arrive, the sink gets them through its own event loop */
     QTest::qWait(1000);
 
-    if(signalReceived)
-        QVERIFY(spy.count()>0);
-
-    int i;
-    for(i=0 ; queue.peek() && i<1000 ; i++)
+    QVERIFY(sink.frames.count() > 0);
+    QSet<quint32> seen;
+    foreach(const CANFrame& frame, sink.frames)
     {
-        CANFrame* canf_p = queue.peek();
-        QVERIFY(pValidateFrame(conn_p, canf_p));
-
-        if(filterOut)
-            QVERIFY(filtered.contains(canf_p->ID));
-
-        queue.dequeue();
+        QVERIFY(targetted.contains(frame.frameId() & mask));
+        seen.insert(frame.frameId());
     }
-
-    QVERIFY(i>0);
+    QCOMPARE(seen.count(), targetted.count());
 
     conn_p->stop();
+    QVERIFY(conn_p->removeAllTargettedFrames(&sink));
     delete conn_p;
 }
 
@@ -269,53 +236,31 @@ void TestCanCon::write()
     /* configure */
     QVERIFY(pConfig(conn_p));
 
+    LFQueue<CANFrame>& queue = conn_p->getQueue();
+
     QList<CANFrame> frames;
     /* build frames */
     CANFrame frame;
-    frame.bus       = 0;
-    frame.ID        = 0x1DE;
-    frame.data[0]   = 0xDE;
-    frame.data[1]   = 0xAD;
-    frame.data[2]   = 0xC0;
-    frame.data[3]   = 0xDE;
-    frame.len       = 4;
-
+    frame.bus = 0;
+    frame.isReceived = false; //CANConManager marks frames going out like this
+    frame.setFrameId(0x1DE);
+    frame.setPayload(QByteArray::fromHex("DEADC0DE"));
     frames.append(frame);
-
-    frame.data[2]   = 0xBE;
-    frame.data[3]   = 0xEF;
+    frame.setPayload(QByteArray::fromHex("DEADBEEF"));
     frames.append(frame);
 
-    frame.data[2]   = 0xDE;
-    frame.data[3]   = 0xAD;
-
-
-    /* bad frame length */
-    unsigned int oldVal = frame.len;
-    frame.len = 9;
-    QCOMPARE(conn_p->sendFrame(frame), false);
-    frame.len       = oldVal;
-
-    /* bad bus id */
-    oldVal = frame.bus;
-    frame.bus = 48;
-    QCOMPARE(conn_p->sendFrame(frame), false);
-    frame.bus       = oldVal;
-
-    qDebug() << "Sending DE AD DE AD";
     /* send */
     QVERIFY(conn_p->sendFrame(frame));
-
-    /* leave some time for the frame to be sent */
-    QTest::qWait(1000);
-
-    qDebug() << "Sending DE AD C0 DE";
-    qDebug() << "Sending DE AD BE EF";
-    /* send */
     QVERIFY(conn_p->sendFrames(frames));
 
-    /* leave some time for the frame to be sent */
-    QTest::qWait(1000);
+    /* sent frames are echoed into the capture as transmitted */
+    int echoed = 0;
+    for(CANFrame* canf_p = queue.peek() ; canf_p ; canf_p = queue.peek())
+    {
+        if(!canf_p->isReceived && canf_p->frameId() == 0x1DE) echoed++;
+        queue.dequeue();
+    }
+    QCOMPARE(echoed, 3);
 
     conn_p->stop();
     delete conn_p;
@@ -326,7 +271,7 @@ void TestCanCon::write()
 
 bool TestCanCon::pCreate(CANConnection*& pConn_p)
 {
-    pConn_p = CanConFactory::create(mType, mPortName);
+    pConn_p = CanConFactory::create(mType, mPortName, QString(), 0, 0, false, 0);
     QVERIFYB(pConn_p);
 
     QCOMPAREB(pConn_p->getPort(),     mPortName);
@@ -344,8 +289,7 @@ bool TestCanCon::pConfig(CANConnection* pConn_p)
     CANBus retBus;
     for(int i=0 ; i<pConn_p->getNumBuses() ; i++)
     {
-        /* TODO: fix configuration */
-        bus.active = true;
+        bus.setActive(true);
         pConn_p->setBusSettings(i, bus);
         QVERIFYB(pConn_p->getBusSettings(i, retBus));
         QCOMPAREB(bus, retBus);
@@ -359,8 +303,8 @@ bool TestCanCon::pValidateFrame(CANConnection* pConn_p, CANFrame* pCan_p)
     QVERIFYB( pCan_p );
     QVERIFYB( (0<=pCan_p->bus) && (pCan_p->bus <= pConn_p->getNumBuses()) );
     QVERIFYB( pCan_p->isReceived);
-    QVERIFYB( pCan_p->len<=8 );
-    QVERIFYB( (0<=pCan_p->ID) && (pCan_p->ID<2048) );
+    QVERIFYB( pCan_p->payload().length()<=8 );
+    QVERIFYB( pCan_p->frameId()<2048 );
 
     return true;
 }
@@ -2,9 +2,20 @@
 #define TESTCANCON_H
 
 #include <QObject>
+#include <QList>
 #include "canconconst.h"
 #include "canconnection.h"
 
+/* stands in for a window that registered targetted frames */
+class TargettedFrameSink: public QObject
+{
+    Q_OBJECT
+public:
+    QList<CANFrame> frames;
+public slots:
+    void gotTargettedFrame(CANFrame frame) { frames.append(frame); }
+};
+
 class TestCanCon: public QObject
 {
     Q_OBJECT
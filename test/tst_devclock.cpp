@@ -0,0 +1,68 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "tst_devclock.h"
+#include "connections/cantimebase.h"
+
+/* one frame per batch every 10ms, the device read out with a constant 300us of latency */
+void TestDeviceClock::wrap()
+{
+    DeviceClock clock(0x100000); //a 20 bit microsecond counter, rolls over about once a second
+    const qint64 deviceStart = 0xF0000;
+    qint64 first = -1;
+
+    for (int i = 0; i < 500; i++)
+    {
+        const qint64 host = 50000 + i * 10000;
+        clock.beginBatch(false, host + 300);
+        const quint64 stamp = clock.stamp((quint64)((deviceStart + i * 10000) & 0xFFFFF));
+        if (first < 0) first = (qint64)stamp;
+        QCOMPARE((qint64)stamp - first, (qint64)i * 10000);
+    }
+}
+
+
+/* device crystal 50ppm fast, random latency. The drift has to be found and the stamps stay close to the truth */
+void TestDeviceClock::drift()
+{
+    DeviceClock clock;
+    QRandomGenerator rng(1234);
+    qint64 worst = 0;
+
+    for (int i = 0; i < 3000; i++)
+    {
+        const qint64 truth = 100000 + i * 10000;
+        const qint64 device = 777777 + (qint64)(truth * 1.00005);
+        clock.beginBatch(false, truth + 100 + rng.bounded(400));
+        const qint64 stamp = (qint64)clock.stamp((quint64)device);
+        //give it a couple of windows to settle
+        if (i > 1000) worst = qMax(worst, qAbs(stamp - truth));
+    }
+
+    QVERIFY(qAbs(clock.getDriftPpm() + 50.0) < 5.0);
+    QVERIFY(worst < 600);
+}
+
+
+/* the device restarts its clock at 0 halfway through. Stamps have to keep following the host */
+void TestDeviceClock::deviceReset()
+{
+    DeviceClock clock;
+    qint64 last = -1;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        const qint64 host = 100000 + i * 10000;
+        const qint64 device = (i < 500) ? 3000000 + i * 10000 : (i - 500) * 10000;
+        clock.beginBatch(false, host + 200);
+        const qint64 stamp = (qint64)clock.stamp((quint64)device);
+
+        if (last >= 0)
+        {
+            QVERIFY(stamp >= last);
+            QVERIFY(stamp - last <= 10000);
+        }
+        QVERIFY(qAbs(stamp - host) <= 10000);
+        last = stamp;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef TST_DEVCLOCK_H
+#define TST_DEVCLOCK_H
+
+#include <QObject>
+
+class TestDeviceClock: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void wrap();
+    void drift();
+    void deviceReset();
+};
+
+#endif // TST_DEVCLOCK_H
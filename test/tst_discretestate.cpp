@@ -0,0 +1,77 @@
+#include <QtTest>
+
+#include "tst_discretestate.h"
+#include "re/discretestatesolver.h"
+
+static CANFrame makeFrame(quint32 id, const QByteArray& payload)
+{
+    CANFrame frame;
+    frame.setFrameId(id);
+    frame.setPayload(payload);
+    return frame;
+}
+
+
+/* a 2 bit, 3 state field in byte 2 next to constant bits and a counter */
+void TestDiscreteState::logged()
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<300 ; i++) {
+        QByteArray payload(8, 0);
+        payload[2] = (char)(0x90 | (((i / 20) % 3) << 2));
+        payload[5] = (char)i;
+        frames.append(makeFrame(0x123, payload));
+    }
+
+    const QVector<DiscreteStateMatch> matches = DiscreteStateSolver::solveID(0x123, frames, 3, 1, 8);
+    QCOMPARE(matches.count(), 1);
+    QCOMPARE(matches[0].id, 0x123u);
+    QCOMPARE(matches[0].startBit, 18);
+    QCOMPARE(matches[0].bitLength, 2);
+    QCOMPARE(matches[0].values, QVector<int>({0, 1, 2}));
+
+    QVERIFY(DiscreteStateSolver::solveID(0x123, frames, 4, 1, 8).isEmpty());
+}
+
+
+void TestDiscreteState::bucketing()
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<100 ; i++) frames.append(makeFrame(0x100 + (i % 5), QByteArray(1, (char)i)));
+
+    QHash<uint32_t, QVector<CANFrame>> buckets = DiscreteStateSolver::bucketFrames(frames, QSet<uint32_t>({0x101, 0x103, 0x200}));
+    QCOMPARE(buckets.count(), 2);
+    QCOMPARE(buckets[0x101].count(), 20);
+    QCOMPARE(buckets[0x103].count(), 20);
+    for(int i=0 ; i<20 ; i++) QCOMPARE(buckets[0x103][i].payload(), QByteArray(1, (char)(i * 5 + 3)));
+}
+
+
+/* steady value per state wins, a field that moves inside a state doesn't */
+void TestDiscreteState::realtime()
+{
+    DiscreteStateTracker tracker;
+    tracker.start(3, 1, 8);
+
+    for(int state=0 ; state<3 ; state++) {
+        for(int k=0 ; k<10 ; k++) {
+            QByteArray payload(8, 0);
+            payload[3] = (char)(state << 2);
+            payload[6] = (char)(k * state);
+            tracker.addFrame(makeFrame(0x321, payload), state);
+            tracker.addFrame(makeFrame(0x400, QByteArray(2, (char)k)), state);
+        }
+    }
+
+    QVector<DiscreteStateMatch> matches = tracker.getMatches();
+    QCOMPARE(matches.count(), 1);
+    QCOMPARE(matches[0].id, 0x321u);
+    QCOMPARE(matches[0].startBit, 26);
+    QCOMPARE(matches[0].bitLength, 2);
+    QCOMPARE(matches[0].values, QVector<int>({0, 1, 2}));
+
+    /* a state nobody held yet means no match */
+    tracker.start(4, 1, 8);
+    tracker.addFrame(makeFrame(0x321, QByteArray(8, 1)), 0);
+    QVERIFY(tracker.getMatches().isEmpty());
+}
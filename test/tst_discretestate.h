@@ -0,0 +1,17 @@
+#ifndef TST_DISCRETESTATE_H
+#define TST_DISCRETESTATE_H
+
+#include <QObject>
+
+class TestDiscreteState: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void logged();
+    void bucketing();
+    void realtime();
+};
+
+#endif // TST_DISCRETESTATE_H
@@ -0,0 +1,290 @@
+#include <QtTest>
+
+#include "tst_framesendprogram.h"
+#include "framesendprogram.h"
+
+static Trigger makeTrigger(uint32_t mask, int id, int bus)
+{
+    Trigger trig;
+    trig.readyCount = false;
+    trig.ID = id;
+    trig.milliseconds = 0;
+    trig.msCounter = 0;
+    trig.maxCount = -1;
+    trig.currCount = 0;
+    trig.bus = bus;
+    trig.sigValueInt = 0;
+    trig.sigValueDbl = 0.0;
+    trig.triggerMask = mask;
+    return trig;
+}
+
+static FrameSendData makeRow(uint32_t id, const QByteArray& payload)
+{
+    FrameSendData row;
+    row.enabled = true;
+    row.count = 0;
+    row.bus = 0;
+    row.setFrameId(id);
+    row.setPayload(payload);
+    return row;
+}
+
+static CANFrame makeFrame(int bus, uint32_t id, const QByteArray& payload)
+{
+    CANFrame frame;
+    frame.bus = bus;
+    frame.setFrameId(id);
+    frame.setPayload(payload);
+    return frame;
+}
+
+static ModifierOperand operand(int id, int databyte, int bus = -1)
+{
+    ModifierOperand op;
+    op.ID = id;
+    op.bus = bus;
+    op.databyte = databyte;
+    op.notOper = false;
+    return op;
+}
+
+/* byte 2 as an unsigned 8 bit signal called "Gear" of every message */
+static bool gearResolver(uint32_t, const QString& sigName, SignalCodecSpec& spec)
+{
+    if (sigName != "Gear") return false;
+    spec.signalSize = 8;
+    spec.valType = UNSIGNED_INT;
+    spec.factor = 1.0;
+    spec.bias = 0.0;
+    spec.neverPresent = false;
+    spec.segments = SignalCodec::layout(16, 8, true);
+    spec.minLength = 3;
+    spec.muxChecks.clear();
+    return true;
+}
+
+
+void TestFrameSendProgram::idTriggers()
+{
+    QList<FrameSendData> rows;
+    rows.append(makeRow(0x500, QByteArray(8, 0)));
+    rows[0].triggers.append(makeTrigger(TRG_ID, 0x100, -1));
+    rows.append(makeRow(0x501, QByteArray(8, 0)));
+    rows[1].triggers.append(makeTrigger(TRG_ID | TRG_BUS, 0x100, 1));
+    rows.append(makeRow(0x502, QByteArray(8, 0)));
+    rows[2].triggers.append(makeTrigger(TRG_BUS, 0, 2));
+    rows.append(makeRow(0x503, QByteArray(8, 0)));
+    rows[3].triggers.append(makeTrigger(TRG_MS, 0, -1)); //timed only, never reacts to frames
+
+    FrameSendProgram program;
+    program.compile(rows, gearResolver);
+    QCOMPARE(program.getTriggerCount(), 3);
+
+    QList<CANFrame> out;
+    QCOMPARE(program.processFrame(makeFrame(0, 0x100, QByteArray(8, 0)), rows, out), 1);
+    QCOMPARE(out[0].frameId(), 0x500u);
+
+    out.clear();
+    QCOMPARE(program.processFrame(makeFrame(1, 0x100, QByteArray(8, 0)), rows, out), 2);
+
+    out.clear();
+    QCOMPARE(program.processFrame(makeFrame(2, 0x333, QByteArray(8, 0)), rows, out), 1);
+    QCOMPARE(out[0].frameId(), 0x502u);
+
+    out.clear();
+    QCOMPARE(program.processFrame(makeFrame(0, 0x101, QByteArray(8, 0)), rows, out), 0);
+    QCOMPARE(rows[0].count, 2);
+    QCOMPARE(rows[0].triggers[0].currCount, 2);
+    QCOMPARE(rows[3].count, 0);
+}
+
+
+void TestFrameSendProgram::countAndDelay()
+{
+    QList<FrameSendData> rows;
+    rows.append(makeRow(0x500, QByteArray(8, 0)));
+    Trigger limited = makeTrigger(TRG_ID | TRG_COUNT, 0x100, -1);
+    limited.maxCount = 2;
+    rows[0].triggers.append(limited);
+    rows.append(makeRow(0x501, QByteArray(8, 0)));
+    Trigger delayed = makeTrigger(TRG_ID | TRG_MS, 0x100, -1);
+    delayed.milliseconds = 20;
+    rows[1].triggers.append(delayed);
+
+    FrameSendProgram program;
+    program.compile(rows, gearResolver);
+
+    QList<CANFrame> out;
+    QVector<QPair<int, int>> armed;
+    for (int i = 0; i < 5; i++) program.processFrame(makeFrame(0, 0x100, QByteArray(8, 0)), rows, out, &armed);
+    QCOMPARE(out.count(), 2);
+    QCOMPARE(rows[0].triggers[0].currCount, 2);
+    //the delayed one is only armed for the timer, and only once until it has been sent
+    QVERIFY(rows[1].triggers[0].readyCount);
+    QCOMPARE(rows[1].count, 0);
+    QCOMPARE(armed.count(), 1);
+    QCOMPARE(armed[0], qMakePair(1, 0));
+}
+
+
+void TestFrameSendProgram::signalTriggers()
+{
+    QList<FrameSendData> rows;
+    rows.append(makeRow(0x500, QByteArray(8, 0)));
+    Trigger onValue = makeTrigger(TRG_ID | TRG_SIGNAL | TRG_SIGVAL, 0x100, -1);
+    onValue.sigName = "Gear";
+    onValue.sigValueDbl = 3.0;
+    rows[0].triggers.append(onValue);
+    rows.append(makeRow(0x501, QByteArray(8, 0)));
+    Trigger unknown = makeTrigger(TRG_ID | TRG_SIGNAL, 0x100, -1);
+    unknown.sigName = "NoSuchSignal";
+    rows[1].triggers.append(unknown);
+
+    FrameSendProgram program;
+    program.compile(rows, gearResolver);
+
+    QByteArray payload(8, 0);
+    QList<CANFrame> out;
+    for (int gear = 0; gear < 6; gear++) {
+        payload[2] = (char)gear;
+        program.processFrame(makeFrame(0, 0x100, payload), rows, out);
+    }
+    QCOMPARE(out.count(), 1);
+    QCOMPARE(out[0].frameId(), 0x500u);
+
+    //too short to hold the signal
+    out.clear();
+    program.processFrame(makeFrame(0, 0x100, QByteArray(2, 3)), rows, out);
+    QCOMPARE(out.count(), 0);
+}
+
+
+/* D0 = D0 + 1, D1 = ID:0x200:D3 ^ 0xFF, D2 = D1 / 0, [Gear] = ~D0 & 7. Gear is byte 2 so it has the last word there */
+void TestFrameSendProgram::modifiers()
+{
+    QList<FrameSendData> rows;
+    rows.append(makeRow(0x500, QByteArray(4, 0)));
+    QList<Modifier> &mods = rows[0].modifiers;
+
+    Modifier inc;
+    inc.destByte = 0;
+    ModifierOp op;
+    op.first = operand(-2, 0);
+    op.operation = ADDITION;
+    op.second = operand(0, 1);
+    inc.operations.append(op);
+    mods.append(inc);
+
+    Modifier other;
+    other.destByte = 1;
+    op.first = operand(0x200, 3);
+    op.operation = XOR;
+    op.second = operand(0, 0xFF);
+    other.operations.append(op);
+    mods.append(other);
+
+    Modifier divide;
+    divide.destByte = 2;
+    op.first = operand(-2, 1);
+    op.operation = DIVISION;
+    op.second = operand(0, 0);
+    divide.operations.append(op);
+    mods.append(divide);
+
+    Modifier sig;
+    sig.destByte = -1;
+    sig.signalName = "Gear";
+    op.first = operand(-2, 0);
+    op.first.notOper = true;
+    op.operation = AND;
+    op.second = operand(0, 7);
+    sig.operations.append(op);
+    mods.append(sig);
+
+    FrameSendProgram program;
+    program.compile(rows, gearResolver);
+    QCOMPARE(program.getInstructionCount(), 12);
+
+    //nothing from 0x200 yet so that operand reads as 0
+    program.runModifiers(0, rows[0]);
+    QCOMPARE(rows[0].payload(), QByteArray::fromHex("01ff0600"));
+
+    QList<CANFrame> out;
+    program.processFrame(makeFrame(0, 0x200, QByteArray::fromHex("000000f0")), rows, out);
+    program.runModifiers(0, rows[0]);
+    QCOMPARE(rows[0].payload(), QByteArray::fromHex("020f0500"));
+}
+
+
+void TestFrameSendProgram::busAwareOperands()
+{
+    QList<FrameSendData> rows;
+    rows.append(makeRow(0x500, QByteArray(2, 0)));
+    Modifier fromBus1;
+    fromBus1.destByte = 0;
+    ModifierOp op;
+    op.first = operand(0x200, 0, 1);
+    op.operation = ADDITION;
+    op.second = operand(0, 0);
+    fromBus1.operations.append(op);
+    rows[0].modifiers.append(fromBus1);
+    Modifier fromAny;
+    fromAny.destByte = 1;
+    op.first = operand(0x200, 0, -1);
+    fromAny.operations.append(op);
+    rows[0].modifiers.append(fromAny);
+
+    FrameSendProgram program;
+    program.compile(rows, gearResolver);
+    QVERIFY(program.hasWatches());
+    QCOMPARE(program.emptySlots(), 2);
+
+    QList<CANFrame> out;
+    program.processFrame(makeFrame(1, 0x200, QByteArray(1, 0x11)), rows, out);
+    program.processFrame(makeFrame(0, 0x200, QByteArray(1, 0x22)), rows, out);
+    QCOMPARE(program.emptySlots(), 0);
+
+    //bus 1 keeps its own frame even though bus 0 sent the same ID after it
+    program.runModifiers(0, rows[0]);
+    QCOMPARE(rows[0].payload(), QByteArray::fromHex("1122"));
+
+    //seeding only fills what is still empty
+    program.compile(rows, gearResolver);
+    QVERIFY(program.seedFrame(makeFrame(0, 0x200, QByteArray(1, 0x33))));
+    QVERIFY(!program.seedFrame(makeFrame(0, 0x200, QByteArray(1, 0x44))));
+    QCOMPARE(program.emptySlots(), 1);
+}
+
+
+/* hundreds of rows each waiting on its own ID, fed a stream of mostly unrelated traffic */
+void TestFrameSendProgram::manyRows()
+{
+    QList<FrameSendData> rows;
+    for (int i = 0; i < 500; i++) {
+        rows.append(makeRow(0x600 + i, QByteArray(8, 0)));
+        rows[i].triggers.append(makeTrigger(TRG_ID | TRG_BUS, 0x100 + i, 0));
+        Modifier counter;
+        counter.destByte = 0;
+        ModifierOp op;
+        op.first = operand(-2, 0);
+        op.operation = ADDITION;
+        op.second = operand(0, 1);
+        counter.operations.append(op);
+        rows[i].modifiers.append(counter);
+    }
+
+    QVector<CANFrame> traffic;
+    for (int i = 0; i < 10000; i++) traffic.append(makeFrame(i % 2, 0x100 + (i % 1000), QByteArray(8, (char)i)));
+
+    FrameSendProgram program;
+    program.compile(rows, gearResolver);
+
+    QList<CANFrame> out;
+    QBENCHMARK {
+        out.clear();
+        foreach (const CANFrame& frame, traffic) program.processFrame(frame, rows, out);
+    }
+    //bus 0 carries the even indexes, half of which are in the first 500 IDs
+    QCOMPARE(out.count(), 2500);
+}
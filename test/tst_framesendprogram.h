@@ -0,0 +1,20 @@
+#ifndef TST_FRAMESENDPROGRAM_H
+#define TST_FRAMESENDPROGRAM_H
+
+#include <QObject>
+
+class TestFrameSendProgram: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void idTriggers();
+    void countAndDelay();
+    void signalTriggers();
+    void modifiers();
+    void busAwareOperands();
+    void manyRows();
+};
+
+#endif // TST_FRAMESENDPROGRAM_H
@@ -0,0 +1,100 @@
+#include <QtTest>
+
+#include "tst_framesendschedule.h"
+#include "framesendschedule.h"
+
+static SendScheduleEntry makeEntry(int row, qint64 dueNs, qint64 periodNs)
+{
+    SendScheduleEntry entry;
+    entry.dueNs = dueNs;
+    entry.periodNs = periodNs;
+    entry.lastSentNs = -1;
+    entry.row = row;
+    entry.trigger = 0;
+    entry.oneShot = false;
+    return entry;
+}
+
+
+void TestFrameSendSchedule::ordering()
+{
+    FrameSendSchedule schedule;
+    QCOMPARE(schedule.nextDue(), -1ll);
+
+    const qint64 dues[] = {500, 100, 900, 300, 700, 100};
+    for (int i = 0; i < 6; i++) schedule.add(makeEntry(i, dues[i], 0));
+    QCOMPARE(schedule.count(), 6);
+    QCOMPARE(schedule.nextDue(), 100ll);
+
+    QVector<SendScheduleEntry> out;
+    QCOMPARE(schedule.takeDue(1000, out), 6);
+    for (int i = 1; i < out.count(); i++) QVERIFY(out[i - 1].dueNs <= out[i].dueNs);
+    //same deadline comes out in row order
+    QCOMPARE(out[0].row, 1);
+    QCOMPARE(out[1].row, 5);
+    QCOMPARE(schedule.nextDue(), -1ll);
+}
+
+
+void TestFrameSendSchedule::batching()
+{
+    FrameSendSchedule schedule;
+    for (int i = 0; i < 10; i++) schedule.add(makeEntry(i, 1000 + i * 10, 0));
+    schedule.add(makeEntry(10, 5000, 0));
+
+    //everything within a slot of the first deadline goes together, the rest waits
+    QVector<SendScheduleEntry> out;
+    QCOMPARE(schedule.takeDue(1000 + 100, out), 10);
+    QCOMPARE(schedule.nextDue(), 5000ll);
+    out.clear();
+    QCOMPARE(schedule.takeDue(4999, out), 0);
+}
+
+
+void TestFrameSendSchedule::reschedule()
+{
+    FrameSendSchedule schedule;
+
+    //on time: one period on from the deadline, not from when it was sent
+    schedule.reschedule(makeEntry(0, 10000, 10000), 10300);
+    QCOMPARE(schedule.nextDue(), 20000ll);
+
+    //more than a period behind: the missed ones are skipped, the phase is kept
+    schedule.clear();
+    schedule.reschedule(makeEntry(0, 10000, 10000), 45000);
+    QCOMPARE(schedule.nextDue(), 50000ll);
+
+    //one shots don't come back
+    schedule.clear();
+    schedule.reschedule(makeEntry(0, 10000, 0), 10000);
+    QCOMPARE(schedule.count(), 0);
+}
+
+
+/* 300 frames at a mix of periods for ten simulated seconds. Each should be sent exactly as often as its period says */
+void TestFrameSendSchedule::restbusLoad()
+{
+    const qint64 periods[] = {10000000, 20000000, 50000000, 100000000, 1000000000};
+    QVector<int> sent(300, 0);
+
+    QBENCHMARK {
+        FrameSendSchedule schedule;
+        sent.fill(0);
+        for (int i = 0; i < 300; i++) schedule.add(makeEntry(i, periods[i % 5], periods[i % 5]));
+
+        QVector<SendScheduleEntry> due;
+        qint64 now = 0;
+        while (true) {
+            now = schedule.nextDue();
+            if (now > 10000000000ll) break;
+            due.clear();
+            schedule.takeSlot(now, due);
+            foreach (const SendScheduleEntry& entry, due) {
+                sent[entry.row]++;
+                schedule.reschedule(entry, now);
+            }
+        }
+    }
+
+    for (int i = 0; i < 300; i++) QCOMPARE((qint64)sent[i], 10000000000ll / periods[i % 5]);
+}
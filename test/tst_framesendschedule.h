@@ -0,0 +1,18 @@
+#ifndef TST_FRAMESENDSCHEDULE_H
+#define TST_FRAMESENDSCHEDULE_H
+
+#include <QObject>
+
+class TestFrameSendSchedule: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void ordering();
+    void batching();
+    void reschedule();
+    void restbusLoad();
+};
+
+#endif // TST_FRAMESENDSCHEDULE_H
@@ -0,0 +1,103 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "tst_framestats.h"
+#include "re/framestatistics.h"
+
+/* noisy low nibbles, slow counters, a few longer frames and one timestamp going backwards */
+static QVector<CANFrame> makeFrames(int count, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QVector<CANFrame> frames;
+    qint64 time = 0;
+    for(int i=0 ; i<count ; i++) {
+        const int len = (i % 97 == 0) ? 12 : 8;
+        QByteArray payload(len, 0);
+        for(int c=0 ; c<len ; c++)
+            payload[c] = (c < 3) ? (char)(rng.generate() & 0x0F) : (char)(i >> c);
+        time += 1000 + rng.bounded(300);
+        if(i == 40) time -= 5000;
+
+        CANFrame frame;
+        frame.setFrameId(0x123);
+        frame.setPayload(payload);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, time));
+        frames.append(frame);
+    }
+    return frames;
+}
+
+
+void TestFrameStats::counts()
+{
+    QVector<CANFrame> frames;
+    const char values[] = {0x01, 0x03, 0x02, 0x02};
+    for(int i=0 ; i<4 ; i++) {
+        CANFrame frame;
+        frame.setFrameId(0x10);
+        frame.setPayload(QByteArray(1, values[i]));
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, i * 1000));
+        frames.append(frame);
+    }
+
+    FrameStatistics stats;
+    foreach(const CANFrame& frame, frames) stats.addFrame(frame, QVector<SignalKeyLayout>());
+
+    QCOMPARE(stats.numFrames, 4ull);
+    QCOMPARE(stats.maxLen, 1);
+    QCOMPARE(stats.intervals.count(), 3);
+    QCOMPARE(stats.minInterval, (int64_t)1000);
+    QCOMPARE(stats.bytes[0].changedBits, (quint8)0x03);
+    QCOMPARE(stats.bytes[0].min, (quint8)1);
+    QCOMPARE(stats.bytes[0].max, (quint8)3);
+    QCOMPARE(stats.bytes[0].histogram[2], 2u);
+    QCOMPARE(stats.bytes[0].bitCount[0], 2u);
+    QCOMPARE(stats.bytes[0].bitFlips[0], 1u);  //3 -> 2
+    QCOMPARE(stats.bytes[0].bitFlips[1], 1u);  //1 -> 3
+}
+
+
+/* statistics built per chunk and appended have to be exactly what one pass produces */
+void TestFrameStats::chunksMatchSequential()
+{
+    const QVector<CANFrame> frames = makeFrames(5000, 7);
+    QVector<SignalKeyLayout> sigs(2);
+    sigs[0] = SignalKeyLayout{0, 4, 0, true, QVector<SignalKeyLayout>()};
+    sigs[1] = SignalKeyLayout{8, 8, 0, true, QVector<SignalKeyLayout>()};
+
+    FrameStatistics whole;
+    foreach(const CANFrame& frame, frames) whole.addFrame(frame, sigs);
+
+    FrameStatistics merged;
+    const int cuts[] = {0, 1, 777, 778, 3000, 5000};
+    for(int k=0 ; k<5 ; k++) {
+        FrameStatistics part;
+        for(int i=cuts[k] ; i<cuts[k + 1] ; i++) part.addFrame(frames[i], sigs);
+        merged.append(part);
+    }
+
+    QCOMPARE(merged.numFrames, whole.numFrames);
+    QCOMPARE(merged.minLen, whole.minLen);
+    QCOMPARE(merged.maxLen, whole.maxLen);
+    QCOMPARE(merged.intervals, whole.intervals);
+    QCOMPARE(merged.minInterval, whole.minInterval);
+    QCOMPARE(merged.maxInterval, whole.maxInterval);
+    QCOMPARE(merged.bytes.count(), whole.bytes.count());
+    for(int c=0 ; c<whole.bytes.count() ; c++)
+        QVERIFY(memcmp(&merged.bytes[c], &whole.bytes[c], sizeof(FrameByteStats)) == 0);
+    for(int c=0 ; c<FRAMESTATS_GRAPH_BYTES ; c++)
+        QCOMPARE(merged.byteSeries[c], whole.byteSeries[c]);
+    for(int i=0 ; i<sigs.count() ; i++) {
+        QCOMPARE(merged.signalValues[i].count(), whole.signalValues[i].count());
+        foreach(const QByteArray& key, whole.signalValues[i].keys())
+            QCOMPARE(merged.signalValues[i][key].count, whole.signalValues[i][key].count);
+    }
+
+    //order statistics against a plain sort
+    QVector<int64_t> sorted = whole.intervals;
+    std::sort(sorted.begin(), sorted.end());
+    int64_t pctl5, pctl95;
+    whole.intervalPercentiles(pctl5, pctl95);
+    QCOMPARE(pctl5, sorted[static_cast<int>(0.05 * sorted.count())]);
+    QCOMPARE(pctl95, sorted[static_cast<int>(0.95 * sorted.count())]);
+}
@@ -0,0 +1,16 @@
+#ifndef TST_FRAMESTATS_H
+#define TST_FRAMESTATS_H
+
+#include <QObject>
+
+class TestFrameStats: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void counts();
+    void chunksMatchSequential();
+};
+
+#endif // TST_FRAMESTATS_H
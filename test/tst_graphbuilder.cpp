@@ -0,0 +1,123 @@
+#include <QtTest>
+
+#include "tst_graphbuilder.h"
+#include "re/graphbuilder.h"
+
+static GraphDecodeSpec makeSpec()
+{
+    GraphDecodeSpec spec;
+    spec.bus = -1;
+    spec.startBit = 8;
+    spec.numBits = 8;
+    spec.intelFormat = true;
+    spec.isSigned = false;
+    spec.scale = 0.5;
+    spec.bias = 10.0;
+    spec.stride = 1;
+    spec.xbias = 0;
+    spec.timeStyle = TS_SECONDS;
+    spec.hasSignal = false;
+    return spec;
+}
+
+/* byte 0 is the multiplexor, byte 1 counts up, odd frames are on bus 1 */
+static QVector<CANFrame> makeFrames(int count)
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<count ; i++) {
+        QByteArray payload(8, 0);
+        payload[0] = (char)(i % 4);
+        payload[1] = (char)(i & 0xFF);
+
+        CANFrame frame;
+        frame.setFrameId(0x200);
+        frame.bus = i & 1;
+        frame.setPayload(payload);
+        frame.setFrameType(QCanBusFrame::DataFrame);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, i * 1000));
+        frames.append(frame);
+    }
+    return frames;
+}
+
+static QVector<int> allRows(int count)
+{
+    QVector<int> rows;
+    for(int i=0 ; i<count ; i++) rows.append(i);
+    return rows;
+}
+
+
+void TestGraphBuilder::decodes()
+{
+    const QVector<CANFrame> frames = makeFrames(10);
+    GraphDecodeSpec spec = makeSpec();
+    spec.bus = 1;
+    spec.stride = 2;
+
+    GraphBuilder builder(spec, frames, allRows(10));
+    builder.run();
+    QVERIFY(builder.isFinished());
+
+    //bus 1 is frames 1, 3, 5, 7, 9 and every second one of those is taken
+    GraphColumns cols;
+    QVERIFY(builder.takeSamples(cols));
+    QCOMPARE(cols.x, QVector<double>({0.001, 0.005, 0.009}));
+    QCOMPARE(cols.raw, QVector<int64_t>({1, 5, 9}));
+    QCOMPARE(cols.y, QVector<double>({10.5, 12.5, 14.5}));
+    QVERIFY(!builder.takeSamples(cols));
+}
+
+
+void TestGraphBuilder::multiplexed()
+{
+    const QVector<CANFrame> frames = makeFrames(8);
+    GraphDecodeSpec spec = makeSpec();
+    spec.hasSignal = true;
+    spec.signal.segments = SignalCodec::layout(8, 8, true);
+    spec.signal.signalSize = 8;
+    spec.signal.valType = UNSIGNED_INT;
+    spec.signal.factor = 0.5;
+    spec.signal.bias = 10.0;
+    spec.signal.minLength = 2;
+    spec.signal.neverPresent = false;
+    SignalCodecMux mux = {SignalCodec::layout(0, 8, true), 8, false, 1.0, 0.0, 1, 2};
+    spec.signal.muxChecks.append(mux);
+
+    GraphBuilder builder(spec, frames, allRows(8));
+    builder.run();
+    GraphColumns cols;
+    QVERIFY(builder.takeSamples(cols));
+    QCOMPARE(cols.raw, QVector<int64_t>({1, 2, 5, 6}));
+
+    spec.signal.neverPresent = true;
+    GraphBuilder never(spec, frames, allRows(8));
+    never.run();
+    QVERIFY(never.isFinished());
+    QVERIFY(!never.takeSamples(cols));
+}
+
+
+/* samples come out a chunk at a time in order, and a canceled build stops with what it had */
+void TestGraphBuilder::chunksAndCancel()
+{
+    const int count = GRAPHBUILD_CHUNK_ROWS * 3 + 17;
+    const QVector<CANFrame> frames = makeFrames(count);
+
+    GraphBuilder builder(makeSpec(), frames, allRows(count));
+    builder.run();
+    QCOMPARE(builder.getRowsDone(), count);
+    GraphColumns cols;
+    QVERIFY(builder.takeSamples(cols));
+    QCOMPARE(cols.x.count(), count);
+    for(int i=0 ; i<count ; i++) QCOMPARE(cols.raw[i], (int64_t)(i & 0xFF));
+
+    GraphBuilder canceled(makeSpec(), frames, allRows(count));
+    canceled.cancel();
+    canceled.run();
+    QVERIFY(canceled.isFinished());
+    QVERIFY(canceled.isCanceled());
+    QCOMPARE(canceled.getRowsDone(), 0);
+    GraphColumns none;
+    QVERIFY(!canceled.takeSamples(none));
+}
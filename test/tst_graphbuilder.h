@@ -0,0 +1,17 @@
+#ifndef TST_GRAPHBUILDER_H
+#define TST_GRAPHBUILDER_H
+
+#include <QObject>
+
+class TestGraphBuilder: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void decodes();
+    void multiplexed();
+    void chunksAndCancel();
+};
+
+#endif // TST_GRAPHBUILDER_H
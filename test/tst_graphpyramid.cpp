@@ -0,0 +1,123 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "tst_graphpyramid.h"
+#include "re/graphpyramid.h"
+
+/* a slow wave with noise and the odd single sample spike */
+static void makeSamples(int count, quint32 seed, QVector<double>& x, QVector<double>& y)
+{
+    QRandomGenerator rng(seed);
+    x.clear();
+    y.clear();
+    for(int i=0 ; i<count ; i++) {
+        x.append(i * 0.01);
+        double v = qSin(i / 5000.0) * 100.0 + rng.bounded(10.0);
+        if(i % 9973 == 5) v += (i & 1) ? 500.0 : -500.0;
+        y.append(v);
+    }
+}
+
+static void checkSorted(const QVector<double>& x)
+{
+    for(int i=1 ; i<x.count() ; i++) QVERIFY(x[i - 1] <= x[i]);
+}
+
+
+void TestGraphPyramid::fullResolutionWhenZoomed()
+{
+    QVector<double> x, y, outX, outY;
+    makeSamples(100000, 3, x, y);
+    GraphPyramid pyramid;
+    pyramid.update(x, y);
+    QCOMPARE(pyramid.getSampleCount(), 100000);
+
+    //samples 50000 to 50300 fit in 500 buckets so they come back untouched
+    pyramid.query(x, y, x[50000], x[50300], 500, outX, outY);
+    checkSorted(outX);
+    const int first = outX.indexOf(x[49999]);
+    QVERIFY(first >= 0);
+    for(int i=0 ; i<=302 ; i++) {
+        QCOMPARE(outX[first + i], x[49999 + i]);
+        QCOMPARE(outY[first + i], y[49999 + i]);
+    }
+
+    //the whole graph comes back as no more than a pair per bucket plus a few pieces at the edges
+    pyramid.query(x, y, x.first(), x.last(), 500, outX, outY);
+    checkSorted(outX);
+    QVERIFY(outX.count() <= 2 * 500 + 64);
+    QVERIFY(outX.count() >= 500 / 4);
+}
+
+
+/* any stretch of the output has to reach as high and as low as the samples it stands in for */
+void TestGraphPyramid::keepsExtremes()
+{
+    QVector<double> x, y, outX, outY;
+    makeSamples(200000, 11, x, y);
+    GraphPyramid pyramid;
+    pyramid.update(x, y);
+
+    const double lo = x[60000], hi = x[140000];
+    pyramid.query(x, y, lo, hi, 300, outX, outY);
+    checkSorted(outX);
+
+    double minAll = y[0], maxAll = y[0], minIn = 1e9, maxIn = -1e9;
+    for(int i=0 ; i<y.count() ; i++) {
+        minAll = qMin(minAll, y[i]);
+        maxAll = qMax(maxAll, y[i]);
+        if(x[i] >= lo && x[i] <= hi) {
+            minIn = qMin(minIn, y[i]);
+            maxIn = qMax(maxIn, y[i]);
+        }
+    }
+
+    double outMinAll = outY[0], outMaxAll = outY[0], outMinIn = 1e9, outMaxIn = -1e9;
+    for(int i=0 ; i<outY.count() ; i++) {
+        outMinAll = qMin(outMinAll, outY[i]);
+        outMaxAll = qMax(outMaxAll, outY[i]);
+        if(outX[i] >= lo && outX[i] <= hi) {
+            outMinIn = qMin(outMinIn, outY[i]);
+            outMaxIn = qMax(outMaxIn, outY[i]);
+        }
+    }
+    QCOMPARE(outMinAll, minAll);
+    QCOMPARE(outMaxAll, maxAll);
+    QCOMPARE(outMinIn, minIn);
+    QCOMPARE(outMaxIn, maxIn);
+    QCOMPARE(outX.first(), x.first());
+    QCOMPARE(outX.last(), x.last());
+}
+
+
+/* frames trickling in a few at a time have to end up with the same pyramid as one big load */
+void TestGraphPyramid::incrementalMatchesBatch()
+{
+    QVector<double> x, y;
+    makeSamples(70001, 5, x, y);
+    GraphPyramid whole;
+    whole.update(x, y);
+
+    GraphPyramid grown;
+    QVector<double> partX, partY;
+    int idx = 0, step = 1;
+    while(idx < x.count()) {
+        const int end = qMin(x.count(), idx + step);
+        for(; idx<end ; idx++) {
+            partX.append(x[idx]);
+            partY.append(y[idx]);
+        }
+        grown.update(partX, partY);
+        step = (step * 7) % 1013 + 1;
+    }
+    QCOMPARE(grown.getSampleCount(), whole.getSampleCount());
+
+    const double ranges[][2] = {{0.0, 700.0}, {100.0, 100.5}, {233.3, 402.7}, {-5.0, 1.0}};
+    for(int r=0 ; r<4 ; r++) {
+        QVector<double> ax, ay, bx, by;
+        whole.query(x, y, ranges[r][0], ranges[r][1], 400, ax, ay);
+        grown.query(partX, partY, ranges[r][0], ranges[r][1], 400, bx, by);
+        QCOMPARE(ax, bx);
+        QCOMPARE(ay, by);
+    }
+}
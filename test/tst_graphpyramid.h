@@ -0,0 +1,17 @@
+#ifndef TST_GRAPHPYRAMID_H
+#define TST_GRAPHPYRAMID_H
+
+#include <QObject>
+
+class TestGraphPyramid: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void fullResolutionWhenZoomed();
+    void keepsExtremes();
+    void incrementalMatchesBatch();
+};
+
+#endif // TST_GRAPHPYRAMID_H
@@ -0,0 +1,215 @@
+#include <QtTest>
+
+#include "tst_isotpreassembly.h"
+#include "bus_protocols/isotp_reassembler.h"
+#include "bus_protocols/isotp_transmitter.h"
+
+static QByteArray makeData(int len, int seed)
+{
+    QByteArray data(len, 0);
+    for(int i=0 ; i<len ; i++) data[i] = (char)(i * 13 + seed);
+    return data;
+}
+
+static CANFrame makeFrame(int bus, uint32_t id, const QByteArray& payload, qint64 timeUs)
+{
+    CANFrame frame;
+    frame.bus = bus;
+    frame.isReceived = true;
+    frame.setFrameId(id);
+    frame.setExtendedFrameFormat(id > 0x7FF);
+    frame.setFlexibleDataRateFormat(payload.length() > 8);
+    frame.setPayload(payload);
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(timeUs / 1000000, timeUs % 1000000));
+    return frame;
+}
+
+/* frames of a message as the sender puts them on the bus, one every gapUs */
+static QVector<CANFrame> messageFrames(int bus, uint32_t id, const QByteArray& data, int frameSize, qint64 startUs, qint64 gapUs)
+{
+    QVector<CANFrame> frames;
+    const QVector<QByteArray> payloads = ISOTPTransmitter::segment(data, frameSize);
+    for(int i=0 ; i<payloads.count() ; i++) frames.append(makeFrame(bus, id, payloads[i], startUs + i * gapUs));
+    return frames;
+}
+
+static QVector<ISOTP_MESSAGE> feed(ISOTPReassembler& rx, const QVector<CANFrame>& frames)
+{
+    QVector<ISOTP_MESSAGE> out;
+    foreach(const CANFrame& frame, frames) rx.addFrame(frame, out);
+    return out;
+}
+
+
+void TestISOTPReassembly::roundTrip_data()
+{
+    QTest::addColumn<int>("length");
+    QTest::addColumn<int>("frameSize");
+
+    foreach(int frameSize, QVector<int>({8, 64})) {
+        foreach(int length, QVector<int>({1, 7, 8, 62, 63, 200, 4095, 4096, 70000})) {
+            QTest::newRow(qPrintable(QString("%1_bytes_dl%2").arg(length).arg(frameSize))) << length << frameSize;
+        }
+    }
+}
+
+/* whatever the transmitter splits up has to come back out the same, escapes and CAN FD included */
+void TestISOTPReassembly::roundTrip()
+{
+    QFETCH(int, length);
+    QFETCH(int, frameSize);
+
+    ISOTPReassembler rx;
+    const QByteArray data = makeData(length, length);
+    const QVector<ISOTP_MESSAGE> msgs = feed(rx, messageFrames(1, 0x7E8, data, frameSize, 5000000, 1000));
+
+    QCOMPARE(msgs.count(), 1);
+    QCOMPARE(msgs[0].payload(), data);
+    QCOMPARE(msgs[0].reportedLength, length);
+    QCOMPARE(msgs[0].frameId(), 0x7E8u);
+    QCOMPARE(msgs[0].bus, 1);
+    QCOMPARE(msgs[0].timeStamp().seconds(), 5ll);
+    QCOMPARE(rx.getOpenSessions(), 0);
+}
+
+/* several ECUs answering at once, and the same ID on two buses, each get their own session */
+void TestISOTPReassembly::interleaved()
+{
+    QVector<QVector<CANFrame>> streams;
+    streams.append(messageFrames(0, 0x7E8, makeData(300, 1), 8, 0, 1000));
+    streams.append(messageFrames(0, 0x7E9, makeData(150, 2), 8, 300, 1000));
+    streams.append(messageFrames(1, 0x7E8, makeData(500, 3), 8, 600, 1000));
+    streams.append(messageFrames(0, 0x18DAF110, makeData(90, 4), 64, 900, 1000));
+
+    QVector<CANFrame> frames;
+    for(int i=0 ; ; i++) {
+        bool any = false;
+        for(int s=0 ; s<streams.count() ; s++) {
+            if(i >= streams[s].count()) continue;
+            frames.append(streams[s][i]);
+            any = true;
+        }
+        if(!any) break;
+    }
+
+    ISOTPReassembler rx;
+    const QVector<ISOTP_MESSAGE> msgs = feed(rx, frames);
+    QCOMPARE(msgs.count(), 4);
+    QHash<quint64, QByteArray> got;
+    foreach(const ISOTP_MESSAGE& msg, msgs) got.insert(((quint64)msg.bus << 32) | msg.frameId(), msg.payload());
+    QCOMPARE(got.value(0x7E8), makeData(300, 1));
+    QCOMPARE(got.value(0x7E9), makeData(150, 2));
+    QCOMPARE(got.value((1ull << 32) | 0x7E8), makeData(500, 3));
+    QCOMPARE(got.value(0x18DAF110), makeData(90, 4));
+}
+
+/* two targets behind one CAN ID, told apart by the address byte */
+void TestISOTPReassembly::extendedAddressing()
+{
+    ISOTPReassembler rx;
+    rx.setExtendedAddressing(true);
+
+    QVector<CANFrame> frames;
+    const QByteArray a = makeData(15, 5), b = makeData(4, 6);
+    frames.append(makeFrame(0, 0x600, QByteArray("\x10\x10\x0F", 3) + a.left(5), 0));
+    frames.append(makeFrame(0, 0x600, QByteArray("\x20\x04", 2) + b + QByteArray(2, 0), 100));
+    frames.append(makeFrame(0, 0x600, QByteArray("\x10\x21", 2) + a.mid(5, 6), 200));
+    frames.append(makeFrame(0, 0x600, QByteArray("\x10\x22", 2) + a.mid(11, 4) + QByteArray(2, 0), 300));
+
+    const QVector<ISOTP_MESSAGE> msgs = feed(rx, frames);
+    QCOMPARE(msgs.count(), 2);
+    QCOMPARE(msgs[0].frameId(), 0x60020u);
+    QCOMPARE(msgs[0].payload(), b);
+    QCOMPARE(msgs[1].frameId(), 0x60010u);
+    QCOMPARE(msgs[1].payload(), a);
+}
+
+/* a skipped sequence number or a new first frame ends the session. What came so far only goes out as a partial */
+void TestISOTPReassembly::brokenSessions()
+{
+    QVector<CANFrame> frames = messageFrames(0, 0x7E8, makeData(100, 7), 8, 0, 1000);
+    frames.remove(3);
+
+    ISOTPReassembler rx;
+    QCOMPARE(feed(rx, frames).count(), 0);
+    QCOMPARE(rx.getOpenSessions(), 0);
+
+    rx.setEmitPartials(true);
+    QVector<ISOTP_MESSAGE> msgs = feed(rx, frames);
+    QCOMPARE(msgs.count(), 1);
+    QCOMPARE(msgs[0].reportedLength, 100);
+    QCOMPARE(msgs[0].payload(), makeData(100, 7).left(6 + 2 * 7));
+
+    //a fresh first frame cuts off the message before it
+    QVector<CANFrame> restart = messageFrames(0, 0x7E8, makeData(50, 8), 8, 0, 1000).mid(0, 3);
+    restart += messageFrames(0, 0x7E8, makeData(30, 9), 8, 10000, 1000);
+    msgs = feed(rx, restart);
+    QCOMPARE(msgs.count(), 2);
+    QCOMPARE(msgs[0].payload().length(), 6 + 2 * 7);
+    QCOMPARE(msgs[1].payload(), makeData(30, 9));
+}
+
+void TestISOTPReassembly::timeouts()
+{
+    ISOTPReassembler rx;
+    rx.setEmitPartials(true);
+
+    //the sender stops for longer than N_Cr between two consecutive frames
+    QVector<CANFrame> frames = messageFrames(0, 0x7E8, makeData(40, 10), 8, 0, 1000);
+    for(int i=3 ; i<frames.count() ; i++)
+        frames[i].setTimeStamp(QCanBusFrame::TimeStamp(2, i));
+    QVector<ISOTP_MESSAGE> msgs = feed(rx, frames);
+    QCOMPARE(msgs.count(), 1);
+    QCOMPARE(msgs[0].payload().length(), 6 + 2 * 7);
+
+    //or never comes back at all. The session stays until something with a later time shows up
+    msgs = feed(rx, messageFrames(0, 0x7E8, makeData(40, 11), 8, 10000000, 1000).mid(0, 2));
+    QCOMPARE(msgs.count(), 0);
+    QCOMPARE(rx.getOpenSessions(), 1);
+    rx.expire(10500000, msgs);
+    QCOMPARE(rx.getOpenSessions(), 1);
+    rx.expire(12000000, msgs);
+    QCOMPARE(rx.getOpenSessions(), 0);
+    QCOMPARE(msgs.count(), 1);
+    QCOMPARE(msgs[0].payload(), makeData(40, 11).left(13));
+}
+
+/*
+  A diagnostic session the way it shows up in a capture: a tester reading identifiers and DTCs from
+  three ECUs, flow control going back and forth and the rest of the bus carrying on in between.
+*/
+void TestISOTPReassembly::replay()
+{
+    QVector<CANFrame> capture;
+    qint64 now = 0;
+    int expected = 0;
+    for(int round=0 ; round<200 ; round++) {
+        for(int ecu=0 ; ecu<3 ; ecu++) {
+            const uint32_t request = 0x7E0 + ecu;
+            const int length = 3 + ((round * 37 + ecu * 101) % 600);
+            capture.append(makeFrame(0, request, QByteArray("\x03\x22\xF1\x90\x00\x00\x00\x00", 8), now));
+            QVector<CANFrame> reply = messageFrames(0, request + 8, makeData(length, round), 8, now + 2000, 500);
+            for(int i=0 ; i<reply.count() ; i++) {
+                capture.append(reply[i]);
+                if(i == 0) capture.append(makeFrame(0, request, QByteArray("\x30\x00\x00\x00\x00\x00\x00\x00", 8), now + 2200));
+                if(i % 3 == 0) capture.append(makeFrame(0, 0x100 + i, QByteArray(8, (char)i), now + 2000 + i * 500 + 100));
+            }
+            now += 2000 + reply.count() * 500 + 5000;
+            expected += 2; //request and reply
+        }
+    }
+    //the filler traffic on 0x100 and up isn't ISO-TP but some of it reads as single frames
+    int filler = 0;
+    foreach(const CANFrame& frame, capture) {
+        if(frame.frameId() < 0x7E0 && (quint8)frame.payload()[0] >= 1 && (quint8)frame.payload()[0] <= 7) filler++;
+    }
+
+    int count = 0;
+    QBENCHMARK {
+        ISOTPReassembler rx;
+        QVector<ISOTP_MESSAGE> out;
+        foreach(const CANFrame& frame, capture) rx.addFrame(frame, out);
+        count = out.count();
+    }
+    QCOMPARE(count, expected + filler);
+}
@@ -0,0 +1,21 @@
+#ifndef TST_ISOTPREASSEMBLY_H
+#define TST_ISOTPREASSEMBLY_H
+
+#include <QObject>
+
+class TestISOTPReassembly: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void interleaved();
+    void extendedAddressing();
+    void brokenSessions();
+    void timeouts();
+    void replay();
+};
+
+#endif // TST_ISOTPREASSEMBLY_H
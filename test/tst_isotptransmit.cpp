@@ -0,0 +1,228 @@
+#include <QtTest>
+#include <QMutex>
+#include <QtConcurrent>
+
+#include "tst_isotptransmit.h"
+#include "bus_protocols/isotp_transmitter.h"
+#include "utils/hiresclock.h"
+
+static QByteArray makeData(int len)
+{
+    QByteArray data(len, 0);
+    for(int i=0 ; i<len ; i++) data[i] = (char)(i * 7 + 3);
+    return data;
+}
+
+/* puts the data of a segmented message back together the way a receiver would */
+static QByteArray reassemble(const QVector<QByteArray>& frames)
+{
+    const QByteArray& first = frames[0];
+    if((first[0] & 0xF0) == 0) {
+        if(first[0]) return first.mid(1, first[0]);
+        return first.mid(2, (quint8)first[1]);
+    }
+
+    int len = ((first[0] & 0x0F) << 8) | (quint8)first[1];
+    QByteArray out;
+    if(len == 0) {
+        len = ((quint8)first[2] << 24) | ((quint8)first[3] << 16) | ((quint8)first[4] << 8) | (quint8)first[5];
+        out = first.mid(6);
+    }
+    else out = first.mid(2);
+    for(int i=1 ; i<frames.count() ; i++) {
+        if((quint8)frames[i][0] != (0x20 | (i & 0xF))) return QByteArray();
+        out += frames[i].mid(1);
+    }
+    return out.left(len);
+}
+
+/* the other end of the bus. Records when every frame went out and answers first frames with flow control */
+struct Receiver
+{
+    ISOTPTransmitter *transmitter = nullptr;
+    int status = 0;
+    int blockSize = 0;
+    quint8 stMin = 0;
+    bool answer = true;
+    int flowDelayMs = 0;    //answer from another thread this long after the frame that asks for it
+
+    QMutex mutex;
+    QVector<qint64> sentNs;
+    QVector<QByteArray> frames;
+    QVector<int> flowsBefore;   //flow control frames handed over before each frame came in
+    int flowsSent = 0;
+    int sinceFlow = 0;
+
+    void gotFrame(const CANFrame& frame)
+    {
+        const QByteArray payload = frame.payload();
+        bool flow = false;
+        {
+            QMutexLocker locker(&mutex);
+            sentNs.append(HiResClock::nowNs());
+            frames.append(payload);
+            flowsBefore.append(flowsSent);
+            if((payload[0] & 0xF0) == 0x10) flow = true;
+            else if(blockSize && ++sinceFlow == blockSize) flow = true;
+            if(flow) sinceFlow = 0;
+        }
+        if(!flow || !answer) return;
+        if(flowDelayMs == 0) sendFlow();
+        else QtConcurrent::run([this]() {
+            QThread::msleep(flowDelayMs);
+            sendFlow();
+        });
+    }
+
+    void sendFlow()
+    {
+        {
+            QMutexLocker locker(&mutex);
+            flowsSent++;
+        }
+        transmitter->flowControl(status, blockSize, stMin);
+    }
+};
+
+static ISOTPTransmitStats runTransfer(Receiver& rx, const QByteArray& data, int frameSize)
+{
+    ISOTPTransmitter transmitter([&rx](const CANFrame& frame) { rx.gotFrame(frame); });
+    rx.transmitter = &transmitter;
+    QSignalSpy spy(&transmitter, &ISOTPTransmitter::transmitFinished);
+
+    CANFrame header;
+    header.bus = 0;
+    header.setFrameId(0x7E0);
+    transmitter.transmit(header, data, frameSize);
+    transmitter.wait(20000); //the thread is done once nothing is left queued
+    QThreadPool::globalInstance()->waitForDone(); //delayed flow control that nobody waits for anymore
+    if(spy.isEmpty()) return ISOTPTransmitStats();
+    return spy.at(0).at(0).value<ISOTPTransmitStats>();
+}
+
+
+void TestISOTPTransmit::segmentation()
+{
+    QVector<QByteArray> frames = ISOTPTransmitter::segment(makeData(5), 8);
+    QCOMPARE(frames.count(), 1);
+    QCOMPARE(frames[0].length(), 8);
+    QCOMPARE((int)frames[0][0], 5);
+
+    frames = ISOTPTransmitter::segment(makeData(20), 8);
+    QCOMPARE(frames.count(), 3);
+    QCOMPARE((quint8)frames[0][0], (quint8)0x10);
+    QCOMPARE((quint8)frames[0][1], (quint8)20);
+    foreach(const QByteArray& frame, frames) QCOMPARE(frame.length(), 8);
+    QCOMPARE(reassemble(frames), makeData(20));
+
+    //sequence numbers wrap from 0x2F back to 0x20
+    frames = ISOTPTransmitter::segment(makeData(200), 8);
+    QCOMPARE(frames.count(), 1 + (194 + 6) / 7);
+    QCOMPARE((quint8)frames[16][0], (quint8)0x20);
+    QCOMPARE(reassemble(frames), makeData(200));
+
+    //too long for 12 bits of length, the first frame carries 32
+    frames = ISOTPTransmitter::segment(makeData(5000), 8);
+    QCOMPARE((quint8)frames[0][0], (quint8)0x10);
+    QCOMPARE((quint8)frames[0][1], (quint8)0);
+    QCOMPARE(frames.count(), 1 + (4998 + 6) / 7);
+    QCOMPARE(reassemble(frames), makeData(5000));
+
+    //CAN FD single frame with the length in the second byte, padded to a valid frame length
+    frames = ISOTPTransmitter::segment(makeData(40), 64);
+    QCOMPARE(frames.count(), 1);
+    QCOMPARE(frames[0].length(), 48);
+    QCOMPARE(reassemble(frames), makeData(40));
+
+    frames = ISOTPTransmitter::segment(makeData(100), 64);
+    QCOMPARE(frames.count(), 2);
+    QCOMPARE(frames[0].length(), 64);
+    QCOMPARE(frames[1].length(), 48);
+    QCOMPARE(reassemble(frames), makeData(100));
+
+    frames = ISOTPTransmitter::segment(makeData(2 * 1024 * 1024), 64);
+    QCOMPARE(frames.count(), 1 + (2 * 1024 * 1024 - 58 + 62) / 63);
+    QCOMPARE(reassemble(frames), makeData(2 * 1024 * 1024));
+}
+
+void TestISOTPTransmit::separationTimes()
+{
+    QCOMPARE(ISOTPTransmitter::separationNs(0), 0ll);
+    QCOMPARE(ISOTPTransmitter::separationNs(0x7F), 127000000ll);
+    QCOMPARE(ISOTPTransmitter::separationNs(0xF1), 100000ll);
+    QCOMPARE(ISOTPTransmitter::separationNs(0xF9), 900000ll);
+    QCOMPARE(ISOTPTransmitter::separationNs(0x80), 127000000ll);
+    QCOMPARE(ISOTPTransmitter::separationNs(0xFA), 127000000ll);
+}
+
+/* 500us STmin has to be kept between every pair of consecutive frames and not rounded up to a timer tick */
+void TestISOTPTransmit::pacing()
+{
+    Receiver rx;
+    rx.stMin = 0xF5;
+    const ISOTPTransmitStats stats = runTransfer(rx, makeData(50 * 7 + 6), 8);
+
+    QVERIFY(stats.completed);
+    QCOMPARE(stats.frames, 51);
+    QCOMPARE(rx.frames.count(), 51);
+    QCOMPARE(reassemble(rx.frames), makeData(50 * 7 + 6));
+
+    for(int i=2 ; i<rx.sentNs.count() ; i++)
+        QVERIFY2(rx.sentNs[i] - rx.sentNs[i - 1] >= 500000 - 20000, qPrintable(QString::number(rx.sentNs[i] - rx.sentNs[i - 1])));
+
+    //a millisecond timer would have needed at least 49ms for the same thing
+    QVERIFY(rx.sentNs.last() - rx.sentNs[1] < 49000000);
+    QVERIFY(stats.bytesPerSecond() > 0);
+}
+
+void TestISOTPTransmit::blocks()
+{
+    Receiver rx;
+    rx.blockSize = 4;
+    rx.flowDelayMs = 2;
+    const QByteArray data = makeData(4095);
+    const ISOTPTransmitStats stats = runTransfer(rx, data, 8);
+
+    QVERIFY(stats.completed);
+    QCOMPARE(stats.bytes, 4095);
+    QCOMPARE(reassemble(rx.frames), data);
+
+    //every block waits for its own flow control frame and never runs into the next one
+    for(int i=1 ; i<rx.frames.count() ; i++) {
+        QCOMPARE(rx.flowsBefore[i], (i - 1) / 4 + 1);
+        if(i > 1 && (i - 1) % 4 == 0)
+            QVERIFY(rx.sentNs[i] - rx.sentNs[i - 1] >= 2000000);
+    }
+
+    //a frame size of 64 moves the same data in a lot fewer frames
+    Receiver fd;
+    fd.blockSize = 8;
+    const ISOTPTransmitStats fdStats = runTransfer(fd, data, 64);
+    QVERIFY(fdStats.completed);
+    QCOMPARE(fdStats.frames, 1 + (4095 - 62 + 62) / 63);
+    QCOMPARE(reassemble(fd.frames), data);
+}
+
+void TestISOTPTransmit::overflow()
+{
+    Receiver rx;
+    rx.status = 2;
+    const ISOTPTransmitStats stats = runTransfer(rx, makeData(100), 8);
+    QVERIFY(!stats.completed);
+    QCOMPARE(stats.frames, 1);
+    QCOMPARE(rx.frames.count(), 1);
+}
+
+/* receivers that never send flow control still get the message, slowly */
+void TestISOTPTransmit::withoutFlowControl()
+{
+    Receiver rx;
+    rx.answer = false;
+    const ISOTPTransmitStats stats = runTransfer(rx, makeData(6 + 3 * 7), 8);
+
+    QVERIFY(stats.completed);
+    QCOMPARE(rx.frames.count(), 4);
+    QVERIFY(rx.sentNs[1] - rx.sentNs[0] >= ISOTP_FIRST_FLOW_TIMEOUT_MS * 1000000ll - 1000000);
+    for(int i=2 ; i<rx.sentNs.count() ; i++)
+        QVERIFY(rx.sentNs[i] - rx.sentNs[i - 1] >= ISOTP_NO_FLOW_STMIN * 1000000ll - 20000);
+}
@@ -0,0 +1,20 @@
+#ifndef TST_ISOTPTRANSMIT_H
+#define TST_ISOTPTRANSMIT_H
+
+#include <QObject>
+
+class TestISOTPTransmit: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void segmentation();
+    void separationTimes();
+    void pacing();
+    void blocks();
+    void overflow();
+    void withoutFlowControl();
+};
+
+#endif // TST_ISOTPTRANSMIT_H
@@ -0,0 +1,263 @@
+#include <QtTest>
+
+#include "tst_j1939.h"
+#include "bus_protocols/j1939_reassembler.h"
+
+static QByteArray makeData(int len, int seed)
+{
+    QByteArray data(len, 0);
+    for(int i=0 ; i<len ; i++) data[i] = (char)(i * 11 + seed);
+    return data;
+}
+
+static uint32_t makeID(int priority, int pgn, int src, int dest)
+{
+    J1939ID jid;
+    jid.priority = priority;
+    jid.pgn = pgn;
+    jid.src = src;
+    jid.dest = dest;
+    return jid.toFrameId();
+}
+
+static CANFrame makeFrame(uint32_t id, const QByteArray& payload, qint64 timeUs, int bus = 0)
+{
+    CANFrame frame;
+    frame.bus = bus;
+    frame.isReceived = true;
+    frame.setFrameId(id);
+    frame.setExtendedFrameFormat(true);
+    frame.setPayload(payload);
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(timeUs / 1000000, timeUs % 1000000));
+    return frame;
+}
+
+static QByteArray controlBytes(int ctrl, quint32 a, int b, int c, int pgn)
+{
+    QByteArray bytes(8, (char)0xFF);
+    bytes[0] = ctrl;
+    bytes[1] = a & 0xFF;
+    bytes[2] = (a >> 8) & 0xFF;
+    bytes[3] = b;
+    bytes[4] = c;
+    bytes[5] = pgn & 0xFF;
+    bytes[6] = (pgn >> 8) & 0xFF;
+    bytes[7] = (pgn >> 16) & 0xFF;
+    return bytes;
+}
+
+static QByteArray packet(const QByteArray& data, int seq, int packetIdx)
+{
+    QByteArray bytes(8, (char)0xFF);
+    bytes[0] = seq;
+    for(int i=0 ; i<7 && packetIdx * 7 + i < data.length() ; i++) bytes[1 + i] = data[packetIdx * 7 + i];
+    return bytes;
+}
+
+static QVector<CANFrame> bamFrames(int src, int pgn, const QByteArray& data, qint64 t)
+{
+    QVector<CANFrame> frames;
+    const int packets = (data.length() + 6) / 7;
+    frames.append(makeFrame(makeID(7, J1939_PGN_TP_CM, src, 0xFF), controlBytes(32, data.length(), packets, 0xFF, pgn), t));
+    for(int p=0 ; p<packets ; p++)
+        frames.append(makeFrame(makeID(7, J1939_PGN_TP_DT, src, 0xFF), packet(data, p + 1, p), t + (p + 1) * 50000));
+    return frames;
+}
+
+/* RTS/CTS with perCTS packets per clear to send. The first packet of every window after the first is sent twice */
+static QVector<CANFrame> rtsFrames(int src, int dest, int pgn, const QByteArray& data, qint64 t, int perCTS)
+{
+    QVector<CANFrame> frames;
+    const int packets = (data.length() + 6) / 7;
+    frames.append(makeFrame(makeID(7, J1939_PGN_TP_CM, src, dest), controlBytes(16, data.length(), packets, perCTS, pgn), t));
+    for(int next=1 ; next<=packets ; next+=perCTS) {
+        const int count = qMin(perCTS, packets - next + 1);
+        t += 1000;
+        frames.append(makeFrame(makeID(7, J1939_PGN_TP_CM, dest, src), controlBytes(17, count | (next << 8), 0xFF, 0xFF, pgn), t));
+        for(int p=next ; p<next+count ; p++) {
+            t += 1000;
+            frames.append(makeFrame(makeID(7, J1939_PGN_TP_DT, src, dest), packet(data, p, p - 1), t));
+            if(p == next && next > 1) frames.append(frames.last());
+        }
+    }
+    frames.append(makeFrame(makeID(7, J1939_PGN_TP_CM, dest, src), controlBytes(19, data.length(), packets, 0xFF, pgn), t + 1000));
+    return frames;
+}
+
+static QVector<CANFrame> etpFrames(int src, int dest, int pgn, const QByteArray& data, qint64 t)
+{
+    QVector<CANFrame> frames;
+    const int packets = (data.length() + 6) / 7;
+    QByteArray rts = controlBytes(20, data.length() & 0xFFFF, (data.length() >> 16) & 0xFF, (data.length() >> 24) & 0xFF, pgn);
+    frames.append(makeFrame(makeID(7, J1939_PGN_ETP_CM, src, dest), rts, t));
+    for(int next=0 ; next<packets ; next+=255) {
+        const int count = qMin(255, packets - next);
+        t += 1000;
+        frames.append(makeFrame(makeID(7, J1939_PGN_ETP_CM, dest, src), controlBytes(21, count | ((next + 1) << 8), ((next + 1) >> 8) & 0xFF, ((next + 1) >> 16) & 0xFF, pgn), t));
+        t += 1000;
+        frames.append(makeFrame(makeID(7, J1939_PGN_ETP_CM, src, dest), controlBytes(22, count | (next << 8), (next >> 8) & 0xFF, (next >> 16) & 0xFF, pgn), t));
+        for(int p=0 ; p<count ; p++) {
+            t += 500;
+            frames.append(makeFrame(makeID(7, J1939_PGN_ETP_DT, src, dest), packet(data, p + 1, next + p), t));
+        }
+    }
+    return frames;
+}
+
+/* several transfers on the bus at once, merged by time */
+static QVector<CANFrame> interleave(const QVector<QVector<CANFrame>>& streams)
+{
+    QVector<CANFrame> frames;
+    foreach(const QVector<CANFrame>& stream, streams) frames += stream;
+    std::stable_sort(frames.begin(), frames.end());
+    return frames;
+}
+
+static QVector<J1939_MESSAGE> feed(J1939Reassembler& rx, const QVector<CANFrame>& frames)
+{
+    QVector<J1939_MESSAGE> out;
+    foreach(const CANFrame& frame, frames) rx.addFrame(frame, out);
+    return out;
+}
+
+
+void TestJ1939::ids()
+{
+    //EEC1 from the engine, a broadcast PGN
+    J1939ID jid = J1939ID::fromFrameId(0x0CF00400);
+    QCOMPARE(jid.priority, 3);
+    QCOMPARE(jid.pgn, 0xF004);
+    QCOMPARE(jid.src, 0x00);
+    QVERIFY(jid.isBroadcast);
+    QCOMPARE(jid.toFrameId(), 0x0CF00400u);
+
+    //request PGN to node 0x17, destination specific so the PGN leaves the destination out
+    jid = J1939ID::fromFrameId(0x18EA17F9);
+    QCOMPARE(jid.pgn, 0xEA00);
+    QCOMPARE(jid.dest, 0x17);
+    QCOMPARE(jid.src, 0xF9);
+    QVERIFY(!jid.isBroadcast);
+    QCOMPARE(jid.toFrameId(), 0x18EA17F9u);
+}
+
+/* DM1 as a BAM with ordinary traffic going on around it */
+void TestJ1939::broadcast()
+{
+    const QByteArray dm1 = makeData(20, 1);
+    QVector<CANFrame> frames = bamFrames(0x00, 0xFECA, dm1, 0);
+    frames.insert(2, makeFrame(0x0CF00400, QByteArray(8, 0x11), 60000));
+
+    J1939Reassembler rx;
+    const QVector<J1939_MESSAGE> msgs = feed(rx, frames);
+    QCOMPARE(msgs.count(), 2);
+
+    QVERIFY(!msgs[0].isTransport);
+    QCOMPARE(msgs[0].jid.pgn, 0xF004);
+
+    QVERIFY(msgs[1].isTransport);
+    QCOMPARE(msgs[1].jid.pgn, 0xFECA);
+    QCOMPARE(msgs[1].jid.src, 0x00);
+    QCOMPARE(msgs[1].jid.dest, 0xFF);
+    QCOMPARE(msgs[1].frameId(), 0x1CFECA00u);
+    QCOMPARE(msgs[1].payload(), dm1);
+    QCOMPARE(msgs[1].reportedLength, 20);
+    QCOMPARE(rx.getOpenSessions(), 0);
+}
+
+/* one node sending to two others and broadcasting all at the same time, with resent packets */
+void TestJ1939::connectionMode()
+{
+    const QByteArray vin = makeData(17, 2), softID = makeData(40, 3), dm1 = makeData(30, 4);
+    QVector<QVector<CANFrame>> streams;
+    streams.append(rtsFrames(0x17, 0x00, 0xFEEC, vin, 0, 2));
+    streams.append(rtsFrames(0x17, 0xF9, 0xFEDA, softID, 300, 3));
+    streams.append(bamFrames(0x17, 0xFECA, dm1, 600));
+
+    J1939Reassembler rx;
+    const QVector<J1939_MESSAGE> msgs = feed(rx, interleave(streams));
+    QCOMPARE(msgs.count(), 3);
+
+    QHash<int, J1939_MESSAGE> byPGN;
+    foreach(const J1939_MESSAGE& msg, msgs) byPGN.insert(msg.jid.pgn, msg);
+    QCOMPARE(byPGN[0xFEEC].payload(), vin);
+    QCOMPARE(byPGN[0xFEEC].jid.dest, 0x00);
+    QCOMPARE(byPGN[0xFEDA].payload(), softID);
+    QCOMPARE(byPGN[0xFEDA].jid.dest, 0xF9);
+    QCOMPARE(byPGN[0xFECA].payload(), dm1);
+    QCOMPARE(rx.getOpenSessions(), 0);
+}
+
+/* more than TP can carry goes over ETP with data packet offsets */
+void TestJ1939::extended()
+{
+    const QByteArray data = makeData(3000, 5);
+    J1939Reassembler rx;
+    const QVector<J1939_MESSAGE> msgs = feed(rx, etpFrames(0xF9, 0x00, 0xEF00, data, 0));
+    QCOMPARE(msgs.count(), 1);
+    QCOMPARE(msgs[0].payload(), data);
+    QCOMPARE(msgs[0].jid.pgn, 0xEF00);
+    QCOMPARE(msgs[0].jid.dest, 0x00);
+    QCOMPARE(msgs[0].frameId(), makeID(7, 0xEF00, 0xF9, 0x00));
+}
+
+void TestJ1939::brokenTransfers()
+{
+    J1939Reassembler rx;
+
+    //receiver aborts halfway
+    QVector<CANFrame> frames = rtsFrames(0x17, 0x00, 0xFEEC, makeData(40, 6), 0, 2);
+    frames.insert(5, makeFrame(makeID(7, J1939_PGN_TP_CM, 0x00, 0x17), controlBytes(255, 3, 0xFF, 0xFF, 0xFEEC), 4500));
+    QCOMPARE(feed(rx, frames).count(), 0);
+    QCOMPARE(rx.getOpenSessions(), 0);
+
+    //a broadcast missing a packet
+    frames = bamFrames(0x00, 0xFECA, makeData(30, 7), 0);
+    frames.remove(2);
+    QCOMPARE(feed(rx, frames).count(), 0);
+
+    //a broadcast that stalls for longer than T1
+    frames = bamFrames(0x00, 0xFECA, makeData(30, 8), 10000000);
+    frames.last().setTimeStamp(QCanBusFrame::TimeStamp(12, 0));
+    QCOMPARE(feed(rx, frames).count(), 0);
+
+    //a sender that never finishes is dropped once time moves on
+    frames = rtsFrames(0x17, 0x00, 0xFEEC, makeData(40, 9), 20000000, 2).mid(0, 4);
+    QCOMPARE(feed(rx, frames).count(), 0);
+    QCOMPARE(rx.getOpenSessions(), 1);
+    rx.expire(21000000);
+    QCOMPARE(rx.getOpenSessions(), 1);
+    rx.expire(22000000);
+    QCOMPARE(rx.getOpenSessions(), 0);
+}
+
+/* a whole capture done in parallel has to give exactly what watching it go by does */
+void TestJ1939::offlineMatchesStreaming()
+{
+    QVector<QVector<CANFrame>> streams;
+    for(int round=0 ; round<100 ; round++) {
+        const qint64 t = round * 2000000ll;
+        const int node = 0x10 + round % 20;
+        streams.append(bamFrames(node, 0xFECA, makeData(9 + round % 50, round), t));
+        streams.append(rtsFrames(node, 0xF9, 0xFEDA, makeData(20 + round * 3, round + 1), t + 100, 1 + round % 5));
+        streams.append(rtsFrames(0xF9, node, 0xEF00, makeData(100 + round, round + 2), t + 200, 16));
+        if(round % 10 == 0) streams.append(etpFrames(node, 0x00, 0xEF00, makeData(2000 + round * 10, round + 3), t + 300));
+        QVector<CANFrame> periodic;
+        for(int i=0 ; i<100 ; i++) periodic.append(makeFrame(0x0CF00400 | node, makeData(8, i), t + i * 10000));
+        streams.append(periodic);
+    }
+    const QVector<CANFrame> capture = interleave(streams);
+
+    J1939Reassembler rx;
+    const QVector<J1939_MESSAGE> expected = feed(rx, capture);
+    QCOMPARE(expected.count(), 100 * (3 + 100) + 10);
+
+    QVector<J1939_MESSAGE> msgs;
+    QBENCHMARK {
+        msgs = J1939Reassembler::processCapture(capture);
+    }
+    QCOMPARE(msgs.count(), expected.count());
+    for(int i=0 ; i<msgs.count() ; i++) {
+        QCOMPARE(msgs[i].frameId(), expected[i].frameId());
+        QCOMPARE(msgs[i].payload(), expected[i].payload());
+    }
+}
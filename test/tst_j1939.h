@@ -0,0 +1,20 @@
+#ifndef TST_J1939_H
+#define TST_J1939_H
+
+#include <QObject>
+
+class TestJ1939: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void ids();
+    void broadcast();
+    void connectionMode();
+    void extended();
+    void brokenTransfers();
+    void offlineMatchesStreaming();
+};
+
+#endif // TST_J1939_H
@@ -0,0 +1,102 @@
+#include <QtTest>
+
+#include <QtConcurrent/qtconcurrentrun.h>
+
+#include "utils/lfinbox.h"
+#include "tst_lfinbox.h"
+
+struct Item
+{
+    int writer;
+    int seq;
+};
+
+
+void TestLFInbox::wakeups()
+{
+    LFInbox<Item> inbox;
+
+    //only the first push after a drain asks for the reader
+    QVERIFY(inbox.push({0, 0}));
+    QVERIFY(!inbox.push({0, 1}));
+    QVERIFY(!inbox.push({0, 2}));
+
+    int expected = 0;
+    QCOMPARE(inbox.drain([&expected](const Item& item) { QCOMPARE(item.seq, expected++); }), 3);
+    QCOMPARE(inbox.drain([](const Item&) {}), 0);
+
+    QVERIFY(inbox.push({0, 3}));
+
+    //a full lane drops and counts instead of blocking. The ring holds one less than its size
+    for(int i=0 ; i<LFINBOX_LANE_SIZE * 2 ; i++) inbox.push({0, i});
+    QCOMPARE(inbox.getDropped(), LFINBOX_LANE_SIZE + 2);
+}
+
+
+static void writerThread(LFInbox<Item>* pInbox_p, int pWriter, int pCount, QAtomicInt* pWakeups_p)
+{
+    for(int i=0 ; i<pCount ; i++) {
+        if(pInbox_p->push({pWriter, i}))
+            pWakeups_p->fetchAndAddRelaxed(1);
+        if(i % 256 == 0)
+            QThread::usleep(50);
+    }
+}
+
+
+void TestLFInbox::manyWriters()
+{
+    const int writers = 4;
+    const int count = 20000;
+    LFInbox<Item> inbox;
+    QAtomicInt wakeups;
+    QVector<int> last(writers, -1);
+    QVector<int> received(writers, 0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(writers);
+    QVector<QFuture<void>> threads;
+    for(int w=0 ; w<writers ; w++)
+        threads.append(QtConcurrent::run(&pool, writerThread, &inbox, w, count, &wakeups));
+
+    bool running = true;
+    while(running) {
+        running = false;
+        for(int w=0 ; w<writers ; w++)
+            if(!threads[w].isFinished()) running = true;
+
+        inbox.drain([&](const Item& item) {
+            //order is kept per writer. Gaps are only allowed where something was dropped
+            QVERIFY(item.seq > last[item.writer]);
+            last[item.writer] = item.seq;
+            received[item.writer]++;
+        });
+    }
+
+    int total = 0;
+    for(int w=0 ; w<writers ; w++) total += received[w];
+    QCOMPARE(total + inbox.getDropped(), writers * count);
+    QVERIFY(wakeups.loadRelaxed() > 0);
+}
+
+
+void TestLFInbox::writerTurnover()
+{
+    LFInbox<Item> inbox;
+    const int writers = LFINBOX_LANES * 3;
+
+    //each writer finishes before the next starts so its lane has to come back for the later ones
+    for(int w=0 ; w<writers ; w++) {
+        QThread *thread = QThread::create([&inbox, w]() {
+            inbox.push({w, 0});
+            inbox.push({w, 1});
+        });
+        thread->start();
+        QVERIFY(thread->wait(5000));
+        delete thread;
+    }
+
+    QVector<int> received(writers, 0);
+    QCOMPARE(inbox.drain([&received](const Item& item) { QCOMPARE(item.seq, received[item.writer]++); }), writers * 2);
+    QCOMPARE(inbox.getDropped(), 0);
+}
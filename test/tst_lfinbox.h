@@ -0,0 +1,17 @@
+#ifndef TST_LFINBOX_H
+#define TST_LFINBOX_H
+
+#include <QObject>
+
+class TestLFInbox: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void wakeups();
+    void manyWriters();
+    void writerTurnover();
+};
+
+#endif // TST_LFINBOX_H
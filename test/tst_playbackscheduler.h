@@ -0,0 +1,17 @@
+#ifndef TST_PLAYBACKSCHEDULER_H
+#define TST_PLAYBACKSCHEDULER_H
+
+#include <QObject>
+
+class TestPlaybackScheduler: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void timing();
+    void startPosition();
+    void abort();
+};
+
+#endif // TST_PLAYBACKSCHEDULER_H
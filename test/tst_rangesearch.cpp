@@ -0,0 +1,83 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "tst_rangesearch.h"
+#include "re/rangesignalsearch.h"
+
+/* a ramp in the first two bytes, slow counters and noise around it so every kind of verdict shows up */
+static QVector<CANFrame> makeFrames(int count, int minLen, int maxLen, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<count ; i++) {
+        const int len = minLen + rng.bounded(maxLen - minLen + 1);
+        QByteArray payload(len, 0);
+        for(int c=0 ; c<len ; c++)
+            payload[c] = (c % 3 == 0) ? (char)rng.generate() : (char)((i * (c + 1) / 7) & 0xFF);
+        const quint32 ramp = i * 37 + rng.bounded(5);
+        if(len > 0) payload[0] = (char)(ramp & 0xFF);
+        if(len > 1) payload[1] = (char)((ramp >> 8) & 0xFF);
+
+        CANFrame frame;
+        frame.setFrameId(0x123);
+        frame.setPayload(payload);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+
+void TestRangeSearch::matchesReference_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("minLen");
+    QTest::addColumn<int>("maxLen");
+
+    QTest::newRow("classic")        << 300 << 8 << 8;
+    QTest::newRow("short_frames")   << 200 << 4 << 8;
+    QTest::newRow("mixed_dlc")      << 250 << 0 << 8;
+    QTest::newRow("fd_64")          << 130 << 64 << 64;
+    QTest::newRow("two_frames")     << 2 << 8 << 8;
+}
+
+
+/* every candidate has to get the same verdict as the old bit by bit search */
+void TestRangeSearch::matchesReference()
+{
+    QFETCH(int, count);
+    QFETCH(int, minLen);
+    QFETCH(int, maxLen);
+
+    const QVector<CANFrame> frames = makeFrames(count, minLen, maxLen, count);
+    RangeSignalSearch search(frames);
+    QCOMPARE(search.getFrameCount(), count);
+
+    int found = 0;
+    foreach(int sens, QVector<int>({10, 130, 250})) {
+        foreach(const RangeSignalCandidate& cand, search.makeCandidates(1, 32, 1, 3, 3)) {
+            const bool expected = RangeSignalSearch::evaluateReference(frames, cand, sens);
+            if(search.evaluate(cand, sens) != expected)
+                QFAIL(qPrintable(QString("start %1 len %2 big %3 signed %4 sens %5")
+                                 .arg(cand.startBit).arg(cand.bitLength).arg(cand.bigEndian).arg(cand.isSigned).arg(sens)));
+            if(expected) found++;
+        }
+    }
+    if(count > 2) QVERIFY(found > 0);
+}
+
+
+/* full sweep of a 64 byte FD ID, the case that used to take ages */
+void TestRangeSearch::sweep()
+{
+    const QVector<CANFrame> frames = makeFrames(2000, 64, 64, 1);
+    RangeSignalSearch search(frames);
+    const QVector<RangeSignalCandidate> cands = search.makeCandidates(1, 32, 1, 3, 3);
+    int found = 0;
+
+    QBENCHMARK {
+        found = 0;
+        foreach(const RangeSignalCandidate& cand, cands)
+            if(search.evaluate(cand, 130)) found++;
+    }
+    QVERIFY(found > 0);
+}
@@ -0,0 +1,17 @@
+#ifndef TST_RANGESEARCH_H
+#define TST_RANGESEARCH_H
+
+#include <QObject>
+
+class TestRangeSearch: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void matchesReference_data();
+    void matchesReference();
+    void sweep();
+};
+
+#endif // TST_RANGESEARCH_H
@@ -0,0 +1,173 @@
+#include <QtTest>
+#include <QMutex>
+
+#include "tst_restbus.h"
+#include "restbusengine.h"
+
+static SignalCodecSpec makeSpec(int startBit, int size)
+{
+    SignalCodecSpec spec;
+    spec.segments = SignalCodec::layout(startBit, size, true);
+    spec.signalSize = size;
+    spec.valType = UNSIGNED_INT;
+    spec.factor = 1.0;
+    spec.bias = 0.0;
+    spec.minLength = (startBit + size + 7) / 8;
+    spec.neverPresent = false;
+    return spec;
+}
+
+//Speed in bytes 0-1, a 4 bit alive counter in the low half of byte 6 and a CRC in byte 7
+static RestbusMessage makeMessage(const QString& name, uint32_t id, qint64 periodNs)
+{
+    RestbusMessage msg;
+    msg.name = name;
+    msg.id = id;
+    msg.extended = false;
+    msg.bus = 0;
+    msg.periodNs = periodNs;
+    msg.offsetNs = 0;
+    msg.payload = QByteArray(8, 0);
+    msg.signalNames << "Speed" << "AliveCounter" << "CRC";
+    msg.specs << makeSpec(0, 16) << makeSpec(48, 4) << makeSpec(56, 8);
+    msg.counters << 1;
+    msg.counterValues << 0;
+    msg.checksum = 2;
+    msg.checksumType = RB_CHECKSUM_CRC8;
+    return msg;
+}
+
+
+void TestRestbus::counters()
+{
+    RestbusMessage msg = makeMessage("Status", 0x100, 10000000);
+    msg.payload[6] = (char)0xA0; //the other half of the byte must survive
+
+    CANFrame frame;
+    for (int i = 0; i < 20; i++)
+    {
+        RestbusEngine::prepareFrame(msg, frame);
+        QCOMPARE((unsigned char)frame.payload()[6], (unsigned char)(0xA0 | (i % 16)));
+    }
+    QCOMPARE(frame.frameId(), 0x100u);
+    QVERIFY(!frame.isReceived);
+}
+
+
+void TestRestbus::checksums()
+{
+    const QByteArray check("123456789");
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(check.constData());
+    QCOMPARE(RestbusEngine::checksum(RB_CHECKSUM_CRC8, data, check.length()), (quint8)0x4B);
+    QCOMPARE(RestbusEngine::checksum(RB_CHECKSUM_XOR, data, check.length()), (quint8)0x31);
+    QCOMPARE(RestbusEngine::checksum(RB_CHECKSUM_SUM, data, check.length()), (quint8)0xDD);
+
+    //the checksum byte itself is left out and it follows the counter
+    RestbusMessage msg = makeMessage("Status", 0x100, 10000000);
+    CANFrame frame;
+    for (int i = 0; i < 3; i++)
+    {
+        RestbusEngine::prepareFrame(msg, frame);
+        const QByteArray payload = frame.payload();
+        const quint8 expected = RestbusEngine::checksum(RB_CHECKSUM_CRC8, reinterpret_cast<const unsigned char *>(payload.constData()), 7);
+        QCOMPARE((quint8)payload[7], expected);
+    }
+
+    msg.checksumType = RB_CHECKSUM_NONE;
+    msg.payload[7] = 0x55;
+    RestbusEngine::prepareFrame(msg, frame);
+    QCOMPARE((quint8)frame.payload()[7], (quint8)0x55);
+}
+
+
+void TestRestbus::lookup()
+{
+    RestbusEngine engine([](const QList<CANFrame>&) {});
+    QVector<RestbusMessage> plan;
+    plan << makeMessage("Status", 0x100, 10000000) << makeMessage("Drive", 0x1A0, 20000000);
+    engine.load(plan);
+
+    QCOMPARE(engine.findMessage("drive"), 1);
+    QCOMPARE(engine.findMessage("0x1A0"), 1);
+    QCOMPARE(engine.findMessage("416"), 1);
+    QCOMPARE(engine.findMessage("Nope"), -1);
+
+    QVERIFY(engine.findSignal("Status", "speed") > -1);
+    QCOMPARE(engine.findSignal("0x1a0", "Speed"), engine.findSignal("Drive", "Speed"));
+    QVERIFY(engine.findSignal("Status", "Speed") != engine.findSignal("Drive", "Speed"));
+    //counters and checksums belong to the engine
+    QCOMPARE(engine.findSignal("Status", "AliveCounter"), -1);
+    QCOMPARE(engine.findSignal("Status", "CRC"), -1);
+    QVERIFY(!engine.setSignal(-1, 1.0));
+}
+
+
+void TestRestbus::sending()
+{
+    QMutex lock;
+    QMap<uint32_t, int> counts;
+    quint16 lastSpeed = 0;
+    RestbusEngine engine([&](const QList<CANFrame>& frames)
+    {
+        QMutexLocker locker(&lock);
+        foreach (const CANFrame &frame, frames)
+        {
+            counts[frame.frameId()]++;
+            if (frame.frameId() == 0x100) lastSpeed = (quint8)frame.payload()[0] | ((quint8)frame.payload()[1] << 8);
+        }
+    });
+
+    QVector<RestbusMessage> plan;
+    plan << makeMessage("Fast", 0x100, 5000000) << makeMessage("Slow", 0x200, 50000000);
+    engine.load(plan);
+    engine.setSignal(engine.findSignal("Fast", "Speed"), 1234);
+    engine.start(QThread::TimeCriticalPriority);
+    QTest::qWait(300);
+    engine.setSignal(engine.findSignal("Fast", "Speed"), 4321);
+    QTest::qWait(200);
+    engine.stopSimulation();
+
+    //500ms at 5ms and 50ms, with room for a slow test machine
+    QMutexLocker locker(&lock);
+    QVERIFY(counts[0x100] >= 80 && counts[0x100] <= 101);
+    QVERIFY(counts[0x200] >= 8 && counts[0x200] <= 11);
+    QCOMPARE(lastSpeed, (quint16)4321);
+    QCOMPARE(engine.getFramesSent(), (quint64)(counts[0x100] + counts[0x200]));
+    QVERIFY(engine.getStats().count > 0);
+}
+
+
+/* values queued for the old plan are dropped rather than landing on the new one */
+void TestRestbus::reload()
+{
+    QMutex lock;
+    QList<CANFrame> sent;
+    RestbusEngine engine([&](const QList<CANFrame>& frames)
+    {
+        QMutexLocker locker(&lock);
+        sent.append(frames);
+    });
+
+    QVector<RestbusMessage> plan;
+    plan << makeMessage("Status", 0x100, 5000000) << makeMessage("Drive", 0x1A0, 5000000);
+    engine.load(plan);
+    QVERIFY(engine.setSignal(engine.findSignal("Status", "Speed"), 55));
+    QVERIFY(engine.setSignal(engine.findSignal("Drive", "Speed"), 99));
+
+    plan.clear();
+    plan << makeMessage("Other", 0x300, 5000000);
+    plan[0].payload = QByteArray(12, 0); //longer than classic CAN
+    engine.load(plan);
+    engine.start(QThread::TimeCriticalPriority);
+    QTest::qWait(50);
+    engine.stopSimulation();
+
+    QMutexLocker locker(&lock);
+    QVERIFY(!sent.isEmpty());
+    foreach (const CANFrame &frame, sent)
+    {
+        QCOMPARE(frame.frameId(), 0x300u);
+        QCOMPARE((quint8)frame.payload()[0], (quint8)0);
+        QVERIFY(frame.hasFlexibleDataRateFormat());
+    }
+}
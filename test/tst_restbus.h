@@ -0,0 +1,19 @@
+#ifndef TST_RESTBUS_H
+#define TST_RESTBUS_H
+
+#include <QObject>
+
+class TestRestbus: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void counters();
+    void checksums();
+    void lookup();
+    void sending();
+    void reload();
+};
+
+#endif // TST_RESTBUS_H
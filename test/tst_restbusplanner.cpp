@@ -0,0 +1,173 @@
+#include <QtTest>
+
+#include "tst_restbusplanner.h"
+#include "restbusplanner.h"
+#include "dbc/dbchandler.h"
+
+static void addAttribute(DBCFile& file, const QString& name, DBC_ATTRIBUTE_TYPE type, const QVariant& defaultValue)
+{
+    DBC_ATTRIBUTE attr;
+    attr.name = name;
+    attr.valType = ATTR_INT;
+    attr.attrType = type;
+    attr.lower = 0;
+    attr.upper = 100000;
+    attr.defaultValue = defaultValue;
+    file.dbc_attributes.append(attr);
+}
+
+static void addValue(QList<DBC_ATTRIBUTE_VALUE>& values, const QString& name, const QVariant& value)
+{
+    DBC_ATTRIBUTE_VALUE val;
+    val.attrName = name;
+    val.value = value;
+    values.append(val);
+}
+
+static DBC_SIGNAL makeSignal(const QString& name, int startBit, int size)
+{
+    DBC_SIGNAL sig;
+    sig.name = name;
+    sig.startBit = startBit;
+    sig.signalSize = size;
+    sig.intelByteOrder = true;
+    sig.valType = UNSIGNED_INT;
+    return sig;
+}
+
+/*
+  BMS sends BMS_Status every 20ms, 5ms in, with a pack voltage that starts at 350.0V, an alive counter and a CRC.
+  BMS_Limits has no cycle time of its own so it takes the 100ms default. Charger_Cmd has a cycle time of 0.
+*/
+static void buildFile(DBCFile& file)
+{
+    DBC_NODE node;
+    node.name = "BMS";
+    file.dbc_nodes.append(node);
+    node.name = "Charger";
+    file.dbc_nodes.append(node);
+    file.setAssocBus(1);
+
+    addAttribute(file, "GenMsgCycleTime", ATTR_TYPE_MESSAGE, 100);
+    addAttribute(file, "GenMsgStartDelayTime", ATTR_TYPE_MESSAGE, 0);
+    addAttribute(file, "GenSigStartValue", ATTR_TYPE_SIG, 0);
+
+    DBC_MESSAGE status;
+    status.ID = 0x100;
+    status.extendedID = false;
+    status.name = "BMS_Status";
+    status.len = 8;
+    status.sender = file.findNodeByName("BMS");
+    addValue(status.attributes, "GenMsgCycleTime", 20);
+    addValue(status.attributes, "GenMsgStartDelayTime", 5);
+    DBC_SIGNAL voltage = makeSignal("PackVoltage", 0, 16);
+    voltage.factor = 0.1;
+    addValue(voltage.attributes, "GenSigStartValue", 3500);
+    status.sigHandler->addSignal(voltage);
+    DBC_SIGNAL alive = makeSignal("AliveCounter", 48, 4);
+    status.sigHandler->addSignal(alive);
+    DBC_SIGNAL crc = makeSignal("CRC", 56, 8);
+    status.sigHandler->addSignal(crc);
+    DBC_SIGNAL flag = makeSignal("EncounterFlag", 16, 1); //counter inside a word doesn't count
+    status.sigHandler->addSignal(flag);
+    file.messageHandler->addMessage(status);
+
+    DBC_MESSAGE limits;
+    limits.ID = 0x101;
+    limits.extendedID = false;
+    limits.name = "BMS_Limits";
+    limits.len = 4;
+    limits.sender = file.findNodeByName("BMS");
+    DBC_SIGNAL current = makeSignal("MaxCurrent", 0, 16);
+    limits.sigHandler->addSignal(current);
+    DBC_SIGNAL count = makeSignal("MSG_CNT", 16, 8);
+    limits.sigHandler->addSignal(count);
+    file.messageHandler->addMessage(limits);
+
+    DBC_MESSAGE command;
+    command.ID = 0x200;
+    command.extendedID = false;
+    command.name = "Charger_Cmd";
+    command.len = 8;
+    command.sender = file.findNodeByName("Charger");
+    addValue(command.attributes, "GenMsgCycleTime", 0);
+    DBC_SIGNAL request = makeSignal("RequestCurrent", 0, 16);
+    command.sigHandler->addSignal(request);
+    file.messageHandler->addMessage(command);
+}
+
+
+void TestRestbusPlanner::names()
+{
+    QCOMPARE(RestbusPlanner::nameTokens("AliveCounter_2"), QStringList({"alive", "counter", "2"}));
+    QCOMPARE(RestbusPlanner::nameTokens("ABSChks"), QStringList({"abs", "chks"}));
+
+    QVERIFY(RestbusPlanner::isCounterName("AliveCounter"));
+    QVERIFY(RestbusPlanner::isCounterName("MSG_CNT"));
+    QVERIFY(RestbusPlanner::isCounterName("EspSqc"));
+    QVERIFY(!RestbusPlanner::isCounterName("EncounterFlag"));
+    QVERIFY(!RestbusPlanner::isCounterName("Content"));
+    QVERIFY(!RestbusPlanner::isCounterName("Account"));
+
+    QVERIFY(RestbusPlanner::isChecksumName("CRC8_Status"));
+    QVERIFY(RestbusPlanner::isChecksumName("ABSChks"));
+    QVERIFY(!RestbusPlanner::isChecksumName("Microcrc"));
+}
+
+
+void TestRestbusPlanner::plan()
+{
+    DBCFile file;
+    buildFile(file);
+
+    QStringList skipped;
+    const QVector<RestbusMessage> all = RestbusPlanner::plan(&file, QStringList(), -1, &skipped);
+    QCOMPARE(all.count(), 2);
+    QCOMPARE(skipped, QStringList({"Charger_Cmd: no cycle time"}));
+
+    const QVector<RestbusMessage> plan = RestbusPlanner::plan(&file, QStringList({"bms"}), -1);
+    QCOMPARE(plan.count(), 2);
+
+    //cycle time and start delay from the message, start value from the signal, bus from the file
+    const RestbusMessage &status = plan[0];
+    QCOMPARE(status.name, QString("BMS_Status"));
+    QCOMPARE(status.periodNs, (qint64)20000000);
+    QCOMPARE(status.offsetNs, (qint64)5000000);
+    QCOMPARE(status.bus, 1);
+    QCOMPARE(status.payload.length(), 8);
+    QCOMPARE((quint8)status.payload[0], (quint8)0xAC);
+    QCOMPARE((quint8)status.payload[1], (quint8)0x0D);
+    QCOMPARE(status.signalNames, QStringList({"PackVoltage", "AliveCounter", "CRC", "EncounterFlag"}));
+    QCOMPARE(status.counters, QVector<int>({1}));
+    QCOMPARE(status.checksum, 2);
+    QCOMPARE(status.checksumType, RB_CHECKSUM_CRC8);
+
+    //everything from the attribute defaults
+    const RestbusMessage &limits = plan[1];
+    QCOMPARE(limits.periodNs, (qint64)100000000);
+    QCOMPARE(limits.offsetNs, (qint64)0);
+    QCOMPARE(limits.payload, QByteArray(4, 0));
+    QCOMPARE(limits.counters, QVector<int>({1}));
+    QCOMPARE(limits.checksum, -1);
+
+    QCOMPARE(RestbusPlanner::plan(&file, QStringList({"BMS"}), 3)[0].bus, 3);
+}
+
+
+void TestRestbusPlanner::counterOverrides()
+{
+    DBCFile file;
+    buildFile(file);
+
+    //by name or by decimal ID, in lower case
+    QHash<QString, bool> counters;
+    counters.insert("bms_limits.msg_cnt", false);
+    counters.insert("257.maxcurrent", true);
+    counters.insert("bms_status.crc", false);
+
+    const QVector<RestbusMessage> plan = RestbusPlanner::plan(&file, QStringList({"BMS"}), -1, nullptr, &counters);
+    QCOMPARE(plan.count(), 2);
+    QCOMPARE(plan[0].counters, QVector<int>({1}));
+    QCOMPARE(plan[0].checksum, -1);
+    QCOMPARE(plan[1].counters, QVector<int>({0}));
+}
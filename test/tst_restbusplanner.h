@@ -0,0 +1,17 @@
+#ifndef TST_RESTBUSPLANNER_H
+#define TST_RESTBUSPLANNER_H
+
+#include <QObject>
+
+class TestRestbusPlanner: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void names();
+    void plan();
+    void counterOverrides();
+};
+
+#endif // TST_RESTBUSPLANNER_H
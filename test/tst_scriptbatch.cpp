@@ -0,0 +1,163 @@
+#include <QtTest>
+#include <QJSEngine>
+
+#include "tst_scriptbatch.h"
+#include "scriptframebatch.h"
+
+static QVector<CANFrame> makeFrames(int count)
+{
+    QVector<CANFrame> frames;
+    for(int i=0 ; i<count ; i++) {
+        CANFrame frame;
+        const int len = (i % 10 == 9) ? 64 : (i % 9);
+        QByteArray bytes(len, 0);
+        for(int j=0 ; j<len ; j++) bytes[j] = (char)(i + j * 7);
+        frame.bus = i % 3;
+        frame.setFrameId((i % 4 == 0) ? 0x18FEF100 + (i & 0xFF) : 0x100 + (i & 0x3FF));
+        frame.setExtendedFrameFormat(frame.frameId() > 0x7FF);
+        frame.setFlexibleDataRateFormat(len > 8);
+        frame.setPayload(bytes);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(i / 1000, (i % 1000) * 1000));
+        frames.append(frame);
+    }
+    return frames;
+}
+
+/* what both kinds of gateway script add up, so it can be checked they saw the same thing */
+static double checksum(const QVector<CANFrame>& frames)
+{
+    double sum = 0;
+    foreach(const CANFrame& frame, frames) {
+        sum += frame.frameId() + frame.bus;
+        for(int j=0 ; j<frame.payload().length() ; j++) sum += (unsigned char)frame.payload()[j];
+    }
+    return sum;
+}
+
+
+void TestScriptBatch::roundTrip()
+{
+    QJSEngine engine;
+    ScriptFrameBatch batcher(&engine);
+    const QVector<CANFrame> frames = makeFrames(50);
+
+    QJSValue batch = batcher.toScript(frames);
+    QCOMPARE(batch.property("count").toInt(), 50);
+    QCOMPARE(batch.property("ids").property(4).toUInt(), frames[4].frameId());
+    QCOMPARE(batch.property("timestamps").property(7).toNumber(), 7000.0);
+    QCOMPARE(batch.property("lengths").property(9).toInt(), 64);
+    QVERIFY(batch.property("data").property("length").toInt() > 0);
+
+    //typed arrays the script can index and slice itself
+    QJSValue probe = engine.evaluate("(function (b) { return b.data[b.offsets[3] + 2]; })");
+    QCOMPARE(probe.call(QJSValueList() << batch).toInt(), (int)(unsigned char)frames[3].payload()[2]);
+
+    const QList<CANFrame> back = batcher.fromScript(batch);
+    QCOMPARE(back.count(), frames.count());
+    for(int i=0 ; i<frames.count() ; i++) {
+        QCOMPARE(back[i].frameId(), frames[i].frameId());
+        QCOMPARE(back[i].bus, frames[i].bus);
+        QCOMPARE(back[i].payload(), frames[i].payload());
+        QCOMPARE(back[i].hasExtendedFrameFormat(), frames[i].hasExtendedFrameFormat());
+        QCOMPARE(back[i].hasFlexibleDataRateFormat(), frames[i].hasFlexibleDataRateFormat());
+    }
+}
+
+/* scripts putting a batch together by hand can skip the typed arrays and the offsets */
+void TestScriptBatch::plainArrays()
+{
+    QJSEngine engine;
+    ScriptFrameBatch batcher(&engine);
+
+    QJSValue batch = engine.evaluate("({ ids: [0x7E0, 0x18DA10F1], buses: [0, 1], lengths: [3, 2], data: [1, 2, 3, 4, 5] })");
+    const QList<CANFrame> frames = batcher.fromScript(batch);
+    QCOMPARE(frames.count(), 2);
+    QCOMPARE(frames[0].frameId(), 0x7E0u);
+    QVERIFY(!frames[0].hasExtendedFrameFormat());
+    QCOMPARE(frames[0].payload(), QByteArray::fromHex("010203"));
+    QCOMPARE(frames[1].frameId(), 0x18DA10F1u);
+    QVERIFY(frames[1].hasExtendedFrameFormat());
+    QCOMPARE(frames[1].bus, 1);
+    QCOMPARE(frames[1].payload(), QByteArray::fromHex("0405"));
+}
+
+/* a count past the end of one of the arrays only takes the frames every array has */
+void TestScriptBatch::shortArrays()
+{
+    QJSEngine engine;
+    ScriptFrameBatch batcher(&engine);
+
+    QJSValue batch = engine.evaluate("({ count: 5, ids: [0x100, 0x101, 0x102], buses: [0, 1], lengths: [1, 1, 1], data: [7, 8, 9] })");
+    const QList<CANFrame> frames = batcher.fromScript(batch);
+    QCOMPARE(frames.count(), 2);
+    QCOMPARE(frames[1].frameId(), 0x101u);
+    QCOMPARE(frames[1].bus, 1);
+
+    batch = engine.evaluate("({ count: 3, ids: new Uint32Array([0x200, 0x201, 0x202]), buses: new Uint8Array(3),"
+                            "   lengths: new Uint8Array([1, 1, 1]), offsets: new Uint32Array([2]), data: [7, 8, 9] })");
+    const QList<CANFrame> offsetFrames = batcher.fromScript(batch);
+    QCOMPARE(offsetFrames.count(), 1);
+    QCOMPARE(offsetFrames[0].payload(), QByteArray::fromHex("09"));
+
+    QVERIFY(batcher.fromScript(engine.evaluate("({ count: 2, ids: [0x300, 0x301], lengths: [0, 0], data: [] })")).isEmpty());
+}
+
+/* typed arrays of some other element type are read by value rather than by their raw bytes */
+void TestScriptBatch::typedArrayTypes()
+{
+    QJSEngine engine;
+    ScriptFrameBatch batcher(&engine);
+
+    QJSValue batch = engine.evaluate("({ ids: new Float64Array([0x7E0, 0x18DA10F1]), buses: new Int32Array([2, 1]),"
+                                     "   lengths: new Uint16Array([3, 2]), data: new Uint8Array([1, 2, 3, 4, 5]) })");
+    const QList<CANFrame> frames = batcher.fromScript(batch);
+    QCOMPARE(frames.count(), 2);
+    QCOMPARE(frames[0].frameId(), 0x7E0u);
+    QCOMPARE(frames[0].bus, 2);
+    QCOMPARE(frames[0].payload(), QByteArray::fromHex("010203"));
+    QCOMPARE(frames[1].frameId(), 0x18DA10F1u);
+    QCOMPARE(frames[1].bus, 1);
+    QCOMPARE(frames[1].payload(), QByteArray::fromHex("0405"));
+}
+
+void TestScriptBatch::perFrameThroughput()
+{
+    QJSEngine engine;
+    ScriptFrameBatch batcher(&engine);
+    const QVector<CANFrame> frames = makeFrames(5000);
+    engine.evaluate("var sum = 0;"
+                    "function gotCANFrame(bus, id, len, data) {"
+                    "    sum += id + bus;"
+                    "    for (var j = 0; j < len; j++) sum += data[j];"
+                    "}");
+    QJSValue callback = engine.globalObject().property("gotCANFrame");
+
+    QBENCHMARK {
+        engine.globalObject().setProperty("sum", 0);
+        foreach(const CANFrame& frame, frames) callback.call(batcher.frameArgs(frame));
+    }
+    QCOMPARE(engine.globalObject().property("sum").toNumber(), checksum(frames));
+}
+
+void TestScriptBatch::batchThroughput()
+{
+    QJSEngine engine;
+    ScriptFrameBatch batcher(&engine);
+    const QVector<CANFrame> frames = makeFrames(5000);
+    engine.evaluate("var sum = 0;"
+                    "function gotCANFrames(b) {"
+                    "    for (var i = 0; i < b.count; i++) {"
+                    "        sum += b.ids[i] + b.buses[i];"
+                    "        var end = b.offsets[i] + b.lengths[i];"
+                    "        for (var j = b.offsets[i]; j < end; j++) sum += b.data[j];"
+                    "    }"
+                    "}");
+    QJSValue callback = engine.globalObject().property("gotCANFrames");
+
+    QBENCHMARK {
+        engine.globalObject().setProperty("sum", 0);
+        for(int start=0 ; start<frames.count() ; start+=SCRIPT_BATCH_MAX_FRAMES)
+            callback.call(QJSValueList() << batcher.toScript(frames.mid(start, SCRIPT_BATCH_MAX_FRAMES)));
+    }
+    QCOMPARE(engine.globalObject().property("sum").toNumber(), checksum(frames));
+}
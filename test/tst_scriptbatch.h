@@ -0,0 +1,20 @@
+#ifndef TST_SCRIPTBATCH_H
+#define TST_SCRIPTBATCH_H
+
+#include <QObject>
+
+class TestScriptBatch: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void roundTrip();
+    void plainArrays();
+    void shortArrays();
+    void typedArrayTypes();
+    void perFrameThroughput();
+    void batchThroughput();
+};
+
+#endif // TST_SCRIPTBATCH_H
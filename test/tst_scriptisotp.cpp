@@ -0,0 +1,49 @@
+#include <QtTest>
+
+#include "tst_scriptisotp.h"
+#include "scriptcontainer.h"
+#include "connections/canconmanager.h"
+
+static CANFrame makeFrame(int bus, uint32_t id, const QByteArray& payload)
+{
+    CANFrame frame;
+    frame.bus = bus;
+    frame.isReceived = true;
+    frame.setFrameId(id);
+    frame.setPayload(payload);
+    return frame;
+}
+
+
+/*
+  The ISO-TP handler behind the script's isotp object lives on the script thread, so the frames the
+  manager emits on this thread reach it through a queued connection. A single frame and a two frame
+  message on the filtered ID come out of gotISOTPMessage, the message on the other ID does not.
+*/
+void TestScriptISOTP::receive()
+{
+    ScriptContainer *container = new ScriptContainer();
+    QStringList lines;
+    QObject sink;
+    connect(container, &ScriptContainer::sendLog, &sink, [&lines](QString text) { lines.append(text); });
+
+    container->fileName = "isotp.js";
+    container->scriptText =
+        "function setup() { isotp.setFilter(0x7E8, 0x7FF, 0); }\n"
+        "function gotISOTPMessage(bus, id, len, data) { host.log('iso ' + bus + ' ' + id.toString(16) + ' ' + len + ' ' + data.join(',')); }\n";
+    container->compileScript();
+    QTRY_VERIFY(lines.contains("Compiling script..."));
+
+    QVector<CANFrame> frames;
+    frames.append(makeFrame(0, 0x7E0, QByteArray::fromHex("0322f19000000000")));
+    frames.append(makeFrame(0, 0x7E8, QByteArray::fromHex("0362f19000000000")));
+    frames.append(makeFrame(0, 0x7E8, QByteArray::fromHex("100a62f190010203")));
+    frames.append(makeFrame(0, 0x7E8, QByteArray::fromHex("2104050607000000")));
+    emit CANConManager::getInstance()->framesReceived(nullptr, frames);
+
+    QTRY_COMPARE(lines.filter("iso ").count(), 2);
+    QCOMPARE(lines.filter("iso ")[0], QString("iso 0 7e8 3 98,241,144"));
+    QCOMPARE(lines.filter("iso ")[1], QString("iso 0 7e8 10 98,241,144,1,2,3,4,5,6,7"));
+
+    delete container;
+}
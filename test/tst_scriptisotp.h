@@ -0,0 +1,15 @@
+#ifndef TST_SCRIPTISOTP_H
+#define TST_SCRIPTISOTP_H
+
+#include <QObject>
+
+class TestScriptISOTP: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void receive();
+};
+
+#endif // TST_SCRIPTISOTP_H
@@ -0,0 +1,187 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "tst_signalcodec.h"
+#include "dbc/signalcodec.h"
+#include "utility.h"
+
+static SignalCodecSpec makeSpec(int startBit, int size, bool intel, DBC_SIG_VAL_TYPE valType, double factor = 1.0, double bias = 0.0)
+{
+    SignalCodecSpec spec;
+    spec.signalSize = size;
+    spec.valType = valType;
+    spec.factor = factor;
+    spec.bias = bias;
+    spec.neverPresent = false;
+    spec.segments = SignalCodec::layout(startBit, size, intel);
+    spec.minLength = 0;
+    foreach(const SignalCodecSegment& seg, spec.segments) spec.minLength = qMax(spec.minLength, seg.byteIdx + 1);
+    return spec;
+}
+
+static QByteArray randomPayload(QRandomGenerator& rng, int len)
+{
+    QByteArray bytes(len, 0);
+    for(int i=0 ; i<len ; i++) bytes[i] = (char)rng.bounded(256);
+    return bytes;
+}
+
+
+/* every layout that fits in 8 bytes must give what the bit by bit loop gives */
+void TestSignalCodec::matchesBitLoop()
+{
+    QRandomGenerator rng(1234);
+    int checked = 0;
+    for(int t=0 ; t<20000 ; t++) {
+        const int size = 1 + rng.bounded(63);
+        const int startBit = rng.bounded(64);
+        const bool intel = rng.bounded(2);
+        const bool isSigned = rng.bounded(2);
+
+        const SignalCodecSpec spec = makeSpec(startBit, size, intel, isSigned ? SIGNED_INT : UNSIGNED_INT);
+        if (spec.minLength > 8) continue;
+
+        const QByteArray payload = randomPayload(rng, 8);
+        double value;
+        QVERIFY(SignalCodec::decode(spec, payload, value));
+        QCOMPARE(value, (double)Utility::processIntegerSignal(payload, startBit, size, intel, isSigned));
+        checked++;
+    }
+    QVERIFY(checked > 10000);
+}
+
+
+/* encoding puts back exactly the bits of the signal and nothing else */
+void TestSignalCodec::roundTrip()
+{
+    QRandomGenerator rng(99);
+    for(int t=0 ; t<5000 ; t++) {
+        const int size = 1 + rng.bounded(53); //beyond that a double can't hold every raw value
+        const int startBit = rng.bounded(64);
+        const bool intel = rng.bounded(2);
+        const SignalCodecSpec spec = makeSpec(startBit, size, intel, rng.bounded(2) ? SIGNED_INT : UNSIGNED_INT, 0.5, -20.0);
+        if (spec.minLength > 8) continue;
+
+        const QByteArray payload = randomPayload(rng, 8);
+        double value;
+        QVERIFY(SignalCodec::decode(spec, payload, value));
+
+        QByteArray rewritten = randomPayload(rng, 8);
+        QVERIFY(SignalCodec::encode(spec, value, rewritten));
+        double back;
+        QVERIFY(SignalCodec::decode(spec, rewritten, back));
+        QCOMPARE(back, value);
+
+        QByteArray same = payload;
+        QVERIFY(SignalCodec::encode(spec, value, same));
+        QCOMPARE(same, payload);
+    }
+}
+
+
+void TestSignalCodec::clamps()
+{
+    const SignalCodecSpec unsignedSpec = makeSpec(8, 12, true, UNSIGNED_INT, 0.25, -40.0);
+    QByteArray payload;
+    double value;
+
+    //grows a short payload to what the signal needs
+    QVERIFY(SignalCodec::encode(unsignedSpec, 100.0, payload));
+    QCOMPARE(payload.length(), 3);
+    QVERIFY(SignalCodec::decode(unsignedSpec, payload, value));
+    QCOMPARE(value, 100.0);
+
+    QVERIFY(SignalCodec::encode(unsignedSpec, 1e9, payload));
+    QVERIFY(SignalCodec::decode(unsignedSpec, payload, value));
+    QCOMPARE(value, 4095 * 0.25 - 40.0);
+
+    QVERIFY(SignalCodec::encode(unsignedSpec, -1e9, payload));
+    QVERIFY(SignalCodec::decode(unsignedSpec, payload, value));
+    QCOMPARE(value, -40.0);
+
+    const SignalCodecSpec signedSpec = makeSpec(8, 12, true, SIGNED_INT);
+    QVERIFY(SignalCodec::encode(signedSpec, -1e9, payload));
+    QVERIFY(SignalCodec::decode(signedSpec, payload, value));
+    QCOMPARE(value, -2048.0);
+    QVERIFY(SignalCodec::encode(signedSpec, 1e9, payload));
+    QVERIFY(SignalCodec::decode(signedSpec, payload, value));
+    QCOMPARE(value, 2047.0);
+
+    QVERIFY(!SignalCodec::encode(signedSpec, qQNaN(), payload));
+    QVERIFY(!SignalCodec::decode(signedSpec, QByteArray(1, 0), value));
+}
+
+
+void TestSignalCodec::floats()
+{
+    QByteArray payload;
+    double value;
+
+    const SignalCodecSpec single = makeSpec(0, 32, true, SP_FLOAT);
+    QVERIFY(SignalCodec::encode(single, 3.5, payload));
+    QCOMPARE(payload.length(), 4);
+    QVERIFY(SignalCodec::decode(single, payload, value));
+    QCOMPARE(value, 3.5);
+
+    const SignalCodecSpec dbl = makeSpec(7, 64, false, DP_FLOAT);
+    payload.clear();
+    QVERIFY(SignalCodec::encode(dbl, -1234.0625, payload));
+    QCOMPARE(payload.length(), 8);
+    QVERIFY(SignalCodec::decode(dbl, payload, value));
+    QCOMPARE(value, -1234.0625);
+}
+
+
+/* byte 0 is the multiplexor and the signal is only there for values 1 and 2 */
+void TestSignalCodec::multiplexed()
+{
+    SignalCodecSpec spec = makeSpec(8, 8, true, UNSIGNED_INT);
+    SignalCodecMux mux;
+    mux.segments = SignalCodec::layout(0, 8, true);
+    mux.signalSize = 8;
+    mux.isSigned = false;
+    mux.factor = 1.0;
+    mux.bias = 0.0;
+    mux.lowValue = 1;
+    mux.highValue = 2;
+    spec.muxChecks.append(mux);
+
+    QByteArray payload(8, 0);
+    payload[1] = 42;
+    double value;
+    for(int m=0 ; m<4 ; m++) {
+        payload[0] = (char)m;
+        QCOMPARE(SignalCodec::decode(spec, payload, value), m == 1 || m == 2);
+    }
+    payload[0] = 2;
+    QVERIFY(SignalCodec::decode(spec, payload, value));
+    QCOMPARE(value, 42.0);
+
+    //encoding doesn't touch the multiplexor
+    QVERIFY(SignalCodec::encode(spec, 7.0, payload));
+    QCOMPARE((int)payload[0], 2);
+    QCOMPARE((int)payload[1], 7);
+
+    spec.neverPresent = true;
+    QVERIFY(!SignalCodec::decode(spec, payload, value));
+}
+
+
+void TestSignalCodec::decodeSpeed()
+{
+    QVector<SignalCodecSpec> specs;
+    for(int i=0 ; i<8 ; i++) specs.append(makeSpec(i * 8 + 7, 12, false, SIGNED_INT, 0.1, 0.0));
+    QRandomGenerator rng(7);
+    const QByteArray payload = randomPayload(rng, 16);
+
+    double sum = 0;
+    QBENCHMARK {
+        for(int f=0 ; f<1000 ; f++) {
+            for(int s=0 ; s<specs.count() ; s++) {
+                double value;
+                if (SignalCodec::decode(specs[s], payload, value)) sum += value;
+            }
+        }
+    }
+    QVERIFY(sum == sum);
+}
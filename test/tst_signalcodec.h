@@ -0,0 +1,20 @@
+#ifndef TST_SIGNALCODEC_H
+#define TST_SIGNALCODEC_H
+
+#include <QObject>
+
+class TestSignalCodec: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void matchesBitLoop();
+    void roundTrip();
+    void clamps();
+    void floats();
+    void multiplexed();
+    void decodeSpeed();
+};
+
+#endif // TST_SIGNALCODEC_H
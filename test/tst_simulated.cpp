@@ -0,0 +1,230 @@
+#include <QtTest>
+#include <QHash>
+
+#include "tst_simulated.h"
+#include "simulatedconnection.h"
+#include "canconmanager.h"
+#include "canframemodel.h"
+#include "utils/hiresclock.h"
+
+/* same period as the CANConManager refresh timer */
+#define DRAIN_INTERVAL_MS   20
+/* same period as the MainWindow GUI update timer */
+#define GUI_INTERVAL_MS     250
+
+
+void TestSimulated::profile()
+{
+    SimulatedConnection conn("ids=10;period=10;dlc=0,8;buses=2;seed=7");
+    QCOMPARE(conn.getNumBuses(), 2);
+    conn.start();
+
+    LFQueue<CANFrame>& queue = conn.getQueue();
+    QVector<CANFrame> frames;
+    QTRY_VERIFY_WITH_TIMEOUT(([&]() {
+        while(CANFrame* frame_p = queue.peek()) {
+            frames.append(*frame_p);
+            queue.dequeue();
+        }
+        return frames.count() >= 200;
+    })(), 5000);
+    conn.stop();
+
+    QCOMPARE(conn.getDroppedFrames(), 0ull);
+
+    /* every ID keeps its slot: bus, length, exact period and a running counter in the first bytes */
+    QHash<quint32, CANFrame> last;
+    foreach(const CANFrame& frame, frames) {
+        const quint32 idx = frame.frameId() - 0x100;
+        QVERIFY(idx < 10);
+        QVERIFY(!frame.hasExtendedFrameFormat());
+        QCOMPARE(frame.bus, (int)(idx % 2));
+        QCOMPARE(frame.payload().size(), (idx % 2) ? 8 : 0);
+
+        if(last.contains(frame.frameId())) {
+            const CANFrame& prev = last[frame.frameId()];
+            QCOMPARE(frame.timeStamp().microSeconds() - prev.timeStamp().microSeconds(), 10000ll);
+            if(frame.payload().size())
+                QCOMPARE((quint8)frame.payload()[0], (quint8)(prev.payload()[0] + 1));
+        }
+        last[frame.frameId()] = frame;
+    }
+    QCOMPARE(last.count(), 10);
+}
+
+
+void TestSimulated::replay_data()
+{
+    QTest::addColumn<QString>("spec");
+    QTest::addColumn<int>("maxMs");
+
+    QTest::newRow("x10")    << "file=mem;speed=10"  << 5000;
+    QTest::newRow("max")    << "file=mem;speed=0"   << 2000;
+}
+
+
+void TestSimulated::replay()
+{
+    QFETCH(QString, spec);
+    QFETCH(int, maxMs);
+
+    /* 1 second of capture, replayed at x10 it must be done in about 100ms */
+    QVector<CANFrame> source;
+    for(int i=0 ; i<1000 ; i++) {
+        CANFrame frame;
+        frame.setFrameId(0x200 + (i%16));
+        frame.setPayload(QByteArray(1 + i%8, (char)i));
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, 5000000 + i*1000));
+        source.append(frame);
+    }
+
+    SimulatedConnection conn(spec);
+    QCOMPARE(conn.getReplayFile(), QString("mem"));
+    conn.setReplayFrames(source);
+    conn.start();
+
+    LFQueue<CANFrame>& queue = conn.getQueue();
+    QVector<CANFrame> frames;
+    QTRY_VERIFY_WITH_TIMEOUT(([&]() {
+        while(CANFrame* frame_p = queue.peek()) {
+            frames.append(*frame_p);
+            queue.dequeue();
+        }
+        return frames.count() >= source.count();
+    })(), maxMs);
+    conn.stop();
+
+    QCOMPARE(frames.count(), source.count());
+    QCOMPARE(conn.getDroppedFrames(), 0ull);
+    for(int i=0 ; i<frames.count() ; i++) {
+        QCOMPARE(frames[i].frameId(), source[i].frameId());
+        QCOMPARE(frames[i].payload(), source[i].payload());
+        if(i) QVERIFY(frames[i].timeStamp().microSeconds() >= frames[i-1].timeStamp().microSeconds());
+    }
+}
+
+
+void TestSimulated::sustainedLoad_data()
+{
+    QTest::addColumn<QString>("spec");
+
+    QTest::newRow("classic_100k")   << "ids=100;period=1;dlc=8";
+    QTest::newRow("fd_burst_200k")  << "ids=50;period=2;fd=1;dlc=8,64;burst=8;buses=2";
+    QTest::newRow("ext_200k")       << "ids=2000;period=10;ext=1;buses=4";
+    QTest::newRow("classic_1M")     << "ids=1000;period=1;dlc=0,2,4,8";
+}
+
+
+/*
+ * Headless load benchmark. The connection generates at full rate in its own thread while this
+ * thread drains the queue on a timer, like the GUI thread does in CANConManager. Reports the
+ * sustained receive rate, the frames lost to a full queue and how much of the time the draining
+ * thread was busy. Run length can be set with SIMULATED_BENCH_MS.
+ */
+void TestSimulated::sustainedLoad()
+{
+    QFETCH(QString, spec);
+
+    int runMs = qEnvironmentVariableIntValue("SIMULATED_BENCH_MS");
+    if(runMs <= 0) runMs = 2000;
+
+    SimulatedConnection conn(spec);
+    LFQueue<CANFrame>& queue = conn.getQueue();
+    QVector<CANFrame> buffer;
+    quint64 received = 0;
+    qint64 busyNs = 0;
+
+    QTimer drain;
+    connect(&drain, &QTimer::timeout, [&]() {
+        const qint64 begin = HiResClock::nowNs();
+        buffer.clear();
+        while(CANFrame* frame_p = queue.peek()) {
+            buffer.append(*frame_p);
+            queue.dequeue();
+        }
+        received += buffer.count();
+        busyNs += HiResClock::nowNs() - begin;
+    });
+
+    conn.start();
+    const qint64 startNs = HiResClock::nowNs();
+    drain.start(DRAIN_INTERVAL_MS);
+    QTest::qWait(runMs);
+    drain.stop();
+    conn.stop();
+    const double seconds = (HiResClock::nowNs() - startNs) / 1e9;
+
+    qInfo("%s: generated %llu, received %.0f frames/s, dropped %llu (%.2f%%), drain thread busy %.1f%%",
+          qPrintable(spec), conn.getGeneratedFrames(), received / seconds, conn.getDroppedFrames(),
+          conn.getGeneratedFrames() ? 100.0 * conn.getDroppedFrames() / conn.getGeneratedFrames() : 0.0,
+          100.0 * busyNs / (seconds * 1e9));
+
+    QVERIFY(received > 0);
+}
+
+
+void TestSimulated::endToEnd_data()
+{
+    QTest::addColumn<QString>("spec");
+
+    QTest::newRow("classic_100k")   << "ids=100;period=1;dlc=8";
+    QTest::newRow("ext_200k")       << "ids=2000;period=10;ext=1;buses=4";
+}
+
+
+/*
+ * Same load as above but through everything the GUI thread does with received frames: CANConManager
+ * drains the connection on its own timer, CANFrameModel takes every batch and a GUI tick refreshes the
+ * model like MainWindow::tickGUIUpdate does. Reports what reached the model and how much of the time
+ * the GUI thread spent in the model. Run length can be set with SIMULATED_BENCH_MS.
+ */
+void TestSimulated::endToEnd()
+{
+    QFETCH(QString, spec);
+
+    int runMs = qEnvironmentVariableIntValue("SIMULATED_BENCH_MS");
+    if(runMs <= 0) runMs = 2000;
+
+    CANConManager *manager = CANConManager::getInstance();
+    SimulatedConnection *conn = new SimulatedConnection(spec);
+    CANFrameModel model;
+    qint64 busyNs = 0;
+    quint64 delivered = 0;
+    int refreshed = 0;
+
+    QMetaObject::Connection received = connect(manager, &CANConManager::framesReceived,
+                                               [&](CANConnection* pConn_p, QVector<CANFrame>& pFrames) {
+        const qint64 begin = HiResClock::nowNs();
+        model.addFrames(pConn_p, pFrames);
+        delivered += pFrames.count();
+        busyNs += HiResClock::nowNs() - begin;
+    });
+
+    QTimer gui;
+    connect(&gui, &QTimer::timeout, [&]() {
+        const qint64 begin = HiResClock::nowNs();
+        refreshed += model.sendBulkRefresh();
+        model.rowCount();
+        busyNs += HiResClock::nowNs() - begin;
+    });
+
+    manager->add(conn);
+    conn->start();
+    const qint64 startNs = HiResClock::nowNs();
+    gui.start(GUI_INTERVAL_MS);
+    QTest::qWait(runMs);
+    gui.stop();
+    conn->stop();
+    manager->remove(conn);
+    disconnect(received);
+    const double seconds = (HiResClock::nowNs() - startNs) / 1e9;
+
+    qInfo("%s: generated %llu, model took %.0f frames/s (%d rows refreshed), dropped %llu (%.2f%%), GUI thread busy %.1f%%",
+          qPrintable(spec), conn->getGeneratedFrames(), delivered / seconds, refreshed, conn->getDroppedFrames(),
+          conn->getGeneratedFrames() ? 100.0 * conn->getDroppedFrames() / conn->getGeneratedFrames() : 0.0,
+          100.0 * busyNs / (seconds * 1e9));
+
+    QVERIFY(delivered > 0);
+    QVERIFY(model.totalFrameCount() > 0);
+    delete conn;
+}
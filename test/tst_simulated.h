@@ -0,0 +1,21 @@
+#ifndef TST_SIMULATED_H
+#define TST_SIMULATED_H
+
+#include <QObject>
+
+class TestSimulated: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void profile();
+    void replay_data();
+    void replay();
+    void sustainedLoad_data();
+    void sustainedLoad();
+    void endToEnd_data();
+    void endToEnd();
+};
+
+#endif // TST_SIMULATED_H
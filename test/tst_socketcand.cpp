@@ -0,0 +1,231 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "tst_socketcand.h"
+#include "socketcand.h"
+
+/* number of frames in the generated recording when no capture is given through SOCKETCAND_RECORDING */
+#define NB_RECORDED_FRAMES 20000
+/* number of frames sent per iteration of the transmit benchmark (must fit in the connection queue) */
+#define NB_TX_FRAMES 2000
+
+
+/* the stand in server greets, acks open and rawmode, then counts send commands and waits for pReplay() */
+bool TestSocketCANd::pStartServer()
+{
+    mServer_p = new QTcpServer(this);
+    if(!mServer_p->listen(QHostAddress::LocalHost))
+        return false;
+
+    connect(mServer_p, &QTcpServer::newConnection, this, [this]() {
+        while(QTcpSocket* sock_p = mServer_p->nextPendingConnection()) {
+            mClients.append(sock_p);
+            connect(sock_p, &QTcpSocket::readyRead, sock_p, [this, sock_p]() {
+                QByteArray cmd = sock_p->readAll();
+                if(cmd.contains("< open ") || cmd.contains("< rawmode >"))
+                    sock_p->write("< ok >");
+                else
+                    mTxTokens += cmd.count('>');
+            });
+            sock_p->write("< hi >");
+        }
+    });
+
+    return true;
+}
+
+
+/* write the recording to every bus, cut into pChunkSize pieces so tokens straddle reads */
+void TestSocketCANd::pReplay(int pChunkSize)
+{
+    foreach(QTcpSocket* sock_p, mClients) {
+        for(int pos=0 ; pos<mRecording.size() ; pos+=pChunkSize)
+            sock_p->write(mRecording.constData() + pos, qMin(pChunkSize, mRecording.size() - pos));
+        sock_p->flush();
+    }
+}
+
+
+void TestSocketCANd::initTestCase()
+{
+    mServer_p = nullptr;
+    mRecordedFrames = 0;
+    mTxTokens = 0;
+
+    QFile file(qEnvironmentVariable("SOCKETCAND_RECORDING"));
+    if(file.fileName().size() && file.open(QIODevice::ReadOnly)) {
+        mRecording = file.readAll();
+        mRecordedFrames = mRecording.count("< frame ");
+    }
+    else {
+        for(int i=0 ; i<NB_RECORDED_FRAMES ; i++) {
+            QByteArray data;
+            for(int c=0 ; c<(i%9) ; c++)
+                data.append(QByteArray::number((i+c) & 0xFF, 16).rightJustified(2, '0').toUpper());
+            mRecording.append("< frame " + QByteArray::number(0x100 + (i%64), 16) + " "
+                              + QByteArray::number(1600000000 + i/1000) + "."
+                              + QByteArray::number((i%1000)*1000).rightJustified(6, '0') + " "
+                              + data + " >");
+        }
+        mRecordedFrames = NB_RECORDED_FRAMES;
+    }
+
+    QVERIFY(pStartServer());
+}
+
+
+void TestSocketCANd::cleanupTestCase()
+{
+    /* client sockets are children of the server */
+    mClients.clear();
+    delete mServer_p;
+    mServer_p = nullptr;
+}
+
+
+void TestSocketCANd::decode_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("1")      << 1;
+    QTest::newRow("7")      << 7;
+    QTest::newRow("1460")   << 1460;
+}
+
+
+void TestSocketCANd::decode()
+{
+    QFETCH(int, chunkSize);
+
+    mClients.clear();
+    SocketCANd conn("vcan0,vcan1@standin (can://127.0.0.1:" + QString::number(mServer_p->serverPort()) + ")");
+    conn.start();
+
+    /* wait for both buses to reach raw mode */
+    QTRY_COMPARE(mClients.count(), 2);
+    QTest::qWait(200);
+
+    QByteArray head;
+    head.append("< frame 123 1600000000.000010 1122334455667788 >");
+    head.append("< frame 1FFFFFFF 1600000001.5 >");
+    head.append("< error 1 >");
+    head.append("garbage< frame 7ff 1600000002.999999 A0 >");
+    mRecording.swap(head);
+    pReplay(chunkSize);
+    mRecording.swap(head);
+
+    LFQueue<CANFrame>& queue = conn.getQueue();
+    QVector<CANFrame> frames;
+    QTRY_VERIFY_WITH_TIMEOUT(([&]() {
+        while(CANFrame* frame_p = queue.peek()) {
+            frames.append(*frame_p);
+            queue.dequeue();
+        }
+        return frames.count() >= 6;
+    })(), 5000);
+
+    QCOMPARE(frames.count(), 6);
+    for(int bus=0 ; bus<2 ; bus++) {
+        QVector<CANFrame> busFrames;
+        foreach(const CANFrame& frame, frames)
+            if(frame.bus == bus) busFrames.append(frame);
+        QCOMPARE(busFrames.count(), 3);
+
+        QCOMPARE(busFrames[0].frameId(), 0x123u);
+        QVERIFY(!busFrames[0].hasExtendedFrameFormat());
+        QCOMPARE(busFrames[0].payload(), QByteArray::fromHex("1122334455667788"));
+
+        QCOMPARE(busFrames[1].frameId(), 0x1FFFFFFFu);
+        QVERIFY(busFrames[1].hasExtendedFrameFormat());
+        QCOMPARE(busFrames[1].payload().size(), 0);
+        /* server stamps are mapped onto the local timebase, only their order survives */
+        QVERIFY(busFrames[1].timeStamp().microSeconds() >= busFrames[0].timeStamp().microSeconds());
+        QVERIFY(busFrames[2].timeStamp().microSeconds() >= busFrames[1].timeStamp().microSeconds());
+
+        QCOMPARE(busFrames[2].frameId(), 0x7FFu);
+        QCOMPARE(busFrames[2].payload(), QByteArray::fromHex("A0"));
+    }
+
+    conn.stop();
+}
+
+
+void TestSocketCANd::replayThroughput()
+{
+    mClients.clear();
+    SocketCANd conn("vcan0,vcan1@standin (can://127.0.0.1:" + QString::number(mServer_p->serverPort()) + ")");
+    conn.start();
+
+    QTRY_COMPARE(mClients.count(), 2);
+    QTest::qWait(200);
+
+    LFQueue<CANFrame>& queue = conn.getQueue();
+    const int expected = mRecordedFrames * mClients.count();
+
+    QBENCHMARK {
+        int received = 0;
+        pReplay(1460);
+        QElapsedTimer timeout;
+        timeout.start();
+        while(received < expected && timeout.elapsed() < 30000) {
+            while(queue.peek()) {
+                queue.dequeue();
+                received++;
+            }
+            QCoreApplication::processEvents();
+        }
+        QCOMPARE(received, expected);
+    }
+
+    conn.stop();
+}
+
+
+void TestSocketCANd::sendThroughput_data()
+{
+    QTest::addColumn<bool>("batched");
+
+    QTest::newRow("perframe")   << false;
+    QTest::newRow("batched")    << true;
+}
+
+
+void TestSocketCANd::sendThroughput()
+{
+    QFETCH(bool, batched);
+
+    mClients.clear();
+    SocketCANd conn("vcan0,vcan1@standin (can://127.0.0.1:" + QString::number(mServer_p->serverPort()) + ")");
+    conn.start();
+
+    QTRY_COMPARE(mClients.count(), 2);
+    QTest::qWait(200);
+
+    QList<CANFrame> frames;
+    for(int i=0 ; i<NB_TX_FRAMES ; i++) {
+        CANFrame frame;
+        frame.setFrameId(0x100 + (i%64));
+        frame.setPayload(QByteArray::fromHex("0011223344556677"));
+        frame.bus = i%2;
+        frames.append(frame);
+    }
+
+    LFQueue<CANFrame>& queue = conn.getQueue();
+
+    QBENCHMARK {
+        mTxTokens = 0;
+        if(batched)
+            QVERIFY(conn.sendFrames(frames));
+        else
+            foreach(const CANFrame& frame, frames)
+                QVERIFY(conn.sendFrame(frame));
+        QTRY_COMPARE_WITH_TIMEOUT(mTxTokens, (qint64)NB_TX_FRAMES, 10000);
+
+        /* sent frames are echoed into the capture queue */
+        while(queue.peek())
+            queue.dequeue();
+    }
+
+    conn.stop();
+}
@@ -0,0 +1,34 @@
+#ifndef TST_SOCKETCAND_H
+#define TST_SOCKETCAND_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+
+class QTcpServer;
+class QTcpSocket;
+
+class TestSocketCANd: public QObject
+{
+    Q_OBJECT
+private:
+    QTcpServer*          mServer_p;
+    QVector<QTcpSocket*> mClients;
+    QByteArray           mRecording;
+    int                  mRecordedFrames;
+    qint64               mTxTokens;
+
+    bool pStartServer();
+    void pReplay(int pChunkSize);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void decode_data();
+    void decode();
+    void replayThroughput();
+    void sendThroughput_data();
+    void sendThroughput();
+};
+
+#endif // TST_SOCKETCAND_H
@@ -0,0 +1,344 @@
+#include <QtTest>
+#include <QMap>
+#include <QSet>
+
+#include "tst_udsscan.h"
+#include "re/udsscanengine.h"
+
+static ScanEntry makeEntry(uint32_t startID, uint32_t endID, SCAN_TYPE type)
+{
+    ScanEntry entry;
+    entry.startID = startID;
+    entry.endID = endID;
+    entry.idOffset = 8;
+    entry.bAdaptiveOffset = false;
+    entry.bShowNoReplies = true;
+    entry.busToScan = 0;
+    entry.maxWaitTime = 100;
+    entry.scanType = type;
+    entry.sessType = 0;
+    entry.subfunctLen = 2;
+    entry.subfunctLower = 0;
+    entry.subfunctUpper = 0;
+    entry.subfunctIncrement = 1;
+    entry.serviceLower = 1;
+    entry.serviceUpper = 1;
+    return entry;
+}
+
+/*
+  The other end of a loopback bus. ECUs sit at some request IDs and answer after their own latency on
+  request ID + replyOffset. Tester present and the DIDs in dids get a positive reply, anything else is
+  answered with request out of range. The slow ECU says response pending before every real answer.
+*/
+struct SimulatedECU
+{
+    uint32_t id;
+    int latencyMs;
+    int replyOffset;
+    bool slow;
+    QMap<int, QByteArray> dids;
+};
+
+struct PendingReply
+{
+    qint64 dueMs;
+    uint32_t replyID;
+    int service;
+    bool isError;
+    QByteArray data;
+};
+
+class Loopback
+{
+public:
+    QVector<SimulatedECU> ecus;
+    QVector<PendingReply> inFlight;
+    QVector<UDSScanResult> results;
+    QHash<uint32_t, int> outstanding;   //requests sent and not yet answered, per ID
+    int maxOutstandingPerID = 0;
+    int maxInFlightIDs = 0;
+
+    /* runs the scan to the end on a simulated clock, one ms per step. Returns the time it took */
+    qint64 run(UDSScanEngine& engine, const QVector<ScanEntry>& entries, int window)
+    {
+        qint64 now = 0;
+        engine.start(entries, window, now);
+        while (engine.isRunning() && now < 10000000) {
+            for (int i = inFlight.count() - 1 ; i >= 0 ; i--) {
+                if (inFlight[i].dueMs > now) continue;
+                PendingReply reply = inFlight.takeAt(i);
+                engine.gotReply(reply.replyID, 0, reply.service, reply.isError, reply.data, now, results);
+            }
+
+            QVector<UDSScanRequest> toSend;
+            engine.poll(now, toSend, results);
+            foreach(const UDSScanResult& result, results) outstanding[result.request.id]--;
+            results.clear();
+            foreach(const UDSScanRequest& req, toSend) request(req, now);
+
+            int ids = 0;
+            foreach(int count, outstanding) if(count > 0) ids++;
+            maxInFlightIDs = qMax(maxInFlightIDs, ids);
+            now++;
+        }
+        return now;
+    }
+
+    void request(const UDSScanRequest& req, qint64 now)
+    {
+        all.append(req);
+        maxOutstandingPerID = qMax(maxOutstandingPerID, ++outstanding[req.id]);
+        foreach(const SimulatedECU& ecu, ecus) {
+            if(ecu.id != req.id) continue;
+            const uint32_t replyID = ecu.id + ecu.replyOffset;
+            if(ecu.slow)
+                inFlight.append({now + 1, replyID, req.service, true, QByteArray(1, (char)UDSSCAN_RESPONSE_PENDING)});
+            if(req.service == 0x3E || (req.service == 0x22 && ecu.dids.contains(req.subFunc)))
+                inFlight.append({now + ecu.latencyMs, replyID, 0x40 + req.service, false, ecu.dids.value(req.subFunc)});
+            else
+                inFlight.append({now + ecu.latencyMs, replyID, req.service, true, QByteArray(1, 0x31)});
+        }
+    }
+
+    QVector<UDSScanRequest> all;
+};
+
+
+/* requests are worked out from the plan on demand but have to be what the window used to list up front */
+void TestUDSScan::plan()
+{
+    ScanEntry custom = makeEntry(0x7E0, 0x7E0, ST_CUSTOM);
+    custom.sessType = 3;
+    custom.serviceLower = 0x21;
+    custom.serviceUpper = 0x23;
+    custom.subfunctLower = 4;
+    custom.subfunctUpper = 10;
+    custom.subfunctIncrement = 3;
+
+    QCOMPARE(UDSScanEngine::requestsPerTarget(custom), 1 + 3 * 3ll);
+    QVector<QPair<int, int>> expected = {{0x10, 3}};
+    for(int service=0x21 ; service<=0x23 ; service++)
+        for(int subf=4 ; subf<=10 ; subf+=3) expected.append(qMakePair(service, subf));
+    for(int k=0 ; k<expected.count() ; k++) {
+        const UDSScanRequest req = UDSScanEngine::makeRequest(custom, 0, 0x7E0, k);
+        QCOMPARE(qMakePair(req.service, req.subFunc), expected[k]);
+    }
+
+    ScanEntry security = makeEntry(0x700, 0x7FF, ST_SEC_ACCESS);
+    QCOMPARE(UDSScanEngine::requestsPerTarget(security), 0x21ll);
+    QCOMPARE(UDSScanEngine::makeRequest(security, 0, 0x700, 0x20).subFunc, 0x41);
+
+    ScanEntry routine = makeEntry(0x700, 0x700, ST_ROUTINE_CTRL);
+    routine.subfunctLower = 0x200;
+    routine.subfunctUpper = 0x2FF;
+    QCOMPARE(UDSScanEngine::requestsPerTarget(routine), 0x100ll);
+    QCOMPARE(UDSScanEngine::makeRequest(routine, 0, 0x700, 1).subFunc, (0x201 << 8) + 3);
+
+    UDSScanEngine engine;
+    engine.start(QVector<ScanEntry>() << custom << security, 4, 0);
+    QCOMPARE(engine.getTotalRequests(), 10 + 0x100 * 0x21ll);
+}
+
+
+/* two ECUs in a range of 16 IDs. Every request gets exactly one result and the whole thing is far quicker than one at a time */
+void TestUDSScan::parallelScan()
+{
+    Loopback bus;
+    bus.ecus.append({0x7E0, 3, 8, false, {{0xF190, QByteArray("VIN")}}});
+    bus.ecus.append({0x7E5, 12, 8, true, {{0xF190, QByteArray("VIN2")}, {0xF195, QByteArray(2, 0x01)}}});
+
+    ScanEntry present = makeEntry(0x7E0, 0x7EF, ST_TESTER_PRESENT);
+    ScanEntry dids = makeEntry(0x7E0, 0x7EF, ST_READ_ID);
+    dids.subfunctLower = 0xF190;
+    dids.subfunctUpper = 0xF19F;
+
+    UDSScanEngine engine;
+    const qint64 took = bus.run(engine, QVector<ScanEntry>() << present << dids, 8);
+
+    QCOMPARE(engine.getCompletedRequests(), engine.getTotalRequests());
+    QCOMPARE(engine.getTotalRequests(), 16 + 16 * 16ll);
+    QCOMPARE((qint64)bus.all.count(), engine.getTotalRequests());
+    QCOMPARE(bus.maxOutstandingPerID, 1);
+    QVERIFY(bus.maxInFlightIDs > 1);
+    QVERIFY(bus.maxInFlightIDs <= 8);
+
+    //one at a time the 14 silent IDs alone would take 17 requests x 100ms each
+    QVERIFY(took < 14 * 17 * 100 / 4);
+
+    //the ECUs are answered quickly now, the silent IDs never learned anything
+    QVERIFY(engine.getTimeout(1, 0x7E0) < 100);
+    QCOMPARE(engine.getTimeout(1, 0x7E1), 100);
+}
+
+
+/* replies on an ID nobody told the scan about are matched by service and teach the offset */
+void TestUDSScan::adaptiveOffset()
+{
+    Loopback bus;
+    bus.ecus.append({0x640, 5, 0x20, false, {{0x0100, QByteArray(1, 0x55)}}});
+
+    ScanEntry dids = makeEntry(0x63C, 0x643, ST_READ_ID);
+    dids.bAdaptiveOffset = true;
+    dids.subfunctLower = 0x00FE;
+    dids.subfunctUpper = 0x0101;
+
+    UDSScanEngine engine;
+    QVector<UDSScanResult> all;
+    qint64 now = 0;
+    engine.start(QVector<ScanEntry>() << dids, 4, now);
+    while(engine.isRunning() && now < 100000) {
+        for(int i = bus.inFlight.count() - 1 ; i >= 0 ; i--) {
+            if(bus.inFlight[i].dueMs > now) continue;
+            PendingReply reply = bus.inFlight.takeAt(i);
+            QVERIFY(engine.gotReply(reply.replyID, -1, reply.service, reply.isError, reply.data, now, all));
+        }
+        QVector<UDSScanRequest> toSend;
+        engine.poll(now, toSend, all);
+        foreach(const UDSScanRequest& req, toSend) bus.request(req, now);
+        now++;
+    }
+
+    int positives = 0, negatives = 0;
+    foreach(const UDSScanResult& result, all) {
+        if(result.kind == UDSScanResult::NO_REPLY) {
+            QVERIFY(result.request.id != 0x640);
+            continue;
+        }
+        QCOMPARE(result.request.id, 0x640u);
+        QCOMPARE(result.replyID, 0x660u);
+        if(result.kind == UDSScanResult::POSITIVE) {
+            positives++;
+            QCOMPARE(result.request.subFunc, 0x0100);
+            QCOMPARE(result.data, QByteArray(1, 0x55));
+        }
+        else negatives++;
+    }
+    QCOMPARE(positives, 1);
+    QCOMPARE(negatives, 3);
+    QCOMPARE(all.count(), 8 * 4);
+}
+
+
+/*
+  Two ECUs with different reply offsets in one adaptive scan. The quick one would answer while the slow
+  one is still outstanding, and a reply on an unknown ID can't say which request it belongs to. Every
+  reply still has to end up with the ECU that sent it.
+*/
+void TestUDSScan::adaptiveTwoTargets()
+{
+    Loopback bus;
+    bus.ecus.append({0x700, 20, 0x08, false, {{0x0100, QByteArray(1, 0x11)}}});
+    bus.ecus.append({0x701, 2, 0x40, false, {{0x0101, QByteArray(1, 0x22)}}});
+
+    ScanEntry dids = makeEntry(0x700, 0x703, ST_READ_ID);
+    dids.bAdaptiveOffset = true;
+    dids.subfunctLower = 0x0100;
+    dids.subfunctUpper = 0x0103;
+
+    UDSScanEngine engine;
+    QVector<UDSScanResult> all;
+    qint64 now = 0;
+    engine.start(QVector<ScanEntry>() << dids, 4, now);
+    while(engine.isRunning() && now < 100000) {
+        for(int i = bus.inFlight.count() - 1 ; i >= 0 ; i--) {
+            if(bus.inFlight[i].dueMs > now) continue;
+            PendingReply reply = bus.inFlight.takeAt(i);
+            QVERIFY(engine.gotReply(reply.replyID, 0, reply.service, reply.isError, reply.data, now, all));
+        }
+        QVector<UDSScanRequest> toSend;
+        engine.poll(now, toSend, all);
+        foreach(const UDSScanRequest& req, toSend) bus.request(req, now);
+        now++;
+    }
+
+    QCOMPARE(all.count(), 4 * 4);
+    QMap<uint32_t, int> answered;
+    foreach(const UDSScanResult& result, all) {
+        if(result.kind == UDSScanResult::NO_REPLY) {
+            QVERIFY(result.request.id > 0x701);
+            continue;
+        }
+        answered[result.request.id]++;
+        QCOMPARE(result.replyID, result.request.id + ((result.request.id == 0x700) ? 0x08 : 0x40));
+        if(result.kind == UDSScanResult::POSITIVE)
+            QCOMPARE(result.request.subFunc, (result.request.id == 0x700) ? 0x0100 : 0x0101);
+    }
+    QCOMPARE(answered.value(0x700), 4);
+    QCOMPARE(answered.value(0x701), 4);
+
+    //and each one's latency was put down to the right ECU
+    QVERIFY(engine.getTimeout(0, 0x701) < engine.getTimeout(0, 0x700));
+}
+
+
+/*
+  A whole block of 11 bit IDs with adaptive offset. Targets a reply range apart go out together so the silent
+  IDs don't take a full timeout each one after the other, and every reply still lands on the ECU that sent it.
+*/
+void TestUDSScan::adaptiveParallel()
+{
+    Loopback bus;
+    bus.ecus.append({0x610, 5, 0x08, false, {}});
+    bus.ecus.append({0x650, 5, 0x20, false, {}});
+    bus.ecus.append({0x6A0, 5, 0x10, false, {}});
+
+    ScanEntry present = makeEntry(0x600, 0x6FF, ST_TESTER_PRESENT);
+    present.bAdaptiveOffset = true;
+
+    UDSScanEngine engine;
+    QVector<UDSScanResult> all;
+    QSet<uint32_t> requested;
+    qint64 now = 0;
+    engine.start(QVector<ScanEntry>() << present, 4, now);
+    while(engine.isRunning() && now < 100000) {
+        for(int i = bus.inFlight.count() - 1 ; i >= 0 ; i--) {
+            if(bus.inFlight[i].dueMs > now) continue;
+            PendingReply reply = bus.inFlight.takeAt(i);
+            QVERIFY(engine.gotReply(reply.replyID, 0, reply.service, reply.isError, reply.data, now, all));
+        }
+        QVector<UDSScanRequest> toSend;
+        engine.poll(now, toSend, all);
+        foreach(const UDSScanRequest& req, toSend) {
+            requested.insert(req.id);
+            bus.request(req, now);
+        }
+        now++;
+    }
+
+    QCOMPARE(all.count(), 0x100);
+    QCOMPARE(requested.count(), 0x100);
+    int positives = 0;
+    foreach(const UDSScanResult& result, all) {
+        if(result.kind == UDSScanResult::NO_REPLY) continue;
+        QCOMPARE(result.kind, UDSScanResult::POSITIVE);
+        positives++;
+        if(result.request.id == 0x610) QCOMPARE(result.replyID, 0x618u);
+        else if(result.request.id == 0x650) QCOMPARE(result.replyID, 0x670u);
+        else QCOMPARE(result.replyID, 0x6B0u);
+    }
+    QCOMPARE(positives, 3);
+
+    //one at a time it would be 253 silent IDs x 100ms
+    QVERIFY(now < 253 * 100 / 2);
+}
+
+
+/* response pending only moves the deadline. The latency the timeout is worked out from is the time to the real answer */
+void TestUDSScan::responsePending()
+{
+    Loopback bus;
+    bus.ecus.append({0x7E5, 30, 8, true, {{0xF190, QByteArray("VIN")}}});
+
+    ScanEntry dids = makeEntry(0x7E5, 0x7E5, ST_READ_ID);
+    dids.subfunctLower = 0xF190;
+    dids.subfunctUpper = 0xF19F;
+
+    UDSScanEngine engine;
+    bus.run(engine, QVector<ScanEntry>() << dids, 1);
+
+    QCOMPARE(engine.getCompletedRequests(), engine.getTotalRequests());
+    const int timeout = engine.getTimeout(0, 0x7E5);
+    QVERIFY(timeout >= 30 + UDSSCAN_TIMEOUT_MARGIN_MS);
+    QVERIFY(timeout < 50);
+}
@@ -0,0 +1,20 @@
+#ifndef TST_UDSSCAN_H
+#define TST_UDSSCAN_H
+
+#include <QObject>
+
+class TestUDSScan: public QObject
+{
+    Q_OBJECT
+private:
+
+private slots:
+    void plan();
+    void parallelScan();
+    void adaptiveOffset();
+    void adaptiveTwoTargets();
+    void adaptiveParallel();
+    void responsePending();
+};
+
+#endif // TST_UDSSCAN_H
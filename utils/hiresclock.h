@@ -0,0 +1,130 @@
+#ifndef HIRESCLOCK_H
+#define HIRESCLOCK_H
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMetaType>
+#include <QAtomicInt>
+#include <cmath>
+
+#if defined(Q_OS_UNIX)
+#include <time.h>
+#endif
+
+/* below this many nanoseconds before a deadline we stop sleeping and spin on the clock */
+#define HIRES_DEFAULT_SPIN_NS   200000
+/* never sleep longer than this in one go so stop requests are honored quickly */
+#define HIRES_MAX_SLEEP_NS      10000000
+
+/*
+  Monotonic nanosecond clock plus an absolute deadline sleep used by the transmit threads.
+  On POSIX systems the kernel is asked to wake us up (clock_nanosleep with TIMER_ABSTIME) slightly
+  before the deadline and the last stretch is spun out. That keeps CPU use low for long gaps while
+  still hitting deadlines in the tens of microseconds. Other platforms fall back to usleep + spin.
+*/
+class HiResClock
+{
+public:
+    static qint64 nowNs()
+    {
+#if defined(Q_OS_UNIX)
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (qint64)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+#else
+        return reference.nsecsElapsed();
+#endif
+    }
+
+    /**
+     * @brief Block the calling thread until the monotonic clock reaches deadlineNs
+     * @param deadlineNs - absolute time in the nowNs() time base
+     * @param spinNs - how long before the deadline to switch from sleeping to spinning
+     * @param abort_p - optional flag checked between sleeps. Returns early if it becomes true
+     */
+    static void sleepUntil(qint64 deadlineNs, qint64 spinNs = HIRES_DEFAULT_SPIN_NS, const QAtomicInt *abort_p = nullptr)
+    {
+        qint64 now = nowNs();
+        while ((deadlineNs - now) > spinNs)
+        {
+            if (abort_p && abort_p->loadRelaxed()) return;
+            qint64 wake = qMin(deadlineNs - spinNs, now + HIRES_MAX_SLEEP_NS);
+#if defined(Q_OS_UNIX)
+            struct timespec ts;
+            ts.tv_sec = wake / 1000000000ll;
+            ts.tv_nsec = wake % 1000000000ll;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+#else
+            QThread::usleep((unsigned long)((wake - now) / 1000));
+#endif
+            now = nowNs();
+        }
+        while (now < deadlineNs) now = nowNs();
+    }
+
+#if !defined(Q_OS_UNIX)
+private:
+    //started during static initialization so two threads can't both find it unstarted and race to start it
+    static QElapsedTimer startedTimer()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }
+    static inline const QElapsedTimer reference = startedTimer();
+#endif
+};
+
+/*
+  Running statistics over a stream of signed nanosecond samples (timing errors, period jitter, etc).
+  Uses Welford's method so it never has to keep the samples around.
+*/
+class TimingStats
+{
+public:
+    quint64 count;
+    qint64 minNs;
+    qint64 maxNs;
+    double meanNs;
+    double m2;
+    quint64 overLimit; //samples whose magnitude exceeded limitNs
+    qint64 limitNs;
+
+    TimingStats(qint64 limit = 100000)
+    {
+        limitNs = limit;
+        reset();
+    }
+
+    void reset()
+    {
+        count = 0;
+        minNs = 0;
+        maxNs = 0;
+        meanNs = 0.0;
+        m2 = 0.0;
+        overLimit = 0;
+    }
+
+    void add(qint64 sampleNs)
+    {
+        if (count == 0 || sampleNs < minNs) minNs = sampleNs;
+        if (count == 0 || sampleNs > maxNs) maxNs = sampleNs;
+        count++;
+        double delta = sampleNs - meanNs;
+        meanNs += delta / count;
+        m2 += delta * (sampleNs - meanNs);
+        if (qAbs(sampleNs) > limitNs) overLimit++;
+    }
+
+    double stdDevNs() const
+    {
+        if (count < 2) return 0.0;
+        return std::sqrt(m2 / (count - 1));
+    }
+};
+
+Q_DECLARE_METATYPE(TimingStats)
+
+#endif // HIRESCLOCK_H
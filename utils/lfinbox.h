@@ -0,0 +1,135 @@
+#ifndef LFINBOX_H
+#define LFINBOX_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QVector>
+#include "lfqueue.h"
+
+/* most threads that can be pushing into one inbox at the same time. One per connection thread is plenty */
+#define LFINBOX_LANES       8
+#define LFINBOX_LANE_SIZE   1024
+
+/*
+  Many writers, one reader, no locks. Every writing thread gets its own LFQueue lane the first time it
+  pushes so each lane still only has one writer and one reader. Order is kept per writer, not between writers.
+  The lane goes back to the inbox when the writing thread finishes, whatever it still had queued is drained
+  as usual, so only LFINBOX_LANES writers have to be alive at once. When a lane is full or all lanes are
+  taken the item is dropped and counted.
+
+  push() returns true when the reader needs waking up, that is when nothing was pending since the reader
+  last started a drain. The writer then posts one wake up however many items follow. The reader clears the
+  pending flag before it looks at the lanes so nothing pushed during a drain is left sitting there.
+*/
+template<class T>
+class LFInbox
+{
+public:
+    LFInbox() : lanes(new Lanes)
+    {
+        for (int i = 0; i < LFINBOX_LANES; i++) lanes->queue[i].setSize(LFINBOX_LANE_SIZE);
+    }
+
+    bool push(const T& item)
+    {
+        LFQueue<T> *queue = laneFor();
+        T *slot = queue ? queue->get() : nullptr;
+        if (!slot)
+        {
+            dropped.fetchAndAddRelaxed(1);
+            return false;
+        }
+        *slot = item;
+        queue->queue();
+        return pending.testAndSetOrdered(0, 1);
+    }
+
+    /* reader thread only. Calls fn for everything queued and returns how many there were */
+    template<typename F>
+    int drain(F fn)
+    {
+        pending.storeRelease(0);
+        int count = 0;
+        for (int i = 0; i < LFINBOX_LANES; i++)
+        {
+            //a lane that was given back can still have items in it so every lane is looked at
+            T *item;
+            while ((item = lanes->queue[i].peek()))
+            {
+                fn(*item);
+                lanes->queue[i].dequeue();
+                count++;
+            }
+        }
+        return count;
+    }
+
+    int getDropped() const
+    {
+        return dropped.loadRelaxed();
+    }
+
+private:
+    struct Lanes
+    {
+        QAtomicInt taken[LFINBOX_LANES];
+        LFQueue<T> queue[LFINBOX_LANES];
+    };
+
+    //the lanes one writing thread holds, in whichever inboxes it pushed into. They are given back when the thread
+    //ends. The inbox may be gone by then which the weak pointer takes care of
+    struct Held
+    {
+        struct Entry
+        {
+            const Lanes *key;
+            QWeakPointer<Lanes> lanes;
+            int lane;
+        };
+        QVector<Entry> entries;
+
+        ~Held()
+        {
+            foreach (const Entry &entry, entries)
+            {
+                QSharedPointer<Lanes> alive = entry.lanes.toStrongRef();
+                if (alive) alive->taken[entry.lane].storeRelease(0);
+            }
+        }
+    };
+
+    LFQueue<T> *laneFor()
+    {
+        static thread_local Held held;
+        const Lanes *key = lanes.data();
+        for (int i = 0; i < held.entries.count(); i++)
+        {
+            if (held.entries[i].key != key) continue;
+            if (!held.entries[i].lanes.isNull()) return &lanes->queue[held.entries[i].lane];
+            held.entries.removeAt(i); //an earlier inbox that happened to live at the same address
+            break;
+        }
+
+        //lanes given back with items still in them are only taken once there is no empty one left
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int i = 0; i < LFINBOX_LANES; i++)
+            {
+                if (pass == 0 && !lanes->queue[i].isEmpty()) continue;
+                if (lanes->taken[i].testAndSetOrdered(0, 1))
+                {
+                    held.entries.append({key, lanes.toWeakRef(), i});
+                    return &lanes->queue[i];
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    QSharedPointer<Lanes> lanes;
+    QAtomicInt pending;
+    QAtomicInt dropped;
+};
+
+#endif // LFINBOX_H
@@ -69,6 +69,11 @@ public:
     }
 
 
+    bool isEmpty() {
+        return IS_EMPTY();
+    }
+
+
     void dequeue() {
         #ifdef QT_DEBUG
         if(IS_EMPTY())